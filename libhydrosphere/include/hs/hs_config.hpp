@@ -9,7 +9,12 @@
  */
 
 #pragma once
-#ifdef __aarch64__
+#ifdef HYDROSPHERE_TARGET_HOST
+// Host builds run the library on top of a stand-in of the AArch64 svc layer,
+// see test/host.
+#define HYDROSPHERE_TARGET_ARCH_NAME aarch64
+#define HYDROSPHERE_TARGET_AARCH64 1
+#elif __aarch64__
 #define HYDROSPHERE_TARGET_ARCH_NAME aarch64
 #define HYDROSPHERE_TARGET_AARCH64 1
 #elif __arm__
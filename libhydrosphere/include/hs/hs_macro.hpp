@@ -19,6 +19,7 @@
     __attribute__((section(section_name)))
 #define __HS_ATTRIBUTE_NAKED __attribute((naked))
 #define __HS_ATTRIBUTE_ALIGNED(align) __attribute__((aligned(align)))
+#define __HS_ATTRIBUTE_ALWAYS_INLINE __attribute__((always_inline))
 #define __HS_ASM __asm__
 
 #define __HS_DISALLOW_COPY(TypeName)   \
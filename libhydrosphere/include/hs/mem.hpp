@@ -0,0 +1,23 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+/**
+ * \defgroup mem_api Memory API
+ * \short Module managing the memory of the process.
+ **/
+
+#include <hs/mem/mem_accounting_api.hpp>
+#include <hs/mem/mem_arena_api.hpp>
+#include <hs/mem/mem_heap_api.hpp>
+#include <hs/mem/mem_new_api.hpp>
+#include <hs/mem/mem_pressure_api.hpp>
+#include <hs/mem/mem_trace_api.hpp>
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/hs_result.hpp>
+
+namespace hs::mem {
+/**
+ * \defgroup accounting_api Memory Accounting API
+ * \short API reporting the memory held by every allocator of Hydrosphère.
+ *
+ * Every allocator keeps counters of the bytes and the blocks it currently holds under a MemoryTag.
+ * The counters are striped by Thread to avoid contention and are merged when a snapshot is taken.
+ *
+ * \ingroup mem_api
+ * \name Memory Accounting API
+ * \addtogroup accounting_api
+ * @{
+ */
+
+/**
+ * \short The origin of some accounted memory.
+ */
+enum class MemoryTag {
+    /**
+     * \short Blocks allocated from the heap (see \ref heap_api "Heap API").
+     *
+     * \remark Every heap block is accounted here, including the ones also accounted by another tag.
+     */
+    Heap,
+    /**
+     * \short Stacks of the created Threads.
+     */
+    ThreadStack,
+    /**
+     * \short Address space reserved by Hydrosphère for Thread stack mirrors, Arenas and other mappings.
+     */
+    VirtualMemory,
+    /**
+     * \short Memory backing the Arenas (see \ref arena_api "Arena API").
+     */
+    Arena,
+    /**
+     * \short Slabs of the object pools (see hs::util::ObjectPool).
+     */
+    ObjectPool,
+    /**
+     * \short Memory accounted by the application with hs::mem::AccountMemory.
+     */
+    Application
+};
+
+/**
+ * \short The count of MemoryTag.
+ */
+const size_t MEMORY_TAG_COUNT = 6;
+
+/**
+ * \short The memory held under a MemoryTag.
+ */
+struct MemoryUsage {
+    /**
+     * \short The count of bytes held.
+     */
+    size_t size;
+
+    /**
+     * \short The count of blocks held.
+     */
+    size_t block_count;
+};
+
+/**
+ * \short The memory usage of the process at a point in time.
+ */
+struct MemoryUsageSnapshot {
+    /**
+     * \short The memory held under every MemoryTag, indexed by MemoryTag.
+     */
+    MemoryUsage usages[MEMORY_TAG_COUNT];
+
+    /**
+     * \short The total amount of memory available to the process as reported by the kernel.
+     */
+    uint64_t process_total_memory_size;
+
+    /**
+     * \short The amount of memory used by the process as reported by the kernel.
+     */
+    uint64_t process_used_memory_size;
+};
+
+/**
+ * \short Account a block of memory acquired under a MemoryTag.
+ *
+ * \param[in] tag The MemoryTag of the block.
+ * \param[in] size The size of the block in bytes.
+ */
+void AccountMemory(MemoryTag tag, size_t size) noexcept;
+
+/**
+ * \short Stop accounting a block of memory released under a MemoryTag.
+ *
+ * \param[in] tag The MemoryTag given to hs::mem::AccountMemory.
+ * \param[in] size The size given to hs::mem::AccountMemory.
+ */
+void UnaccountMemory(MemoryTag tag, size_t size) noexcept;
+
+/**
+ * \short Take a snapshot of the memory usage of the process.
+ *
+ * \param[in] out_snapshot Where to write the snapshot.
+ *
+ * \return The result of the kernel queries, the accounted usages are written even on failure.
+ *
+ * \remark The counters are read one by one without stopping the other Threads, a snapshot taken while allocating may be slightly inconsistent.
+ */
+hs::Result GetMemoryUsageSnapshot(MemoryUsageSnapshot *out_snapshot) noexcept;
+
+/**
+ * @}
+ */
+}  // namespace hs::mem
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/hs_macro.hpp>
+#include <hs/mem/mem_heap_api.hpp>
+
+namespace hs::mem {
+/**
+ * \defgroup arena_api Arena API
+ * \short API providing bump allocation with scoped lifetime.
+ *
+ * An Arena reserves a virtual range up front and backs it with memory from the heap, 64KiB at a time, as its bump pointer advances.
+ * Allocations cannot be freed individually, instead a position can be saved with Arena::Mark and restored with Arena::Rewind, or the whole Arena can be emptied with Arena::Reset.
+ *
+ * \ingroup mem_api
+ * \name Arena API
+ * \addtogroup arena_api
+ * @{
+ */
+
+/**
+ * \short A position in an Arena returned by Arena::Mark.
+ */
+typedef size_t ArenaMarker;
+
+/**
+ * \short The size of the virtual range reserved by the arena of every Thread.
+ */
+const size_t THREAD_ARENA_SIZE = 0x1000000;
+
+/**
+ * \short The granule by which memory is committed to and released from an Arena.
+ */
+const size_t ARENA_COMMIT_SIZE = 0x10000;
+
+/**
+ * \short A bump allocator over a reserved virtual range.
+ *
+ * \remark An Arena isn't thread safe.
+ */
+class Arena {
+ private:
+    /**
+     * \private
+     * \short The start of the reserved virtual range.
+     */
+    uintptr_t address;
+
+    /**
+     * \private
+     * \short The size of the reserved virtual range.
+     */
+    size_t size;
+
+    /**
+     * \private
+     * \short The size of the memory backing the start of the range.
+     */
+    size_t committed_size;
+
+    /**
+     * \private
+     * \short The offset of the next allocation.
+     */
+    size_t current_offset;
+
+    /**
+     * \private
+     * \short The heap blocks mapped in the range, one per commit granule.
+     */
+    uintptr_t *backing_blocks;
+
+    bool Commit() noexcept;
+
+ public:
+    Arena() noexcept
+        : address(0),
+          size(0),
+          committed_size(0),
+          current_offset(0),
+          backing_blocks(nullptr) {}
+    __HS_DISALLOW_COPY(Arena);
+    __HS_DISALLOW_ASSIGN(Arena);
+
+    /**
+     * \short Reserve the virtual range of the Arena.
+     *
+     * \param[in] size The size of the virtual range in bytes.
+     *
+     * \return true if the range was reserved.
+     *
+     * \pre The Arena isn't initialized.
+     */
+    bool Initialize(size_t size) noexcept;
+
+    /**
+     * \short Give back the memory and the virtual range of the Arena.
+     *
+     * \pre The Arena is initialized.
+     * \post The Arena isn't initialized.
+     */
+    void Finalize() noexcept;
+
+    /**
+     * \short Allocate a block from the Arena.
+     *
+     * \param[in] size The size of the block in bytes.
+     * \param[in] alignment The alignment of the block in bytes.
+     *
+     * \return A pointer to the block or a null pointer if the Arena is full or the heap is exhausted.
+     *
+     * \pre ``alignment`` is a power of two.
+     */
+    void *Allocate(size_t size,
+                   size_t alignment = HEAP_MINIMAL_ALIGNMENT) noexcept;
+
+    /**
+     * \short Save the current position of the Arena.
+     */
+    inline ArenaMarker Mark() const noexcept { return this->current_offset; }
+
+    /**
+     * \short Free every block allocated since a call to Arena::Mark.
+     *
+     * \param[in] marker A value returned by Arena::Mark.
+     *
+     * \pre No Arena::Rewind to an earlier position happened since ``marker`` was obtained.
+     */
+    inline void Rewind(ArenaMarker marker) noexcept {
+        this->current_offset = marker;
+    }
+
+    /**
+     * \short Free every block of the Arena.
+     *
+     * \remark The memory backing the Arena is kept for the next allocations.
+     */
+    inline void Reset() noexcept { this->current_offset = 0; }
+
+    /**
+     * \short Give back the memory backing the Arena past its current position.
+     *
+     * \return The count of bytes given back to the heap.
+     * \remark The memory is released by granules, the granule holding the current position is kept.
+     */
+    size_t Trim() noexcept;
+
+    /**
+     * \short Get the count of bytes currently allocated from the Arena.
+     */
+    inline size_t GetUsedSize() const noexcept { return this->current_offset; }
+
+    /**
+     * \short Get the count of bytes of memory backing the Arena.
+     */
+    inline size_t GetCommittedSize() const noexcept {
+        return this->committed_size;
+    }
+};
+
+/**
+ * \short Rewind an Arena to its position at construction when going out of scope.
+ */
+class ArenaScope {
+ private:
+    Arena &arena;
+    ArenaMarker marker;
+
+ public:
+    explicit ArenaScope(Arena &arena) noexcept
+        : arena(arena), marker(arena.Mark()) {}
+    __HS_DISALLOW_COPY(ArenaScope);
+    __HS_DISALLOW_ASSIGN(ArenaScope);
+
+    ~ArenaScope() noexcept { this->arena.Rewind(this->marker); }
+};
+
+/**
+ * \short An allocator over an Arena, usable as the allocator of the library containers (see hs::util::ObjectPool).
+ *
+ * \remark Freeing a block is a no-op, the memory is reclaimed when the Arena is rewinded.
+ */
+class ArenaAllocator {
+ private:
+    Arena *arena;
+
+ public:
+    explicit ArenaAllocator(Arena *arena) noexcept : arena(arena) {}
+
+    inline void *Allocate(size_t size, size_t alignment) noexcept {
+        return this->arena->Allocate(size, alignment);
+    }
+
+    inline void Free(void *ptr) noexcept { __HS_IGNORE_ARGUMENT(ptr); }
+};
+
+/**
+ * \short Get the Arena of the current Thread.
+ *
+ * The Arena is created on first use with a virtual range of hs::mem::THREAD_ARENA_SIZE bytes and is finalized when the Thread exits.
+ *
+ * \return The Arena of the current Thread or a null pointer if it couldn't be created.
+ */
+Arena *GetThreadArena() noexcept;
+
+/**
+ * @}
+ */
+}  // namespace hs::mem
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+namespace hs::mem {
+/**
+ * \defgroup heap_api Heap API
+ * \short API managing the process heap.
+ *
+ * The heap is backed by hs::svc::SetHeapSize. Small blocks are served from segregated size classes cached per Thread, bigger blocks are directly carved out of the heap.
+ *
+ * \remark The C allocation functions (malloc, free...) and the global operator new/delete are implemented on top of this API.
+ * \ingroup mem_api
+ * \name Heap API
+ * \addtogroup heap_api
+ * @{
+ */
+
+/**
+ * \short The alignment guaranteed for every block returned by the heap.
+ */
+const size_t HEAP_MINIMAL_ALIGNMENT = 0x10;
+
+/**
+ * \short The biggest alignment hs::mem::AllocateAligned can satisfy.
+ */
+const size_t HEAP_MAXIMUM_ALIGNMENT = 0x8000;
+
+/**
+ * \short The size from which heap blocks start on a multiple of their own size.
+ *
+ * The heap grows by multiple of this size, blocks of at least this size are placed on a boundary of it so that the kernel can map them with large page table blocks, reducing the TLB pressure of accessing them.
+ */
+const size_t HEAP_LARGE_BLOCK_SIZE = 0x200000;
+
+/**
+ * \short The biggest block size served from a size class of the heap.
+ */
+const size_t HEAP_SMALL_BLOCK_SIZE_MAX = 0x2000;
+
+/**
+ * \short Get the size class serving the blocks of a given size.
+ *
+ * Size classes are 16 bytes apart up to 128 bytes, then every power of two band is split in 4 classes up to hs::mem::HEAP_SMALL_BLOCK_SIZE_MAX.
+ *
+ * \param[in] size The size of the block in bytes.
+ *
+ * \pre ``size`` is at most hs::mem::HEAP_SMALL_BLOCK_SIZE_MAX.
+ *
+ * \return The index of the size class.
+ */
+constexpr size_t GetHeapSizeClass(size_t size) noexcept {
+    if (size <= 0x80) {
+        return size == 0 ? 0 : ((size + 0xF) >> 4) - 1;
+    }
+
+    unsigned int value = static_cast<unsigned int>(size - 1);
+    unsigned int most_significant_bit = 31 - __builtin_clz(value);
+
+    return 8 + (most_significant_bit - 7) * 4 +
+           ((value >> (most_significant_bit - 2)) & 3);
+}
+
+/**
+ * \short Allocate a block from the heap.
+ *
+ * \param[in] size The size of the block in bytes.
+ *
+ * \return A pointer to a block of at least ``size`` bytes aligned to hs::mem::HEAP_MINIMAL_ALIGNMENT or a null pointer if the heap is exhausted.
+ */
+void *Allocate(size_t size) noexcept;
+
+/**
+ * \short Allocate an aligned block from the heap.
+ *
+ * \param[in] size The size of the block in bytes.
+ * \param[in] alignment The alignment of the block in bytes.
+ *
+ * \pre ``alignment`` is a power of two.
+ *
+ * \return A pointer to a block of at least ``size`` bytes aligned to ``alignment`` or a null pointer if the heap is exhausted or ``alignment`` is bigger than hs::mem::HEAP_MAXIMUM_ALIGNMENT.
+ */
+void *AllocateAligned(size_t size, size_t alignment) noexcept;
+
+/**
+ * \short Change the size of a block allocated from the heap.
+ *
+ * The content of the block is preserved up to the lesser of the new and old sizes.
+ *
+ * \param[in] ptr A pointer to a block allocated from the heap or a null pointer.
+ * \param[in] size The new size of the block in bytes.
+ *
+ * \return A pointer to the resized block or a null pointer if the heap is exhausted (in which case ``ptr`` is left untouched).
+ */
+void *Reallocate(void *ptr, size_t size) noexcept;
+
+/**
+ * \short Return a block to the heap.
+ *
+ * \param[in] ptr A pointer to a block allocated from the heap or a null pointer.
+ *
+ * \pre ``ptr`` wasn't already freed.
+ * \post ``ptr`` must not be used anymore.
+ */
+void Free(void *ptr) noexcept;
+
+/**
+ * \short Get the usable size of a block allocated from the heap.
+ *
+ * \param[in] ptr A pointer to a block allocated from the heap.
+ *
+ * \return The number of bytes that can be used from ``ptr``, which is at least the size that was requested.
+ */
+size_t GetAllocationSize(const void *ptr) noexcept;
+
+/**
+ * \short An allocator over the heap, usable as the allocator of the library containers (see hs::util::ObjectPool).
+ */
+class HeapAllocator {
+ public:
+    inline void *Allocate(size_t size, size_t alignment) noexcept {
+        return AllocateAligned(size, alignment);
+    }
+
+    inline void Free(void *ptr) noexcept { hs::mem::Free(ptr); }
+};
+
+/**
+ * \short Give the free memory at the end of the heap back to the kernel.
+ *
+ * The objects cached by the current Thread and the empty slabs kept by the heap are released first, then the heap is shrunk with hs::svc::SetHeapSize down to its last used block.
+ *
+ * \return The count of bytes given back to the kernel.
+ * \remark The kernel can only shrink the heap from its end by multiple of hs::mem::HEAP_LARGE_BLOCK_SIZE, free memory in the middle of the heap is kept.
+ * \remark The objects cached by the other Threads are not released.
+ */
+size_t TrimHeap() noexcept;
+
+/**
+ * @}
+ */
+
+}  // namespace hs::mem
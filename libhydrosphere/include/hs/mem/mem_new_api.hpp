@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include <hs/hs_macro.hpp>
+#include <hs/mem/mem_heap_api.hpp>
+#include <hs/util/util_std_new.hpp>
+#include <hs/util/util_template_api.hpp>
+
+namespace hs::mem {
+namespace detail {
+/**
+ * \private
+ * \short Allocate an object of a small size class from the heap.
+ */
+void *AllocateSizeClass(size_t size_class) noexcept;
+
+/**
+ * \private
+ * \short Return an object of a small size class to the heap.
+ */
+void FreeSizeClass(void *ptr, size_t size_class) noexcept;
+
+/**
+ * \private
+ * \short Allocate a block whose size and alignment are known at compile time.
+ */
+template <size_t Size, size_t Alignment>
+__HS_ATTRIBUTE_ALWAYS_INLINE inline void *AllocateStatic() noexcept {
+    if constexpr (Alignment <= HEAP_MINIMAL_ALIGNMENT &&
+                  Size <= HEAP_SMALL_BLOCK_SIZE_MAX) {
+        constexpr size_t size_class = GetHeapSizeClass(Size);
+
+        return AllocateSizeClass(size_class);
+    } else {
+        return AllocateAligned(Size, Alignment);
+    }
+}
+
+/**
+ * \private
+ * \short Free a block allocated by AllocateStatic with the same parameters.
+ */
+template <size_t Size, size_t Alignment>
+__HS_ATTRIBUTE_ALWAYS_INLINE inline void FreeStatic(void *ptr) noexcept {
+    if constexpr (Alignment <= HEAP_MINIMAL_ALIGNMENT &&
+                  Size <= HEAP_SMALL_BLOCK_SIZE_MAX) {
+        constexpr size_t size_class = GetHeapSizeClass(Size);
+
+        FreeSizeClass(ptr, size_class);
+    } else {
+        Free(ptr);
+    }
+}
+}  // namespace detail
+
+/**
+ * \defgroup new_api Object API
+ * \short API allocating objects from the heap.
+ *
+ * The size class of the objects is resolved at compile time, allocating and freeing a small object goes straight to the free list of its size class without looking up the size class or the span of the block.
+ *
+ * \ingroup mem_api
+ * \name Object API
+ * \addtogroup new_api
+ * @{
+ */
+
+/**
+ * \short Allocate and construct an object from the heap.
+ *
+ * \tparam T The type of the object.
+ * \param[in] args The arguments given to the constructor of T.
+ *
+ * \return A pointer to the new object or a null pointer if the heap is exhausted.
+ */
+template <typename T, typename... Args>
+__HS_ATTRIBUTE_ALWAYS_INLINE inline T *New(Args &&... args) noexcept {
+    void *storage = detail::AllocateStatic<sizeof(T), alignof(T)>();
+
+    if (storage == nullptr) {
+        return nullptr;
+    }
+
+    return new (storage) T(hs::util::Forward<Args>(args)...);
+}
+
+/**
+ * \short Destruct and free an object allocated with hs::mem::New.
+ *
+ * \param[in] object A pointer returned by hs::mem::New<T> or a null pointer.
+ *
+ * \pre The dynamic type of ``object`` is T.
+ * \post ``object`` must not be used anymore.
+ */
+template <typename T>
+__HS_ATTRIBUTE_ALWAYS_INLINE inline void Delete(T *object) noexcept {
+    if (object == nullptr) {
+        return;
+    }
+
+    object->~T();
+    detail::FreeStatic<sizeof(T), alignof(T)>(object);
+}
+
+/**
+ * @}
+ */
+}  // namespace hs::mem
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include <hs/util/util_intrusive_list.hpp>
+
+namespace hs::mem {
+/**
+ * \defgroup pressure_api Memory Pressure API
+ * \short API letting subsystems release memory when the heap runs low.
+ *
+ * Subsystems holding memory they can rebuild (caches, pools...) register a MemoryPressureCallback.
+ * The callbacks are invoked, and the heap is trimmed with hs::mem::TrimHeap, when:
+ *
+ * - The heap is exhausted, the allocation is then tried again once.
+ * - The heap grew while the memory accounted under MemoryTag::Heap is over the budget set with hs::mem::SetHeapMemoryBudget.
+ * - hs::mem::NotifyMemoryPressure is called.
+ *
+ * The callbacks are invoked by one Thread at a time, the other Threads under pressure wait for it to complete.
+ * A callback must therefore not wait for another Thread that may allocate memory.
+ *
+ * \ingroup mem_api
+ * \name Memory Pressure API
+ * \addtogroup pressure_api
+ * @{
+ */
+
+/**
+ * \short Memory pressure callback function type.
+ * \arg ``argument``: argument given to hs::mem::RegisterMemoryPressureCallback.
+ */
+typedef void (*MemoryPressureFunction)(void *argument);
+
+/**
+ * \short This is the context of a memory pressure callback.
+ *
+ * See \ref pressure_api "Memory Pressure API" for usages.
+ **/
+struct MemoryPressureCallback : public hs::util::IntrusiveListElement<> {
+    /**
+     * \private
+     * \short The function to invoke.
+     */
+    MemoryPressureFunction function;
+
+    /**
+     * \private
+     * \short The argument given to the function.
+     */
+    void *argument;
+};
+
+/**
+ * \short Register a memory pressure callback.
+ *
+ * \param[in] callback A pointer to a MemoryPressureCallback.
+ * \param[in] function The function to invoke under memory pressure.
+ * \param[in] argument The argument to pass to ``function``.
+ *
+ * \pre ``callback`` isn't registered.
+ * \remark The callbacks are invoked on the Thread that hit the memory pressure, from inside the allocation functions. They must only release memory and must not register or unregister callbacks.
+ */
+void RegisterMemoryPressureCallback(MemoryPressureCallback *callback,
+                                    MemoryPressureFunction function,
+                                    void *argument) noexcept;
+
+/**
+ * \short Unregister a memory pressure callback.
+ *
+ * \param[in] callback A pointer to a MemoryPressureCallback.
+ *
+ * \pre ``callback`` is registered.
+ * \post ``callback`` isn't invoked anymore.
+ */
+void UnregisterMemoryPressureCallback(
+    MemoryPressureCallback *callback) noexcept;
+
+/**
+ * \short Set the count of bytes accounted under MemoryTag::Heap above which the heap is under pressure.
+ *
+ * The budget is checked every time the heap grows.
+ *
+ * \param[in] budget The budget in bytes, 0 disables the budget (this is the default).
+ */
+void SetHeapMemoryBudget(size_t budget) noexcept;
+
+/**
+ * \short Invoke the memory pressure callbacks and trim the heap.
+ *
+ * \return The count of bytes given back to the kernel by the heap trim.
+ * \remark If another Thread is already invoking the callbacks, this waits for it to complete and returns 0.
+ * \remark Nothing is done if called from a callback.
+ */
+size_t NotifyMemoryPressure() noexcept;
+
+/**
+ * @}
+ */
+}  // namespace hs::mem
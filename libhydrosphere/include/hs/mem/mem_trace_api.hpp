@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace hs::mem {
+/**
+ * \defgroup trace_api Allocation Trace API
+ * \short API recording the allocations of the heap to find where they come from.
+ *
+ * When enabled, every allocation and free of the heap is recorded with its tick, size and return address in a ring buffer owned by the current Thread.
+ * A ring buffer is flushed to the trace sink when it is full, when hs::mem::FlushAllocationTrace is called and when its Thread exits.
+ *
+ * The trace is a sequence of chunks, each made of an AllocationTraceHeader followed by its AllocationTraceRecord, all little endian.
+ * The default sink outputs the chunks to hs::svc::OutputDebugString as lines prefixed with ``hsat:`` and followed by the bytes in hexadecimal.
+ * The ``allocation_trace`` tool shipped with Hydrosphère turns the trace into flame graph input or a per call site report.
+ *
+ * \ingroup mem_api
+ * \name Allocation Trace API
+ * \addtogroup trace_api
+ * @{
+ */
+
+/**
+ * \short The magic of an AllocationTraceHeader ("HSAT").
+ */
+const uint32_t ALLOCATION_TRACE_MAGIC = 0x54415348;
+
+/**
+ * \short The version of the trace format.
+ */
+const uint16_t ALLOCATION_TRACE_VERSION = 2;
+
+/**
+ * \short The count of records buffered per Thread.
+ */
+const size_t ALLOCATION_TRACE_BUFFER_RECORD_COUNT = 0x80;
+
+/**
+ * \short The kind of a traced event.
+ */
+enum class AllocationTraceEvent : uint32_t {
+    /**
+     * \short A block was allocated.
+     */
+    Allocate = 0,
+    /**
+     * \short A block was freed.
+     */
+    Free = 1
+};
+
+/**
+ * \short The header of a chunk of trace.
+ */
+struct AllocationTraceHeader {
+    /**
+     * \short hs::mem::ALLOCATION_TRACE_MAGIC.
+     */
+    uint32_t magic;
+
+    /**
+     * \short hs::mem::ALLOCATION_TRACE_VERSION.
+     */
+    uint16_t version;
+
+    /**
+     * \short The count of records following the header.
+     */
+    uint16_t record_count;
+
+    /**
+     * \short An identifier of the Thread that recorded the chunk, unique among the running Threads.
+     */
+    uint64_t thread_id;
+
+    /**
+     * \short The name of the Thread that recorded the chunk.
+     */
+    char thread_name[0x20];
+};
+
+static_assert(sizeof(AllocationTraceHeader) == 0x30,
+              "invalid AllocationTraceHeader size");
+
+/**
+ * \short A traced event.
+ */
+struct AllocationTraceRecord {
+    /**
+     * \short The system tick of the event.
+     */
+    uint64_t tick;
+
+    /**
+     * \short The address the allocation function was called from.
+     */
+    uint64_t return_address;
+
+    /**
+     * \short The address of the block.
+     */
+    uint64_t address;
+
+    /**
+     * \short The usable size of the block in bytes.
+     */
+    uint64_t size;
+
+    /**
+     * \short The kind of the event.
+     */
+    AllocationTraceEvent event;
+
+    /**
+     * \short Reserved, always zero.
+     */
+    uint32_t reserved;
+};
+
+static_assert(sizeof(AllocationTraceRecord) == 0x28,
+              "invalid AllocationTraceRecord size");
+
+/**
+ * \short Allocation trace sink function type.
+ * \arg ``argument``: argument given to hs::mem::SetAllocationTraceSink.
+ * \arg ``data``: a chunk of trace.
+ * \arg ``size``: the size of the chunk in bytes.
+ */
+typedef void (*AllocationTraceSink)(void *argument, const void *data,
+                                    size_t size);
+
+/**
+ * \short Enable or disable the allocation tracing.
+ *
+ * \param[in] is_enabled true to record the allocations from now on.
+ */
+void SetAllocationTracing(bool is_enabled) noexcept;
+
+/**
+ * \short Set the function receiving the trace.
+ *
+ * \param[in] sink The function receiving the chunks of trace, a null pointer restores the default sink using hs::svc::OutputDebugString.
+ * \param[in] argument The argument to pass to ``sink``.
+ *
+ * \remark The sink is called by the Thread owning the flushed buffer, it may be called concurrently by several Threads. The allocations done by the sink are not traced.
+ */
+void SetAllocationTraceSink(AllocationTraceSink sink, void *argument) noexcept;
+
+/**
+ * \short Flush the trace buffered by the current Thread to the sink.
+ */
+void FlushAllocationTrace() noexcept;
+
+/**
+ * @}
+ */
+}  // namespace hs::mem
@@ -15,12 +15,21 @@
  * \short Module containing the core interactions with the operating system.
  **/
 
+#include <hs/os/os_address_arbiter_api.hpp>
 #include <hs/os/os_api.hpp>
 #include <hs/os/os_barrier_api.hpp>
 #include <hs/os/os_condition_variable_api.hpp>
 #include <hs/os/os_critical_section.hpp>
 #include <hs/os/os_kernel_event_api.hpp>
+#include <hs/os/os_light_event_api.hpp>
+#include <hs/os/os_memory_map_api.hpp>
+#include <hs/os/os_mirrored_ring_buffer_api.hpp>
+#include <hs/os/os_multi_wait_api.hpp>
 #include <hs/os/os_mutex_api.hpp>
+#include <hs/os/os_reader_writer_lock_api.hpp>
+#include <hs/os/os_semaphore_api.hpp>
+#include <hs/os/os_shared_memory_api.hpp>
 #include <hs/os/os_thread_api.hpp>
+#include <hs/os/os_transfer_memory_api.hpp>
 #include <hs/os/os_types.hpp>
 #include <hs/os/os_user_event_api.hpp>
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+namespace hs::os {
+/**
+ * \defgroup address_arbiter_api Address Arbiter API
+ * \short API to block threads on a 32 bits value in memory until another thread signals it.
+ *
+ * The kernel compares (and updates) the value and queues the thread atomically, a thread can't miss a signal sent after the value it waits on was changed.
+ * This allows synchronization primitives to keep their state in a single word, only reaching the kernel when a thread has to sleep or to be woken.
+ *
+ * \remark A negative timeout waits forever.
+ * \remark This requires the 4.0.0 kernel or later.
+ * \ingroup os_api
+ * \name Address Arbiter API
+ * \addtogroup address_arbiter_api
+ * @{
+ */
+
+/**
+ * \short Type that indicates why a wait on an address returned.
+ */
+enum class AddressWaitStatus {
+    /**
+     * \short The thread was signaled.
+     */
+    Signaled = 0,
+    /**
+     * \short The timeout expired before the thread was signaled.
+     */
+    TimedOut = 1,
+    /**
+     * \short The value didn't satisfy the condition, the thread didn't wait.
+     */
+    ValueMismatch = 2,
+};
+
+/**
+ * \short Wait on an address while it holds a given value.
+ *
+ * \param[in] address The address to wait on.
+ * \param[in] value The value the address must hold to wait.
+ * \param[in] timeout The number of nanoseconds before timing out.
+ */
+AddressWaitStatus WaitForAddressIfEqual(volatile _Atomic(int32_t) *address,
+                                        int32_t value,
+                                        int64_t timeout) noexcept;
+
+/**
+ * \short Wait on an address while it holds a value less than a given value.
+ *
+ * \param[in] address The address to wait on.
+ * \param[in] value The value the address must be less than to wait.
+ * \param[in] timeout The number of nanoseconds before timing out.
+ */
+AddressWaitStatus WaitForAddressIfLessThan(volatile _Atomic(int32_t) *address,
+                                           int32_t value,
+                                           int64_t timeout) noexcept;
+
+/**
+ * \short Decrement the value of an address and wait on it if it was less than a given value.
+ *
+ * \param[in] address The address to wait on.
+ * \param[in] value The value the address must be less than to be decremented and to wait.
+ * \param[in] timeout The number of nanoseconds before timing out.
+ */
+AddressWaitStatus DecrementAndWaitForAddressIfLessThan(
+    volatile _Atomic(int32_t) *address, int32_t value,
+    int64_t timeout) noexcept;
+
+/**
+ * \short Wake threads waiting on an address.
+ *
+ * \param[in] address The address the threads wait on.
+ * \param[in] count The count of threads to wake, all of them if less or equal to 0.
+ */
+void SignalToAddress(volatile _Atomic(int32_t) *address,
+                     int32_t count) noexcept;
+
+/**
+ * \short Increment the value of an address and wake threads waiting on it if it holds a given value.
+ *
+ * \param[in] address The address the threads wait on.
+ * \param[in] value The value the address must hold.
+ * \param[in] count The count of threads to wake, all of them if less or equal to 0.
+ *
+ * \return false if the address didn't hold ``value``, nothing was done.
+ */
+bool SignalToAddressAndIncrementIfEqual(volatile _Atomic(int32_t) *address,
+                                        int32_t value, int32_t count) noexcept;
+
+/**
+ * \short Wake threads waiting on an address if it holds a given value, and modify it depending on the count of waiters.
+ *
+ * If nobody waits, the value is incremented. If ``count`` or less threads wait (or all of them are woken), the value is decremented. Otherwise the value is left untouched.
+ *
+ * \param[in] address The address the threads wait on.
+ * \param[in] value The value the address must hold.
+ * \param[in] count The count of threads to wake, all of them if less or equal to 0.
+ *
+ * \return false if the address didn't hold ``value``, nothing was done.
+ */
+bool SignalToAddressAndModifyByWaitingCountIfEqual(
+    volatile _Atomic(int32_t) *address, int32_t value, int32_t count) noexcept;
+
+/**
+ * @}
+ */
+}  // namespace hs::os
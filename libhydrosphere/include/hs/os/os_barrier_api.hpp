@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <stdatomic.h>
 #include <stdint.h>
 
 #include <hs/os/os_condition_variable_impl.hpp>
@@ -20,12 +21,49 @@ namespace hs::os {
 /**
  * \defgroup barrier_api Barrier API
  * \short API implementing the barrier synchronization primitive.
+ *
+ * A Barrier is reusable: once the last participating thread arrived, the barrier is ready for the next phase.
+ * Arriving at a Barrier is a single atomic operation, the threads waiting for the others can spin for a while before blocking.
+ * With many participating threads, a combining tree of BarrierNode spreads the arrivals over several cache lines.
+ *
  * \ingroup os_api
  * \name Barrier API
  * \addtogroup barrier_api
  * @{
  */
 
+/**
+ * \short The count of threads or nodes arriving at a node of a combining tree.
+ */
+static const uint32_t BARRIER_TREE_FAN_IN = 4;
+
+/**
+ * \short This is a node of the combining tree of a barrier.
+ *
+ * See \ref barrier_api "Barrier API" for usages.
+ **/
+struct BarrierNode {
+    /**
+     * \private
+     * \short Number of threads or nodes that arrived at the node.
+     */
+    alignas(0x40) volatile _Atomic(uint32_t) arrive_count;
+
+    /**
+     * \private
+     * \short Number of threads or nodes arriving at the node.
+     */
+    uint32_t number_to_wait;
+
+    /**
+     * \private
+     * \short The index of the parent of the node.
+     */
+    uint32_t parent_index;
+};
+
+static_assert(hs::util::is_pod<BarrierNode>::value, "BarrierNode isn't pod");
+
 /**
  * \short This is the context of a barrier.
  * 
@@ -44,16 +82,34 @@ struct Barrier {
 
     /**
      * \private
-     * \short Number of threads needed to release the barrier.
+     * \short Number of threads that arrived during the current phase.
      */
-    uint32_t arrive_count;
+    volatile _Atomic(uint32_t) arrive_count;
 
     /**
      * \private
-     * \short Number of threads actually waiting.
+     * \short Number of threads needed to release the barrier.
      */
     uint32_t number_to_wait;
 
+    /**
+     * \private
+     * \short The phase of the barrier, incremented when it is released.
+     */
+    volatile _Atomic(uint32_t) generation;
+
+    /**
+     * \private
+     * \short The count of spins done before blocking.
+     */
+    uint32_t spin_count;
+
+    /**
+     * \private
+     * \short The combining tree of the barrier, null if there is none.
+     */
+    BarrierNode *nodes;
+
     /**
      * \private
      * \short The critical section of the barrier.
@@ -69,6 +125,24 @@ struct Barrier {
 
 static_assert(hs::util::is_pod<Barrier>::value, "Barrier isn't pod");
 
+/**
+ * \short Get the count of BarrierNode in the combining tree of a barrier.
+ *
+ * \param[in] number_to_wait The number of threads the barrier need to wait on.
+ */
+constexpr uint32_t GetBarrierNodeCount(uint32_t number_to_wait) noexcept {
+    uint32_t node_count = 0;
+    uint32_t level_node_count = number_to_wait;
+
+    do {
+        level_node_count =
+            (level_node_count + BARRIER_TREE_FAN_IN - 1) / BARRIER_TREE_FAN_IN;
+        node_count += level_node_count;
+    } while (level_node_count > 1);
+
+    return node_count;
+}
+
 /**
  * \short Initialize a Barrier for \c num_to_wait participating threads.
  *
@@ -83,16 +157,56 @@ static_assert(hs::util::is_pod<Barrier>::value, "Barrier isn't pod");
  */
 void InitializeBarrier(Barrier *barrier, uint32_t number_to_wait) noexcept;
 
+/**
+ * \short Initialize a Barrier for \c num_to_wait participating threads, arriving at a combining tree.
+ *
+ * \remark Every participating thread must arrive with its own index, see AwaitBarrier(Barrier *, uint32_t).
+ *
+ * \param[in] barrier A pointer to a Barrier.
+ * \param[in] number_to_wait The number of threads this barrier need to wait on.
+ * \param[in] nodes The storage of the combining tree, GetBarrierNodeCount(number_to_wait) nodes.
+ *
+ * \pre ``number_to_wait`` > 0
+ * \pre ``barrier`` is uninitialized.
+ * \post ``barrier`` is initialized.
+ */
+void InitializeBarrier(Barrier *barrier, uint32_t number_to_wait,
+                       BarrierNode *nodes) noexcept;
+
+/**
+ * \short Set the count of spins done by the threads waiting at a Barrier before blocking.
+ *
+ * \remark Spinning pays off when every participating thread runs on its own core, it is disabled by default.
+ *
+ * \param[in] barrier A pointer to a Barrier.
+ * \param[in] spin_count The count of spins, 0 never spins.
+ *
+ * \pre ``barrier`` is initialized.
+ */
+void SetBarrierSpinCount(Barrier *barrier, uint32_t spin_count) noexcept;
+
 /**
  * \short Blocks and arrive at the barrier's synchronization point.
  *
  * \param[in] barrier A pointer to a Barrier.
  * 
- * \pre ``barrier`` is initialized.
+ * \pre ``barrier`` is initialized without a combining tree.
  * \post The thread arrived at the barrier's synchronization point.
  */
 void AwaitBarrier(Barrier *barrier) noexcept;
 
+/**
+ * \short Blocks and arrive at the barrier's synchronization point.
+ *
+ * \param[in] barrier A pointer to a Barrier.
+ * \param[in] participant_index The index of the thread among the participating threads.
+ * 
+ * \pre ``barrier`` is initialized.
+ * \pre ``participant_index`` < the number of threads the barrier waits on, and no other thread arrives with it during the phase.
+ * \post The thread arrived at the barrier's synchronization point.
+ */
+void AwaitBarrier(Barrier *barrier, uint32_t participant_index) noexcept;
+
 /**
  * \short Finalize a Barrier.
  *
@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <stdatomic.h>
 #include <stdint.h>
 
 #include <hs/hs_macro.hpp>
@@ -21,10 +22,11 @@ namespace hs::os {
  * \short Condition Variable implementation.
  * 
  * \remark A condition variable is an object able to block the calling thread until notified to resume.
+ * \remark Signaling a condition variable nobody waits on doesn't reach the kernel. The state the waiters check must be changed with the critical section held, before signaling.
  */
 class ConditionVariableImpl {
  private:
-    uint_fast32_t image;
+    volatile _Atomic(uint_fast32_t) image;
 
  public:
     /**
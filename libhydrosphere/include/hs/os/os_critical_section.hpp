@@ -17,10 +17,31 @@
 #include <hs/util/util_template_api.hpp>
 
 namespace hs::os {
+/**
+ * \short The spin state of a lock entering a CriticalSection.
+ *
+ * \remark The spin count is tuned on every contended entry to follow the time the lock is usually held, bounded by the spin limit.
+ */
+struct CriticalSectionSpinState {
+    /**
+     * \short The maximum count of spins before blocking, 0 never spins.
+     */
+    uint8_t spin_limit;
+
+    /**
+     * \short The count of spins it usually takes to enter.
+     */
+    uint8_t spin_count;
+};
+
+static_assert(hs::util::is_pod<CriticalSectionSpinState>::value,
+              "CriticalSectionSpinState isn't pod");
+
 /**
  * \short Critical Section implementation.
  * 
  * \remark CriticalSection ensures mutual exclusion of access.
+ * \remark When the critical section is owned, entering spins for a while before blocking, as the owner usually leaves it soon. No thread spins once some other thread blocks on it.
  */
 class CriticalSection {
  private:
@@ -29,9 +50,18 @@ class CriticalSection {
  public:
     /**
      * \short Enter the critical section.
+     *
+     * \remark This spins up to the count returned by GetCriticalSectionSpinCount before blocking.
      */
     void Enter() noexcept;
 
+    /**
+     * \short Enter the critical section, spinning as told by a spin state before blocking.
+     *
+     * \param[in,out] spin_state The spin state of the lock, updated with the count of spins it took to enter.
+     */
+    void Enter(CriticalSectionSpinState *spin_state) noexcept;
+
     /**
      * \short Try to enter the critical section.
      */
@@ -51,4 +81,18 @@ class CriticalSection {
 static_assert(hs::util::is_pod<CriticalSection>::value,
 "CriticalSection isn't pod");
 
+/**
+ * \short Set the count of spins done by CriticalSection::Enter before blocking.
+ *
+ * \param[in] spin_count The count of spins, 0 never spins.
+ *
+ * \remark This also is the spin limit of the locks initialized afterward.
+ */
+void SetCriticalSectionSpinCount(uint32_t spin_count) noexcept;
+
+/**
+ * \short Get the count of spins done by CriticalSection::Enter before blocking.
+ */
+uint32_t GetCriticalSectionSpinCount() noexcept;
+
 }  // namespace hs::os
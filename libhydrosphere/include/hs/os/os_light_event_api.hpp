@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include <hs/util/util_template_api.hpp>
+
+namespace hs::os {
+/**
+ * \defgroup light_event_api Light Event API
+ * \short API implementing a user event whose state lives in a single word.
+ *
+ * Signaling, polling and clearing a LightEvent are single atomic operations, the kernel is only reached to put a thread to sleep or to wake it.
+ * Signaling an auto clear LightEvent wakes exactly one waiter, which clears it.
+ *
+ * \remark This API is used to share events between threads in the same process.
+ * \remark This requires the 4.0.0 kernel or later, see \ref address_arbiter_api "Address Arbiter API".
+ * \ingroup os_api
+ * \name Light Event API
+ * \addtogroup light_event_api
+ * @{
+ */
+
+/**
+ * \short This is the context of a light event.
+ *
+ * See \ref light_event_api "Light Event API" for usages.
+ **/
+struct LightEvent {
+    /**
+     * \private
+     * \short Internal object state.
+     */
+    uint8_t state;
+
+    /**
+     * \private
+     * \short True if the LightEvent must be automatically cleared after a wait operation.
+     */
+    bool is_auto_clear;
+
+    /**
+     * \private
+     * \short Reserved for future usages.
+     */
+    char reserved[2];
+
+    /**
+     * \private
+     * \short The signal state of the LightEvent, the kernel arbitrates the waiters on it.
+     */
+    volatile _Atomic(int32_t) signal_state;
+};
+
+static_assert(hs::util::is_pod<LightEvent>::value, "LightEvent isn't pod");
+
+/**
+ * \short Initialize a LightEvent.
+ *
+ * \param[in] event A pointer to a LightEvent.
+ * \param[in] is_signaled True if the LightEvent must be signaled after the initialization.
+ * \param[in] is_auto_clear True if the LightEvent must be automatically cleared after a wait operation.
+ *
+ * \pre ``event`` is uninitialized.
+ * \post ``event`` is initialized.
+ */
+void InitializeLightEvent(LightEvent *event, bool is_signaled,
+                          bool is_auto_clear) noexcept;
+
+/**
+ * \short Wait a signal on a LightEvent.
+ *
+ * \param[in] event A pointer to a LightEvent.
+ *
+ * \pre ``event`` is initialized.
+ * \post The ``event`` has been signaled.
+ */
+void WaitLightEvent(LightEvent *event) noexcept;
+
+/**
+ * \short Wait a signal on a LightEvent, or until a timeout expires.
+ *
+ * \param[in] event A pointer to a LightEvent.
+ * \param[in] timeout The number of nanoseconds before timing out.
+ *
+ * \pre ``event`` is initialized.
+ *
+ * \return true if the ``event`` has been signaled, false if the timeout expired.
+ */
+bool TimedWaitLightEvent(LightEvent *event, int64_t timeout) noexcept;
+
+/**
+ * \short Get the signal state of a LightEvent.
+ *
+ * \param[in] event A pointer to a LightEvent.
+ *
+ * \remark This clears an auto clear LightEvent.
+ * \pre ``event`` is initialized.
+ *
+ * \return true if the ``event`` has been signaled.
+ */
+bool IsLightEventSignaled(LightEvent *event) noexcept;
+
+/**
+ * \short Signal a LightEvent.
+ *
+ * \param[in] event A pointer to a LightEvent.
+ *
+ * \pre ``event`` is initialized.
+ * \post The ``event`` has been signaled.
+ */
+void SignalLightEvent(LightEvent *event) noexcept;
+
+/**
+ * \short Clear the signal state of a LightEvent.
+ *
+ * \param[in] event A pointer to a LightEvent.
+ *
+ * \pre ``event`` is initialized.
+ * \post The ``event`` has been cleared.
+ */
+void ClearLightEvent(LightEvent *event) noexcept;
+
+/**
+ * \short Finalize a LightEvent.
+ *
+ * \param[in] event A pointer to a LightEvent.
+ *
+ * \pre ``event`` is initialized and nobody waits for it.
+ * \post ``event`` is uninitialized.
+ */
+void FinalizeLightEvent(LightEvent *event) noexcept;
+
+/**
+ * @}
+ */
+}  // namespace hs::os
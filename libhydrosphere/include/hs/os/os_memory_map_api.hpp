@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/svc/svc_types.hpp>
+#include <hs/util/util_template_api.hpp>
+
+namespace hs::os {
+/**
+ * \defgroup memory_map_api Memory Map API
+ * \short API querying the memory map of the process without kernel round-trips.
+ *
+ * The memory map is a snapshot of the process address space built with svc::QueryMemory at initialization.
+ * It is updated in place when Hydrosphère itself changes the address space and refreshed from the kernel when an operation shows it is out of date.
+ *
+ * \remark Changes made to the address space outside of Hydrosphère must be reported with hs::os::RefreshMemoryMap.
+ * \ingroup os_api
+ * \name Memory Map API
+ * \addtogroup memory_map_api
+ * @{
+ */
+
+/**
+ * \short A region of the memory map with uniform state.
+ */
+struct MemoryRegion {
+    /**
+     * \short The start address of the region.
+     */
+    uintptr_t address;
+
+    /**
+     * \short The size of the region in bytes.
+     */
+    size_t size;
+
+    /**
+     * \short The type of the memory of the region.
+     */
+    hs::svc::MemoryType type;
+
+    /**
+     * \short The attributes of the memory of the region (see hs::svc::MemoryAttribute).
+     */
+    uint32_t attribute;
+
+    /**
+     * \short The permission of the memory of the region.
+     */
+    hs::svc::MemoryPermission permission;
+};
+
+static_assert(hs::util::is_pod<MemoryRegion>::value, "MemoryRegion isn't pod");
+
+/**
+ * \short Get the region of the memory map containing an address.
+ *
+ * \param[in] out_region Where to write the region.
+ * \param[in] address The address to look up.
+ *
+ * \return false if the address is outside of the memory map.
+ */
+bool QueryMemoryMap(MemoryRegion *out_region, uintptr_t address) noexcept;
+
+/**
+ * \short Find an unmapped range inside a part of the address space.
+ *
+ * \param[in] out_address Where to write the start address of the range.
+ * \param[in] search_address The start address of the part of the address space to search.
+ * \param[in] search_size The size of the part of the address space to search.
+ * \param[in] size The size of the range in bytes.
+ * \param[in] alignment The alignment of the range in bytes.
+ *
+ * \return false if no unmapped range was found.
+ *
+ * \pre ``alignment`` is a power of two.
+ * \remark The range isn't reserved and may be mapped by someone else before it is used.
+ */
+bool FindFreeMemoryGap(uintptr_t *out_address, uintptr_t search_address,
+                       size_t search_size, size_t size,
+                       size_t alignment) noexcept;
+
+/**
+ * \short Refresh the memory map from the kernel.
+ *
+ * If the memory map ran out of room, it is rebuilt entirely and used again if
+ * the regions fit.
+ *
+ * \param[in] address The start address of the range to refresh.
+ * \param[in] size The size of the range to refresh.
+ */
+void RefreshMemoryMap(uintptr_t address, size_t size) noexcept;
+
+/**
+ * @}
+ */
+}  // namespace hs::os
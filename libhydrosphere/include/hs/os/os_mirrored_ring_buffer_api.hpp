@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/hs_result.hpp>
+#include <hs/svc/svc_types.hpp>
+#include <hs/util/util_template_api.hpp>
+
+namespace hs::os {
+/**
+ * \defgroup mirrored_ring_buffer_api Mirrored Ring Buffer API
+ * \short API implementing a single producer, single consumer ring buffer without wrap points.
+ *
+ * The memory of a MirroredRingBuffer is mapped twice, back to back. Any range of up to the capacity of the buffer starting inside the first mapping is contiguous, so reads and writes never have to be split at the end of the buffer.
+ *
+ * \remark The memory is backed by a shared memory object mapped twice in the address space of the process.
+ * \ingroup os_api
+ * \name Mirrored Ring Buffer API
+ * \addtogroup mirrored_ring_buffer_api
+ * @{
+ */
+
+/**
+ * \short This is the context of a mirrored ring buffer.
+ *
+ * See \ref mirrored_ring_buffer_api "Mirrored Ring Buffer API" for usages.
+ **/
+struct MirroredRingBuffer {
+    /**
+     * \private
+     * \short The handle of the shared memory backing the buffer.
+     */
+    svc::Handle shared_memory_handle;
+
+    /**
+     * \private
+     * \short The address of the first mapping, the second mapping follows it.
+     */
+    uintptr_t address;
+
+    /**
+     * \private
+     * \short The size of one mapping in bytes.
+     */
+    size_t capacity;
+
+    /**
+     * \private
+     * \short The position of the producer, in the range [0, 2 * capacity).
+     */
+    alignas(0x40) volatile _Atomic(size_t) write_index;
+
+    /**
+     * \private
+     * \short The position of the consumer, in the range [0, 2 * capacity).
+     */
+    alignas(0x40) volatile _Atomic(size_t) read_index;
+};
+
+static_assert(hs::util::is_pod<MirroredRingBuffer>::value,
+              "MirroredRingBuffer isn't pod");
+
+/**
+ * \short Create a MirroredRingBuffer.
+ *
+ * \param[in] ring_buffer A pointer to a MirroredRingBuffer.
+ * \param[in] capacity The size of the buffer in bytes.
+ *
+ * \return The result of the creation or the mapping of the shared memory, or an out of resources error if the address space is exhausted.
+ *
+ * \pre ``ring_buffer`` is uninitialized.
+ * \pre ``capacity`` is page aligned and not equal to 0.
+ * \post ``ring_buffer`` is initialized and empty.
+ */
+hs::Result CreateMirroredRingBuffer(MirroredRingBuffer *ring_buffer,
+                                    size_t capacity) noexcept;
+
+/**
+ * \short Destroy a MirroredRingBuffer.
+ *
+ * \param[in] ring_buffer A pointer to a MirroredRingBuffer.
+ *
+ * \pre ``ring_buffer`` is initialized.
+ * \post ``ring_buffer`` is uninitialized.
+ */
+void DestroyMirroredRingBuffer(MirroredRingBuffer *ring_buffer) noexcept;
+
+/**
+ * \short Get the free space of a MirroredRingBuffer, to be called by the producer.
+ *
+ * \param[in] ring_buffer A pointer to a MirroredRingBuffer.
+ * \param[in] out_size Where to write the count of bytes that can be written.
+ *
+ * \return A pointer to the contiguous free space of the buffer.
+ *
+ * \pre ``ring_buffer`` is initialized.
+ */
+void *BeginMirroredRingBufferWrite(MirroredRingBuffer *ring_buffer,
+                                   size_t *out_size) noexcept;
+
+/**
+ * \short Publish bytes written to a MirroredRingBuffer to the consumer.
+ *
+ * \param[in] ring_buffer A pointer to a MirroredRingBuffer.
+ * \param[in] size The count of bytes written at the pointer returned by hs::os::BeginMirroredRingBufferWrite.
+ *
+ * \pre ``ring_buffer`` is initialized.
+ * \pre ``size`` is at most the size returned by the last call to hs::os::BeginMirroredRingBufferWrite.
+ */
+void EndMirroredRingBufferWrite(MirroredRingBuffer *ring_buffer,
+                                size_t size) noexcept;
+
+/**
+ * \short Get the published bytes of a MirroredRingBuffer, to be called by the consumer.
+ *
+ * \param[in] ring_buffer A pointer to a MirroredRingBuffer.
+ * \param[in] out_size Where to write the count of bytes that can be read.
+ *
+ * \return A pointer to the contiguous published bytes of the buffer.
+ *
+ * \pre ``ring_buffer`` is initialized.
+ */
+const void *BeginMirroredRingBufferRead(MirroredRingBuffer *ring_buffer,
+                                        size_t *out_size) noexcept;
+
+/**
+ * \short Give bytes read from a MirroredRingBuffer back to the producer.
+ *
+ * \param[in] ring_buffer A pointer to a MirroredRingBuffer.
+ * \param[in] size The count of bytes read at the pointer returned by hs::os::BeginMirroredRingBufferRead.
+ *
+ * \pre ``ring_buffer`` is initialized.
+ * \pre ``size`` is at most the size returned by the last call to hs::os::BeginMirroredRingBufferRead.
+ */
+void EndMirroredRingBufferRead(MirroredRingBuffer *ring_buffer,
+                               size_t size) noexcept;
+
+/**
+ * @}
+ */
+}  // namespace hs::os
@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/os/os_condition_variable_impl.hpp>
+#include <hs/os/os_critical_section.hpp>
+#include <hs/os/os_kernel_event_api.hpp>
+#include <hs/os/os_thread_api.hpp>
+#include <hs/os/os_user_event_api.hpp>
+#include <hs/svc.hpp>
+#include <hs/util/util_template_api.hpp>
+
+namespace hs::os {
+/**
+ * \defgroup multi_wait_api Multi Wait API
+ * \short API to wait for any of several synchronization objects at once.
+ *
+ * A MultiWaitHolder is initialized for a synchronization object and linked to a MultiWait, waiting on the MultiWait returns the first holder whose object is signaled.
+ * The kernel objects (handles, KernelEvent and Thread exits) are waited on with a single syscall, the user objects (UserEvent) notify the MultiWait when signaled.
+ *
+ * \remark Waiting doesn't clear the signaled object, the caller is expected to wait on it (or clear it) afterward.
+ * \remark Holders must be linked and unlinked while nobody waits on the MultiWait.
+ * \ingroup os_api
+ * \name Multi Wait API
+ * \addtogroup multi_wait_api
+ * @{
+ */
+
+/**
+ * \short The maximum count of kernel objects linked to a MultiWait.
+ */
+static const int32_t MULTI_WAIT_HANDLE_COUNT_MAX = 64;
+
+struct MultiWait;
+
+/**
+ * \short This is the context of a holder of a synchronization object.
+ *
+ * See \ref multi_wait_api "Multi Wait API" for usages.
+ **/
+struct MultiWaitHolder {
+    /**
+     * \private
+     * \short Internal object state.
+     */
+    uint8_t state;
+
+    /**
+     * \private
+     * \short The type of the synchronization object.
+     */
+    uint8_t type;
+
+    /**
+     * \private
+     * \short Reserved for future usages.
+     */
+    char reserved[2];
+
+    /**
+     * \private
+     * \short The handle of a kernel object.
+     */
+    svc::Handle handle;
+
+    /**
+     * \private
+     * \short The user object.
+     */
+    UserEvent *user_event;
+
+    /**
+     * \private
+     * \short The MultiWait the holder is linked to.
+     */
+    MultiWait *multi_wait;
+
+    /**
+     * \private
+     * \short The next holder linked to the same MultiWait.
+     */
+    MultiWaitHolder *next;
+
+    /**
+     * \private
+     * \short The next holder of the same user object.
+     */
+    MultiWaitHolder *next_object_holder;
+
+    /**
+     * \private
+     * \short The value associated to the holder by the user.
+     */
+    uintptr_t user_data;
+};
+
+static_assert(hs::util::is_pod<MultiWaitHolder>::value,
+              "MultiWaitHolder isn't pod");
+
+/**
+ * \short This is the context of a multi wait.
+ *
+ * See \ref multi_wait_api "Multi Wait API" for usages.
+ **/
+struct MultiWait {
+    /**
+     * \private
+     * \short Internal object state.
+     */
+    uint8_t state;
+
+    /**
+     * \private
+     * \short Reserved for future usages.
+     */
+    char reserved[3];
+
+    /**
+     * \private
+     * \short The count of notifications of the user objects.
+     */
+    uint32_t notification_count;
+
+    /**
+     * \private
+     * \short The thread waiting on the kernel objects, invalid if there is none.
+     */
+    svc::Handle waiting_thread_handle;
+
+    /**
+     * \private
+     * \short The holders linked to the MultiWait.
+     */
+    MultiWaitHolder *holders;
+
+    /**
+     * \private
+     * \short The critical section protecting the notifications.
+     */
+    CriticalSection critical_section;
+
+    /**
+     * \private
+     * \short The condition variable notified when there isn't any kernel object to wait on.
+     */
+    ConditionVariableImpl condition_variable;
+};
+
+static_assert(hs::util::is_pod<MultiWait>::value, "MultiWait isn't pod");
+
+/**
+ * \short Initialize a MultiWait.
+ *
+ * \param[in] multi_wait A pointer to a MultiWait.
+ *
+ * \pre ``multi_wait`` is uninitialized.
+ * \post ``multi_wait`` is initialized.
+ */
+void InitializeMultiWait(MultiWait *multi_wait) noexcept;
+
+/**
+ * \short Finalize a MultiWait.
+ *
+ * \param[in] multi_wait A pointer to a MultiWait.
+ *
+ * \pre ``multi_wait`` is initialized and no holder is linked to it.
+ * \post ``multi_wait`` is uninitialized.
+ */
+void FinalizeMultiWait(MultiWait *multi_wait) noexcept;
+
+/**
+ * \short Initialize a MultiWaitHolder for a kernel object handle.
+ *
+ * \param[in] holder A pointer to a MultiWaitHolder.
+ * \param[in] handle The handle of a waitable kernel object.
+ *
+ * \pre ``holder`` is uninitialized.
+ * \post ``holder`` is initialized.
+ */
+void InitializeMultiWaitHolder(MultiWaitHolder *holder,
+                               svc::Handle handle) noexcept;
+
+/**
+ * \short Initialize a MultiWaitHolder for a KernelEvent.
+ *
+ * \param[in] holder A pointer to a MultiWaitHolder.
+ * \param[in] event A pointer to a KernelEvent.
+ *
+ * \pre ``holder`` is uninitialized.
+ * \pre ``event`` is initialized and has a readable handle.
+ * \post ``holder`` is initialized.
+ */
+void InitializeMultiWaitHolder(MultiWaitHolder *holder,
+                               KernelEvent *event) noexcept;
+
+/**
+ * \short Initialize a MultiWaitHolder for the exit of a Thread.
+ *
+ * \param[in] holder A pointer to a MultiWaitHolder.
+ * \param[in] thread A pointer to a Thread.
+ *
+ * \pre ``holder`` is uninitialized.
+ * \pre ``thread`` state is **not** ThreadState::Uninitialized.
+ * \post ``holder`` is initialized.
+ */
+void InitializeMultiWaitHolder(MultiWaitHolder *holder,
+                               Thread *thread) noexcept;
+
+/**
+ * \short Initialize a MultiWaitHolder for a UserEvent.
+ *
+ * \param[in] holder A pointer to a MultiWaitHolder.
+ * \param[in] event A pointer to a UserEvent.
+ *
+ * \pre ``holder`` is uninitialized.
+ * \pre ``event`` is initialized.
+ * \post ``holder`` is initialized.
+ */
+void InitializeMultiWaitHolder(MultiWaitHolder *holder,
+                               UserEvent *event) noexcept;
+
+/**
+ * \short Finalize a MultiWaitHolder.
+ *
+ * \param[in] holder A pointer to a MultiWaitHolder.
+ *
+ * \pre ``holder`` is initialized and isn't linked.
+ * \post ``holder`` is uninitialized.
+ */
+void FinalizeMultiWaitHolder(MultiWaitHolder *holder) noexcept;
+
+/**
+ * \short Associate a value to a MultiWaitHolder.
+ *
+ * \param[in] holder A pointer to a MultiWaitHolder.
+ * \param[in] user_data The value.
+ *
+ * \pre ``holder`` is initialized.
+ */
+void SetMultiWaitHolderUserData(MultiWaitHolder *holder,
+                                uintptr_t user_data) noexcept;
+
+/**
+ * \short Get the value associated to a MultiWaitHolder.
+ *
+ * \param[in] holder A pointer to a MultiWaitHolder.
+ *
+ * \pre ``holder`` is initialized.
+ */
+uintptr_t GetMultiWaitHolderUserData(MultiWaitHolder *holder) noexcept;
+
+/**
+ * \short Link a MultiWaitHolder to a MultiWait.
+ *
+ * \param[in] multi_wait A pointer to a MultiWait.
+ * \param[in] holder A pointer to a MultiWaitHolder.
+ *
+ * \pre ``multi_wait`` is initialized and nobody waits on it.
+ * \pre ``holder`` is initialized and isn't linked.
+ * \pre Less than MULTI_WAIT_HANDLE_COUNT_MAX kernel objects are linked to ``multi_wait``.
+ * \post ``holder`` is linked to ``multi_wait``.
+ */
+void LinkMultiWaitHolder(MultiWait *multi_wait,
+                         MultiWaitHolder *holder) noexcept;
+
+/**
+ * \short Unlink a MultiWaitHolder from its MultiWait.
+ *
+ * \param[in] holder A pointer to a MultiWaitHolder.
+ *
+ * \pre ``holder`` is linked and nobody waits on its MultiWait.
+ * \post ``holder`` isn't linked.
+ */
+void UnlinkMultiWaitHolder(MultiWaitHolder *holder) noexcept;
+
+/**
+ * \short Unlink all the MultiWaitHolder of a MultiWait.
+ *
+ * \param[in] multi_wait A pointer to a MultiWait.
+ *
+ * \pre ``multi_wait`` is initialized and nobody waits on it.
+ * \post No holder is linked to ``multi_wait``.
+ */
+void UnlinkAllMultiWaitHolders(MultiWait *multi_wait) noexcept;
+
+/**
+ * \short Wait until an object linked to a MultiWait is signaled.
+ *
+ * \param[in] multi_wait A pointer to a MultiWait.
+ *
+ * \pre ``multi_wait`` is initialized and nobody else waits on it.
+ *
+ * \return The holder of the signaled object.
+ */
+MultiWaitHolder *WaitAny(MultiWait *multi_wait) noexcept;
+
+/**
+ * \short Get an object linked to a MultiWait that is signaled, without waiting.
+ *
+ * \param[in] multi_wait A pointer to a MultiWait.
+ *
+ * \pre ``multi_wait`` is initialized and nobody else waits on it.
+ *
+ * \return The holder of the signaled object, or a null pointer if none is signaled.
+ */
+MultiWaitHolder *TryWaitAny(MultiWait *multi_wait) noexcept;
+
+/**
+ * \short Wait until an object linked to a MultiWait is signaled or a timeout expires.
+ *
+ * \param[in] multi_wait A pointer to a MultiWait.
+ * \param[in] timeout The number of nanoseconds before timing out.
+ *
+ * \pre ``multi_wait`` is initialized and nobody else waits on it.
+ *
+ * \return The holder of the signaled object, or a null pointer if the timeout expired.
+ */
+MultiWaitHolder *TimedWaitAny(MultiWait *multi_wait, int64_t timeout) noexcept;
+
+/**
+ * @}
+ */
+}  // namespace hs::os
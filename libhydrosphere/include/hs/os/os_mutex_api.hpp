@@ -46,9 +46,9 @@ struct Mutex {
 
     /**
      * \private
-     * \short Reserved for future usages.
+     * \short The spin state used to enter the critical section.
      */
-    char reserved[2];
+    CriticalSectionSpinState spin_state;
 
     /**
      * \private
@@ -118,6 +118,19 @@ bool TryLockMutex(Mutex *mutex) noexcept;
  */
 void UnlockMutex(Mutex *mutex) noexcept;
 
+/**
+ * \short Set the maximum count of spins done when locking a Mutex before blocking.
+ *
+ * \param[in] mutex A pointer to a Mutex.
+ * \param[in] spin_limit The maximum count of spins, 0 never spins.
+ *
+ * \remark A Mutex starts with the count returned by GetCriticalSectionSpinCount, up to 255.
+ * \remark The count of spins follows the time the Mutex is usually held, bounded by this limit.
+ *
+ * \pre ``mutex`` is initialized.
+ */
+void SetMutexSpinLimit(Mutex *mutex, uint8_t spin_limit) noexcept;
+
 /**
  * \short Finalize a Mutex.
  *
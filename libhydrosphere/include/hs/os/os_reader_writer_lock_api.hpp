@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include <hs/os/os_condition_variable_impl.hpp>
+#include <hs/os/os_critical_section.hpp>
+#include <hs/util/util_template_api.hpp>
+
+namespace hs::os {
+/**
+ * \defgroup reader_writer_lock_api Reader Writer Lock API
+ * \short API implementing a lock shared by readers and exclusive to writers.
+ *
+ * Any number of readers can hold the lock at the same time, a writer holds it alone.
+ * Writers are preferred: once a writer waits for the lock, new readers wait for it to be done.
+ *
+ * \remark Acquiring and releasing the lock without contention with a writer is a single atomic operation and doesn't need any syscall.
+ * \remark The lock isn't recursive.
+ * \ingroup os_api
+ * \name Reader Writer Lock API
+ * \addtogroup reader_writer_lock_api
+ * @{
+ */
+
+/**
+ * \short This is the context of a reader writer lock.
+ *
+ * See \ref reader_writer_lock_api "Reader Writer Lock API" for usages.
+ **/
+struct ReaderWriterLock {
+    /**
+     * \private
+     * \short Internal object state.
+     */
+    uint8_t state;
+
+    /**
+     * \private
+     * \short Reserved for future usages.
+     */
+    char reserved[3];
+
+    /**
+     * \private
+     * \short The count of readers holding the lock and the flags of the writers.
+     */
+    volatile _Atomic(uint32_t) lock_state;
+
+    /**
+     * \private
+     * \short The count of readers waiting for the lock.
+     */
+    uint32_t waiting_reader_count;
+
+    /**
+     * \private
+     * \short The count of writers waiting for the lock.
+     */
+    uint32_t waiting_writer_count;
+
+    /**
+     * \private
+     * \short The critical section protecting the waiters.
+     */
+    CriticalSection critical_section;
+
+    /**
+     * \private
+     * \short The condition variable of the waiting readers.
+     */
+    ConditionVariableImpl reader_condition_variable;
+
+    /**
+     * \private
+     * \short The condition variable of the waiting writers.
+     */
+    ConditionVariableImpl writer_condition_variable;
+};
+
+static_assert(hs::util::is_pod<ReaderWriterLock>::value,
+              "ReaderWriterLock isn't pod");
+
+/**
+ * \short Initialize a ReaderWriterLock.
+ *
+ * \param[in] lock A pointer to a ReaderWriterLock.
+ *
+ * \pre ``lock`` is uninitialized.
+ * \post ``lock`` is initialized.
+ */
+void InitializeReaderWriterLock(ReaderWriterLock *lock) noexcept;
+
+/**
+ * \short Acquire a ReaderWriterLock as a reader, blocking if needed.
+ *
+ * \param[in] lock A pointer to a ReaderWriterLock.
+ *
+ * \pre ``lock`` is initialized.
+ * \pre The current thread doesn't hold ``lock``.
+ * \post The lock was acquired as a reader.
+ */
+void AcquireReaderLock(ReaderWriterLock *lock) noexcept;
+
+/**
+ * \short Acquire a ReaderWriterLock as a reader if no writer holds it or waits for it.
+ *
+ * \param[in] lock A pointer to a ReaderWriterLock.
+ *
+ * \pre ``lock`` is initialized.
+ *
+ * \return true if the lock was acquired as a reader.
+ */
+bool TryAcquireReaderLock(ReaderWriterLock *lock) noexcept;
+
+/**
+ * \short Release a ReaderWriterLock held as a reader.
+ *
+ * \param[in] lock A pointer to a ReaderWriterLock.
+ *
+ * \pre The current thread holds ``lock`` as a reader.
+ * \post The lock was released.
+ */
+void ReleaseReaderLock(ReaderWriterLock *lock) noexcept;
+
+/**
+ * \short Acquire a ReaderWriterLock as a writer, blocking if needed.
+ *
+ * \param[in] lock A pointer to a ReaderWriterLock.
+ *
+ * \pre ``lock`` is initialized.
+ * \pre The current thread doesn't hold ``lock``.
+ * \post The lock was acquired as a writer.
+ */
+void AcquireWriterLock(ReaderWriterLock *lock) noexcept;
+
+/**
+ * \short Acquire a ReaderWriterLock as a writer if nobody holds it.
+ *
+ * \param[in] lock A pointer to a ReaderWriterLock.
+ *
+ * \pre ``lock`` is initialized.
+ *
+ * \return true if the lock was acquired as a writer.
+ */
+bool TryAcquireWriterLock(ReaderWriterLock *lock) noexcept;
+
+/**
+ * \short Release a ReaderWriterLock held as a writer.
+ *
+ * \param[in] lock A pointer to a ReaderWriterLock.
+ *
+ * \pre The current thread holds ``lock`` as a writer.
+ * \post The lock was released.
+ */
+void ReleaseWriterLock(ReaderWriterLock *lock) noexcept;
+
+/**
+ * \short Finalize a ReaderWriterLock.
+ *
+ * \param[in] lock A pointer to a ReaderWriterLock.
+ *
+ * \pre ``lock`` is initialized and isn't held.
+ * \post ``lock`` is uninitialized.
+ */
+void FinalizeReaderWriterLock(ReaderWriterLock *lock) noexcept;
+
+/**
+ * @}
+ */
+}  // namespace hs::os
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include <hs/os/os_condition_variable_impl.hpp>
+#include <hs/os/os_critical_section.hpp>
+#include <hs/util/util_template_api.hpp>
+
+namespace hs::os {
+/**
+ * \defgroup semaphore_api Semaphore API
+ * \short API implementing the counting semaphore synchronization primitive.
+ *
+ * \remark Acquiring an available unit and releasing units nobody waits for are single atomic operations, the kernel is only reached to put a thread to sleep or to wake it.
+ * \ingroup os_api
+ * \name Semaphore API
+ * \addtogroup semaphore_api
+ * @{
+ */
+
+/**
+ * \short This is the context of a semaphore.
+ *
+ * See \ref semaphore_api "Semaphore API" for usages.
+ **/
+struct Semaphore {
+    /**
+     * \private
+     * \short Internal object state.
+     */
+    uint8_t state;
+
+    /**
+     * \private
+     * \short Reserved for future usages.
+     */
+    char reserved[3];
+
+    /**
+     * \private
+     * \short The count of available units and the flag of the waiters.
+     */
+    volatile _Atomic(uint32_t) count;
+
+    /**
+     * \private
+     * \short The maximum count of available units.
+     */
+    uint32_t max_count;
+
+    /**
+     * \private
+     * \short The count of threads waiting for a unit.
+     */
+    uint32_t waiting_count;
+
+    /**
+     * \private
+     * \short The critical section protecting the waiters.
+     */
+    CriticalSection critical_section;
+
+    /**
+     * \private
+     * \short The condition variable of the waiters.
+     */
+    ConditionVariableImpl condition_variable;
+};
+
+static_assert(hs::util::is_pod<Semaphore>::value, "Semaphore isn't pod");
+
+/**
+ * \short Initialize a Semaphore.
+ *
+ * \param[in] semaphore A pointer to a Semaphore.
+ * \param[in] initial_count The count of units available at first.
+ * \param[in] max_count The maximum count of available units.
+ *
+ * \pre ``semaphore`` is uninitialized.
+ * \pre ``initial_count`` <= ``max_count`` and ``max_count`` is less than 0x80000000.
+ * \post ``semaphore`` is initialized.
+ */
+void InitializeSemaphore(Semaphore *semaphore, uint32_t initial_count,
+                         uint32_t max_count) noexcept;
+
+/**
+ * \short Acquire a unit of a Semaphore, blocking until one is available.
+ *
+ * \param[in] semaphore A pointer to a Semaphore.
+ *
+ * \pre ``semaphore`` is initialized.
+ * \post A unit was acquired.
+ */
+void AcquireSemaphore(Semaphore *semaphore) noexcept;
+
+/**
+ * \short Acquire a unit of a Semaphore if one is available.
+ *
+ * \param[in] semaphore A pointer to a Semaphore.
+ *
+ * \pre ``semaphore`` is initialized.
+ *
+ * \return true if a unit was acquired.
+ */
+bool TryAcquireSemaphore(Semaphore *semaphore) noexcept;
+
+/**
+ * \short Acquire a unit of a Semaphore, blocking until one is available or a timeout expires.
+ *
+ * \param[in] semaphore A pointer to a Semaphore.
+ * \param[in] timeout The number of nanoseconds before timing out.
+ *
+ * \pre ``semaphore`` is initialized.
+ *
+ * \return true if a unit was acquired, false if the timeout expired.
+ */
+bool TimedAcquireSemaphore(Semaphore *semaphore, int64_t timeout) noexcept;
+
+/**
+ * \short Release units of a Semaphore.
+ *
+ * \param[in] semaphore A pointer to a Semaphore.
+ * \param[in] count The count of units to release.
+ *
+ * \pre ``semaphore`` is initialized.
+ * \pre The count of available units stays below the maximum count.
+ * \post ``count`` waiters were woken if any.
+ */
+void ReleaseSemaphore(Semaphore *semaphore, uint32_t count = 1) noexcept;
+
+/**
+ * \short Get the count of available units of a Semaphore.
+ *
+ * \param[in] semaphore A pointer to a Semaphore.
+ *
+ * \pre ``semaphore`` is initialized.
+ */
+uint32_t GetSemaphoreCount(Semaphore *semaphore) noexcept;
+
+/**
+ * \short Finalize a Semaphore.
+ *
+ * \param[in] semaphore A pointer to a Semaphore.
+ *
+ * \pre ``semaphore`` is initialized and nobody waits for it.
+ * \post ``semaphore`` is uninitialized.
+ */
+void FinalizeSemaphore(Semaphore *semaphore) noexcept;
+
+/**
+ * @}
+ */
+}  // namespace hs::os
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/hs_result.hpp>
+#include <hs/svc/svc_types.hpp>
+#include <hs/util/util_template_api.hpp>
+
+namespace hs::os {
+/**
+ * \defgroup shared_memory_api Shared Memory API
+ * \short API implementing memory shared between processes.
+ *
+ * A SharedMemory is allocated by the kernel and mapped by every process holding its handle, buffers written in it are seen by the other processes without any copy.
+ *
+ * \remark The mappings are placed in the address space reserved by Hydrosphère, the application doesn't have to find a free region.
+ * \ingroup os_api
+ * \name Shared Memory API
+ * \addtogroup shared_memory_api
+ * @{
+ */
+
+/**
+ * \short This is the context of a shared memory.
+ *
+ * See \ref shared_memory_api "Shared Memory API" for usages.
+ **/
+struct SharedMemory {
+    /**
+     * \private
+     * \short Internal object state.
+     */
+    uint8_t state;
+
+    /**
+     * \private
+     * \short True if the handle must be closed when the SharedMemory is destroyed.
+     */
+    bool is_handle_managed;
+
+    /**
+     * \private
+     * \short Reserved for future usage.
+     */
+    char reserved[2];
+
+    /**
+     * \private
+     * \short The handle of the shared memory.
+     */
+    svc::Handle handle;
+
+    /**
+     * \private
+     * \short The permission of the mappings of this process.
+     */
+    svc::MemoryPermission permission;
+
+    /**
+     * \private
+     * \short The size of the shared memory in bytes.
+     */
+    size_t size;
+
+    /**
+     * \private
+     * \short The address of the mapping, 0 when not mapped.
+     */
+    uintptr_t address;
+};
+
+static_assert(hs::util::is_pod<SharedMemory>::value, "SharedMemory isn't pod");
+
+/**
+ * \short Create a SharedMemory.
+ *
+ * \param[in] shared_memory A pointer to a SharedMemory.
+ * \param[in] size The size of the shared memory in bytes.
+ * \param[in] my_permission The permission of the mappings of this process.
+ * \param[in] other_permission The permission of the mappings of the other processes.
+ *
+ * \return The result of the creation of the shared memory.
+ *
+ * \pre ``shared_memory`` is uninitialized.
+ * \pre ``size`` is page aligned and not equal to 0.
+ * \post ``shared_memory`` is initialized and not mapped.
+ */
+hs::Result CreateSharedMemory(SharedMemory *shared_memory, size_t size,
+                              svc::MemoryPermission my_permission,
+                              svc::MemoryPermission other_permission) noexcept;
+
+/**
+ * \short Load a SharedMemory from a raw handle.
+ *
+ * \param[in] shared_memory A pointer to a SharedMemory.
+ * \param[in] handle The handle of the shared memory, usually received from another process.
+ * \param[in] size The size of the shared memory in bytes.
+ * \param[in] permission The permission of the mappings of this process.
+ * \param[in] is_handle_managed True if the handle must be closed when the SharedMemory is destroyed.
+ *
+ * \pre ``shared_memory`` is uninitialized.
+ * \pre ``size`` is page aligned and not equal to 0.
+ * \post ``shared_memory`` is initialized and not mapped.
+ */
+void LoadSharedMemory(SharedMemory *shared_memory, svc::Handle handle,
+                      size_t size, svc::MemoryPermission permission,
+                      bool is_handle_managed) noexcept;
+
+/**
+ * \short Map a SharedMemory in the address space of the process.
+ *
+ * \param[in] shared_memory A pointer to a SharedMemory.
+ * \param[in] out_address Where to write the address of the mapping.
+ *
+ * \return The result of the mapping, or an out of resources error if the address space is exhausted.
+ *
+ * \pre ``shared_memory`` is initialized and not mapped.
+ * \post ``shared_memory`` is mapped at ``out_address`` on success.
+ */
+hs::Result MapSharedMemory(SharedMemory *shared_memory,
+                           void **out_address) noexcept;
+
+/**
+ * \short Unmap a SharedMemory from the address space of the process.
+ *
+ * \param[in] shared_memory A pointer to a SharedMemory.
+ *
+ * \pre ``shared_memory`` is mapped.
+ * \post ``shared_memory`` is not mapped.
+ */
+void UnmapSharedMemory(SharedMemory *shared_memory) noexcept;
+
+/**
+ * \short Get the address of the mapping of a SharedMemory.
+ *
+ * \param[in] shared_memory A pointer to a SharedMemory.
+ *
+ * \pre ``shared_memory`` is initialized.
+ * \return The address of the mapping, or a null pointer if ``shared_memory`` isn't mapped.
+ */
+void *GetSharedMemoryAddress(const SharedMemory *shared_memory) noexcept;
+
+/**
+ * \short Get the handle of a SharedMemory, to be sent to another process.
+ *
+ * \param[in] shared_memory A pointer to a SharedMemory.
+ *
+ * \pre ``shared_memory`` is initialized.
+ * \return The handle of the shared memory, it stays owned by ``shared_memory``.
+ */
+svc::Handle GetSharedMemoryHandle(const SharedMemory *shared_memory) noexcept;
+
+/**
+ * \short Destroy a SharedMemory.
+ *
+ * \param[in] shared_memory A pointer to a SharedMemory.
+ *
+ * \pre ``shared_memory`` is initialized.
+ * \post ``shared_memory`` is unmapped if it was mapped.
+ * \post ``shared_memory`` is uninitialized.
+ */
+void DestroySharedMemory(SharedMemory *shared_memory) noexcept;
+
+/**
+ * @}
+ */
+}  // namespace hs::os
@@ -38,6 +38,11 @@ typedef void (*ThreadEntrypointFunction)(void *argument);
  */
 const size_t THREAD_NAME_SIZE = 0x20;
 
+/**
+ * \short The max count of Thread stack mirrors that can be kept by the stack cache.
+ */
+const size_t THREAD_STACK_CACHE_MAX_CAPACITY = 0x10;
+
 /**
  * \short Represent the state of a Thread.
  */
@@ -118,6 +123,24 @@ struct Thread : public hs::util::IntrusiveListElement<> {
      */
     bool is_alias_thread_stack_mapped;
 
+    /**
+     * \private
+     * \short True if the ``original_thread_stack`` was allocated by hs::os::CreateThread.
+     */
+    bool is_thread_stack_owned;
+
+    /**
+     * \private
+     * \short True if the stack was painted by hs::os::CreateThread to track its usage.
+     */
+    bool is_thread_stack_painted;
+
+    /**
+     * \private
+     * \short The peak usage of the stack, recorded when its mirror is unmapped.
+     */
+    size_t thread_stack_peak_usage;
+
     /**
      * \private
      * \short A condition variable used to signal thread change of states.
@@ -141,6 +164,30 @@ struct Thread : public hs::util::IntrusiveListElement<> {
      * \short The Thread name given by the user.
      */
     char thread_name[THREAD_NAME_SIZE];
+
+    /**
+     * \private
+     * \short The heap cache of the Thread, created on its first allocation.
+     */
+    void *heap_cache;
+
+    /**
+     * \private
+     * \short The Arena of the Thread, created on its first use (see hs::mem::GetThreadArena).
+     */
+    void *arena;
+
+    /**
+     * \private
+     * \short The records of the Thread in the epoch domains it used (see hs::util::EpochDomain).
+     */
+    void *epoch_records;
+
+    /**
+     * \private
+     * \short The allocation trace buffer of the Thread, created on its first traced allocation (see hs::mem::SetAllocationTracing).
+     */
+    void *allocation_trace;
 };
 
 /**
@@ -161,13 +208,40 @@ struct Thread : public hs::util::IntrusiveListElement<> {
  * \pre ``priority`` is within the range 0-0x3F.
  * \pre ``cpuid`` is within the range 0-3 or is -2.
  *
- * \post ``thread`` state is ThreadState::Initialized.
+ * \post ``thread`` state is ThreadState::Initialized, or ThreadState::Uninitialized if the creation failed.
  */
 hs::Result CreateThread(Thread *thread,
                         ThreadEntrypointFunction thread_entrypoint,
                         void *argument, void *stack, size_t stack_size,
                         int priority, int cpuid = -2) noexcept;
 
+/**
+ * \short Create a Thread with a stack allocated by Hydrosphère.
+ *
+ * The stack is allocated from the heap and is freed by hs::os::DestroyThread.
+ * Like for any other Thread, the stack is used through a mirror in the Stack region that is surrounded by unmapped guard pages.
+ *
+ * \param[in] thread A pointer to a Thread.
+ * \param[in] thread_entrypoint The entrypoint of the Thread.
+ * \param[in] argument The argument to pass to the entrypoint when starting the Thread.
+ * \param[in] stack_size The size of the stack (must be page aligned).
+ * \param[in] priority The priority of the Thread (0x2C is the usual priority of the main thread. 0x3B on core 0 to 2 and 0x3F on core 3 is a special priority that enables preemptive multithreading).
+ * \param[in] cpuid The ID of the CPU core to use (-2 means the default core of the current process).
+ *
+ * \pre ``thread`` state is ThreadState::Uninitialized.
+ * \pre ``thread_entrypoint`` is not a null pointer.
+ * \pre ``stack_size`` is page aligned and not equal to 0.
+ * \pre ``priority`` is within the range 0-0x3F.
+ * \pre ``cpuid`` is within the range 0-3 or is -2.
+ *
+ * \post ``thread`` state is ThreadState::Initialized, or ThreadState::Uninitialized if the creation failed.
+ * \remark The kernel doesn't page memory on demand so the whole stack is backed by memory as soon as the Thread is created.
+ */
+hs::Result CreateThread(Thread *thread,
+                        ThreadEntrypointFunction thread_entrypoint,
+                        void *argument, size_t stack_size, int priority,
+                        int cpuid = -2) noexcept;
+
 /**
  * \short Destroy a Thread.
  *
@@ -175,6 +249,7 @@ hs::Result CreateThread(Thread *thread,
  *
  * - If the ``thread`` state is ThreadState::Initialized, the thread is started and signaled as ThreadState::Destroyed (The thread will imediately exit).
  * - It waits for the Thread to exit and ensures that the Thread stack mirror is unmapped if needed.
+ * - It frees the Thread stack if it was allocated by hs::os::CreateThread.
  *
  * \param[in] thread A pointer to a Thread.
  * \pre ``thread`` state is **not** ThreadState::Uninitialized.
@@ -250,6 +325,57 @@ int GetOriginalThreadPriority(Thread *thread) noexcept;
  */
 int GetCurrentThreadPriority(Thread *thread) noexcept;
 
+/**
+ * \short Set the count of Thread stack mirrors kept by the stack cache.
+ *
+ * When a Thread is destroyed, the mirror of its stack in the Stack region is kept mapped by the cache instead of being unmapped.
+ * A Thread later created with the same stack and stack size reuses it, saving the reservation and the mapping of a new mirror.
+ * When the cache is full, the oldest mirror is unmapped. The cache is disabled by default.
+ *
+ * \param[in] capacity The count of stack mirrors to keep, 0 disables the cache.
+ *
+ * \pre ``capacity`` is at most hs::os::THREAD_STACK_CACHE_MAX_CAPACITY.
+ * \warning The stack given to hs::os::CreateThread stays unaccessible while its mirror is cached. Call hs::os::TrimThreadStackCache before reusing the memory of a stack for anything else.
+ */
+void SetThreadStackCacheCapacity(size_t capacity) noexcept;
+
+/**
+ * \short Unmap every Thread stack mirror kept by the stack cache.
+ *
+ * \post The stacks of the destroyed Threads are accessible again.
+ */
+void TrimThreadStackCache() noexcept;
+
+/**
+ * \short Enable or disable the tracking of the stack usage of the Threads created afterwards.
+ *
+ * When enabled, hs::os::CreateThread fills the stack of the Thread with a known pattern, the bytes that were overwritten give the peak usage of the stack.
+ * The tracking is disabled by default as painting the stack touches all of it.
+ *
+ * \param[in] is_enabled true to paint the stacks of the Threads created afterwards.
+ */
+void SetThreadStackUsageTracking(bool is_enabled) noexcept;
+
+/**
+ * \short Get the peak usage of a Thread stack.
+ *
+ * \param[in] thread A pointer to a Thread.
+ *
+ * \return The highest count of bytes of the stack used by the Thread so far, or 0 if its stack usage isn't tracked.
+ *
+ * \pre ``thread`` was created, it may have been destroyed since.
+ * \remark The usage is recorded when the Thread exits, it stays available until the Thread is created again.
+ * \remark A stack frame that didn't write to some of its bytes may go unnoticed, the result is a lower bound.
+ */
+size_t GetThreadStackUsage(Thread *thread) noexcept;
+
+/**
+ * \short Output the name, the stack size and the peak stack usage of every Thread to the debug log.
+ *
+ * \remark Only the Threads created while hs::os::SetThreadStackUsageTracking was enabled report a peak usage.
+ */
+void DumpThreadStackUsage() noexcept;
+
 /**
  * @}
  */
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/hs_result.hpp>
+#include <hs/svc/svc_types.hpp>
+#include <hs/util/util_template_api.hpp>
+
+namespace hs::os {
+/**
+ * \defgroup transfer_memory_api Transfer Memory API
+ * \short API implementing the transfer of a buffer to another process.
+ *
+ * A TransferMemory hands an existing buffer of this process to another process (usually a service) without copying it.
+ * While the TransferMemory exists, the access of this process to the buffer is limited to the permission given at creation.
+ *
+ * \remark The mappings are placed in the address space reserved by Hydrosphère, the receiving side doesn't have to find a free region.
+ * \ingroup os_api
+ * \name Transfer Memory API
+ * \addtogroup transfer_memory_api
+ * @{
+ */
+
+/**
+ * \short This is the context of a transfer memory.
+ *
+ * See \ref transfer_memory_api "Transfer Memory API" for usages.
+ **/
+struct TransferMemory {
+    /**
+     * \private
+     * \short Internal object state.
+     */
+    uint8_t state;
+
+    /**
+     * \private
+     * \short True if the handle must be closed when the TransferMemory is destroyed.
+     */
+    bool is_handle_managed;
+
+    /**
+     * \private
+     * \short Reserved for future usage.
+     */
+    char reserved[2];
+
+    /**
+     * \private
+     * \short The handle of the transfer memory.
+     */
+    svc::Handle handle;
+
+    /**
+     * \private
+     * \short The permission of the transfered buffer.
+     */
+    svc::MemoryPermission permission;
+
+    /**
+     * \private
+     * \short The size of the transfered buffer in bytes.
+     */
+    size_t size;
+
+    /**
+     * \private
+     * \short The address of the transfered buffer in this process, 0 if the TransferMemory was loaded.
+     */
+    uintptr_t source_address;
+
+    /**
+     * \private
+     * \short The address of the mapping, 0 when not mapped.
+     */
+    uintptr_t address;
+};
+
+static_assert(hs::util::is_pod<TransferMemory>::value,
+              "TransferMemory isn't pod");
+
+/**
+ * \short Create a TransferMemory from a buffer of this process.
+ *
+ * \param[in] transfer_memory A pointer to a TransferMemory.
+ * \param[in] address The address of the buffer to transfer.
+ * \param[in] size The size of the buffer in bytes.
+ * \param[in] permission The permission left to this process on the buffer while it is transfered.
+ *
+ * \return The result of the creation of the transfer memory.
+ *
+ * \pre ``transfer_memory`` is uninitialized.
+ * \pre ``address`` and ``size`` are page aligned and ``size`` is not equal to 0.
+ * \pre The buffer is owned by the caller (heap blocks allocated with hs::mem::AllocateAligned are suitable).
+ * \post ``transfer_memory`` is initialized and not mapped.
+ */
+hs::Result CreateTransferMemory(TransferMemory *transfer_memory, void *address,
+                                size_t size,
+                                svc::MemoryPermission permission) noexcept;
+
+/**
+ * \short Load a TransferMemory from a raw handle.
+ *
+ * \param[in] transfer_memory A pointer to a TransferMemory.
+ * \param[in] handle The handle of the transfer memory, usually received from another process.
+ * \param[in] size The size of the transfered buffer in bytes.
+ * \param[in] permission The permission given to the transfer memory at its creation.
+ * \param[in] is_handle_managed True if the handle must be closed when the TransferMemory is destroyed.
+ *
+ * \pre ``transfer_memory`` is uninitialized.
+ * \pre ``size`` is page aligned and not equal to 0.
+ * \post ``transfer_memory`` is initialized and not mapped.
+ */
+void LoadTransferMemory(TransferMemory *transfer_memory, svc::Handle handle,
+                        size_t size, svc::MemoryPermission permission,
+                        bool is_handle_managed) noexcept;
+
+/**
+ * \short Map a TransferMemory in the address space of the process.
+ *
+ * \param[in] transfer_memory A pointer to a TransferMemory.
+ * \param[in] out_address Where to write the address of the mapping.
+ *
+ * \return The result of the mapping, or an out of resources error if the address space is exhausted.
+ *
+ * \pre ``transfer_memory`` is initialized and not mapped.
+ * \post ``transfer_memory`` is mapped at ``out_address`` on success.
+ */
+hs::Result MapTransferMemory(TransferMemory *transfer_memory,
+                             void **out_address) noexcept;
+
+/**
+ * \short Unmap a TransferMemory from the address space of the process.
+ *
+ * \param[in] transfer_memory A pointer to a TransferMemory.
+ *
+ * \pre ``transfer_memory`` is mapped.
+ * \post ``transfer_memory`` is not mapped.
+ */
+void UnmapTransferMemory(TransferMemory *transfer_memory) noexcept;
+
+/**
+ * \short Get the address of the mapping of a TransferMemory.
+ *
+ * \param[in] transfer_memory A pointer to a TransferMemory.
+ *
+ * \pre ``transfer_memory`` is initialized.
+ * \return The address of the mapping, or a null pointer if ``transfer_memory`` isn't mapped.
+ */
+void *GetTransferMemoryAddress(const TransferMemory *transfer_memory) noexcept;
+
+/**
+ * \short Get the handle of a TransferMemory, to be sent to another process.
+ *
+ * \param[in] transfer_memory A pointer to a TransferMemory.
+ *
+ * \pre ``transfer_memory`` is initialized.
+ * \return The handle of the transfer memory, it stays owned by ``transfer_memory``.
+ */
+svc::Handle GetTransferMemoryHandle(
+    const TransferMemory *transfer_memory) noexcept;
+
+/**
+ * \short Destroy a TransferMemory.
+ *
+ * \param[in] transfer_memory A pointer to a TransferMemory.
+ *
+ * \pre ``transfer_memory`` is initialized.
+ * \post ``transfer_memory`` is unmapped if it was mapped.
+ * \post ``transfer_memory`` is uninitialized, a transfered buffer is given back to this process once every other process closed its handle.
+ */
+void DestroyTransferMemory(TransferMemory *transfer_memory) noexcept;
+
+/**
+ * @}
+ */
+}  // namespace hs::os
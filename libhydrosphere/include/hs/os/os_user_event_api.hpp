@@ -27,6 +27,8 @@ namespace hs::os {
  * @{
  */
 
+struct MultiWaitHolder;
+
 /**
  * \short This is the context of a user event.
  * 
@@ -68,9 +70,17 @@ struct UserEvent {
      * \short A condition variable used to signal user event.
      */
     ConditionVariableImpl condition_variable;
+
+    /**
+     * \private
+     * \short The MultiWait holders of the UserEvent, notified when it is signaled.
+     */
+    MultiWaitHolder *multi_wait_holders;
 };
 
-static_assert(sizeof(UserEvent) == 0xC, "invalid event_t size");
+static_assert(sizeof(UserEvent) == 0xC + sizeof(uintptr_t) +
+                                       (sizeof(uintptr_t) == 8 ? 4 : 0),
+              "invalid event_t size");
 static_assert(hs::util::is_pod<UserEvent>::value, "UserEvent isn't pod");
 
 /**
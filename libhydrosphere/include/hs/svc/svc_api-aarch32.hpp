@@ -116,8 +116,11 @@ hs::Result GetResourceLimitCurrentValue(
 hs::Result SetThreadActivity(hs::svc::Handle thread_handle,
                              hs::svc::ThreadActivity activity) noexcept;
 // TODO(Kaenbyō): [1.0.0+] 0x33 - GetThreadContext3
-// [4.0.0+] 0x34 - WaitForAddress
-// [4.0.0+] 0x35 - SignalToAddress
+hs::Result WaitForAddress(uintptr_t address,
+                          hs::svc::ArbitrationType arbitration_type,
+                          int32_t value, int64_t timeout) noexcept;
+hs::Result SignalToAddress(uintptr_t address, hs::svc::SignalType signal_type,
+                           int32_t value, int32_t count) noexcept;
 // [8.0.0+] 0x36 - SynchronizePreemptionState
 // [1.0.0+] 0x3C - DumpInfo (stubbed?)
 // [4.0.0+] 0x3D - DumpInfoNew (subbed?)
@@ -51,6 +51,20 @@ inline hs::Result WaitProcessWideKeyAtomic(uintptr_t mutex_address,
         mutex_address, condvar_address, thread_handle, timeout);
 }
 
+inline hs::Result WaitForAddress(uintptr_t address,
+                                 hs::svc::ArbitrationType arbitration_type,
+                                 int32_t value, int64_t timeout) noexcept {
+    return hs::svc::HYDROSPHERE_TARGET_ARCH_NAME::WaitForAddress(
+        address, arbitration_type, value, timeout);
+}
+
+inline hs::Result SignalToAddress(uintptr_t address,
+                                  hs::svc::SignalType signal_type,
+                                  int32_t value, int32_t count) noexcept {
+    return hs::svc::HYDROSPHERE_TARGET_ARCH_NAME::SignalToAddress(
+        address, signal_type, value, count);
+}
+
 inline void SleepThread(int64_t nanoseconds) noexcept {
     hs::svc::HYDROSPHERE_TARGET_ARCH_NAME::SleepThread(nanoseconds);
 }
@@ -71,6 +85,12 @@ inline hs::Result WaitSynchronization(int32_t *index,
         index, handles, handle_count, timeout);
 }
 
+inline hs::Result CancelSynchronization(
+    hs::svc::Handle thread_handle) noexcept {
+    return hs::svc::HYDROSPHERE_TARGET_ARCH_NAME::CancelSynchronization(
+        thread_handle);
+}
+
 inline hs::Result CreateThread(hs::svc::Handle *out_thread_handle,
                                uintptr_t thread_entry_point, uintptr_t argument,
                                uintptr_t stack_top, int32_t priority,
@@ -80,7 +100,7 @@ inline hs::Result CreateThread(hs::svc::Handle *out_thread_handle,
         cpu_id);
 }
 
-inline void ExitThread(void) noexcept __HS_ATTRIBUTE_NORETURN {
+__HS_ATTRIBUTE_NORETURN inline void ExitThread(void) noexcept {
     hs::svc::HYDROSPHERE_TARGET_ARCH_NAME::ExitThread();
 }
 
@@ -113,6 +133,12 @@ inline hs::Result GetInfo(uint64_t *out_info_value, InfoType info_type,
         out_info_value, info_type, handle, info_subtype);
 }
 
+inline hs::Result SetHeapSize(uintptr_t *out_address,
+                              size_t heap_size) noexcept {
+    return hs::svc::HYDROSPHERE_TARGET_ARCH_NAME::SetHeapSize(out_address,
+                                                              heap_size);
+}
+
 inline hs::Result MapMemory(uintptr_t dst_address, uintptr_t src_address,
                             uintptr_t size) noexcept {
     return hs::svc::HYDROSPHERE_TARGET_ARCH_NAME::MapMemory(dst_address,
@@ -153,6 +179,48 @@ inline hs::Result ResetSignal(hs::svc::Handle handle) noexcept {
     return hs::svc::HYDROSPHERE_TARGET_ARCH_NAME::ResetSignal(handle);
 }
 
+inline hs::Result CreateSharedMemory(
+    hs::svc::Handle *out_shared_memory_handle, size_t size,
+    MemoryPermission my_permission,
+    MemoryPermission other_permission) noexcept {
+    return hs::svc::HYDROSPHERE_TARGET_ARCH_NAME::CreateSharedMemory(
+        out_shared_memory_handle, size, my_permission, other_permission);
+}
+
+inline hs::Result MapSharedMemory(hs::svc::Handle shared_memory_handle,
+                                  uintptr_t address, size_t size,
+                                  MemoryPermission permission) noexcept {
+    return hs::svc::HYDROSPHERE_TARGET_ARCH_NAME::MapSharedMemory(
+        shared_memory_handle, address, size, permission);
+}
+
+inline hs::Result UnmapSharedMemory(hs::svc::Handle shared_memory_handle,
+                                    uintptr_t address, size_t size) noexcept {
+    return hs::svc::HYDROSPHERE_TARGET_ARCH_NAME::UnmapSharedMemory(
+        shared_memory_handle, address, size);
+}
+
+inline hs::Result CreateTransferMemory(
+    hs::svc::Handle *out_transfer_memory_handle, uintptr_t address,
+    size_t size, MemoryPermission permission) noexcept {
+    return hs::svc::HYDROSPHERE_TARGET_ARCH_NAME::CreateTransferMemory(
+        out_transfer_memory_handle, address, size, permission);
+}
+
+inline hs::Result MapTransferMemory(hs::svc::Handle transfer_memory_handle,
+                                    uintptr_t address, size_t size,
+                                    MemoryPermission permission) noexcept {
+    return hs::svc::HYDROSPHERE_TARGET_ARCH_NAME::MapTransferMemory(
+        transfer_memory_handle, address, size, permission);
+}
+
+inline hs::Result UnmapTransferMemory(hs::svc::Handle transfer_memory_handle,
+                                      uintptr_t address,
+                                      size_t size) noexcept {
+    return hs::svc::HYDROSPHERE_TARGET_ARCH_NAME::UnmapTransferMemory(
+        transfer_memory_handle, address, size);
+}
+
 }  // namespace svc
 
 }  // namespace hs
@@ -64,7 +64,7 @@ inline bool operator==(Handle a, Handle b) noexcept {
 }
 
 inline bool operator!=(Handle a, Handle b) noexcept {
-    return a.GetValue() == b.GetValue();
+    return a.GetValue() != b.GetValue();
 }
 
 enum class MemoryPermission {
@@ -91,6 +91,39 @@ struct MemoryInfo {
     uint32_t padding;
 };
 
+enum class MemoryType {
+    Free = 0x00,
+    Io = 0x01,
+    Static = 0x02,
+    Code = 0x03,
+    CodeData = 0x04,
+    Normal = 0x05,
+    Shared = 0x06,
+    Alias = 0x07,
+    AliasCode = 0x08,
+    AliasCodeData = 0x09,
+    Ipc = 0x0A,
+    Stack = 0x0B,
+    ThreadLocal = 0x0C,
+    Transfered = 0x0D,
+    SharedTransfered = 0x0E,
+    SharedCode = 0x0F,
+    Inaccessible = 0x10,
+    NonSecureIpc = 0x11,
+    NonDeviceIpc = 0x12,
+    Kernel = 0x13,
+    GeneratedCode = 0x14,
+    CodeOut = 0x15,
+};
+
+enum class MemoryAttribute {
+    None = 0,
+    Locked = __HS_BIT(0),
+    IpcLocked = __HS_BIT(1),
+    DeviceShared = __HS_BIT(2),
+    Uncached = __HS_BIT(3),
+};
+
 enum class LimitableResource {
     Memory = 0,
     Threads = 1,
@@ -103,6 +136,18 @@ enum class ThreadActivity { UnPaused = 0, Paused = 1 };
 
 enum class ProcessActivity { UnPaused = 0, Paused = 1 };
 
+enum class ArbitrationType {
+    WaitIfLessThan = 0,
+    DecrementAndWaitIfLessThan = 1,
+    WaitIfEqual = 2,
+};
+
+enum class SignalType {
+    Signal = 0,
+    SignalAndIncrementIfEqual = 1,
+    SignalAndModifyByWaitingCountIfEqual = 2,
+};
+
 // TODO(Kaenbyō): use infos from the TRM as it's a 1:1 mapping.
 enum class Interrupt {};
 
@@ -113,6 +158,12 @@ enum class InterruptType {
 
 // TODO(Kaenbyō): populate this
 enum class InfoType {
+    AliasRegionBase = 2,
+    AliasRegionSize = 3,
+    HeapRegionBase = 4,
+    HeapRegionSize = 5,
+    TotalMemorySize = 6,
+    UsedMemorySize = 7,
     AddressSpaceBase = 12,
     AddressSpaceSize = 13,
     StackRegionBase = 14,
@@ -11,8 +11,11 @@
 #pragma once
 
 #include <hs/util/util_api.hpp>
+#include <hs/util/util_epoch_domain.hpp>
 #include <hs/util/util_intrusive_list.hpp>
+#include <hs/util/util_object_pool.hpp>
 #include <hs/util/util_object_storage.hpp>
 #include <hs/util/util_optional.hpp>
 #include <hs/util/util_std_new.hpp>
 #include <hs/util/util_template_api.hpp>
+#include <hs/util/util_virtual_array.hpp>
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/hs_macro.hpp>
+#include <hs/os/os_critical_section.hpp>
+
+namespace hs::os {
+struct Thread;
+}  // namespace hs::os
+
+namespace hs::util {
+struct EpochRetiredObject;
+
+namespace detail {
+void FinalizeThreadEpochRecords(hs::os::Thread *thread) noexcept;
+}  // namespace detail
+
+/**
+ * \short Function reclaiming an object retired to an EpochDomain.
+ * \arg ``object``: the EpochRetiredObject given to EpochDomain::Retire.
+ */
+typedef void (*EpochReclaimFunction)(EpochRetiredObject *object);
+
+/**
+ * \short The link of an object retired to an EpochDomain.
+ *
+ * This is meant to be embedded in the nodes of a lock-free data structure, no allocation is needed to retire them.
+ */
+struct EpochRetiredObject {
+    /**
+     * \private
+     * \short The next retired object.
+     */
+    EpochRetiredObject *next;
+
+    /**
+     * \private
+     * \short The epoch of the domain when the object was retired.
+     */
+    uint64_t epoch;
+
+    /**
+     * \private
+     * \short The function reclaiming the object.
+     */
+    EpochReclaimFunction reclaim;
+};
+
+/**
+ * \short Epoch based reclamation of the memory of lock-free data structures.
+ *
+ * Threads reading the shared data structure pin the current epoch with EpochDomain::Enter and EpochDomain::Leave.
+ * An object unlinked from the data structure is given to EpochDomain::Retire and is reclaimed once every Thread that could still be reading it has left the domain.
+ *
+ * Every Thread gets a record in the domain on first use, attached to its Thread context. The record is removed when the Thread exits, exited Threads never hold back reclamation.
+ *
+ * \remark Pinning and unpinning without nesting cost a few atomic operations and no syscall.
+ * \remark Only Threads created by Hydrosphère (and the main thread) can use an EpochDomain.
+ */
+class EpochDomain {
+ private:
+    volatile _Atomic(uint64_t) global_epoch;
+
+    // Objects left behind by exited threads.
+    hs::os::CriticalSection critical_section;
+    EpochRetiredObject *orphans;
+
+    void AdoptOrphans(EpochRetiredObject *head) noexcept;
+    void ReclaimOrphans() noexcept;
+
+ public:
+    EpochDomain() noexcept
+        : global_epoch(0), critical_section(), orphans(nullptr) {}
+    __HS_DISALLOW_COPY(EpochDomain);
+    __HS_DISALLOW_ASSIGN(EpochDomain);
+
+    /**
+     * \short Reclaim every retired object and remove the records of the Threads.
+     *
+     * \pre No Thread is inside the domain or uses it anymore.
+     */
+    ~EpochDomain() noexcept;
+
+    /**
+     * \short Pin the current epoch, the objects retired from now on are not reclaimed until EpochDomain::Leave.
+     *
+     * \remark Calls can be nested.
+     */
+    void Enter() noexcept;
+
+    /**
+     * \short Unpin the epoch pinned by EpochDomain::Enter.
+     *
+     * \pre The current Thread is inside the domain.
+     */
+    void Leave() noexcept;
+
+    /**
+     * \short Retire an object unlinked from the shared data structure.
+     *
+     * \param[in] object The link embedded in the object.
+     * \param[in] reclaim The function called to reclaim the object once no Thread can be reading it.
+     *
+     * \pre ``object`` can't be reached from the shared data structure anymore.
+     * \remark ``reclaim`` may be called on any Thread using the domain.
+     */
+    void Retire(EpochRetiredObject *object,
+                EpochReclaimFunction reclaim) noexcept;
+
+    /**
+     * \short Try to advance the epoch of the domain and reclaim the objects of the current Thread that became safe.
+     *
+     * \return true if the epoch was advanced.
+     * \remark This is done automatically by EpochDomain::Retire.
+     */
+    bool TryAdvance() noexcept;
+
+    /**
+     * \short Wait until every object retired by the current Thread so far is reclaimed.
+     *
+     * \pre The current Thread isn't inside the domain.
+     */
+    void Synchronize() noexcept;
+
+    friend void detail::FinalizeThreadEpochRecords(
+        hs::os::Thread *thread) noexcept;
+};
+
+/**
+ * \short Pin the epoch of an EpochDomain for the duration of a scope.
+ */
+class EpochGuard {
+ private:
+    EpochDomain &domain;
+
+ public:
+    explicit EpochGuard(EpochDomain &domain) noexcept : domain(domain) {
+        this->domain.Enter();
+    }
+    __HS_DISALLOW_COPY(EpochGuard);
+    __HS_DISALLOW_ASSIGN(EpochGuard);
+
+    ~EpochGuard() noexcept { this->domain.Leave(); }
+};
+}  // namespace hs::util
@@ -0,0 +1,351 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/diag/diag_macro.hpp>
+#include <hs/hs_macro.hpp>
+#include <hs/mem/mem_accounting_api.hpp>
+#include <hs/mem/mem_heap_api.hpp>
+#include <hs/util/util_object_storage.hpp>
+
+namespace hs::util {
+namespace detail {
+/**
+ * \private
+ * \short Lock-free stack of slot indexes.
+ *
+ * The head packs the index of the first free slot with a tag incremented on every push to defeat ABA.
+ */
+class ObjectPoolFreeStack {
+ private:
+    static const uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+    volatile _Atomic(uint64_t) head;
+
+    static inline uint64_t MakeHead(uint32_t index, uint32_t tag) noexcept {
+        return (static_cast<uint64_t>(tag) << 32) | index;
+    }
+
+ public:
+    ObjectPoolFreeStack() noexcept : head(MakeHead(INVALID_INDEX, 0)) {}
+    __HS_DISALLOW_COPY(ObjectPoolFreeStack);
+    __HS_DISALLOW_ASSIGN(ObjectPoolFreeStack);
+
+    /**
+     * \short Pop a slot index from the stack.
+     *
+     * \param[in] out_index Where to write the index of the slot.
+     * \param[in] get_next_link A callable returning the link stored inside a slot.
+     *
+     * \return false if the stack was empty.
+     */
+    template <typename GetNextLink>
+    inline bool Pop(uint32_t *out_index, GetNextLink get_next_link) noexcept {
+        uint64_t current_head = atomic_load(&this->head);
+
+        while (true) {
+            uint32_t index = static_cast<uint32_t>(current_head);
+
+            if (index == INVALID_INDEX) {
+                return false;
+            }
+
+            // The slot may already have been reused by another thread, the
+            // tag makes the exchange fail in this case.
+            uint32_t next_index = atomic_load_explicit(get_next_link(index),
+                                                       memory_order_relaxed);
+            uint64_t new_head =
+                MakeHead(next_index, static_cast<uint32_t>(current_head >> 32));
+
+            if (atomic_compare_exchange_weak(&this->head, &current_head,
+                                             new_head)) {
+                *out_index = index;
+                return true;
+            }
+        }
+    }
+
+    /**
+     * \short Push a slot index to the stack.
+     *
+     * \param[in] index The index of the slot.
+     * \param[in] link The link stored inside the slot.
+     */
+    inline void Push(uint32_t index,
+                     volatile _Atomic(uint32_t) *link) noexcept {
+        uint64_t current_head = atomic_load(&this->head);
+
+        while (true) {
+            atomic_store_explicit(link, static_cast<uint32_t>(current_head),
+                                  memory_order_relaxed);
+            uint64_t new_head = MakeHead(
+                index, static_cast<uint32_t>(current_head >> 32) + 1);
+
+            if (atomic_compare_exchange_weak(&this->head, &current_head,
+                                             new_head)) {
+                return;
+            }
+        }
+    }
+};
+
+/**
+ * \private
+ * \short A slot of an object pool.
+ *
+ * While the slot is free, its first bytes hold the index of the next free slot.
+ */
+template <typename T>
+union ObjectPoolSlot {
+    ObjectStorage<T> storage;
+    volatile _Atomic(uint32_t) next;
+};
+}  // namespace detail
+
+/**
+ * \short A pool of up to N objects of type T whose storage is allocated by page sized slabs on demand.
+ *
+ * Acquiring and releasing an object are lock-free and O(1).
+ *
+ * \remark The slabs are taken from the allocator on first use and are only given back when the pool is destroyed.
+ * \remark The objects returned by ObjectPool::Acquire are not constructed.
+ *
+ * \tparam T The type of the objects.
+ * \tparam N The maximum count of objects.
+ * \tparam Allocator The allocator providing the slabs (see hs::mem::HeapAllocator and hs::mem::ArenaAllocator).
+ */
+template <typename T, size_t N, typename Allocator = hs::mem::HeapAllocator>
+class ObjectPool {
+ private:
+    typedef detail::ObjectPoolSlot<T> Slot;
+
+    // Every slab starts with the index of its first slot, slabs are aligned on
+    // their size so a slot can find its slab back by masking.
+    struct SlabHeader {
+        uint32_t first_index;
+    };
+
+    static const size_t PAGE_SIZE = 0x1000;
+    static const size_t SLOTS_OFFSET =
+        (sizeof(SlabHeader) + (alignof(Slot) - 1)) & ~(alignof(Slot) - 1);
+
+    static constexpr size_t GetSlabSize() noexcept {
+        size_t slab_size = PAGE_SIZE;
+
+        while (slab_size < SLOTS_OFFSET + sizeof(Slot)) {
+            slab_size *= 2;
+        }
+
+        return slab_size;
+    }
+
+    static const size_t SLAB_SIZE = GetSlabSize();
+    static const size_t SLOTS_PER_SLAB =
+        (SLAB_SIZE - SLOTS_OFFSET) / sizeof(Slot);
+    static const size_t SLAB_COUNT =
+        (N + (SLOTS_PER_SLAB - 1)) / SLOTS_PER_SLAB;
+
+    static_assert(N > 0 && N < 0xFFFFFFFF, "Invalid ObjectPool capacity");
+    static_assert(SLAB_SIZE <= 0x8000, "T is too big for an ObjectPool");
+
+    Allocator allocator;
+    detail::ObjectPoolFreeStack free_stack;
+    volatile _Atomic(uint32_t) next_unused_index;
+    _Atomic(SlabHeader *) volatile slabs[SLAB_COUNT];
+
+    static inline Slot *GetSlabSlot(SlabHeader *slab,
+                                    uint32_t index) noexcept {
+        auto slots = reinterpret_cast<Slot *>(
+            reinterpret_cast<uintptr_t>(slab) + SLOTS_OFFSET);
+        return &slots[index - slab->first_index];
+    }
+
+    inline Slot *GetSlot(uint32_t index) noexcept {
+        SlabHeader *slab = atomic_load_explicit(
+            &this->slabs[index / SLOTS_PER_SLAB], memory_order_acquire);
+        return GetSlabSlot(slab, index);
+    }
+
+    inline Slot *GetOrCreateSlot(uint32_t index) noexcept {
+        auto slab_entry = &this->slabs[index / SLOTS_PER_SLAB];
+        SlabHeader *slab =
+            atomic_load_explicit(slab_entry, memory_order_acquire);
+
+        if (slab == nullptr) {
+            auto new_slab = reinterpret_cast<SlabHeader *>(
+                this->allocator.Allocate(SLAB_SIZE, SLAB_SIZE));
+
+            if (new_slab == nullptr) {
+                return nullptr;
+            }
+
+            new_slab->first_index =
+                static_cast<uint32_t>(index / SLOTS_PER_SLAB * SLOTS_PER_SLAB);
+
+            // Another thread may have created the slab in the meantime.
+            if (atomic_compare_exchange_strong(slab_entry, &slab, new_slab)) {
+                slab = new_slab;
+                hs::mem::AccountMemory(hs::mem::MemoryTag::ObjectPool,
+                                       SLAB_SIZE);
+            } else {
+                this->allocator.Free(new_slab);
+            }
+        }
+
+        return GetSlabSlot(slab, index);
+    }
+
+ public:
+    explicit ObjectPool(Allocator allocator = Allocator()) noexcept
+        : allocator(allocator), free_stack(), next_unused_index(0), slabs() {}
+    __HS_DISALLOW_COPY(ObjectPool);
+    __HS_DISALLOW_ASSIGN(ObjectPool);
+
+    ~ObjectPool() noexcept {
+        for (size_t i = 0; i < SLAB_COUNT; i++) {
+            SlabHeader *slab = atomic_load(&this->slabs[i]);
+
+            if (slab != nullptr) {
+                this->allocator.Free(slab);
+                hs::mem::UnaccountMemory(hs::mem::MemoryTag::ObjectPool,
+                                         SLAB_SIZE);
+            }
+        }
+    }
+
+    /**
+     * \short Acquire the storage of an object from the pool.
+     *
+     * \return A pointer to uninitialized storage for a T or a null pointer if the pool is exhausted.
+     */
+    T *Acquire() noexcept {
+        uint32_t index;
+
+        bool has_free_slot = this->free_stack.Pop(
+            &index, [this](uint32_t i) { return &this->GetSlot(i)->next; });
+
+        if (has_free_slot) {
+            return this->GetSlot(index)->storage.GetPointer();
+        }
+
+        // Take a slot that was never used, its slab is created before the
+        // slot is claimed so running out of heap doesn't lose it.
+        Slot *slot;
+        index = atomic_load(&this->next_unused_index);
+        do {
+            if (index >= N) {
+                return nullptr;
+            }
+
+            slot = this->GetOrCreateSlot(index);
+            if (slot == nullptr) {
+                return nullptr;
+            }
+        } while (!atomic_compare_exchange_weak(&this->next_unused_index,
+                                               &index, index + 1));
+
+        return slot->storage.GetPointer();
+    }
+
+    /**
+     * \short Release the storage of an object to the pool.
+     *
+     * \param[in] object A pointer returned by ObjectPool::Acquire.
+     *
+     * \pre The object was destructed if needed.
+     * \post ``object`` must not be used anymore.
+     */
+    void Release(T *object) noexcept {
+        auto slot = reinterpret_cast<Slot *>(object);
+        auto slab = reinterpret_cast<SlabHeader *>(
+            reinterpret_cast<uintptr_t>(object) & ~(SLAB_SIZE - 1));
+        auto slots = reinterpret_cast<Slot *>(
+            reinterpret_cast<uintptr_t>(slab) + SLOTS_OFFSET);
+
+        this->free_stack.Push(
+            slab->first_index + static_cast<uint32_t>(slot - slots),
+            &slot->next);
+    }
+};
+
+/**
+ * \short A pool of N objects of type T whose storage is part of the pool itself.
+ *
+ * Acquiring and releasing an object are lock-free and O(1).
+ *
+ * \remark This is suitable for pools in static storage.
+ * \remark The objects returned by StaticObjectPool::Acquire are not constructed.
+ *
+ * \tparam T The type of the objects.
+ * \tparam N The count of objects.
+ */
+template <typename T, size_t N>
+class StaticObjectPool {
+ private:
+    typedef detail::ObjectPoolSlot<T> Slot;
+
+    static_assert(N > 0 && N < 0xFFFFFFFF,
+                  "Invalid StaticObjectPool capacity");
+
+    detail::ObjectPoolFreeStack free_stack;
+    volatile _Atomic(uint32_t) next_unused_index;
+    Slot slots[N];
+
+ public:
+    StaticObjectPool() noexcept : free_stack(), next_unused_index(0) {}
+    __HS_DISALLOW_COPY(StaticObjectPool);
+    __HS_DISALLOW_ASSIGN(StaticObjectPool);
+
+    /**
+     * \short Acquire the storage of an object from the pool.
+     *
+     * \return A pointer to uninitialized storage for a T or a null pointer if the pool is exhausted.
+     */
+    T *Acquire() noexcept {
+        uint32_t index;
+
+        bool has_free_slot = this->free_stack.Pop(
+            &index, [this](uint32_t i) { return &this->slots[i].next; });
+
+        if (!has_free_slot) {
+            index = atomic_load(&this->next_unused_index);
+            do {
+                if (index >= N) {
+                    return nullptr;
+                }
+            } while (!atomic_compare_exchange_weak(&this->next_unused_index,
+                                                   &index, index + 1));
+        }
+
+        return this->slots[index].storage.GetPointer();
+    }
+
+    /**
+     * \short Release the storage of an object to the pool.
+     *
+     * \param[in] object A pointer returned by StaticObjectPool::Acquire.
+     *
+     * \pre The object was destructed if needed.
+     * \post ``object`` must not be used anymore.
+     */
+    void Release(T *object) noexcept {
+        Slot *slot = reinterpret_cast<Slot *>(object);
+        __HS_ASSERT((slot >= this->slots && slot < this->slots + N));
+
+        this->free_stack.Push(static_cast<uint32_t>(slot - this->slots),
+                              &slot->next);
+    }
+};
+}  // namespace hs::util
@@ -12,6 +12,11 @@
 
 #include <stddef.h>
 
+namespace std {
+// The alignment tag of the aligned versions of operator new/delete.
+enum class align_val_t : size_t {};
+}  // namespace std
+
 // Default placement versions of operator new.
 inline void* operator new(size_t, void* __p) throw() { return __p; }
 inline void* operator new[](size_t, void* __p) throw() { return __p; }
@@ -33,5 +33,27 @@ template<class T, T v> struct integral_constant {
 template<class T> struct is_pod : public integral_constant<bool, __is_pod(T)>
 {};
 
+/**
+ * \short Provides the member typedef type which is the type referred to by T, or T if it is not a reference.
+ * \remark This is a simple implementation of std::remove_reference.
+ */
+template<class T> struct remove_reference { typedef T type; };
+template<class T> struct remove_reference<T&> { typedef T type; };
+template<class T> struct remove_reference<T&&> { typedef T type; };
+
+/**
+ * \short Forward an argument with the value category it was passed with.
+ * \remark This is a simple implementation of std::forward.
+ */
+template<class T>
+constexpr T&& Forward(typename remove_reference<T>::type& value) noexcept {
+    return static_cast<T&&>(value);
+}
+
+template<class T>
+constexpr T&& Forward(typename remove_reference<T>::type&& value) noexcept {
+    return static_cast<T&&>(value);
+}
+
 }  // namespace hs::util
 
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/diag/diag_macro.hpp>
+#include <hs/hs_macro.hpp>
+#include <hs/mem/mem_arena_api.hpp>
+#include <hs/util/util_std_new.hpp>
+#include <hs/util/util_template_api.hpp>
+
+namespace hs::util {
+/**
+ * \short A growable array of T whose elements never move.
+ *
+ * The virtual range of the maximum count of elements is reserved up front and memory is committed as the array grows and given back as it shrinks. Growing never reallocates nor copies the elements, pointers to the elements stay valid until they are removed.
+ *
+ * \remark The memory is committed by granules of 64KiB, this is suitable for big tables (entities, logs...).
+ * \remark A VirtualArray isn't thread safe.
+ *
+ * \tparam T The type of the elements.
+ */
+template <typename T>
+class VirtualArray {
+ private:
+    static_assert(alignof(T) <= 0x1000, "T is too aligned for a VirtualArray");
+
+    hs::mem::Arena arena;
+    T *elements;
+    size_t count;
+    size_t capacity;
+
+    // Make room for count elements at the end of the array.
+    bool Grow(size_t count) noexcept {
+        if (count > this->capacity - this->count) {
+            return false;
+        }
+
+        return this->arena.Allocate(count * sizeof(T), alignof(T)) != nullptr;
+    }
+
+    // Give back the memory past the elements once there is enough of it, so
+    // an array going back and forth around a granule boundary doesn't commit
+    // and release the same granule every time.
+    void TrimSlack() noexcept {
+        size_t committed_size = this->arena.GetCommittedSize();
+        size_t used_size =
+            (this->arena.GetUsedSize() + (hs::mem::ARENA_COMMIT_SIZE - 1)) &
+            ~(hs::mem::ARENA_COMMIT_SIZE - 1);
+        size_t slack_size = committed_size - used_size;
+
+        if (slack_size > 2 * hs::mem::ARENA_COMMIT_SIZE ||
+            slack_size > committed_size / 2) {
+            this->arena.Trim();
+        }
+    }
+
+ public:
+    VirtualArray() noexcept
+        : arena(), elements(nullptr), count(0), capacity(0) {}
+    __HS_DISALLOW_COPY(VirtualArray);
+    __HS_DISALLOW_ASSIGN(VirtualArray);
+
+    ~VirtualArray() noexcept {
+        if (this->elements != nullptr) {
+            this->Finalize();
+        }
+    }
+
+    /**
+     * \short Reserve the virtual range of the array.
+     *
+     * \param[in] capacity The maximum count of elements.
+     *
+     * \return true if the range was reserved.
+     *
+     * \pre The VirtualArray isn't initialized.
+     */
+    bool Initialize(size_t capacity) noexcept {
+        __HS_ASSERT(capacity != 0);
+
+        if (capacity > SIZE_MAX / sizeof(T) ||
+            !this->arena.Initialize(capacity * sizeof(T))) {
+            return false;
+        }
+
+        // The range is page aligned, the elements start at its beginning.
+        this->elements = reinterpret_cast<T *>(this->arena.Allocate(0, 1));
+        this->count = 0;
+        this->capacity = capacity;
+
+        return true;
+    }
+
+    /**
+     * \short Destroy the elements and give back the memory and the virtual range of the array.
+     *
+     * \pre The VirtualArray is initialized.
+     * \post The VirtualArray isn't initialized.
+     */
+    void Finalize() noexcept {
+        this->Clear();
+        this->arena.Finalize();
+
+        this->elements = nullptr;
+        this->capacity = 0;
+    }
+
+    /**
+     * \short Construct an element at the end of the array.
+     *
+     * \param[in] args The arguments given to the constructor of T.
+     *
+     * \return A pointer to the new element or a null pointer if the array is full or the heap is exhausted.
+     */
+    template <typename... Args>
+    T *EmplaceBack(Args &&... args) noexcept {
+        if (!this->Grow(1)) {
+            return nullptr;
+        }
+
+        T *element =
+            new (&this->elements[this->count]) T(Forward<Args>(args)...);
+        this->count++;
+
+        return element;
+    }
+
+    /**
+     * \short Copy an element at the end of the array.
+     *
+     * \param[in] value The element to copy.
+     *
+     * \return false if the array is full or the heap is exhausted.
+     */
+    bool PushBack(const T &value) noexcept {
+        return this->EmplaceBack(value) != nullptr;
+    }
+
+    /**
+     * \short Destroy the last element of the array.
+     *
+     * \pre The array isn't empty.
+     */
+    void PopBack() noexcept {
+        __HS_ASSERT(this->count != 0);
+
+        this->Resize(this->count - 1);
+    }
+
+    /**
+     * \short Change the count of elements of the array.
+     *
+     * New elements are value initialized, removed elements are destroyed and the memory that doesn't back any element anymore is given back once it is more than two granules or half of the committed memory (see VirtualArray::ShrinkToFit).
+     *
+     * \param[in] count The new count of elements.
+     *
+     * \return false if ``count`` is greater than the capacity or the heap is exhausted, the array is left untouched in this case.
+     */
+    bool Resize(size_t count) noexcept {
+        if (count > this->count) {
+            if (!this->Grow(count - this->count)) {
+                return false;
+            }
+
+            for (size_t i = this->count; i < count; i++) {
+                new (&this->elements[i]) T();
+            }
+        } else if (count < this->count) {
+            for (size_t i = count; i < this->count; i++) {
+                this->elements[i].~T();
+            }
+
+            this->arena.Rewind(count * sizeof(T));
+            this->TrimSlack();
+        }
+
+        this->count = count;
+        return true;
+    }
+
+    /**
+     * \short Destroy every element of the array.
+     */
+    inline void Clear() noexcept { this->Resize(0); }
+
+    /**
+     * \short Give back all the memory that doesn't back any element.
+     *
+     * \return The count of bytes given back to the heap.
+     * \remark The granule holding the end of the last element is kept.
+     */
+    inline size_t ShrinkToFit() noexcept { return this->arena.Trim(); }
+
+    /**
+     * \short Get the count of bytes of memory backing the array.
+     */
+    inline size_t GetCommittedSize() const noexcept {
+        return this->arena.GetCommittedSize();
+    }
+
+    /**
+     * \short Get an element of the array.
+     *
+     * \param[in] index The index of the element.
+     *
+     * \pre ``index`` is less than the count of elements.
+     */
+    inline T &operator[](size_t index) noexcept {
+        return this->elements[index];
+    }
+
+    /**
+     * \short Get an element of the array.
+     *
+     * \param[in] index The index of the element.
+     *
+     * \pre ``index`` is less than the count of elements.
+     */
+    inline const T &operator[](size_t index) const noexcept {
+        return this->elements[index];
+    }
+
+    /**
+     * \short Get a pointer to the first element of the array.
+     */
+    inline T *GetData() noexcept { return this->elements; }
+
+    /**
+     * \short Get a pointer to the first element of the array.
+     */
+    inline const T *GetData() const noexcept { return this->elements; }
+
+    /**
+     * \short Get the count of elements of the array.
+     */
+    inline size_t GetSize() const noexcept { return this->count; }
+
+    /**
+     * \short Get the maximum count of elements of the array.
+     */
+    inline size_t GetCapacity() const noexcept { return this->capacity; }
+
+    /**
+     * \short Check if the array doesn't have any element.
+     */
+    inline bool IsEmpty() const noexcept { return this->count == 0; }
+};
+}  // namespace hs::util
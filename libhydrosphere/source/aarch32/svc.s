@@ -202,8 +202,16 @@ SVC_END
 
 DEFINE_OUT00_SVC      0x32 _ZN2hs3svc7aarch3217SetThreadActivityENS0_6HandleENS0_14ThreadActivityE
 # TODO(Kaenbyō): [1.0.0+] 0x33 - GetThreadContext3
-# [4.0.0+] 0x34 - WaitForAddress
-# [4.0.0+] 0x35 - SignalToAddress
+SVC_BEGIN _ZN2hs3svc7aarch3214WaitForAddressEjNS0_15ArbitrationTypeEix
+    str r4, [sp, #-0x4]!
+    ldr r3, [sp, #0x4]
+    ldr r4, [sp, #0x8]
+    svc 0x34
+    pop {r4}
+    bx lr
+SVC_END
+
+DEFINE_OUT00_SVC      0x35 _ZN2hs3svc7aarch3215SignalToAddressEjNS0_10SignalTypeEii
 # [8.0.0+] 0x36 - SynchronizePreemptionState
 # [1.0.0+] 0x3C - DumpInfo (stubbed?)
 # [4.0.0+] 0x3D - DumpInfoNew (subbed?)
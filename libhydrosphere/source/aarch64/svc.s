@@ -141,8 +141,8 @@ DEFINE_OUT64_SVC      0x30 _ZN2hs3svc7aarch6426GetResourceLimitLimitValueEPmNS0_
 DEFINE_OUT64_SVC      0x31 _ZN2hs3svc7aarch6428GetResourceLimitCurrentValueEPmNS0_6HandleENS0_17LimitableResourceE
 DEFINE_OUT00_SVC      0x32 _ZN2hs3svc7aarch6417SetThreadActivityENS0_6HandleENS0_14ThreadActivityE
 # TODO(Kaenbyō): [1.0.0+] 0x33 - GetThreadContext3
-# [4.0.0+] 0x34 - WaitForAddress
-# [4.0.0+] 0x35 - SignalToAddress
+DEFINE_OUT00_SVC      0x34 _ZN2hs3svc7aarch6414WaitForAddressEmNS0_15ArbitrationTypeEil
+DEFINE_OUT00_SVC      0x35 _ZN2hs3svc7aarch6415SignalToAddressEmNS0_10SignalTypeEii
 # [8.0.0+] 0x36 - SynchronizePreemptionState
 # [1.0.0+] 0x3C - DumpInfo (stubbed?)
 # [4.0.0+] 0x3D - DumpInfoNew (subbed?)
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <hs/hs_macro.hpp>
+#include <hs/mem/mem_heap_api.hpp>
+#include <mem/detail/mem_heap.hpp>
+#include <util/util_string_api.hpp>
+
+// We define the C allocation functions on top of the heap as we don't have
+// any libraries that can provide them.
+// If there is any, as this is weak, it's going to be discared.
+// The allocations are attributed to the callers of these functions in the
+// allocation trace.
+extern "C" __HS_ATTRIBUTE_WEAK void *malloc(size_t size) {
+    return hs::mem::detail::AllocateFrom(size, hs::mem::HEAP_MINIMAL_ALIGNMENT,
+                                         __builtin_return_address(0));
+}
+
+extern "C" __HS_ATTRIBUTE_WEAK void free(void *ptr) {
+    hs::mem::detail::FreeFrom(ptr, __builtin_return_address(0));
+}
+
+extern "C" __HS_ATTRIBUTE_WEAK void *calloc(size_t count, size_t size) {
+    if (size != 0 && count > SIZE_MAX / size) {
+        return nullptr;
+    }
+
+    void *ptr = hs::mem::detail::AllocateFrom(
+        count * size, hs::mem::HEAP_MINIMAL_ALIGNMENT,
+        __builtin_return_address(0));
+
+    if (ptr != nullptr) {
+        memset(ptr, 0, count * size);
+    }
+
+    return ptr;
+}
+
+extern "C" __HS_ATTRIBUTE_WEAK void *realloc(void *ptr, size_t size) {
+    return hs::mem::detail::ReallocateFrom(ptr, size,
+                                           __builtin_return_address(0));
+}
+
+extern "C" __HS_ATTRIBUTE_WEAK void *memalign(size_t alignment, size_t size) {
+    return hs::mem::detail::AllocateFrom(size, alignment,
+                                         __builtin_return_address(0));
+}
+
+extern "C" __HS_ATTRIBUTE_WEAK void *aligned_alloc(size_t alignment,
+                                                   size_t size) {
+    return hs::mem::detail::AllocateFrom(size, alignment,
+                                         __builtin_return_address(0));
+}
+
+extern "C" __HS_ATTRIBUTE_WEAK size_t malloc_usable_size(void *ptr) {
+    return ptr == nullptr ? 0 : hs::mem::GetAllocationSize(ptr);
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <stddef.h>
+#include <hs/diag.hpp>
+#include <hs/hs_macro.hpp>
+#include <hs/mem/mem_heap_api.hpp>
+#include <hs/util/util_std_new.hpp>
+#include <mem/detail/mem_heap.hpp>
+#include <mem/detail/mem_size_class.hpp>
+
+// We define the global operator new/delete on top of the heap as we don't
+// have any libraries that can provide them. As we don't have exceptions, an
+// exhausted heap is fatal.
+// If there is any, as this is weak, it's going to be discared.
+// The allocations are attributed to the callers of these functions in the
+// allocation trace.
+
+static inline void *AllocateObject(size_t size, size_t alignment,
+                                   const void *return_address) noexcept {
+    void *ptr;
+
+    if (alignment <= hs::mem::HEAP_MINIMAL_ALIGNMENT &&
+        size <= hs::mem::detail::SIZE_CLASS_SMALL_MAX) {
+        ptr = hs::mem::detail::AllocateSizeClassFrom(
+            hs::mem::detail::GetSizeClassIndex(size), return_address);
+    } else {
+        ptr = hs::mem::detail::AllocateFrom(size, alignment, return_address);
+    }
+
+    __HS_ABORT_UNLESS_NOT_NULL(ptr);
+    return ptr;
+}
+
+__HS_ATTRIBUTE_WEAK void *operator new(size_t size) {
+    return AllocateObject(size, hs::mem::HEAP_MINIMAL_ALIGNMENT,
+                          __builtin_return_address(0));
+}
+
+__HS_ATTRIBUTE_WEAK void *operator new[](size_t size) {
+    return AllocateObject(size, hs::mem::HEAP_MINIMAL_ALIGNMENT,
+                          __builtin_return_address(0));
+}
+
+__HS_ATTRIBUTE_WEAK void *operator new(size_t size,
+                                       std::align_val_t alignment) {
+    return AllocateObject(size, static_cast<size_t>(alignment),
+                          __builtin_return_address(0));
+}
+
+__HS_ATTRIBUTE_WEAK void *operator new[](size_t size,
+                                         std::align_val_t alignment) {
+    return AllocateObject(size, static_cast<size_t>(alignment),
+                          __builtin_return_address(0));
+}
+
+__HS_ATTRIBUTE_WEAK void operator delete(void *ptr) noexcept {
+    hs::mem::detail::FreeFrom(ptr, __builtin_return_address(0));
+}
+
+__HS_ATTRIBUTE_WEAK void operator delete[](void *ptr) noexcept {
+    hs::mem::detail::FreeFrom(ptr, __builtin_return_address(0));
+}
+
+// The other versions of operator delete forward to the plain ones so that
+// replacing those is enough to take over every deallocation. The forwarding
+// is a tail call, the frees keep being attributed to the right callers.
+__HS_ATTRIBUTE_WEAK void operator delete(void *ptr, size_t) noexcept {
+    ::operator delete(ptr);
+}
+
+__HS_ATTRIBUTE_WEAK void operator delete[](void *ptr, size_t) noexcept {
+    ::operator delete[](ptr);
+}
+
+__HS_ATTRIBUTE_WEAK void operator delete(void *ptr,
+                                         std::align_val_t) noexcept {
+    ::operator delete(ptr);
+}
+
+__HS_ATTRIBUTE_WEAK void operator delete[](void *ptr,
+                                           std::align_val_t) noexcept {
+    ::operator delete[](ptr);
+}
+
+__HS_ATTRIBUTE_WEAK void operator delete(void *ptr, size_t,
+                                         std::align_val_t) noexcept {
+    ::operator delete(ptr);
+}
+
+__HS_ATTRIBUTE_WEAK void operator delete[](void *ptr, size_t,
+                                           std::align_val_t) noexcept {
+    ::operator delete[](ptr);
+}
@@ -14,6 +14,9 @@
 #include <hs/util.hpp>
 
 #include <hs/os/os_tls.hpp>
+#include <mem/detail/mem_heap.hpp>
+#include <os/detail/os_memory_map.hpp>
+#include <os/detail/os_stack_alias_cache.hpp>
 #include <os/detail/os_threadlist.hpp>
 #include <os/detail/os_virtualmemory_allocator.hpp>
 
@@ -56,10 +59,21 @@ void hs::init::Start(uint64_t thread_handle, uintptr_t argument_address,
     // Init main thread
     InitMainThread(svc::Handle::FromRawValue(thread_handle));
 
+    __HS_DEBUG_LOG("Initializing memory map");
+
+    // Init memory map
+    hs::os::detail::InitializeMemoryMap();
+
+    __HS_DEBUG_LOG("Initializing heap");
+
+    // Init heap
+    hs::mem::detail::InitializeHeap();
+
     __HS_DEBUG_LOG("Initializing virtual memory allocators");
 
     // Init virtual memory allocators
     hs::os::detail::InitializeVirtualMemoryAllocators();
+    hs::os::detail::InitializeStackAliasCache();
 
     // Ask rtld to call init fo all modules?
     call_initializator();
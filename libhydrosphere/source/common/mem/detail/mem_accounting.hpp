@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <hs/mem/mem_accounting_api.hpp>
+
+namespace hs::mem::detail {
+// Merge the counters of a tag without querying the kernel.
+MemoryUsage GetAccountedUsage(MemoryTag tag) noexcept;
+}  // namespace hs::mem::detail
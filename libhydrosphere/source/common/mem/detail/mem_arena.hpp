@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <hs/os/os_thread_api.hpp>
+
+namespace hs::mem::detail {
+// Finalize and destroy the arena of a thread.
+void FinalizeThreadArena(hs::os::Thread *thread) noexcept;
+}  // namespace hs::mem::detail
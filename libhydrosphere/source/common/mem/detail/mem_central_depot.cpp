@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/util/util_std_new.hpp>
+#include <mem/detail/mem_central_depot.hpp>
+#include <mem/detail/mem_page_heap.hpp>
+
+namespace hs::mem::detail {
+__HS_ATTRIBUTE_VISIBILITY_HIDDEN hs::util::ObjectStorage<CentralDepot, 0x40>
+    g_CentralDepot;
+
+SpanHeader *CentralDepot::CreateSlab(size_t size_class) noexcept {
+    void *span = g_PageHeap->AllocateSpans(1);
+
+    if (span == nullptr) {
+        return nullptr;
+    }
+
+    auto slab = new (span) SpanHeader();
+    slab->size_class = size_class;
+    slab->used_count = 0;
+    slab->span_count = 1;
+    slab->free_list = nullptr;
+    slab->bump_address = GetSpanObjectsAddress(slab);
+
+    return slab;
+}
+
+void *CentralDepot::PopObject(SpanHeader *slab, size_t object_size) noexcept {
+    void *object = slab->free_list;
+
+    if (object != nullptr) {
+        slab->free_list = *reinterpret_cast<void **>(object);
+    } else if (slab->bump_address + object_size <= GetSpanEndAddress(slab)) {
+        object = reinterpret_cast<void *>(slab->bump_address);
+        slab->bump_address += object_size;
+    } else {
+        return nullptr;
+    }
+
+    slab->used_count++;
+    return object;
+}
+
+size_t CentralDepot::Refill(size_t size_class, void **out_head,
+                            size_t count) noexcept {
+    auto &depot = this->depots[size_class];
+    size_t object_size = GetSizeClassSize(size_class);
+    size_t object_count = 0;
+    void *head = nullptr;
+
+    depot.critical_section.Enter();
+
+    while (object_count < count) {
+        if (depot.partial_slabs.empty()) {
+            auto new_slab = CreateSlab(size_class);
+
+            if (new_slab == nullptr) {
+                break;
+            }
+
+            depot.partial_slabs.push_front(*new_slab);
+            depot.partial_slab_count++;
+        }
+
+        auto &slab = depot.partial_slabs.front();
+
+        while (object_count < count) {
+            void *object = PopObject(&slab, object_size);
+
+            // The slab is full, remove it from the partial list.
+            if (object == nullptr) {
+                depot.partial_slabs.pop_front();
+                depot.partial_slab_count--;
+                break;
+            }
+
+            *reinterpret_cast<void **>(object) = head;
+            head = object;
+            object_count++;
+        }
+    }
+
+    depot.critical_section.Leave();
+
+    *out_head = head;
+    return object_count;
+}
+
+void CentralDepot::Release(size_t size_class, void *head) noexcept {
+    auto &depot = this->depots[size_class];
+
+    depot.critical_section.Enter();
+
+    while (head != nullptr) {
+        void *next = *reinterpret_cast<void **>(head);
+        auto slab = GetSpanHeader(head);
+
+        *reinterpret_cast<void **>(head) = slab->free_list;
+        slab->free_list = head;
+        slab->used_count--;
+
+        // The slab was full, it now has a free object.
+        if (!slab->HasNext()) {
+            depot.partial_slabs.push_front(*slab);
+            depot.partial_slab_count++;
+        }
+
+        // Give empty slabs back to the page heap but keep the last one around
+        // to avoid thrashing.
+        if (slab->used_count == 0 && depot.partial_slab_count > 1) {
+            slab->Unlink();
+            depot.partial_slab_count--;
+            g_PageHeap->FreeSpans(slab, slab->span_count);
+        }
+
+        head = next;
+    }
+
+    depot.critical_section.Leave();
+}
+
+void CentralDepot::ReleaseEmptySlabs() noexcept {
+    for (size_t size_class = 0; size_class < SIZE_CLASS_COUNT; size_class++) {
+        auto &depot = this->depots[size_class];
+
+        depot.critical_section.Enter();
+
+        auto iterator = depot.partial_slabs.begin();
+        while (iterator != depot.partial_slabs.end()) {
+            auto &slab = *iterator;
+            ++iterator;
+
+            if (slab.used_count == 0) {
+                slab.Unlink();
+                depot.partial_slab_count--;
+                g_PageHeap->FreeSpans(&slab, slab.span_count);
+            }
+        }
+
+        depot.critical_section.Leave();
+    }
+}
+}  // namespace hs::mem::detail
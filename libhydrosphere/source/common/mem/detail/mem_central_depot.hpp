@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/hs_macro.hpp>
+#include <hs/os/os_critical_section.hpp>
+#include <hs/util/util_intrusive_list.hpp>
+#include <hs/util/util_object_storage.hpp>
+#include <mem/detail/mem_size_class.hpp>
+#include <mem/detail/mem_span.hpp>
+
+namespace hs::mem::detail {
+// The central depot owns the slabs of every size class. Each size class has
+// its own lock so threads only contend when they refill or drain their caches
+// for the same size class.
+class CentralDepot {
+ private:
+    struct __HS_ATTRIBUTE_ALIGNED(0x40) SizeClassDepot {
+        hs::os::CriticalSection critical_section;
+        size_t partial_slab_count;
+        hs::util::IntrusiveList<SpanHeader> partial_slabs;
+    };
+
+    SizeClassDepot depots[SIZE_CLASS_COUNT];
+
+    static SpanHeader *CreateSlab(size_t size_class) noexcept;
+    static void *PopObject(SpanHeader *slab, size_t object_size) noexcept;
+
+ public:
+    CentralDepot() noexcept : depots() {}
+    __HS_DISALLOW_COPY(CentralDepot);
+
+    // Pop up to count objects of the given size class, chained through their
+    // first word. Returns the number of objects obtained.
+    size_t Refill(size_t size_class, void **out_head, size_t count) noexcept;
+
+    // Give back a null terminated chain of objects of the given size class.
+    void Release(size_t size_class, void *head) noexcept;
+
+    // Give the empty slabs kept around by every size class back to the page
+    // heap.
+    void ReleaseEmptySlabs() noexcept;
+};
+
+extern __HS_ATTRIBUTE_VISIBILITY_HIDDEN
+    hs::util::ObjectStorage<CentralDepot, 0x40>
+        g_CentralDepot;
+}  // namespace hs::mem::detail
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include <hs/os/os_thread_api.hpp>
+
+namespace hs::mem::detail {
+// Construct the page heap and the central depot.
+void InitializeHeap() noexcept;
+
+// Flush and destroy the heap cache of a thread.
+void FinalizeThreadHeapCache(hs::os::Thread *thread) noexcept;
+
+// Heap entry points taking the address the allocation is attributed to by the
+// allocation trace, used by the wrappers of the heap (malloc, operator new).
+void *AllocateFrom(size_t size, size_t alignment,
+                   const void *return_address) noexcept;
+void *ReallocateFrom(void *ptr, size_t size,
+                     const void *return_address) noexcept;
+void FreeFrom(void *ptr, const void *return_address) noexcept;
+
+// Heap entry points for small blocks whose size class is known by the caller.
+// The block must have been allocated with a minimal alignment.
+void *AllocateSizeClassFrom(size_t size_class,
+                            const void *return_address) noexcept;
+void FreeSizeClassFrom(void *ptr, size_t size_class,
+                       const void *return_address) noexcept;
+}  // namespace hs::mem::detail
@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/svc.hpp>
+#include <mem/detail/mem_page_heap.hpp>
+#include <mem/detail/mem_pressure.hpp>
+#include <mem/detail/mem_span.hpp>
+#include <os/detail/os_memory_map.hpp>
+
+namespace hs::mem::detail {
+__HS_ATTRIBUTE_VISIBILITY_HIDDEN hs::util::ObjectStorage<PageHeap> g_PageHeap;
+
+bool PageHeap::GrowUnsafe(size_t size) noexcept {
+    size_t new_heap_size = (this->heap_size + size +
+                            (HEAP_SIZE_GRANULARITY - 1)) &
+                           ~(HEAP_SIZE_GRANULARITY - 1);
+    uintptr_t address;
+
+    auto result = hs::svc::SetHeapSize(&address, new_heap_size);
+    if (result.Err()) {
+        return false;
+    }
+
+    // The heap region never moves, we only need to know where it starts once.
+    if (this->heap_address == 0) {
+        this->heap_address = address;
+    }
+
+    hs::os::detail::g_MemoryMap->Update(
+        this->heap_address + this->heap_size, new_heap_size - this->heap_size,
+        hs::svc::MemoryType::Normal, 0,
+        hs::svc::MemoryPermission::Read | hs::svc::MemoryPermission::Write);
+
+    this->InsertFreeRunUnsafe(this->heap_address + this->heap_size,
+                              new_heap_size - this->heap_size);
+    this->heap_size = new_heap_size;
+    atomic_store_explicit(&g_HasHeapGrown, true, memory_order_relaxed);
+
+    return true;
+}
+
+void PageHeap::InsertFreeRunUnsafe(uintptr_t address, size_t size) noexcept {
+    FreeRun *previous = nullptr;
+    FreeRun *next = this->free_runs;
+
+    while (next != nullptr && reinterpret_cast<uintptr_t>(next) < address) {
+        previous = next;
+        next = next->next;
+    }
+
+    auto run = reinterpret_cast<FreeRun *>(address);
+    run->next = next;
+    run->size = size;
+
+    // Coalesce with the following run
+    if (next != nullptr &&
+        address + size == reinterpret_cast<uintptr_t>(next)) {
+        run->size += next->size;
+        run->next = next->next;
+    }
+
+    // Coalesce with the preceding run
+    if (previous == nullptr) {
+        this->free_runs = run;
+    } else if (reinterpret_cast<uintptr_t>(previous) + previous->size ==
+               address) {
+        previous->size += run->size;
+        previous->next = run->next;
+    } else {
+        previous->next = run;
+    }
+}
+
+void *PageHeap::AllocateSpans(size_t span_count, size_t alignment) noexcept {
+    size_t size = span_count * SPAN_SIZE;
+
+    this->critical_section.Enter();
+
+    while (true) {
+        FreeRun **link = &this->free_runs;
+
+        // First fit, we carve the run from its first aligned address to keep
+        // the end of the heap free.
+        while (*link != nullptr) {
+            FreeRun *run = *link;
+            uintptr_t run_address = reinterpret_cast<uintptr_t>(run);
+            uintptr_t run_end = run_address + run->size;
+            uintptr_t address =
+                (run_address + (alignment - 1)) & ~(alignment - 1);
+
+            if (address < run_end && run_end - address >= size) {
+                FreeRun *next = run->next;
+
+                // Keep what is after the allocation.
+                if (address + size < run_end) {
+                    auto remaining =
+                        reinterpret_cast<FreeRun *>(address + size);
+                    remaining->next = next;
+                    remaining->size = run_end - (address + size);
+                    next = remaining;
+                }
+
+                // Keep what is before the allocation.
+                if (address != run_address) {
+                    run->size = address - run_address;
+                    run->next = next;
+                } else {
+                    *link = next;
+                }
+
+                this->critical_section.Leave();
+                return reinterpret_cast<void *>(address);
+            }
+
+            link = &run->next;
+        }
+
+        // Grow enough for the worst case alignment padding.
+        if (!this->GrowUnsafe(size + (alignment - SPAN_SIZE))) {
+            break;
+        }
+    }
+
+    this->critical_section.Leave();
+    return nullptr;
+}
+
+void PageHeap::FreeSpans(void *address, size_t span_count) noexcept {
+    this->critical_section.Enter();
+    this->InsertFreeRunUnsafe(reinterpret_cast<uintptr_t>(address),
+                              span_count * SPAN_SIZE);
+    this->critical_section.Leave();
+}
+
+size_t PageHeap::Trim() noexcept {
+    size_t released_size = 0;
+
+    this->critical_section.Enter();
+
+    uintptr_t heap_end = this->heap_address + this->heap_size;
+    FreeRun **link = &this->free_runs;
+
+    while (*link != nullptr && (*link)->next != nullptr) {
+        link = &(*link)->next;
+    }
+
+    FreeRun *run = *link;
+    uintptr_t run_address = reinterpret_cast<uintptr_t>(run);
+
+    // Only the end of the heap can be given back.
+    if (run != nullptr && run_address + run->size == heap_end) {
+        size_t new_heap_size =
+            (run_address - this->heap_address + (HEAP_SIZE_GRANULARITY - 1)) &
+            ~(HEAP_SIZE_GRANULARITY - 1);
+        uintptr_t address;
+
+        if (new_heap_size < this->heap_size &&
+            hs::svc::SetHeapSize(&address, new_heap_size).Ok()) {
+            uintptr_t new_heap_end = this->heap_address + new_heap_size;
+
+            hs::os::detail::g_MemoryMap->Update(
+                new_heap_end, heap_end - new_heap_end,
+                hs::svc::MemoryType::Free, 0, hs::svc::MemoryPermission::None);
+
+            if (new_heap_end == run_address) {
+                *link = nullptr;
+            } else {
+                run->size = new_heap_end - run_address;
+            }
+
+            released_size = heap_end - new_heap_end;
+            this->heap_size = new_heap_size;
+        }
+    }
+
+    this->critical_section.Leave();
+
+    return released_size;
+}
+}  // namespace hs::mem::detail
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/hs_macro.hpp>
+#include <hs/os/os_critical_section.hpp>
+#include <hs/util/util_object_storage.hpp>
+#include <mem/detail/mem_span.hpp>
+
+namespace hs::mem::detail {
+// The heap region can only be resized by multiple of 2MiB.
+const size_t HEAP_SIZE_GRANULARITY = 0x200000;
+
+class PageHeap {
+ private:
+    // Free runs are stored inside the free memory itself, sorted by address.
+    struct FreeRun {
+        FreeRun *next;
+        size_t size;
+    };
+
+    hs::os::CriticalSection critical_section;
+    uintptr_t heap_address;
+    size_t heap_size;
+    FreeRun *free_runs;
+
+    bool GrowUnsafe(size_t size) noexcept;
+    void InsertFreeRunUnsafe(uintptr_t address, size_t size) noexcept;
+
+ public:
+    PageHeap() noexcept
+        : critical_section(), heap_address(0), heap_size(0),
+          free_runs(nullptr) {}
+    __HS_DISALLOW_COPY(PageHeap);
+
+    // Allocate contiguous spans starting at a multiple of alignment, which
+    // must be a power of two multiple of the span size.
+    void *AllocateSpans(size_t span_count,
+                        size_t alignment = SPAN_SIZE) noexcept;
+    void FreeSpans(void *address, size_t span_count) noexcept;
+
+    // Shrink the heap to the end of the last used span, returns the count of
+    // bytes given back to the kernel.
+    size_t Trim() noexcept;
+};
+
+extern __HS_ATTRIBUTE_VISIBILITY_HIDDEN hs::util::ObjectStorage<PageHeap>
+    g_PageHeap;
+}  // namespace hs::mem::detail
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+
+#include <hs/hs_macro.hpp>
+#include <hs/mem/mem_pressure_api.hpp>
+#include <hs/os/os_critical_section.hpp>
+#include <hs/util/util_intrusive_list.hpp>
+#include <hs/util/util_object_storage.hpp>
+
+namespace hs::mem::detail {
+class MemoryPressureRegistry {
+ private:
+    hs::os::CriticalSection critical_section;
+    hs::util::IntrusiveList<MemoryPressureCallback> callbacks;
+
+    // Held for the whole dispatch, the count tells the threads waiting on it
+    // that a dispatch completed meanwhile.
+    hs::os::CriticalSection dispatch_critical_section;
+    volatile _Atomic(uint32_t) dispatch_count;
+
+ public:
+    volatile _Atomic(size_t) heap_budget;
+
+    MemoryPressureRegistry() noexcept
+        : critical_section(),
+          callbacks(),
+          dispatch_critical_section(),
+          dispatch_count(0),
+          heap_budget(0) {}
+    __HS_DISALLOW_COPY(MemoryPressureRegistry);
+
+    void Register(MemoryPressureCallback *callback) noexcept;
+    void Unregister(MemoryPressureCallback *callback) noexcept;
+
+    // Invoke the callbacks and trim the heap. If another thread is
+    // dispatching, wait for it to complete instead. Returns false if called
+    // from a callback.
+    bool Dispatch(size_t *out_released_size) noexcept;
+};
+
+extern __HS_ATTRIBUTE_VISIBILITY_HIDDEN
+    hs::util::ObjectStorage<MemoryPressureRegistry>
+        g_MemoryPressureRegistry;
+
+// Set by the page heap when it grows, the budget is checked by the next
+// allocation as the page heap can't call back with its lock held.
+extern __HS_ATTRIBUTE_VISIBILITY_HIDDEN volatile _Atomic(bool) g_HasHeapGrown;
+
+void CheckHeapMemoryBudgetSlow() noexcept;
+
+// Must be called without any heap lock held.
+inline void CheckHeapMemoryBudget() noexcept {
+    if (atomic_load_explicit(&g_HasHeapGrown, memory_order_relaxed)) {
+        CheckHeapMemoryBudgetSlow();
+    }
+}
+}  // namespace hs::mem::detail
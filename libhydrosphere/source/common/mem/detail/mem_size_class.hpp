@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/mem/mem_heap_api.hpp>
+
+namespace hs::mem::detail {
+// The mapping of sizes to size classes is public so hs::mem::New can resolve
+// it at compile time.
+const size_t SIZE_CLASS_COUNT = 32;
+const size_t SIZE_CLASS_SMALL_MAX = HEAP_SMALL_BLOCK_SIZE_MAX;
+const uint32_t SIZE_CLASS_LARGE = 0xFFFFFFFF;
+
+constexpr size_t GetSizeClassIndex(size_t size) noexcept {
+    return GetHeapSizeClass(size);
+}
+
+constexpr size_t GetSizeClassSize(size_t index) noexcept {
+    if (index < 8) {
+        return (index + 1) << 4;
+    }
+
+    size_t band_size = static_cast<size_t>(0x80) << ((index - 8) / 4);
+    return band_size + ((index - 8) % 4 + 1) * (band_size / 4);
+}
+
+// Number of objects moved between a thread cache and the central depot at
+// once.
+constexpr size_t GetSizeClassBatchSize(size_t index) noexcept {
+    size_t batch_size = 0x1000 / GetSizeClassSize(index);
+
+    if (batch_size < 4) {
+        return 4;
+    } else if (batch_size > 64) {
+        return 64;
+    }
+
+    return batch_size;
+}
+
+static_assert(GetSizeClassIndex(SIZE_CLASS_SMALL_MAX) == SIZE_CLASS_COUNT - 1,
+              "invalid size class table");
+static_assert(GetSizeClassSize(SIZE_CLASS_COUNT - 1) == SIZE_CLASS_SMALL_MAX,
+              "invalid size class table");
+}  // namespace hs::mem::detail
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/util/util_intrusive_list.hpp>
+
+namespace hs::mem::detail {
+const size_t SPAN_SIZE = 0x10000;
+const size_t SPAN_HEADER_SIZE = 0x40;
+
+// A span is the unit handed out by the page heap. Every span starts with this
+// header so any pointer inside the first SPAN_SIZE bytes of an allocation can
+// find it back by masking.
+struct SpanHeader : public hs::util::IntrusiveListElement<> {
+    // The size class of the slab or SIZE_CLASS_LARGE.
+    uint32_t size_class;
+
+    // Count of objects of the slab currently allocated.
+    uint32_t used_count;
+
+    // Count of contiguous spans covered by this allocation.
+    size_t span_count;
+
+    // Objects of the slab that were freed.
+    void *free_list;
+
+    // Address of the first never allocated object of the slab.
+    uintptr_t bump_address;
+};
+
+static_assert(sizeof(SpanHeader) <= SPAN_HEADER_SIZE, "SpanHeader too big");
+
+inline SpanHeader *GetSpanHeader(const void *ptr) noexcept {
+    return reinterpret_cast<SpanHeader *>(reinterpret_cast<uintptr_t>(ptr) &
+                                          ~(SPAN_SIZE - 1));
+}
+
+inline uintptr_t GetSpanObjectsAddress(const SpanHeader *span) noexcept {
+    return reinterpret_cast<uintptr_t>(span) + SPAN_HEADER_SIZE;
+}
+
+inline uintptr_t GetSpanEndAddress(const SpanHeader *span) noexcept {
+    return reinterpret_cast<uintptr_t>(span) + span->span_count * SPAN_SIZE;
+}
+}  // namespace hs::mem::detail
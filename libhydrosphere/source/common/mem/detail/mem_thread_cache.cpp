@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/os/os_tls.hpp>
+#include <hs/util/util_std_new.hpp>
+#include <mem/detail/mem_heap.hpp>
+#include <mem/detail/mem_thread_cache.hpp>
+
+namespace hs::mem::detail {
+// The thread caches are allocated from the central depot directly.
+static constexpr size_t THREAD_CACHE_SIZE_CLASS =
+    GetSizeClassIndex(sizeof(ThreadCache));
+
+void ThreadCache::Drain(size_t size_class, size_t count) noexcept {
+    auto &bin = this->bins[size_class];
+
+    if (count > bin.count) {
+        count = bin.count;
+    }
+
+    if (count == 0) {
+        return;
+    }
+
+    // Detach the first count objects of the bin.
+    void *head = bin.head;
+    void *last = head;
+
+    for (size_t i = 1; i < count; i++) {
+        last = *reinterpret_cast<void **>(last);
+    }
+
+    bin.head = *reinterpret_cast<void **>(last);
+    bin.count -= count;
+    *reinterpret_cast<void **>(last) = nullptr;
+
+    g_CentralDepot->Release(size_class, head);
+}
+
+void ThreadCache::Flush() noexcept {
+    for (size_t size_class = 0; size_class < SIZE_CLASS_COUNT; size_class++) {
+        this->Drain(size_class, this->bins[size_class].count);
+    }
+}
+
+ThreadCache *GetCurrentThreadCache() noexcept {
+    auto thread =
+        hs::os::ThreadLocalStorage::GetThreadLocalStorage()->GetThreadContext();
+
+    if (thread == nullptr) {
+        return nullptr;
+    }
+
+    if (thread->heap_cache == nullptr) {
+        void *storage;
+
+        if (g_CentralDepot->Refill(THREAD_CACHE_SIZE_CLASS, &storage, 1) ==
+            0) {
+            return nullptr;
+        }
+
+        thread->heap_cache = new (storage) ThreadCache();
+    }
+
+    return reinterpret_cast<ThreadCache *>(thread->heap_cache);
+}
+
+void FlushCurrentThreadHeapCache() noexcept {
+    auto thread =
+        hs::os::ThreadLocalStorage::GetThreadLocalStorage()->GetThreadContext();
+
+    if (thread == nullptr || thread->heap_cache == nullptr) {
+        return;
+    }
+
+    reinterpret_cast<ThreadCache *>(thread->heap_cache)->Flush();
+}
+
+void FinalizeThreadHeapCache(hs::os::Thread *thread) noexcept {
+    auto cache = reinterpret_cast<ThreadCache *>(thread->heap_cache);
+
+    if (cache == nullptr) {
+        return;
+    }
+
+    thread->heap_cache = nullptr;
+    cache->Flush();
+
+    *reinterpret_cast<void **>(cache) = nullptr;
+    g_CentralDepot->Release(THREAD_CACHE_SIZE_CLASS, cache);
+}
+}  // namespace hs::mem::detail
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/hs_macro.hpp>
+#include <hs/os/os_thread_api.hpp>
+#include <mem/detail/mem_central_depot.hpp>
+#include <mem/detail/mem_size_class.hpp>
+
+namespace hs::mem::detail {
+// Per thread magazines of free objects, one per size class. Only the owning
+// thread touches them so no locking is needed.
+class ThreadCache {
+ private:
+    struct Bin {
+        void *head;
+        size_t count;
+    };
+
+    Bin bins[SIZE_CLASS_COUNT];
+
+    void Drain(size_t size_class, size_t count) noexcept;
+
+ public:
+    ThreadCache() noexcept : bins() {}
+    __HS_DISALLOW_COPY(ThreadCache);
+
+    inline void *Allocate(size_t size_class) noexcept {
+        auto &bin = this->bins[size_class];
+
+        if (bin.head == nullptr) {
+            bin.count = g_CentralDepot->Refill(
+                size_class, &bin.head, GetSizeClassBatchSize(size_class));
+
+            if (bin.head == nullptr) {
+                return nullptr;
+            }
+        }
+
+        void *object = bin.head;
+        bin.head = *reinterpret_cast<void **>(object);
+        bin.count--;
+
+        return object;
+    }
+
+    inline void Free(void *object, size_t size_class) noexcept {
+        auto &bin = this->bins[size_class];
+
+        *reinterpret_cast<void **>(object) = bin.head;
+        bin.head = object;
+        bin.count++;
+
+        if (bin.count >= GetSizeClassBatchSize(size_class) * 2) {
+            this->Drain(size_class, GetSizeClassBatchSize(size_class));
+        }
+    }
+
+    // Give every cached object back to the central depot.
+    void Flush() noexcept;
+};
+
+// Get the heap cache of the current thread, creating it if needed. Returns a
+// null pointer if the current thread doesn't have a context or if the cache
+// couldn't be allocated.
+ThreadCache *GetCurrentThreadCache() noexcept;
+
+// Give every object cached by the current thread back to the central depot.
+void FlushCurrentThreadHeapCache() noexcept;
+}  // namespace hs::mem::detail
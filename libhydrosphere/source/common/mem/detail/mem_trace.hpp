@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include <hs/hs_macro.hpp>
+#include <hs/mem/mem_trace_api.hpp>
+#include <hs/os/os_thread_api.hpp>
+
+namespace hs::mem::detail {
+extern __HS_ATTRIBUTE_VISIBILITY_HIDDEN volatile _Atomic(bool)
+    g_IsAllocationTracingEnabled;
+
+void TraceAllocationSlow(AllocationTraceEvent event, const void *address,
+                         size_t size, const void *return_address) noexcept;
+
+// Record an event in the trace buffer of the current thread. This is a single
+// relaxed load while tracing is disabled.
+inline void TraceAllocation(AllocationTraceEvent event, const void *address,
+                            size_t size, const void *return_address) noexcept {
+    if (atomic_load_explicit(&g_IsAllocationTracingEnabled,
+                             memory_order_relaxed)) {
+        TraceAllocationSlow(event, address, size, return_address);
+    }
+}
+
+// Flush and destroy the allocation trace buffer of a thread.
+void FinalizeThreadAllocationTrace(hs::os::Thread *thread) noexcept;
+}  // namespace hs::mem::detail
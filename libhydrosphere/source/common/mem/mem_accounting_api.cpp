@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <stdatomic.h>
+
+#include <hs/mem/mem_accounting_api.hpp>
+#include <hs/os/os_api.hpp>
+#include <hs/os/os_tls.hpp>
+#include <hs/svc.hpp>
+#include <mem/detail/mem_accounting.hpp>
+
+namespace hs::mem {
+// One stripe per core, each on its own cache line.
+static const size_t ACCOUNTING_STRIPE_COUNT = 4;
+
+struct alignas(0x40) AccountingStripe {
+    volatile _Atomic(int64_t) sizes[MEMORY_TAG_COUNT];
+    volatile _Atomic(int64_t) block_counts[MEMORY_TAG_COUNT];
+};
+
+// Zero initialized, this is usable before the heap is initialized.
+__HS_ATTRIBUTE_VISIBILITY_HIDDEN AccountingStripe
+    g_AccountingStripes[ACCOUNTING_STRIPE_COUNT];
+
+static inline AccountingStripe &GetCurrentStripe() noexcept {
+    // The TLS regions are 0x200 bytes apart, neighbour threads get different
+    // stripes.
+    auto tls_address = reinterpret_cast<uintptr_t>(
+        hs::os::ThreadLocalStorage::GetThreadLocalStorage());
+
+    return g_AccountingStripes[(tls_address >> 9) % ACCOUNTING_STRIPE_COUNT];
+}
+
+static inline void AddToStripe(MemoryTag tag, int64_t size,
+                               int64_t block_count) noexcept {
+    auto &stripe = GetCurrentStripe();
+    size_t index = static_cast<size_t>(tag);
+
+    atomic_fetch_add_explicit(&stripe.sizes[index], size,
+                              memory_order_relaxed);
+    atomic_fetch_add_explicit(&stripe.block_counts[index], block_count,
+                              memory_order_relaxed);
+}
+
+void AccountMemory(MemoryTag tag, size_t size) noexcept {
+    AddToStripe(tag, static_cast<int64_t>(size), 1);
+}
+
+void UnaccountMemory(MemoryTag tag, size_t size) noexcept {
+    AddToStripe(tag, -static_cast<int64_t>(size), -1);
+}
+
+namespace detail {
+MemoryUsage GetAccountedUsage(MemoryTag tag) noexcept {
+    size_t index = static_cast<size_t>(tag);
+    int64_t size = 0;
+    int64_t block_count = 0;
+
+    // A block can be accounted on a stripe and unaccounted on another, only
+    // the sum is meaningful.
+    for (size_t i = 0; i < ACCOUNTING_STRIPE_COUNT; i++) {
+        size += atomic_load_explicit(&g_AccountingStripes[i].sizes[index],
+                                     memory_order_relaxed);
+        block_count += atomic_load_explicit(
+            &g_AccountingStripes[i].block_counts[index], memory_order_relaxed);
+    }
+
+    MemoryUsage usage;
+    usage.size = size > 0 ? static_cast<size_t>(size) : 0;
+    usage.block_count = block_count > 0 ? static_cast<size_t>(block_count) : 0;
+
+    return usage;
+}
+}  // namespace detail
+
+hs::Result GetMemoryUsageSnapshot(MemoryUsageSnapshot *out_snapshot) noexcept {
+    for (size_t index = 0; index < MEMORY_TAG_COUNT; index++) {
+        out_snapshot->usages[index] =
+            detail::GetAccountedUsage(static_cast<MemoryTag>(index));
+    }
+
+    out_snapshot->process_total_memory_size = 0;
+    out_snapshot->process_used_memory_size = 0;
+
+    auto result = hs::svc::GetInfo(&out_snapshot->process_total_memory_size,
+                                   hs::svc::InfoType::TotalMemorySize,
+                                   hs::os::GetProcessPseudoHandle(), 0);
+    if (result.Err()) {
+        return result;
+    }
+
+    return hs::svc::GetInfo(&out_snapshot->process_used_memory_size,
+                            hs::svc::InfoType::UsedMemorySize,
+                            hs::os::GetProcessPseudoHandle(), 0);
+}
+}  // namespace hs::mem
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/diag.hpp>
+#include <hs/mem/mem_accounting_api.hpp>
+#include <hs/mem/mem_arena_api.hpp>
+#include <hs/os/os_tls.hpp>
+#include <hs/svc.hpp>
+#include <hs/util/util_std_new.hpp>
+#include <mem/detail/mem_arena.hpp>
+#include <mem/detail/mem_page_heap.hpp>
+#include <mem/detail/mem_span.hpp>
+#include <os/detail/os_memory_map.hpp>
+#include <os/detail/os_virtualmemory_allocator.hpp>
+
+namespace hs::mem {
+// The arena is backed by heap spans aliased in the stack region.
+static_assert(ARENA_COMMIT_SIZE == detail::SPAN_SIZE,
+              "An Arena granule must be a heap span");
+
+bool Arena::Initialize(size_t size) noexcept {
+    size = (size + (ARENA_COMMIT_SIZE - 1)) & ~(ARENA_COMMIT_SIZE - 1);
+
+    // Only the stack region accepts aliases made by svc::MapMemory.
+    void *address = hs::os::detail::g_StackAllocator->Reserve(size, 0x1000);
+    if (address == nullptr) {
+        return false;
+    }
+
+    auto backing_blocks = reinterpret_cast<uintptr_t *>(
+        hs::mem::Allocate(size / ARENA_COMMIT_SIZE * sizeof(uintptr_t)));
+    if (backing_blocks == nullptr) {
+        hs::os::detail::g_StackAllocator->Free(address);
+        return false;
+    }
+
+    this->address = reinterpret_cast<uintptr_t>(address);
+    this->size = size;
+    this->committed_size = 0;
+    this->current_offset = 0;
+    this->backing_blocks = backing_blocks;
+
+    return true;
+}
+
+void Arena::Finalize() noexcept {
+    this->current_offset = 0;
+    this->Trim();
+
+    hs::os::detail::g_StackAllocator->Free(
+        reinterpret_cast<void *>(this->address));
+    hs::mem::Free(this->backing_blocks);
+
+    this->address = 0;
+    this->size = 0;
+    this->committed_size = 0;
+    this->current_offset = 0;
+    this->backing_blocks = nullptr;
+}
+
+size_t Arena::Trim() noexcept {
+    size_t used_size = (this->current_offset + (ARENA_COMMIT_SIZE - 1)) &
+                       ~(ARENA_COMMIT_SIZE - 1);
+    size_t released_size = 0;
+
+    while (this->committed_size > used_size) {
+        this->committed_size -= ARENA_COMMIT_SIZE;
+
+        uintptr_t block =
+            this->backing_blocks[this->committed_size / ARENA_COMMIT_SIZE];
+
+        auto result =
+            hs::os::detail::UnmapMemory(this->address + this->committed_size,
+                                        block, ARENA_COMMIT_SIZE);
+        __HS_ABORT_CONDITIONAL_RESULT(result.Ok(), result);
+
+        detail::g_PageHeap->FreeSpans(reinterpret_cast<void *>(block), 1);
+        UnaccountMemory(MemoryTag::Arena, ARENA_COMMIT_SIZE);
+
+        released_size += ARENA_COMMIT_SIZE;
+    }
+
+    return released_size;
+}
+
+bool Arena::Commit() noexcept {
+    void *block = detail::g_PageHeap->AllocateSpans(1);
+    if (block == nullptr) {
+        return false;
+    }
+
+    auto result = hs::os::detail::MapMemory(
+        this->address + this->committed_size,
+        reinterpret_cast<uintptr_t>(block), ARENA_COMMIT_SIZE);
+    if (result.Err()) {
+        detail::g_PageHeap->FreeSpans(block, 1);
+        return false;
+    }
+
+    this->backing_blocks[this->committed_size / ARENA_COMMIT_SIZE] =
+        reinterpret_cast<uintptr_t>(block);
+    this->committed_size += ARENA_COMMIT_SIZE;
+    AccountMemory(MemoryTag::Arena, ARENA_COMMIT_SIZE);
+
+    return true;
+}
+
+void *Arena::Allocate(size_t size, size_t alignment) noexcept {
+    __HS_ASSERT((alignment & (alignment - 1)) == 0);
+
+    uintptr_t start_address =
+        (this->address + this->current_offset + (alignment - 1)) &
+        ~(alignment - 1);
+    size_t start_offset = start_address - this->address;
+
+    if (start_offset > this->size || size > this->size - start_offset) {
+        return nullptr;
+    }
+
+    size_t end_offset = start_offset + size;
+
+    while (this->committed_size < end_offset) {
+        if (!this->Commit()) {
+            return nullptr;
+        }
+    }
+
+    this->current_offset = end_offset;
+    return reinterpret_cast<void *>(start_address);
+}
+
+Arena *GetThreadArena() noexcept {
+    auto thread =
+        hs::os::ThreadLocalStorage::GetThreadLocalStorage()->GetThreadContext();
+
+    if (thread == nullptr) {
+        return nullptr;
+    }
+
+    if (thread->arena == nullptr) {
+        void *storage = Allocate(sizeof(Arena));
+        if (storage == nullptr) {
+            return nullptr;
+        }
+
+        auto arena = new (storage) Arena();
+        if (!arena->Initialize(THREAD_ARENA_SIZE)) {
+            Free(storage);
+            return nullptr;
+        }
+
+        thread->arena = arena;
+    }
+
+    return reinterpret_cast<Arena *>(thread->arena);
+}
+
+namespace detail {
+void FinalizeThreadArena(hs::os::Thread *thread) noexcept {
+    auto arena = reinterpret_cast<Arena *>(thread->arena);
+
+    if (arena == nullptr) {
+        return;
+    }
+
+    thread->arena = nullptr;
+    arena->Finalize();
+    Free(arena);
+}
+}  // namespace detail
+}  // namespace hs::mem
@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <stdint.h>
+
+#include <hs/diag.hpp>
+#include <hs/mem/mem_accounting_api.hpp>
+#include <hs/mem/mem_heap_api.hpp>
+#include <hs/mem/mem_new_api.hpp>
+#include <hs/mem/mem_trace_api.hpp>
+#include <hs/util/util_std_new.hpp>
+#include <mem/detail/mem_central_depot.hpp>
+#include <mem/detail/mem_heap.hpp>
+#include <mem/detail/mem_page_heap.hpp>
+#include <mem/detail/mem_pressure.hpp>
+#include <mem/detail/mem_size_class.hpp>
+#include <mem/detail/mem_span.hpp>
+#include <mem/detail/mem_thread_cache.hpp>
+#include <mem/detail/mem_trace.hpp>
+#include <util/util_string_api.hpp>
+
+namespace hs::mem {
+namespace detail {
+void InitializeHeap() noexcept {
+    new (g_PageHeap.GetPointer()) PageHeap();
+    new (g_CentralDepot.GetPointer()) CentralDepot();
+    new (g_MemoryPressureRegistry.GetPointer()) MemoryPressureRegistry();
+}
+}  // namespace detail
+
+// A large block must keep its first byte in the span holding its header.
+static_assert(HEAP_MAXIMUM_ALIGNMENT <= detail::SPAN_SIZE / 2,
+              "HEAP_MAXIMUM_ALIGNMENT doesn't fit in a span");
+
+static inline uintptr_t AlignUp(uintptr_t value, size_t alignment) noexcept {
+    return (value + (alignment - 1)) & ~(alignment - 1);
+}
+
+static void *AllocateSmall(size_t size_class) noexcept {
+    auto cache = detail::GetCurrentThreadCache();
+
+    if (cache != nullptr) {
+        return cache->Allocate(size_class);
+    }
+
+    void *object;
+    if (detail::g_CentralDepot->Refill(size_class, &object, 1) == 0) {
+        return nullptr;
+    }
+
+    return object;
+}
+
+static void FreeSmall(void *object, size_t size_class) noexcept {
+    auto cache = detail::GetCurrentThreadCache();
+
+    if (cache != nullptr) {
+        cache->Free(object, size_class);
+        return;
+    }
+
+    *reinterpret_cast<void **>(object) = nullptr;
+    detail::g_CentralDepot->Release(size_class, object);
+}
+
+static void *AllocateLarge(size_t size, size_t alignment) noexcept {
+    size_t data_offset = AlignUp(detail::SPAN_HEADER_SIZE, alignment);
+
+    if (size > SIZE_MAX - data_offset - detail::SPAN_SIZE) {
+        return nullptr;
+    }
+
+    size_t span_count =
+        (data_offset + size + (detail::SPAN_SIZE - 1)) / detail::SPAN_SIZE;
+
+    // Start big blocks on a large block boundary so the kernel can back them
+    // with block mappings.
+    size_t span_alignment = detail::SPAN_SIZE;
+    if (size >= HEAP_LARGE_BLOCK_SIZE) {
+        span_alignment = HEAP_LARGE_BLOCK_SIZE;
+    }
+
+    void *span = detail::g_PageHeap->AllocateSpans(span_count, span_alignment);
+
+    if (span == nullptr) {
+        return nullptr;
+    }
+
+    auto header = new (span) detail::SpanHeader();
+    header->size_class = detail::SIZE_CLASS_LARGE;
+    header->used_count = 1;
+    header->span_count = span_count;
+    header->free_list = nullptr;
+    header->bump_address = 0;
+
+    return reinterpret_cast<void *>(reinterpret_cast<uintptr_t>(span) +
+                                    data_offset);
+}
+
+// Get back the start of the small object holding ptr. Aligned allocations may
+// point anywhere inside their object.
+static inline uintptr_t GetSmallObjectAddress(const detail::SpanHeader *slab,
+                                              const void *ptr) noexcept {
+    uintptr_t objects_address = detail::GetSpanObjectsAddress(slab);
+    size_t object_size = detail::GetSizeClassSize(slab->size_class);
+    uintptr_t offset = reinterpret_cast<uintptr_t>(ptr) - objects_address;
+
+    return objects_address + (offset / object_size) * object_size;
+}
+
+
+static void *AllocateUnaccounted(size_t size) noexcept {
+    if (size <= detail::SIZE_CLASS_SMALL_MAX) {
+        return AllocateSmall(detail::GetSizeClassIndex(size));
+    }
+
+    return AllocateLarge(size, HEAP_MINIMAL_ALIGNMENT);
+}
+
+static void *AllocateAlignedUnaccounted(size_t size,
+                                        size_t alignment) noexcept {
+    if (alignment <= HEAP_MINIMAL_ALIGNMENT) {
+        return AllocateUnaccounted(size);
+    }
+
+    if (alignment > HEAP_MAXIMUM_ALIGNMENT) {
+        return nullptr;
+    }
+
+    // Over allocate small blocks and align them inside their object.
+    size_t padding = alignment - HEAP_MINIMAL_ALIGNMENT;
+
+    if (padding < detail::SIZE_CLASS_SMALL_MAX &&
+        size <= detail::SIZE_CLASS_SMALL_MAX - padding) {
+        void *object =
+            AllocateSmall(detail::GetSizeClassIndex(size + padding));
+
+        if (object == nullptr) {
+            return nullptr;
+        }
+
+        return reinterpret_cast<void *>(
+            AlignUp(reinterpret_cast<uintptr_t>(object), alignment));
+    }
+
+    return AllocateLarge(size, alignment);
+}
+
+template <typename AllocateFunction>
+static inline void *AllocateAccounted(AllocateFunction allocate,
+                                      const void *return_address) noexcept {
+    void *ptr = allocate();
+
+    // Let the subsystems release some memory and try again once.
+    size_t released_size;
+    if (ptr == nullptr &&
+        detail::g_MemoryPressureRegistry->Dispatch(&released_size)) {
+        ptr = allocate();
+    }
+
+    detail::CheckHeapMemoryBudget();
+
+    if (ptr != nullptr) {
+        size_t size = GetAllocationSize(ptr);
+
+        AccountMemory(MemoryTag::Heap, size);
+        detail::TraceAllocation(AllocationTraceEvent::Allocate, ptr, size,
+                                return_address);
+    }
+
+    return ptr;
+}
+
+namespace detail {
+void *AllocateFrom(size_t size, size_t alignment,
+                   const void *return_address) noexcept {
+    __HS_ASSERT((alignment & (alignment - 1)) == 0);
+
+    return AllocateAccounted(
+        [size, alignment]() {
+            return AllocateAlignedUnaccounted(size, alignment);
+        },
+        return_address);
+}
+
+void FreeFrom(void *ptr, const void *return_address) noexcept {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    size_t size = GetAllocationSize(ptr);
+
+    UnaccountMemory(MemoryTag::Heap, size);
+    TraceAllocation(AllocationTraceEvent::Free, ptr, size, return_address);
+
+    auto span = GetSpanHeader(ptr);
+
+    if (span->size_class == SIZE_CLASS_LARGE) {
+        g_PageHeap->FreeSpans(span, span->span_count);
+        return;
+    }
+
+    FreeSmall(reinterpret_cast<void *>(GetSmallObjectAddress(span, ptr)),
+              span->size_class);
+}
+
+void *ReallocateFrom(void *ptr, size_t size,
+                     const void *return_address) noexcept {
+    if (ptr == nullptr) {
+        return AllocateFrom(size, HEAP_MINIMAL_ALIGNMENT, return_address);
+    }
+
+    size_t old_size = GetAllocationSize(ptr);
+
+    // Keep the block if it is big enough and not oversized for small blocks.
+    if (old_size >= size && (old_size <= SIZE_CLASS_SMALL_MAX ||
+                             size > SIZE_CLASS_SMALL_MAX)) {
+        return ptr;
+    }
+
+    void *new_ptr = AllocateFrom(size, HEAP_MINIMAL_ALIGNMENT, return_address);
+    if (new_ptr == nullptr) {
+        return nullptr;
+    }
+
+    memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+    FreeFrom(ptr, return_address);
+
+    return new_ptr;
+}
+
+// The size class is resolved by the caller, the fast path touches neither the
+// size class table nor the span of the block.
+void *AllocateSizeClassFrom(size_t size_class,
+                            const void *return_address) noexcept {
+    void *ptr = AllocateSmall(size_class);
+    size_t size = GetSizeClassSize(size_class);
+
+    // Take the generic path to handle memory pressure.
+    if (ptr == nullptr) {
+        return AllocateFrom(size, HEAP_MINIMAL_ALIGNMENT, return_address);
+    }
+
+    CheckHeapMemoryBudget();
+
+    AccountMemory(MemoryTag::Heap, size);
+    TraceAllocation(AllocationTraceEvent::Allocate, ptr, size, return_address);
+
+    return ptr;
+}
+
+void FreeSizeClassFrom(void *ptr, size_t size_class,
+                       const void *return_address) noexcept {
+    __HS_DEBUG_ASSERT((GetSpanHeader(ptr)->size_class == size_class &&
+                       GetSmallObjectAddress(GetSpanHeader(ptr), ptr) ==
+                           reinterpret_cast<uintptr_t>(ptr)));
+
+    size_t size = GetSizeClassSize(size_class);
+
+    UnaccountMemory(MemoryTag::Heap, size);
+    TraceAllocation(AllocationTraceEvent::Free, ptr, size, return_address);
+
+    FreeSmall(ptr, size_class);
+}
+
+void *AllocateSizeClass(size_t size_class) noexcept {
+    return AllocateSizeClassFrom(size_class, __builtin_return_address(0));
+}
+
+void FreeSizeClass(void *ptr, size_t size_class) noexcept {
+    FreeSizeClassFrom(ptr, size_class, __builtin_return_address(0));
+}
+}  // namespace detail
+
+void *Allocate(size_t size) noexcept {
+    return detail::AllocateFrom(size, HEAP_MINIMAL_ALIGNMENT,
+                                __builtin_return_address(0));
+}
+
+void *AllocateAligned(size_t size, size_t alignment) noexcept {
+    return detail::AllocateFrom(size, alignment, __builtin_return_address(0));
+}
+
+void *Reallocate(void *ptr, size_t size) noexcept {
+    return detail::ReallocateFrom(ptr, size, __builtin_return_address(0));
+}
+
+void Free(void *ptr) noexcept {
+    detail::FreeFrom(ptr, __builtin_return_address(0));
+}
+
+size_t GetAllocationSize(const void *ptr) noexcept {
+    auto span = detail::GetSpanHeader(ptr);
+
+    if (span->size_class == detail::SIZE_CLASS_LARGE) {
+        return detail::GetSpanEndAddress(span) -
+               reinterpret_cast<uintptr_t>(ptr);
+    }
+
+    uintptr_t object_address = GetSmallObjectAddress(span, ptr);
+
+    return detail::GetSizeClassSize(span->size_class) -
+           (reinterpret_cast<uintptr_t>(ptr) - object_address);
+}
+
+size_t TrimHeap() noexcept {
+    detail::FlushCurrentThreadHeapCache();
+    detail::g_CentralDepot->ReleaseEmptySlabs();
+
+    return detail::g_PageHeap->Trim();
+}
+}  // namespace hs::mem
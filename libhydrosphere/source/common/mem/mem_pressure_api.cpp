@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/mem/mem_heap_api.hpp>
+#include <hs/mem/mem_pressure_api.hpp>
+#include <mem/detail/mem_accounting.hpp>
+#include <mem/detail/mem_pressure.hpp>
+
+namespace hs::mem {
+namespace detail {
+__HS_ATTRIBUTE_VISIBILITY_HIDDEN
+    hs::util::ObjectStorage<MemoryPressureRegistry>
+        g_MemoryPressureRegistry;
+__HS_ATTRIBUTE_VISIBILITY_HIDDEN volatile _Atomic(bool) g_HasHeapGrown = false;
+
+void MemoryPressureRegistry::Register(
+    MemoryPressureCallback *callback) noexcept {
+    this->critical_section.Enter();
+    this->callbacks.push_back(*callback);
+    this->critical_section.Leave();
+}
+
+void MemoryPressureRegistry::Unregister(
+    MemoryPressureCallback *callback) noexcept {
+    this->critical_section.Enter();
+    callback->Unlink();
+    this->critical_section.Leave();
+}
+
+bool MemoryPressureRegistry::Dispatch(size_t *out_released_size) noexcept {
+    // The callbacks free memory, which may bring us back here.
+    if (this->dispatch_critical_section.IsLockedByCurrentThread()) {
+        return false;
+    }
+
+    uint32_t dispatch_count = atomic_load(&this->dispatch_count);
+
+    this->dispatch_critical_section.Enter();
+
+    // Someone else released what could be while we were waiting, the caller
+    // can try again.
+    if (atomic_load(&this->dispatch_count) != dispatch_count) {
+        this->dispatch_critical_section.Leave();
+        *out_released_size = 0;
+        return true;
+    }
+
+    this->critical_section.Enter();
+    for (auto &callback : this->callbacks) {
+        callback.function(callback.argument);
+    }
+    this->critical_section.Leave();
+
+    *out_released_size = TrimHeap();
+
+    atomic_fetch_add(&this->dispatch_count, 1);
+    this->dispatch_critical_section.Leave();
+    return true;
+}
+
+void CheckHeapMemoryBudgetSlow() noexcept {
+    if (!atomic_exchange(&g_HasHeapGrown, false)) {
+        return;
+    }
+
+    size_t budget = atomic_load(&g_MemoryPressureRegistry->heap_budget);
+
+    if (budget != 0 && GetAccountedUsage(MemoryTag::Heap).size > budget) {
+        size_t released_size;
+        g_MemoryPressureRegistry->Dispatch(&released_size);
+    }
+}
+}  // namespace detail
+
+void RegisterMemoryPressureCallback(MemoryPressureCallback *callback,
+                                    MemoryPressureFunction function,
+                                    void *argument) noexcept {
+    callback->function = function;
+    callback->argument = argument;
+    detail::g_MemoryPressureRegistry->Register(callback);
+}
+
+void UnregisterMemoryPressureCallback(
+    MemoryPressureCallback *callback) noexcept {
+    detail::g_MemoryPressureRegistry->Unregister(callback);
+}
+
+void SetHeapMemoryBudget(size_t budget) noexcept {
+    atomic_store(&detail::g_MemoryPressureRegistry->heap_budget, budget);
+}
+
+size_t NotifyMemoryPressure() noexcept {
+    size_t released_size = 0;
+    detail::g_MemoryPressureRegistry->Dispatch(&released_size);
+
+    return released_size;
+}
+}  // namespace hs::mem
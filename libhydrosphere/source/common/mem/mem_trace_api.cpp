@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/hs_config.hpp>
+#include <hs/mem/mem_trace_api.hpp>
+#include <hs/os/os_tls.hpp>
+#include <hs/svc.hpp>
+#include <hs/util/util_std_new.hpp>
+#include <mem/detail/mem_central_depot.hpp>
+#include <mem/detail/mem_size_class.hpp>
+#include <mem/detail/mem_trace.hpp>
+#include <util/util_string_api.hpp>
+
+namespace hs::mem {
+namespace detail {
+__HS_ATTRIBUTE_VISIBILITY_HIDDEN volatile _Atomic(bool)
+    g_IsAllocationTracingEnabled = false;
+}  // namespace detail
+
+// The header and the records are contiguous so a full chunk is given to the
+// sink without copying.
+struct AllocationTraceBuffer {
+    AllocationTraceHeader header;
+    AllocationTraceRecord records[ALLOCATION_TRACE_BUFFER_RECORD_COUNT];
+    bool is_flushing;
+};
+
+static_assert(offsetof(AllocationTraceBuffer, records) ==
+                  sizeof(AllocationTraceHeader),
+              "The trace records must follow the header");
+
+// The trace buffers are allocated from the central depot directly so they are
+// never traced.
+static constexpr size_t TRACE_BUFFER_SIZE_CLASS =
+    detail::GetSizeClassIndex(sizeof(AllocationTraceBuffer));
+
+static_assert(sizeof(AllocationTraceBuffer) <= detail::SIZE_CLASS_SMALL_MAX,
+              "AllocationTraceBuffer is too big for a small block");
+
+// The count of chunk bytes per debug output line.
+static const size_t TRACE_OUTPUT_LINE_DATA_SIZE = 0x100;
+
+static const char TRACE_OUTPUT_LINE_PREFIX[] = "hsat:";
+
+__HS_ATTRIBUTE_VISIBILITY_HIDDEN _Atomic(AllocationTraceSink) volatile
+    g_AllocationTraceSink = nullptr;
+__HS_ATTRIBUTE_VISIBILITY_HIDDEN _Atomic(void *) volatile
+    g_AllocationTraceSinkArgument = nullptr;
+
+// Read the physical counter directly, the tick is taken on every traced
+// allocation and a syscall would dominate the cost of tracing.
+static inline uint64_t GetCurrentTick() noexcept {
+#ifdef HYDROSPHERE_TARGET_HOST
+    return hs::svc::GetSystemTick();
+#elif HYDROSPHERE_TARGET_AARCH64
+    uint64_t tick;
+    __HS_ASM __volatile__("mrs %0, cntpct_el0" : "=r"(tick));
+    return tick;
+#elif HYDROSPHERE_TARGET_AARCH32
+    uint32_t tick_low;
+    uint32_t tick_high;
+    __HS_ASM __volatile__("mrrc p15, 0, %0, %1, c14"
+                          : "=r"(tick_low), "=r"(tick_high));
+    return (static_cast<uint64_t>(tick_high) << 32) | tick_low;
+#else
+#error "System tick not implemented for this architecture"
+#endif
+}
+
+static inline char *WriteHex(char *output, const uint8_t *data,
+                             size_t size) noexcept {
+    static const char HEX_DIGITS[] = "0123456789abcdef";
+
+    for (size_t i = 0; i < size; i++) {
+        *output++ = HEX_DIGITS[data[i] >> 4];
+        *output++ = HEX_DIGITS[data[i] & 0xF];
+    }
+
+    return output;
+}
+
+// Lines of concurrent threads may be interleaved, every line is prefixed with
+// the identifier of its thread so the chunks can be put back together.
+static void OutputAllocationTrace(void *argument, const void *data,
+                                  size_t size) noexcept {
+    (void)argument;
+
+    auto header = reinterpret_cast<const AllocationTraceHeader *>(data);
+    auto bytes = reinterpret_cast<const uint8_t *>(data);
+    uint8_t thread_id[sizeof(uint64_t)];
+
+    for (size_t i = 0; i < sizeof(thread_id); i++) {
+        thread_id[i] = static_cast<uint8_t>(header->thread_id >> (56 - i * 8));
+    }
+
+    char line[sizeof(TRACE_OUTPUT_LINE_PREFIX) + sizeof(thread_id) * 2 +
+              TRACE_OUTPUT_LINE_DATA_SIZE * 2];
+    memcpy(line, TRACE_OUTPUT_LINE_PREFIX,
+           sizeof(TRACE_OUTPUT_LINE_PREFIX) - 1);
+
+    char *line_data =
+        WriteHex(line + sizeof(TRACE_OUTPUT_LINE_PREFIX) - 1, thread_id,
+                 sizeof(thread_id));
+    *line_data++ = ':';
+
+    for (size_t offset = 0; offset < size;
+         offset += TRACE_OUTPUT_LINE_DATA_SIZE) {
+        size_t line_size = size - offset;
+
+        if (line_size > TRACE_OUTPUT_LINE_DATA_SIZE) {
+            line_size = TRACE_OUTPUT_LINE_DATA_SIZE;
+        }
+
+        char *line_end = WriteHex(line_data, bytes + offset, line_size);
+        hs::svc::OutputDebugString(line, static_cast<size_t>(line_end - line));
+    }
+}
+
+static void FlushBuffer(hs::os::Thread *thread,
+                        AllocationTraceBuffer *buffer) noexcept {
+    if (buffer->header.record_count == 0) {
+        return;
+    }
+
+    // Events caused by the sink itself are dropped.
+    buffer->is_flushing = true;
+
+    memcpy(buffer->header.thread_name, thread->thread_name,
+           sizeof(buffer->header.thread_name));
+
+    AllocationTraceSink sink =
+        atomic_load_explicit(&g_AllocationTraceSink, memory_order_acquire);
+    void *argument = atomic_load_explicit(&g_AllocationTraceSinkArgument,
+                                          memory_order_relaxed);
+
+    if (sink == nullptr) {
+        sink = OutputAllocationTrace;
+    }
+
+    sink(argument, &buffer->header,
+         sizeof(AllocationTraceHeader) +
+             buffer->header.record_count * sizeof(AllocationTraceRecord));
+
+    buffer->header.record_count = 0;
+    buffer->is_flushing = false;
+}
+
+static AllocationTraceBuffer *GetCurrentThreadBuffer(
+    hs::os::Thread **out_thread) noexcept {
+    auto thread =
+        hs::os::ThreadLocalStorage::GetThreadLocalStorage()->GetThreadContext();
+
+    *out_thread = thread;
+
+    if (thread == nullptr) {
+        return nullptr;
+    }
+
+    return reinterpret_cast<AllocationTraceBuffer *>(thread->allocation_trace);
+}
+
+namespace detail {
+void TraceAllocationSlow(AllocationTraceEvent event, const void *address,
+                         size_t size, const void *return_address) noexcept {
+    hs::os::Thread *thread;
+    auto buffer = GetCurrentThreadBuffer(&thread);
+
+    if (buffer == nullptr) {
+        if (thread == nullptr) {
+            return;
+        }
+
+        void *storage;
+        if (g_CentralDepot->Refill(TRACE_BUFFER_SIZE_CLASS, &storage, 1) ==
+            0) {
+            return;
+        }
+
+        buffer = new (storage) AllocationTraceBuffer();
+        buffer->header.magic = ALLOCATION_TRACE_MAGIC;
+        buffer->header.version = ALLOCATION_TRACE_VERSION;
+        buffer->header.thread_id = reinterpret_cast<uintptr_t>(thread);
+        thread->allocation_trace = buffer;
+    }
+
+    if (buffer->is_flushing) {
+        return;
+    }
+
+    auto &record = buffer->records[buffer->header.record_count++];
+    record.tick = GetCurrentTick();
+    record.return_address = reinterpret_cast<uintptr_t>(return_address);
+    record.address = reinterpret_cast<uintptr_t>(address);
+    record.size = size;
+    record.event = event;
+    record.reserved = 0;
+
+    if (buffer->header.record_count == ALLOCATION_TRACE_BUFFER_RECORD_COUNT) {
+        FlushBuffer(thread, buffer);
+    }
+}
+
+void FinalizeThreadAllocationTrace(hs::os::Thread *thread) noexcept {
+    auto buffer =
+        reinterpret_cast<AllocationTraceBuffer *>(thread->allocation_trace);
+
+    if (buffer == nullptr) {
+        return;
+    }
+
+    FlushBuffer(thread, buffer);
+    thread->allocation_trace = nullptr;
+
+    *reinterpret_cast<void **>(buffer) = nullptr;
+    g_CentralDepot->Release(TRACE_BUFFER_SIZE_CLASS, buffer);
+}
+}  // namespace detail
+
+void SetAllocationTracing(bool is_enabled) noexcept {
+    atomic_store(&detail::g_IsAllocationTracingEnabled, is_enabled);
+}
+
+void SetAllocationTraceSink(AllocationTraceSink sink, void *argument) noexcept {
+    atomic_store_explicit(&g_AllocationTraceSinkArgument, argument,
+                          memory_order_relaxed);
+    atomic_store_explicit(&g_AllocationTraceSink, sink, memory_order_release);
+}
+
+void FlushAllocationTrace() noexcept {
+    hs::os::Thread *thread;
+    auto buffer = GetCurrentThreadBuffer(&thread);
+
+    if (buffer != nullptr) {
+        FlushBuffer(thread, buffer);
+    }
+}
+}  // namespace hs::mem
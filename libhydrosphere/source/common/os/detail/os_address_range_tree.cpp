@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <os/detail/os_address_range_tree.hpp>
+
+namespace hs::os::detail {
+void AddressRangeTree::Update(AddressRange *node) noexcept {
+    int left_height = GetHeight(node->left);
+    int right_height = GetHeight(node->right);
+    size_t max_size = node->size;
+
+    if (GetMaxSize(node->left) > max_size) {
+        max_size = GetMaxSize(node->left);
+    }
+
+    if (GetMaxSize(node->right) > max_size) {
+        max_size = GetMaxSize(node->right);
+    }
+
+    node->height =
+        1 + (left_height > right_height ? left_height : right_height);
+    node->max_size = max_size;
+}
+
+AddressRange *AddressRangeTree::RotateLeft(AddressRange *node) noexcept {
+    AddressRange *new_root = node->right;
+
+    node->right = new_root->left;
+    new_root->left = node;
+
+    Update(node);
+    Update(new_root);
+
+    return new_root;
+}
+
+AddressRange *AddressRangeTree::RotateRight(AddressRange *node) noexcept {
+    AddressRange *new_root = node->left;
+
+    node->left = new_root->right;
+    new_root->right = node;
+
+    Update(node);
+    Update(new_root);
+
+    return new_root;
+}
+
+AddressRange *AddressRangeTree::Balance(AddressRange *node) noexcept {
+    Update(node);
+
+    int balance = GetHeight(node->left) - GetHeight(node->right);
+
+    if (balance > 1) {
+        if (GetHeight(node->left->left) < GetHeight(node->left->right)) {
+            node->left = RotateLeft(node->left);
+        }
+
+        return RotateRight(node);
+    } else if (balance < -1) {
+        if (GetHeight(node->right->right) < GetHeight(node->right->left)) {
+            node->right = RotateRight(node->right);
+        }
+
+        return RotateLeft(node);
+    }
+
+    return node;
+}
+
+AddressRange *AddressRangeTree::InsertNode(AddressRange *node,
+                                           AddressRange *new_node) noexcept {
+    if (node == nullptr) {
+        new_node->left = nullptr;
+        new_node->right = nullptr;
+        Update(new_node);
+        return new_node;
+    }
+
+    if (new_node->address < node->address) {
+        node->left = InsertNode(node->left, new_node);
+    } else {
+        node->right = InsertNode(node->right, new_node);
+    }
+
+    return Balance(node);
+}
+
+AddressRange *AddressRangeTree::RemoveMinimumNode(
+    AddressRange *node, AddressRange **out_minimum) noexcept {
+    if (node->left == nullptr) {
+        *out_minimum = node;
+        return node->right;
+    }
+
+    node->left = RemoveMinimumNode(node->left, out_minimum);
+    return Balance(node);
+}
+
+AddressRange *AddressRangeTree::RemoveNode(
+    AddressRange *node, uintptr_t address,
+    AddressRange **out_removed) noexcept {
+    if (node == nullptr) {
+        return nullptr;
+    }
+
+    if (address < node->address) {
+        node->left = RemoveNode(node->left, address, out_removed);
+    } else if (address > node->address) {
+        node->right = RemoveNode(node->right, address, out_removed);
+    } else {
+        *out_removed = node;
+
+        if (node->right == nullptr) {
+            return node->left;
+        }
+
+        // Replace the node by the minimum of its right subtree.
+        AddressRange *successor;
+        AddressRange *right = RemoveMinimumNode(node->right, &successor);
+
+        successor->left = node->left;
+        successor->right = right;
+        return Balance(successor);
+    }
+
+    return Balance(node);
+}
+
+AddressRange *AddressRangeTree::FindFirstFitNode(AddressRange *node,
+                                                 size_t min_size, size_t size,
+                                                 size_t alignment,
+                                                 size_t guard_size) noexcept {
+    if (node == nullptr || node->max_size < min_size) {
+        return nullptr;
+    }
+
+    AddressRange *result =
+        FindFirstFitNode(node->left, min_size, size, alignment, guard_size);
+    if (result != nullptr) {
+        return result;
+    }
+
+    if (node->size >= min_size &&
+        GetFitAddress(node, size, alignment, guard_size) != 0) {
+        return node;
+    }
+
+    return FindFirstFitNode(node->right, min_size, size, alignment,
+                            guard_size);
+}
+
+void AddressRangeTree::Insert(AddressRange *range) noexcept {
+    this->root = InsertNode(this->root, range);
+}
+
+AddressRange *AddressRangeTree::Remove(uintptr_t address) noexcept {
+    AddressRange *removed = nullptr;
+
+    this->root = RemoveNode(this->root, address, &removed);
+    return removed;
+}
+
+AddressRange *AddressRangeTree::Find(uintptr_t address) const noexcept {
+    AddressRange *node = this->root;
+
+    while (node != nullptr && node->address != address) {
+        node = address < node->address ? node->left : node->right;
+    }
+
+    return node;
+}
+
+AddressRange *AddressRangeTree::FindLowerOrEqual(uintptr_t address) const
+    noexcept {
+    AddressRange *node = this->root;
+    AddressRange *result = nullptr;
+
+    while (node != nullptr) {
+        if (node->address <= address) {
+            result = node;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+
+    return result;
+}
+
+AddressRange *AddressRangeTree::FindGreaterOrEqual(uintptr_t address) const
+    noexcept {
+    AddressRange *node = this->root;
+    AddressRange *result = nullptr;
+
+    while (node != nullptr) {
+        if (node->address >= address) {
+            result = node;
+            node = node->left;
+        } else {
+            node = node->right;
+        }
+    }
+
+    return result;
+}
+}  // namespace hs::os::detail
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/hs_macro.hpp>
+
+namespace hs::os::detail {
+struct AddressRange {
+    AddressRange *left;
+    AddressRange *right;
+    uintptr_t address;
+    size_t size;
+
+    // The biggest size of the ranges of the subtree.
+    size_t max_size;
+    int height;
+};
+
+// An AVL tree of non overlapping address ranges keyed by their start
+// address. Every node also knows the biggest range of its subtree so a range
+// of a given size can be found in O(log n).
+class AddressRangeTree {
+ private:
+    AddressRange *root;
+
+    static inline int GetHeight(const AddressRange *node) noexcept {
+        return node == nullptr ? 0 : node->height;
+    }
+
+    static inline size_t GetMaxSize(const AddressRange *node) noexcept {
+        return node == nullptr ? 0 : node->max_size;
+    }
+
+    static void Update(AddressRange *node) noexcept;
+    static AddressRange *RotateLeft(AddressRange *node) noexcept;
+    static AddressRange *RotateRight(AddressRange *node) noexcept;
+    static AddressRange *Balance(AddressRange *node) noexcept;
+    static AddressRange *InsertNode(AddressRange *node,
+                                    AddressRange *new_node) noexcept;
+    static AddressRange *RemoveMinimumNode(AddressRange *node,
+                                           AddressRange **out_minimum) noexcept;
+    static AddressRange *RemoveNode(AddressRange *node, uintptr_t address,
+                                    AddressRange **out_removed) noexcept;
+    static AddressRange *FindFirstFitNode(AddressRange *node, size_t min_size,
+                                          size_t size, size_t alignment,
+                                          size_t guard_size) noexcept;
+
+ public:
+    AddressRangeTree() noexcept : root(nullptr) {}
+    __HS_DISALLOW_COPY(AddressRangeTree);
+
+    void Insert(AddressRange *range) noexcept;
+
+    // Remove the range starting at the given address, returns a null pointer
+    // if there is none.
+    AddressRange *Remove(uintptr_t address) noexcept;
+
+    // Find the range starting at the given address.
+    AddressRange *Find(uintptr_t address) const noexcept;
+
+    // Find the range with the biggest start address lower or equal to the
+    // given address.
+    AddressRange *FindLowerOrEqual(uintptr_t address) const noexcept;
+
+    // Find the range with the smallest start address greater or equal to the
+    // given address.
+    AddressRange *FindGreaterOrEqual(uintptr_t address) const noexcept;
+
+    // Find the range with the lowest address able to hold size bytes aligned
+    // to alignment preceded by guard_size bytes. Only ranges of at least
+    // min_size bytes are considered.
+    inline AddressRange *FindFirstFit(size_t min_size, size_t size,
+                                      size_t alignment,
+                                      size_t guard_size) const noexcept {
+        return FindFirstFitNode(this->root, min_size, size, alignment,
+                                guard_size);
+    }
+
+    // Get the address of a block of size bytes aligned to alignment preceded
+    // by guard_size bytes inside a range, or 0 if it doesn't fit.
+    static inline uintptr_t GetFitAddress(const AddressRange *range,
+                                          size_t size, size_t alignment,
+                                          size_t guard_size) noexcept {
+        uintptr_t address =
+            (range->address + guard_size + (alignment - 1)) & ~(alignment - 1);
+        uintptr_t range_end = range->address + range->size;
+
+        if (address < range->address || address > range_end ||
+            size > range_end - address) {
+            return 0;
+        }
+
+        return address;
+    }
+};
+}  // namespace hs::os::detail
@@ -0,0 +1,444 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/diag.hpp>
+#include <hs/svc.hpp>
+#include <hs/util/util_std_new.hpp>
+#include <os/detail/os_memory_map.hpp>
+
+namespace hs::os::detail {
+__HS_ATTRIBUTE_VISIBILITY_HIDDEN hs::util::ObjectStorage<MemoryMap>
+    g_MemoryMap;
+
+static bool QueryKernelRegion(MemoryRegion *out_region,
+                              uintptr_t address) noexcept {
+    hs::svc::MemoryInfo memory_info;
+    uint32_t page_info;
+
+    auto result = hs::svc::QueryMemory(&memory_info, &page_info, address);
+    if (result.Err()) {
+        return false;
+    }
+
+    out_region->address = static_cast<uintptr_t>(memory_info.address);
+    out_region->type = static_cast<hs::svc::MemoryType>(memory_info.type);
+    out_region->attribute = memory_info.attribute;
+    out_region->permission =
+        static_cast<hs::svc::MemoryPermission>(memory_info.permission);
+
+    // On 32-bit the last region goes past the end of the address space.
+    uint64_t end_address = memory_info.address + memory_info.size;
+    if (end_address > static_cast<uintptr_t>(-1)) {
+        out_region->size = static_cast<size_t>(-out_region->address);
+    } else {
+        out_region->size = static_cast<size_t>(memory_info.size);
+    }
+
+    return true;
+}
+
+size_t MemoryMap::FindRegionIndexUnsafe(uintptr_t address) const noexcept {
+    size_t low = 0;
+    size_t high = this->region_count;
+
+    // Find the last region starting before or at the address.
+    while (high - low > 1) {
+        size_t middle = low + (high - low) / 2;
+
+        if (this->regions[middle].address <= address) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+void MemoryMap::UpdateUnsafe(const MemoryRegion &new_region) noexcept {
+    if (this->is_overflowed) {
+        // Freeing ranges is what may bring the region count back under the
+        // capacity, don't pay for a full rebuild on every one of them.
+        if (new_region.type == hs::svc::MemoryType::Free &&
+            ++this->freed_count >= MEMORY_MAP_REBUILD_FREE_COUNT) {
+            this->RebuildUnsafe();
+        }
+
+        return;
+    }
+
+    if (this->region_count == 0) {
+        return;
+    }
+
+    uintptr_t last_address = GetLastAddress(new_region);
+    size_t first_index = this->FindRegionIndexUnsafe(new_region.address);
+    size_t last_index = this->FindRegionIndexUnsafe(last_address);
+
+    // Build the regions replacing the ones between first_index and
+    // last_index.
+    MemoryRegion replacements[3];
+    size_t replacement_count = 0;
+
+    const MemoryRegion &first_region = this->regions[first_index];
+    if (first_region.address < new_region.address) {
+        replacements[replacement_count] = first_region;
+        replacements[replacement_count].size =
+            new_region.address - first_region.address;
+        replacement_count++;
+    }
+
+    replacements[replacement_count++] = new_region;
+
+    const MemoryRegion &last_region = this->regions[last_index];
+    if (GetLastAddress(last_region) > last_address) {
+        replacements[replacement_count] = last_region;
+        replacements[replacement_count].address = last_address + 1;
+        replacements[replacement_count].size =
+            GetLastAddress(last_region) - last_address;
+        replacement_count++;
+    }
+
+    // Merge with the neighbouring regions when they have the same state.
+    if (first_index > 0 &&
+        HasSameState(this->regions[first_index - 1], replacements[0])) {
+        first_index--;
+        replacements[0].size += this->regions[first_index].size;
+        replacements[0].address = this->regions[first_index].address;
+    }
+
+    if (last_index + 1 < this->region_count &&
+        HasSameState(this->regions[last_index + 1],
+                     replacements[replacement_count - 1])) {
+        last_index++;
+        replacements[replacement_count - 1].size +=
+            this->regions[last_index].size;
+    }
+
+    size_t merged_count = 1;
+    for (size_t i = 1; i < replacement_count; i++) {
+        if (HasSameState(replacements[merged_count - 1], replacements[i])) {
+            replacements[merged_count - 1].size += replacements[i].size;
+        } else {
+            replacements[merged_count++] = replacements[i];
+        }
+    }
+
+    size_t removed_count = last_index - first_index + 1;
+    size_t new_region_count = this->region_count - removed_count + merged_count;
+
+    if (new_region_count > MEMORY_MAP_CAPACITY) {
+        this->is_overflowed = true;
+        this->freed_count = 0;
+        return;
+    }
+
+    // Move the following regions to their new place.
+    size_t tail_index = last_index + 1;
+    size_t tail_count = this->region_count - tail_index;
+    size_t new_tail_index = first_index + merged_count;
+
+    if (new_tail_index < tail_index) {
+        for (size_t i = 0; i < tail_count; i++) {
+            this->regions[new_tail_index + i] = this->regions[tail_index + i];
+        }
+    } else if (new_tail_index > tail_index) {
+        for (size_t i = tail_count; i > 0; i--) {
+            this->regions[new_tail_index + i - 1] =
+                this->regions[tail_index + i - 1];
+        }
+    }
+
+    for (size_t i = 0; i < merged_count; i++) {
+        this->regions[first_index + i] = replacements[i];
+    }
+
+    this->region_count = new_region_count;
+}
+
+void MemoryMap::RefreshUnsafe(uintptr_t address, size_t size) noexcept {
+    uintptr_t last_address = address + (size - 1);
+    MemoryRegion region;
+
+    while (QueryKernelRegion(&region, address)) {
+        this->UpdateUnsafe(region);
+
+        uintptr_t region_last_address = GetLastAddress(region);
+        if (region_last_address >= last_address) {
+            break;
+        }
+
+        address = region_last_address + 1;
+    }
+}
+
+bool MemoryMap::RebuildUnsafe() noexcept {
+    uintptr_t address = 0;
+    MemoryRegion region;
+
+    this->region_count = 0;
+    this->freed_count = 0;
+
+    while (true) {
+        bool success = QueryKernelRegion(&region, address);
+        __HS_ASSERT(success);
+
+        if (this->region_count == MEMORY_MAP_CAPACITY) {
+            this->is_overflowed = true;
+            return false;
+        }
+
+        this->regions[this->region_count++] = region;
+
+        // Stop once we reached the end of the address space.
+        uintptr_t next_address = region.address + region.size;
+        if (next_address <= address) {
+            break;
+        }
+
+        address = next_address;
+    }
+
+    this->is_overflowed = false;
+    return true;
+}
+
+void MemoryMap::Initialize() noexcept {
+    this->critical_section.Enter();
+    this->RebuildUnsafe();
+    this->critical_section.Leave();
+}
+
+bool MemoryMap::Query(MemoryRegion *out_region, uintptr_t address) noexcept {
+    this->critical_section.Enter();
+
+    if (this->is_overflowed) {
+        this->critical_section.Leave();
+        return QueryKernelRegion(out_region, address);
+    }
+
+    bool found = false;
+
+    if (this->region_count != 0) {
+        const auto &region =
+            this->regions[this->FindRegionIndexUnsafe(address)];
+
+        if (region.address <= address && address <= GetLastAddress(region)) {
+            *out_region = region;
+            found = true;
+        }
+    }
+
+    this->critical_section.Leave();
+    return found;
+}
+
+bool MemoryMap::FindFreeGap(uintptr_t *out_address, uintptr_t search_address,
+                            size_t search_size, size_t size,
+                            size_t alignment) noexcept {
+    __HS_ASSERT((alignment & (alignment - 1)) == 0);
+
+    if (size == 0 || search_size < size) {
+        return false;
+    }
+
+    uintptr_t search_last_address = search_address + (search_size - 1);
+    uintptr_t address = search_address;
+    MemoryRegion region;
+
+    while (this->Query(&region, address)) {
+        uintptr_t region_last_address = GetLastAddress(region);
+
+        if (region_last_address > search_last_address) {
+            region_last_address = search_last_address;
+        }
+
+        if (region.type == hs::svc::MemoryType::Free) {
+            uintptr_t aligned_address =
+                (address + (alignment - 1)) & ~(alignment - 1);
+
+            if (aligned_address >= address &&
+                aligned_address <= region_last_address &&
+                region_last_address - aligned_address >= size - 1) {
+                *out_address = aligned_address;
+                return true;
+            }
+        }
+
+        if (region_last_address >= search_last_address) {
+            break;
+        }
+
+        address = region_last_address + 1;
+    }
+
+    return false;
+}
+
+void MemoryMap::Update(uintptr_t address, size_t size,
+                       hs::svc::MemoryType type, uint32_t attribute,
+                       hs::svc::MemoryPermission permission) noexcept {
+    if (size == 0) {
+        return;
+    }
+
+    MemoryRegion region;
+    region.address = address;
+    region.size = size;
+    region.type = type;
+    region.attribute = attribute;
+    region.permission = permission;
+
+    this->critical_section.Enter();
+    this->UpdateUnsafe(region);
+    this->critical_section.Leave();
+}
+
+void MemoryMap::Refresh(uintptr_t address, size_t size) noexcept {
+    if (size == 0) {
+        return;
+    }
+
+    this->critical_section.Enter();
+
+    if (this->is_overflowed) {
+        this->RebuildUnsafe();
+    } else {
+        this->RefreshUnsafe(address, size);
+    }
+
+    this->critical_section.Leave();
+}
+
+void InitializeMemoryMap() noexcept {
+    new (g_MemoryMap.GetPointer()) MemoryMap();
+    g_MemoryMap->Initialize();
+}
+
+hs::Result MapMemory(uintptr_t dst_address, uintptr_t src_address,
+                     size_t size) noexcept {
+    MemoryRegion src_region;
+    auto result = hs::svc::MapMemory(dst_address, src_address, size);
+
+    if (result.Err() || !g_MemoryMap->Query(&src_region, src_address)) {
+        // Our view of one of the ranges may be out of date.
+        g_MemoryMap->Refresh(dst_address, size);
+        g_MemoryMap->Refresh(src_address, size);
+        return result;
+    }
+
+    // The source is locked and unaccessible until the alias is unmapped.
+    g_MemoryMap->Update(
+        src_address, size, src_region.type,
+        src_region.attribute |
+            static_cast<uint32_t>(hs::svc::MemoryAttribute::Locked),
+        hs::svc::MemoryPermission::None);
+    g_MemoryMap->Update(
+        dst_address, size, hs::svc::MemoryType::Stack, 0,
+        hs::svc::MemoryPermission::Read | hs::svc::MemoryPermission::Write);
+
+    return result;
+}
+
+hs::Result UnmapMemory(uintptr_t dst_address, uintptr_t src_address,
+                       size_t size) noexcept {
+    MemoryRegion src_region;
+    auto result = hs::svc::UnmapMemory(dst_address, src_address, size);
+
+    if (result.Err() || !g_MemoryMap->Query(&src_region, src_address)) {
+        g_MemoryMap->Refresh(dst_address, size);
+        g_MemoryMap->Refresh(src_address, size);
+        return result;
+    }
+
+    g_MemoryMap->Update(
+        src_address, size, src_region.type,
+        src_region.attribute &
+            ~static_cast<uint32_t>(hs::svc::MemoryAttribute::Locked),
+        hs::svc::MemoryPermission::Read | hs::svc::MemoryPermission::Write);
+    g_MemoryMap->Update(dst_address, size, hs::svc::MemoryType::Free, 0,
+                        hs::svc::MemoryPermission::None);
+
+    return result;
+}
+
+hs::Result MapSharedMemory(hs::svc::Handle shared_memory_handle,
+                           uintptr_t address, size_t size,
+                           hs::svc::MemoryPermission permission) noexcept {
+    auto result = hs::svc::MapSharedMemory(shared_memory_handle, address, size,
+                                           permission);
+
+    if (result.Err()) {
+        g_MemoryMap->Refresh(address, size);
+        return result;
+    }
+
+    g_MemoryMap->Update(address, size, hs::svc::MemoryType::Shared, 0,
+                        permission);
+
+    return result;
+}
+
+hs::Result UnmapSharedMemory(hs::svc::Handle shared_memory_handle,
+                             uintptr_t address, size_t size) noexcept {
+    auto result =
+        hs::svc::UnmapSharedMemory(shared_memory_handle, address, size);
+
+    if (result.Err()) {
+        g_MemoryMap->Refresh(address, size);
+        return result;
+    }
+
+    g_MemoryMap->Update(address, size, hs::svc::MemoryType::Free, 0,
+                        hs::svc::MemoryPermission::None);
+
+    return result;
+}
+
+hs::Result MapTransferMemory(hs::svc::Handle transfer_memory_handle,
+                             uintptr_t address, size_t size,
+                             hs::svc::MemoryPermission permission) noexcept {
+    auto result = hs::svc::MapTransferMemory(transfer_memory_handle, address,
+                                             size, permission);
+
+    if (result.Err()) {
+        g_MemoryMap->Refresh(address, size);
+        return result;
+    }
+
+    // The permission is the one given at creation, the mapping itself is
+    // always writable. The owner may still access the buffer unless it gave
+    // up every permission.
+    g_MemoryMap->Update(
+        address, size,
+        permission == hs::svc::MemoryPermission::None
+            ? hs::svc::MemoryType::Transfered
+            : hs::svc::MemoryType::SharedTransfered,
+        0, hs::svc::MemoryPermission::Read | hs::svc::MemoryPermission::Write);
+
+    return result;
+}
+
+hs::Result UnmapTransferMemory(hs::svc::Handle transfer_memory_handle,
+                               uintptr_t address, size_t size) noexcept {
+    auto result =
+        hs::svc::UnmapTransferMemory(transfer_memory_handle, address, size);
+
+    if (result.Err()) {
+        g_MemoryMap->Refresh(address, size);
+        return result;
+    }
+
+    g_MemoryMap->Update(address, size, hs::svc::MemoryType::Free, 0,
+                        hs::svc::MemoryPermission::None);
+
+    return result;
+}
+}  // namespace hs::os::detail
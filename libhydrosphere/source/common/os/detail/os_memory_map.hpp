@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/hs_macro.hpp>
+#include <hs/hs_result.hpp>
+#include <hs/os/os_critical_section.hpp>
+#include <hs/os/os_memory_map_api.hpp>
+#include <hs/util/util_object_storage.hpp>
+
+namespace hs::os::detail {
+// The count of regions the memory map can hold. Once full, lookups are
+// forwarded to the kernel.
+const size_t MEMORY_MAP_CAPACITY = 0x400;
+
+// The count of ranges freed while the memory map is full after which we try
+// to rebuild it.
+const size_t MEMORY_MAP_REBUILD_FREE_COUNT = 0x10;
+
+// A sorted snapshot of the address space. The regions cover the whole address
+// space without holes. The last region may end at the very end of the address
+// space so we always compare the last address of the regions.
+class MemoryMap {
+ private:
+    hs::os::CriticalSection critical_section;
+    bool is_overflowed;
+    size_t freed_count;
+    size_t region_count;
+    MemoryRegion regions[MEMORY_MAP_CAPACITY];
+
+    static inline uintptr_t GetLastAddress(
+        const MemoryRegion &region) noexcept {
+        return region.address + (region.size - 1);
+    }
+
+    static inline bool HasSameState(const MemoryRegion &a,
+                                    const MemoryRegion &b) noexcept {
+        return a.type == b.type && a.attribute == b.attribute &&
+               a.permission == b.permission;
+    }
+
+    size_t FindRegionIndexUnsafe(uintptr_t address) const noexcept;
+    void UpdateUnsafe(const MemoryRegion &new_region) noexcept;
+    void RefreshUnsafe(uintptr_t address, size_t size) noexcept;
+
+    // Build the snapshot from scratch, returns false if it doesn't fit.
+    bool RebuildUnsafe() noexcept;
+
+ public:
+    MemoryMap() noexcept
+        : critical_section(),
+          is_overflowed(false),
+          freed_count(0),
+          region_count(0) {}
+    __HS_DISALLOW_COPY(MemoryMap);
+
+    // Build the snapshot with one pass of svc::QueryMemory.
+    void Initialize() noexcept;
+
+    bool Query(MemoryRegion *out_region, uintptr_t address) noexcept;
+    bool FindFreeGap(uintptr_t *out_address, uintptr_t search_address,
+                     size_t search_size, size_t size,
+                     size_t alignment) noexcept;
+
+    // Set the state of a range known to have changed.
+    void Update(uintptr_t address, size_t size, hs::svc::MemoryType type,
+                uint32_t attribute,
+                hs::svc::MemoryPermission permission) noexcept;
+
+    // Get back the state of a range from the kernel. Once the snapshot
+    // overflowed, this rebuilds it entirely.
+    void Refresh(uintptr_t address, size_t size) noexcept;
+};
+
+extern __HS_ATTRIBUTE_VISIBILITY_HIDDEN hs::util::ObjectStorage<MemoryMap>
+    g_MemoryMap;
+
+// Must be called before any other allocator is initialized.
+void InitializeMemoryMap() noexcept;
+
+// svc::MapMemory and svc::UnmapMemory keeping the memory map up to date.
+hs::Result MapMemory(uintptr_t dst_address, uintptr_t src_address,
+                     size_t size) noexcept;
+hs::Result UnmapMemory(uintptr_t dst_address, uintptr_t src_address,
+                       size_t size) noexcept;
+
+// svc::MapSharedMemory and svc::UnmapSharedMemory keeping the memory map up to
+// date.
+hs::Result MapSharedMemory(hs::svc::Handle shared_memory_handle,
+                           uintptr_t address, size_t size,
+                           hs::svc::MemoryPermission permission) noexcept;
+hs::Result UnmapSharedMemory(hs::svc::Handle shared_memory_handle,
+                             uintptr_t address, size_t size) noexcept;
+
+// svc::MapTransferMemory and svc::UnmapTransferMemory keeping the memory map
+// up to date.
+hs::Result MapTransferMemory(hs::svc::Handle transfer_memory_handle,
+                             uintptr_t address, size_t size,
+                             hs::svc::MemoryPermission permission) noexcept;
+hs::Result UnmapTransferMemory(hs::svc::Handle transfer_memory_handle,
+                               uintptr_t address, size_t size) noexcept;
+}  // namespace hs::os::detail
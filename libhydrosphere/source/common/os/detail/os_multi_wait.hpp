@@ -0,0 +1,19 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <hs/os/os_multi_wait_api.hpp>
+
+namespace hs::os::detail {
+// Wake the MultiWait of every holder of a user object that was just signaled.
+// This must be called with the critical section of the object held.
+void NotifyMultiWaitHolders(MultiWaitHolder *holders) noexcept;
+}  // namespace hs::os::detail
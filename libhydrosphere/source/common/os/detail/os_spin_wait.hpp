@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <hs/hs_macro.hpp>
+
+namespace hs::os::detail {
+// Tell the CPU we are spinning on a value another thread will change.
+inline void SpinWaitHint() noexcept {
+#if defined(HYDROSPHERE_TARGET_HOST) && defined(__x86_64__)
+    __HS_ASM __volatile__("pause");
+#else
+    __HS_ASM __volatile__("yield");
+#endif
+}
+}  // namespace hs::os::detail
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/diag.hpp>
+#include <hs/util/util_std_new.hpp>
+#include <os/detail/os_memory_map.hpp>
+#include <os/detail/os_stack_alias_cache.hpp>
+#include <os/detail/os_virtualmemory_allocator.hpp>
+
+namespace hs::os::detail {
+__HS_ATTRIBUTE_VISIBILITY_HIDDEN hs::util::ObjectStorage<StackAliasCache>
+    g_StackAliasCache;
+
+void StackAliasCache::RemoveEntryUnsafe(size_t index) noexcept {
+    for (size_t i = index + 1; i < this->entry_count; i++) {
+        this->entries[i - 1] = this->entries[i];
+    }
+
+    this->entry_count--;
+}
+
+void StackAliasCache::UnmapEntry(const Entry &entry) noexcept {
+    auto result = UnmapMemory(reinterpret_cast<uintptr_t>(entry.mapped_stack),
+                              reinterpret_cast<uintptr_t>(entry.original_stack),
+                              entry.stack_size);
+    __HS_ABORT_CONDITIONAL_RESULT(result.Ok(), result);
+
+    g_StackAllocator->Free(entry.mapped_stack);
+}
+
+void *StackAliasCache::Acquire(void *original_stack,
+                               size_t stack_size) noexcept {
+    void *mapped_stack = nullptr;
+
+    this->critical_section.Enter();
+
+    for (size_t i = 0; i < this->entry_count; i++) {
+        const auto &entry = this->entries[i];
+
+        if (entry.original_stack == original_stack &&
+            entry.stack_size == stack_size) {
+            mapped_stack = entry.mapped_stack;
+            this->RemoveEntryUnsafe(i);
+            break;
+        }
+    }
+
+    this->critical_section.Leave();
+
+    return mapped_stack;
+}
+
+void StackAliasCache::Release(void *original_stack, size_t stack_size,
+                              void *mapped_stack) noexcept {
+    Entry entry = {original_stack, stack_size, mapped_stack};
+
+    this->critical_section.Enter();
+
+    if (this->capacity != 0) {
+        // Evict the oldest entry if we are full.
+        Entry evicted_entry = this->entries[0];
+        bool has_evicted = this->entry_count == this->capacity;
+
+        if (has_evicted) {
+            this->RemoveEntryUnsafe(0);
+        }
+
+        this->entries[this->entry_count++] = entry;
+        this->critical_section.Leave();
+
+        if (has_evicted) {
+            UnmapEntry(evicted_entry);
+        }
+
+        return;
+    }
+
+    this->critical_section.Leave();
+    UnmapEntry(entry);
+}
+
+void StackAliasCache::SetCapacity(size_t capacity) noexcept {
+    __HS_ASSERT(capacity <= THREAD_STACK_CACHE_MAX_CAPACITY);
+
+    this->critical_section.Enter();
+    this->capacity = capacity;
+    this->critical_section.Leave();
+
+    // Drop the entries that don't fit anymore, oldest first.
+    while (true) {
+        this->critical_section.Enter();
+
+        if (this->entry_count <= this->capacity) {
+            this->critical_section.Leave();
+            break;
+        }
+
+        Entry entry = this->entries[0];
+        this->RemoveEntryUnsafe(0);
+        this->critical_section.Leave();
+
+        UnmapEntry(entry);
+    }
+}
+
+void StackAliasCache::Trim() noexcept {
+    while (true) {
+        this->critical_section.Enter();
+
+        if (this->entry_count == 0) {
+            this->critical_section.Leave();
+            break;
+        }
+
+        Entry entry = this->entries[0];
+        this->RemoveEntryUnsafe(0);
+        this->critical_section.Leave();
+
+        UnmapEntry(entry);
+    }
+}
+
+void InitializeStackAliasCache() noexcept {
+    new (g_StackAliasCache.GetPointer()) StackAliasCache();
+}
+}  // namespace hs::os::detail
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/hs_macro.hpp>
+#include <hs/os/os_critical_section.hpp>
+#include <hs/os/os_thread_api.hpp>
+#include <hs/util/util_object_storage.hpp>
+
+namespace hs::os::detail {
+// Keep the stack aliases of exited threads mapped so a thread created later
+// with the same stack can reuse them without any syscall. Entries are kept
+// from the oldest to the most recently released one.
+class StackAliasCache {
+ private:
+    struct Entry {
+        void *original_stack;
+        size_t stack_size;
+        void *mapped_stack;
+    };
+
+    hs::os::CriticalSection critical_section;
+    size_t capacity;
+    size_t entry_count;
+    Entry entries[THREAD_STACK_CACHE_MAX_CAPACITY];
+
+    void RemoveEntryUnsafe(size_t index) noexcept;
+    static void UnmapEntry(const Entry &entry) noexcept;
+
+ public:
+    StackAliasCache() noexcept
+        : critical_section(), capacity(0), entry_count(0) {}
+    __HS_DISALLOW_COPY(StackAliasCache);
+
+    // Get a cached alias of the given stack, returns a null pointer if there
+    // is none.
+    void *Acquire(void *original_stack, size_t stack_size) noexcept;
+
+    // Give back the alias of a stack, it is unmapped if the cache is
+    // disabled.
+    void Release(void *original_stack, size_t stack_size,
+                 void *mapped_stack) noexcept;
+
+    void SetCapacity(size_t capacity) noexcept;
+    void Trim() noexcept;
+};
+
+extern __HS_ATTRIBUTE_VISIBILITY_HIDDEN hs::util::ObjectStorage<StackAliasCache>
+    g_StackAliasCache;
+
+void InitializeStackAliasCache() noexcept;
+}  // namespace hs::os::detail
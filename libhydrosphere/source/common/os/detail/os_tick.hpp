@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <hs/svc.hpp>
+
+namespace hs::os::detail {
+// The system tick runs at 19.2MHz, 12 ticks every 625ns.
+inline int64_t ConvertToTicks(int64_t nanoseconds) noexcept {
+    return nanoseconds / 625 * 12 + nanoseconds % 625 * 12 / 625;
+}
+
+inline int64_t ConvertToNanoseconds(int64_t ticks) noexcept {
+    return ticks / 12 * 625 + ticks % 12 * 625 / 12;
+}
+
+// Get the system tick at which a timeout expires.
+inline int64_t GetDeadline(int64_t timeout) noexcept {
+    return static_cast<int64_t>(hs::svc::GetSystemTick()) +
+           ConvertToTicks(timeout);
+}
+
+// Get the nanoseconds left before a deadline, 0 once it expired.
+inline int64_t GetRemainingTime(int64_t deadline) noexcept {
+    int64_t remaining_ticks =
+        deadline - static_cast<int64_t>(hs::svc::GetSystemTick());
+
+    if (remaining_ticks <= 0) {
+        return 0;
+    }
+
+    return ConvertToNanoseconds(remaining_ticks);
+}
+}  // namespace hs::os::detail
@@ -10,9 +10,12 @@
 
 #include <hs/diag.hpp>
 #include <hs/hs_macro.hpp>
+#include <hs/mem/mem_accounting_api.hpp>
+#include <hs/mem/mem_heap_api.hpp>
 #include <hs/os/os_api.hpp>
 #include <hs/svc.hpp>
 #include <hs/util.hpp>
+#include <os/detail/os_memory_map.hpp>
 #include <os/detail/os_virtualmemory_allocator.hpp>
 
 #define PAGE_SIZE 0x1000
@@ -23,65 +26,249 @@ __HS_ATTRIBUTE_VISIBILITY_HIDDEN hs::util::ObjectStorage<VirtualMemoryAllocator>
 __HS_ATTRIBUTE_VISIBILITY_HIDDEN hs::util::ObjectStorage<VirtualMemoryAllocator>
     g_StackAllocator;
 
-void *VirtualMemoryAllocator::Reserve(size_t size, size_t alignement) noexcept {
-    this->critical_section.Enter();
+AddressRange *VirtualMemoryAllocator::AllocateRange() noexcept {
+    return reinterpret_cast<AddressRange *>(
+        hs::mem::Allocate(sizeof(AddressRange)));
+}
 
-    // First page align the size
-    size = (size + (PAGE_SIZE - 1)) & ~(PAGE_SIZE - 1);
+void VirtualMemoryAllocator::FreeRange(AddressRange *range) noexcept {
+    hs::mem::Free(range);
+}
+
+void VirtualMemoryAllocator::InsertFreeRangeUnsafe(
+    AddressRange *range) noexcept {
+    uintptr_t range_end = range->address + range->size;
+
+    // Coalesce with the preceding range
+    auto previous = this->free_ranges.FindLowerOrEqual(range->address);
+    if (previous != nullptr &&
+        previous->address + previous->size == range->address) {
+        this->free_ranges.Remove(previous->address);
+        range->address = previous->address;
+        range->size += previous->size;
+        FreeRange(previous);
+    }
+
+    // Coalesce with the following range
+    auto next = this->free_ranges.Find(range_end);
+    if (next != nullptr) {
+        this->free_ranges.Remove(next->address);
+        range->size += next->size;
+        FreeRange(next);
+    }
+
+    this->free_ranges.Insert(range);
+}
+
+void VirtualMemoryAllocator::Initialize() noexcept {
+    uintptr_t address = this->address_space_start;
+    MemoryRegion region;
+
+    while (address < this->address_space_end) {
+        bool success = g_MemoryMap->Query(&region, address);
+        __HS_ASSERT(success);
+
+        uintptr_t region_end = region.address + region.size;
+
+        // The last region of the address space may wrap around.
+        if (region_end <= address || region_end > this->address_space_end) {
+            region_end = this->address_space_end;
+        }
+
+        if (region.type == hs::svc::MemoryType::Free) {
+            auto range = AllocateRange();
+            __HS_ABORT_UNLESS_NOT_NULL(range);
+
+            range->address = address;
+            range->size = region_end - address;
+            this->InsertFreeRangeUnsafe(range);
+        }
+
+        address = region_end;
+    }
+}
+
+bool VirtualMemoryAllocator::ExcludeMapped(uintptr_t address,
+                                           size_t size) noexcept {
+    uintptr_t end_address = address + size;
+    MemoryRegion region;
+    bool has_excluded = false;
+
+    while (address < end_address && g_MemoryMap->Query(&region, address)) {
+        if (region.type != hs::svc::MemoryType::Free) {
+            this->Exclude(region.address, region.size);
+            has_excluded = true;
+        }
 
-    // Make sure we are going to be in range
-    if (!this->InsideAddressRange(this->address_space_start,
-                                  this->address_space_end,
-                                  this->next_availaible_address)) {
-        this->next_availaible_address = this->address_space_start;
+        address = region.address + region.size;
     }
 
-    uintptr_t address = this->next_availaible_address;
-    hs::svc::MemoryInfo memory_info;
-    uint32_t page_info;
-    bool already_retried = false;
+    return has_excluded;
+}
+
+void VirtualMemoryAllocator::Exclude(uintptr_t address, size_t size) noexcept {
+    uintptr_t end_address = address + size;
+
+    this->critical_section.Enter();
 
     while (true) {
-        // Add guard pages
-        address += this->guard_page_size;
-
-        // Align address to user requirement
-        address = (address + (alignement - 1)) & ~(alignement - 1);
-
-        if (!this->InsideAddressRange(this->address_space_start,
-                                      this->address_space_end, address)) {
-            // We scanned all the address space but haven't found a free spot so
-            // we need to return here
-            if (already_retried) {
-                address = 0;
-                break;
-            } else {
-                // We might have some free spots before the last allocated
-                // address, try to scan this part
-                address = this->address_space_start;
-                already_retried = true;
-                continue;
-            }
+        auto range = this->free_ranges.FindLowerOrEqual(address);
+
+        if (range == nullptr || range->address + range->size <= address) {
+            range = this->free_ranges.FindGreaterOrEqual(address);
+        }
+
+        if (range == nullptr || range->address >= end_address) {
+            break;
         }
 
-        hs::svc::QueryMemory(&memory_info, &page_info, address);
+        this->free_ranges.Remove(range->address);
+
+        uintptr_t range_end = range->address + range->size;
 
-        // not availaible/enough memory, try next region
-        if (memory_info.type != 0 || size > memory_info.size) {
-            address = memory_info.address + memory_info.size;
-            continue;
+        // Keep what is before the excluded range.
+        if (range->address < address) {
+            range->size = address - range->address;
+            this->free_ranges.Insert(range);
+            range = nullptr;
         }
 
-        this->next_availaible_address = address + size;
-        break;
+        // Keep what is after the excluded range.
+        if (range_end > end_address) {
+            if (range == nullptr) {
+                range = AllocateRange();
+                __HS_ABORT_UNLESS_NOT_NULL(range);
+            }
+
+            range->address = end_address;
+            range->size = range_end - end_address;
+            this->free_ranges.Insert(range);
+            range = nullptr;
+        }
+
+        if (range != nullptr) {
+            FreeRange(range);
+        }
     }
 
     this->critical_section.Leave();
+}
+
+void *VirtualMemoryAllocator::Reserve(size_t size, size_t alignement) noexcept {
+    // First page align the size
+    size = (size + (PAGE_SIZE - 1)) & ~(PAGE_SIZE - 1);
+
+    if (alignement < PAGE_SIZE) {
+        alignement = PAGE_SIZE;
+    }
+
+    // Get the nodes we may need before touching the trees.
+    auto reservation = AllocateRange();
+    auto remaining_range = AllocateRange();
+
+    if (reservation == nullptr || remaining_range == nullptr) {
+        FreeRange(reservation);
+        FreeRange(remaining_range);
+        return nullptr;
+    }
+
+    this->critical_section.Enter();
+
+    size_t required_size = size + this->guard_page_size;
+    AddressRange *range = nullptr;
+
+    // Any range big enough to hold the worst case alignment padding fits,
+    // this keeps the search O(log n).
+    if (alignement > PAGE_SIZE) {
+        range = this->free_ranges.FindFirstFit(
+            required_size + alignement - PAGE_SIZE, size, alignement,
+            this->guard_page_size);
+    }
+
+    if (range == nullptr) {
+        range = this->free_ranges.FindFirstFit(required_size, size, alignement,
+                                               this->guard_page_size);
+    }
+
+    if (range == nullptr) {
+        this->critical_section.Leave();
+        FreeRange(reservation);
+        FreeRange(remaining_range);
+        return nullptr;
+    }
+
+    uintptr_t address = AddressRangeTree::GetFitAddress(
+        range, size, alignement, this->guard_page_size);
+    uintptr_t reservation_start = address - this->guard_page_size;
+    uintptr_t reservation_end = address + size;
+    uintptr_t range_end = range->address + range->size;
+
+    this->free_ranges.Remove(range->address);
+
+    // Keep what is before the reservation.
+    if (range->address < reservation_start) {
+        range->size = reservation_start - range->address;
+        this->free_ranges.Insert(range);
+    } else {
+        FreeRange(range);
+    }
+
+    // Keep what is after the reservation.
+    if (reservation_end < range_end) {
+        remaining_range->address = reservation_end;
+        remaining_range->size = range_end - reservation_end;
+        this->free_ranges.Insert(remaining_range);
+        remaining_range = nullptr;
+    }
+
+    reservation->address = address;
+    reservation->size = size;
+    this->reservations.Insert(reservation);
+
+    this->critical_section.Leave();
+
+    FreeRange(remaining_range);
+    hs::mem::AccountMemory(hs::mem::MemoryTag::VirtualMemory, size);
+
     return reinterpret_cast<void *>(address);
 }
 
+void *VirtualMemoryAllocator::ReserveLargeBlocks(size_t size) noexcept {
+    if (size > SIZE_MAX - (LARGE_BLOCK_SIZE - 1)) {
+        return nullptr;
+    }
+
+    size = (size + (LARGE_BLOCK_SIZE - 1)) & ~(LARGE_BLOCK_SIZE - 1);
+
+    if (size >= HUGE_BLOCK_SIZE) {
+        void *address = this->Reserve(size, HUGE_BLOCK_SIZE);
+
+        if (address != nullptr) {
+            return address;
+        }
+    }
+
+    return this->Reserve(size, LARGE_BLOCK_SIZE);
+}
+
 void VirtualMemoryAllocator::Free(void *ptr) noexcept {
-    __HS_IGNORE_ARGUMENT(ptr);
+    if (ptr == nullptr) {
+        return;
+    }
+
+    this->critical_section.Enter();
+
+    auto range = this->reservations.Remove(reinterpret_cast<uintptr_t>(ptr));
+    __HS_ABORT_UNLESS_NOT_NULL(range);
+
+    hs::mem::UnaccountMemory(hs::mem::MemoryTag::VirtualMemory, range->size);
+
+    // Give back the guard pages with the reservation.
+    range->address -= this->guard_page_size;
+    range->size += this->guard_page_size;
+    this->InsertFreeRangeUnsafe(range);
+
+    this->critical_section.Leave();
 }
 
 void InitializeVirtualMemoryAllocators(void) noexcept {
@@ -91,6 +278,12 @@ void InitializeVirtualMemoryAllocators(void) noexcept {
     uint64_t stack_address_space_start = 0;
     uint64_t stack_address_space_size = 0;
 
+    uint64_t heap_region_start = 0;
+    uint64_t heap_region_size = 0;
+
+    uint64_t alias_region_start = 0;
+    uint64_t alias_region_size = 0;
+
     if (hs::svc::GetInfo(&address_space_start, svc::InfoType::AddressSpaceBase,
                          hs::os::GetProcessPseudoHandle(), 0)
             .Err()) {
@@ -111,12 +304,50 @@ void InitializeVirtualMemoryAllocators(void) noexcept {
                                   svc::InfoType::StackRegionSize,
                                   hs::os::GetProcessPseudoHandle(), 0);
         __HS_ABORT_CONDITIONAL_RESULT(result.Ok(), result);
+
+        result = hs::svc::GetInfo(&heap_region_start,
+                                  svc::InfoType::HeapRegionBase,
+                                  hs::os::GetProcessPseudoHandle(), 0);
+        __HS_ABORT_CONDITIONAL_RESULT(result.Ok(), result);
+
+        result = hs::svc::GetInfo(&heap_region_size,
+                                  svc::InfoType::HeapRegionSize,
+                                  hs::os::GetProcessPseudoHandle(), 0);
+        __HS_ABORT_CONDITIONAL_RESULT(result.Ok(), result);
+
+        result = hs::svc::GetInfo(&alias_region_start,
+                                  svc::InfoType::AliasRegionBase,
+                                  hs::os::GetProcessPseudoHandle(), 0);
+        __HS_ABORT_CONDITIONAL_RESULT(result.Ok(), result);
+
+        result = hs::svc::GetInfo(&alias_region_size,
+                                  svc::InfoType::AliasRegionSize,
+                                  hs::os::GetProcessPseudoHandle(), 0);
+        __HS_ABORT_CONDITIONAL_RESULT(result.Ok(), result);
+    }
+
+    // On 32-bit the address space ends at 4GiB which doesn't fit in an
+    // uintptr_t, give up on its last page.
+    uintptr_t address_space_end =
+        static_cast<uintptr_t>(address_space_start + address_space_size);
+    if (address_space_end < address_space_start) {
+        address_space_end = ~static_cast<uintptr_t>(PAGE_SIZE - 1);
     }
 
-    *g_AddressSpaceAllocator = VirtualMemoryAllocator(
-        address_space_start, address_space_start + address_space_size, 0x1000);
-    *g_StackAllocator = VirtualMemoryAllocator(
+    new (g_AddressSpaceAllocator.GetPointer()) VirtualMemoryAllocator(
+        address_space_start, address_space_end, 0x1000);
+    new (g_StackAllocator.GetPointer()) VirtualMemoryAllocator(
         stack_address_space_start,
         stack_address_space_start + stack_address_space_size, 0x1000);
+
+    g_AddressSpaceAllocator->Initialize();
+    g_StackAllocator->Initialize();
+
+    // The heap, alias and stack regions are managed by other means, keep them
+    // out of the general address space allocator.
+    g_AddressSpaceAllocator->Exclude(heap_region_start, heap_region_size);
+    g_AddressSpaceAllocator->Exclude(alias_region_start, alias_region_size);
+    g_AddressSpaceAllocator->Exclude(stack_address_space_start,
+                                     stack_address_space_size);
 }
 }  // namespace hs::os::detail
@@ -10,26 +10,36 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include <hs/hs_macro.hpp>
 #include <hs/os/os_critical_section.hpp>
 #include <hs/util/util_object_storage.hpp>
+#include <os/detail/os_address_range_tree.hpp>
 
 namespace hs::os::detail {
+// The sizes of the ranges the MMU can map with a single level 2 and level 1
+// page table entry.
+const size_t LARGE_BLOCK_SIZE = 0x200000;
+const size_t HUGE_BLOCK_SIZE = 0x40000000;
+
+// Track the free ranges and the reservations of an address space region.
+// The free ranges are taken from the memory map when the allocator is
+// initialized, reserving and freeing don't issue any syscall afterwards.
 class VirtualMemoryAllocator {
  private:
     hs::os::CriticalSection critical_section;
     uintptr_t address_space_start;
     uintptr_t address_space_end;
     size_t guard_page_size;
-    uintptr_t next_availaible_address;
-    static inline bool InsideAddressRange(uintptr_t start_address,
-                                          uintptr_t end_address,
-                                          uintptr_t target_address) noexcept {
-        return (target_address >= start_address) &&
-               (target_address < end_address);
-    }
+    AddressRangeTree free_ranges;
+    AddressRangeTree reservations;
+
+    static AddressRange *AllocateRange() noexcept;
+    static void FreeRange(AddressRange *range) noexcept;
+
+    void InsertFreeRangeUnsafe(AddressRange *range) noexcept;
 
  public:
     VirtualMemoryAllocator(uintptr_t address_space_start,
@@ -39,9 +49,30 @@ class VirtualMemoryAllocator {
           address_space_start(address_space_start),
           address_space_end(address_space_end),
           guard_page_size(guard_page_size),
-          next_availaible_address(address_space_start) {}
+          free_ranges(),
+          reservations() {}
     __HS_DISALLOW_COPY(VirtualMemoryAllocator);
+
+    // Get the unmapped ranges of the address space region from the memory
+    // map.
+    void Initialize() noexcept;
+
+    // Remove a range from the free ranges, used to keep other regions of the
+    // address space out of this allocator.
+    void Exclude(uintptr_t address, size_t size) noexcept;
+
+    // Exclude the ranges the memory map knows as mapped inside a range,
+    // returns true if there was any. This is used when mapping memory at a
+    // reserved address failed because someone else mapped it.
+    bool ExcludeMapped(uintptr_t address, size_t size) noexcept;
+
     void *Reserve(size_t size, size_t alignement) noexcept;
+
+    // Reserve a range made of whole large blocks, aligned on huge blocks if
+    // the range is big enough and a suitable place is free. Memory mapped
+    // at the same offsets in a range like this can be backed by block
+    // mappings.
+    void *ReserveLargeBlocks(size_t size) noexcept;
     void Free(void *ptr) noexcept;
 };
 
@@ -52,6 +83,7 @@ extern __HS_ATTRIBUTE_VISIBILITY_HIDDEN
     hs::util::ObjectStorage<VirtualMemoryAllocator>
         g_StackAllocator;
 
+// Must be called after the memory map and the heap are initialized.
 void InitializeVirtualMemoryAllocators(void) noexcept;
 
 }  // namespace hs::os::detail
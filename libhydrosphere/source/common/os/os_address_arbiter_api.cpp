@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/diag.hpp>
+#include <hs/os/os_address_arbiter_api.hpp>
+#include <hs/svc.hpp>
+
+namespace hs::os {
+static AddressWaitStatus WaitForAddress(
+    volatile _Atomic(int32_t) *address,
+    hs::svc::ArbitrationType arbitration_type, int32_t value,
+    int64_t timeout) noexcept {
+    auto result = hs::svc::WaitForAddress(reinterpret_cast<uintptr_t>(address),
+                                          arbitration_type, value, timeout);
+
+    if (result.Err()) {
+        // timed out
+        if ((result.GetValue() & 0x3FFFFF) == 0xEA01) {
+            return AddressWaitStatus::TimedOut;
+        }
+
+        // the value didn't satisfy the condition
+        if ((result.GetValue() & 0x3FFFFF) == 0xFA01) {
+            return AddressWaitStatus::ValueMismatch;
+        }
+
+        __HS_ABORT_CONDITIONAL_RESULT(result.Ok(), result);
+    }
+
+    return AddressWaitStatus::Signaled;
+}
+
+static bool SignalToAddress(volatile _Atomic(int32_t) *address,
+                            hs::svc::SignalType signal_type, int32_t value,
+                            int32_t count) noexcept {
+    auto result = hs::svc::SignalToAddress(
+        reinterpret_cast<uintptr_t>(address), signal_type, value, count);
+
+    if (result.Err()) {
+        // the value didn't satisfy the condition
+        if ((result.GetValue() & 0x3FFFFF) == 0xFA01) {
+            return false;
+        }
+
+        __HS_ABORT_CONDITIONAL_RESULT(result.Ok(), result);
+    }
+
+    return true;
+}
+
+AddressWaitStatus WaitForAddressIfEqual(volatile _Atomic(int32_t) *address,
+                                        int32_t value,
+                                        int64_t timeout) noexcept {
+    return WaitForAddress(address, hs::svc::ArbitrationType::WaitIfEqual,
+                          value, timeout);
+}
+
+AddressWaitStatus WaitForAddressIfLessThan(volatile _Atomic(int32_t) *address,
+                                           int32_t value,
+                                           int64_t timeout) noexcept {
+    return WaitForAddress(address, hs::svc::ArbitrationType::WaitIfLessThan,
+                          value, timeout);
+}
+
+AddressWaitStatus DecrementAndWaitForAddressIfLessThan(
+    volatile _Atomic(int32_t) *address, int32_t value,
+    int64_t timeout) noexcept {
+    return WaitForAddress(
+        address, hs::svc::ArbitrationType::DecrementAndWaitIfLessThan, value,
+        timeout);
+}
+
+void SignalToAddress(volatile _Atomic(int32_t) *address,
+                     int32_t count) noexcept {
+    SignalToAddress(address, hs::svc::SignalType::Signal, 0, count);
+}
+
+bool SignalToAddressAndIncrementIfEqual(volatile _Atomic(int32_t) *address,
+                                        int32_t value,
+                                        int32_t count) noexcept {
+    return SignalToAddress(address,
+                           hs::svc::SignalType::SignalAndIncrementIfEqual,
+                           value, count);
+}
+
+bool SignalToAddressAndModifyByWaitingCountIfEqual(
+    volatile _Atomic(int32_t) *address, int32_t value,
+    int32_t count) noexcept {
+    return SignalToAddress(
+        address, hs::svc::SignalType::SignalAndModifyByWaitingCountIfEqual,
+        value, count);
+}
+}  // namespace hs::os
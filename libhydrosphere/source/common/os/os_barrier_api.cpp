@@ -8,7 +8,9 @@
  * except according to those terms.
  */
 
+#include <hs/diag.hpp>
 #include <hs/os/os_barrier_api.hpp>
+#include <os/detail/os_spin_wait.hpp>
 
 enum BarrierState {
     BarrierState_Uninitialized = 0,
@@ -16,26 +18,150 @@ enum BarrierState {
 };
 
 namespace hs::os {
+static const uint32_t BARRIER_NODE_ROOT = 0xFFFFFFFF;
+
+// The last thread to arrive resets the count for the next phase, the others
+// only arrive again once they see the barrier released.
+static bool Arrive(volatile _Atomic(uint32_t) *arrive_count,
+                   uint32_t number_to_wait) noexcept {
+    if (atomic_fetch_add_explicit(arrive_count, 1, memory_order_acq_rel) + 1 !=
+        number_to_wait) {
+        return false;
+    }
+
+    atomic_store_explicit(arrive_count, 0, memory_order_relaxed);
+    return true;
+}
+
+// Return true for the last thread to arrive at the root of the tree.
+static bool ArriveAtTree(BarrierNode *nodes, uint32_t node_index) noexcept {
+    while (node_index != BARRIER_NODE_ROOT) {
+        BarrierNode *node = &nodes[node_index];
+
+        if (!Arrive(&node->arrive_count, node->number_to_wait)) {
+            return false;
+        }
+
+        node_index = node->parent_index;
+    }
+
+    return true;
+}
+
+static void Release(Barrier *barrier) noexcept {
+    barrier->critical_section.Enter();
+
+    atomic_fetch_add_explicit(&barrier->generation, 1, memory_order_release);
+    barrier->condition_variable.Broadcast();
+
+    barrier->critical_section.Leave();
+}
+
+static void WaitForRelease(Barrier *barrier, uint32_t generation) noexcept {
+    for (uint32_t i = 0; i < barrier->spin_count; i++) {
+        if (atomic_load_explicit(&barrier->generation, memory_order_acquire) !=
+            generation) {
+            return;
+        }
+
+        detail::SpinWaitHint();
+    }
+
+    barrier->critical_section.Enter();
+
+    while (atomic_load_explicit(&barrier->generation, memory_order_acquire) ==
+           generation) {
+        barrier->condition_variable.Wait(&barrier->critical_section);
+    }
+
+    barrier->critical_section.Leave();
+}
+
 void InitializeBarrier(Barrier *barrier, uint32_t number_to_wait) noexcept {
-    barrier->arrive_count = 0;
+    __HS_ASSERT(number_to_wait != 0);
+
+    atomic_store(&barrier->arrive_count, 0);
     barrier->number_to_wait = number_to_wait;
+    atomic_store(&barrier->generation, 0);
+    barrier->spin_count = 0;
+    barrier->nodes = nullptr;
     barrier->critical_section = CriticalSection();
     barrier->condition_variable = ConditionVariableImpl();
     barrier->state = BarrierState_Initialized;
 }
 
+void InitializeBarrier(Barrier *barrier, uint32_t number_to_wait,
+                       BarrierNode *nodes) noexcept {
+    InitializeBarrier(barrier, number_to_wait);
+
+    // The leaves come first, each level is followed by the level of their
+    // parents up to the root.
+    uint32_t level_index = 0;
+    uint32_t child_count = number_to_wait;
+
+    do {
+        uint32_t level_node_count =
+            (child_count + BARRIER_TREE_FAN_IN - 1) / BARRIER_TREE_FAN_IN;
+        uint32_t next_level_index = level_index + level_node_count;
+
+        for (uint32_t i = 0; i < level_node_count; i++) {
+            BarrierNode *node = &nodes[level_index + i];
+            uint32_t first_child = i * BARRIER_TREE_FAN_IN;
+
+            atomic_store(&node->arrive_count, 0);
+            node->number_to_wait = child_count - first_child;
+            if (node->number_to_wait > BARRIER_TREE_FAN_IN) {
+                node->number_to_wait = BARRIER_TREE_FAN_IN;
+            }
+
+            if (level_node_count > 1) {
+                node->parent_index = next_level_index + i / BARRIER_TREE_FAN_IN;
+            } else {
+                node->parent_index = BARRIER_NODE_ROOT;
+            }
+        }
+
+        level_index = next_level_index;
+        child_count = level_node_count;
+    } while (child_count > 1);
+
+    barrier->nodes = nodes;
+}
+
+void SetBarrierSpinCount(Barrier *barrier, uint32_t spin_count) noexcept {
+    barrier->spin_count = spin_count;
+}
+
 void AwaitBarrier(Barrier *barrier) noexcept {
-    barrier->critical_section.Enter();
+    __HS_ASSERT(barrier->nodes == nullptr);
 
-    barrier->arrive_count++;
+    uint32_t generation =
+        atomic_load_explicit(&barrier->generation, memory_order_acquire);
 
-    if (barrier->arrive_count == barrier->number_to_wait) {
-        barrier->condition_variable.Broadcast();
+    if (Arrive(&barrier->arrive_count, barrier->number_to_wait)) {
+        Release(barrier);
     } else {
-        barrier->condition_variable.Wait(&barrier->critical_section);
+        WaitForRelease(barrier, generation);
     }
+}
 
-    barrier->critical_section.Leave();
+void AwaitBarrier(Barrier *barrier, uint32_t participant_index) noexcept {
+    if (barrier->nodes == nullptr) {
+        AwaitBarrier(barrier);
+        return;
+    }
+
+    __HS_ASSERT(participant_index < barrier->number_to_wait);
+
+    uint32_t generation =
+        atomic_load_explicit(&barrier->generation, memory_order_acquire);
+
+    if (ArriveAtTree(barrier->nodes,
+                     participant_index / BARRIER_TREE_FAN_IN)) {
+        Release(barrier);
+    } else {
+        WaitForRelease(barrier, generation);
+    }
 }
 
 void FinalizeBarrier(Barrier *barrier) noexcept {
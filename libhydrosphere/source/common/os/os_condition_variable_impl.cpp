@@ -15,13 +15,24 @@
 #include <hs/svc.hpp>
 
 namespace hs::os {
+// The kernel sets the key before a thread releases the critical section to
+// wait on it, and clears it once the last waiter was signaled. A signaler that
+// entered the critical section after a waiter left it always sees the key set.
+static inline bool HasWaiters(
+    volatile _Atomic(uint_fast32_t) *image) noexcept {
+    return atomic_load(image) != 0;
+}
 
 void ConditionVariableImpl::Signal(void) noexcept {
-    hs::svc::SignalProcessWideKey((uintptr_t) & this->image, 1);
+    if (HasWaiters(&this->image)) {
+        hs::svc::SignalProcessWideKey((uintptr_t) & this->image, 1);
+    }
 }
 
 void ConditionVariableImpl::Broadcast(void) noexcept {
-    hs::svc::SignalProcessWideKey((uintptr_t) & this->image, -1);
+    if (HasWaiters(&this->image)) {
+        hs::svc::SignalProcessWideKey((uintptr_t) & this->image, -1);
+    }
 }
 
 void ConditionVariableImpl::Wait(CriticalSection *critical_section) noexcept {
@@ -11,48 +11,127 @@
 #include <hs/os/os_api.hpp>
 #include <hs/os/os_critical_section.hpp>
 #include <hs/svc.hpp>
+#include <os/detail/os_spin_wait.hpp>
 
 #define HAS_LISTENERS 0x40000000
 
 namespace hs::os {
-void CriticalSection::Enter() noexcept {
+// About the cost of blocking in the kernel and being woken back.
+static volatile _Atomic(uint32_t) g_SpinCount = 100;
+
+// Spin while the owner may leave the critical section soon. Once a thread
+// blocks on it, the owner is likely to hold it for long and the kernel hands
+// it to the blocked threads anyway, stop spinning then.
+static bool SpinToEnter(volatile _Atomic(uint_fast32_t) *image,
+                        uint32_t self_value, uint32_t spin_limit,
+                        uint32_t *out_spin_count) noexcept {
+    uint32_t i;
+
+    for (i = 0; i < spin_limit; i++) {
+        uint32_t value = atomic_load_explicit(image, memory_order_relaxed);
+
+        if (value == 0) {
+            uint32_t expected_value = 0;
+
+            if (atomic_compare_exchange_weak_explicit(
+                    image, &expected_value, self_value, memory_order_acquire,
+                    memory_order_relaxed)) {
+                *out_spin_count = i;
+                return true;
+            }
+        } else if (value & HAS_LISTENERS) {
+            break;
+        }
+
+        detail::SpinWaitHint();
+    }
+
+    // Stopping early on a blocked thread counts as the spins done so far.
+    *out_spin_count = i;
+    return false;
+}
+
+// Return false if the critical section was entered without contention.
+static bool EnterCriticalSection(volatile _Atomic(uint_fast32_t) *image,
+                                 uint32_t spin_limit,
+                                 uint32_t *out_spin_count) noexcept {
     auto self_thread_handle = hs::os::GetCurrentThreadHandle();
+    uint32_t expected_value = 0;
+
+    // If there is no contention, we won, return.
+    if (atomic_compare_exchange_strong(image, &expected_value,
+                                       self_thread_handle.GetValue())) {
+        return false;
+    }
+
+    // If we already own the lock, we won, return.
+    if ((expected_value & ~HAS_LISTENERS) == self_thread_handle.GetValue()) {
+        return false;
+    }
+
+    if (SpinToEnter(image, self_thread_handle.GetValue(), spin_limit,
+                    out_spin_count)) {
+        return true;
+    }
 
     while (true) {
-        uint32_t expected_value = 0;
+        expected_value = 0;
 
         // If there is no contention, we won, return.
-        if (atomic_compare_exchange_strong(&this->image, &expected_value,
+        if (atomic_compare_exchange_strong(image, &expected_value,
                                            self_thread_handle.GetValue())) {
-            return;
+            return true;
         }
 
         // If we own the lock or it was previously not owned, we won, return.
         if ((expected_value & ~HAS_LISTENERS) ==
             self_thread_handle.GetValue()) {
-            return;
+            return true;
         }
 
         if (expected_value & HAS_LISTENERS) {
             hs::svc::ArbitrateLock(
                 hs::svc::Handle::FromRawValue(expected_value & ~HAS_LISTENERS),
-                (uintptr_t) & this->image, self_thread_handle);
+                (uintptr_t)image, self_thread_handle);
         } else {
             // the value changed, we lost the race :(
             if (!atomic_compare_exchange_strong(
-                    &this->image, &expected_value,
-                    expected_value | HAS_LISTENERS)) {
+                    image, &expected_value, expected_value | HAS_LISTENERS)) {
                 continue;
             } else {
                 hs::svc::ArbitrateLock(
                             hs::svc::Handle::FromRawValue(expected_value),
-                            reinterpret_cast<uintptr_t>(&this->image),
+                            reinterpret_cast<uintptr_t>(image),
                             self_thread_handle);
             }
         }
     }
 }
 
+void CriticalSection::Enter() noexcept {
+    uint32_t spin_count;
+
+    EnterCriticalSection(&this->image, GetCriticalSectionSpinCount(),
+                         &spin_count);
+}
+
+void CriticalSection::Enter(CriticalSectionSpinState *spin_state) noexcept {
+    // Give a bit more than usual, so the spin count can also grow.
+    uint32_t spin_limit = spin_state->spin_count * 2 + 10;
+    if (spin_limit > spin_state->spin_limit) {
+        spin_limit = spin_state->spin_limit;
+    }
+
+    uint32_t spin_count;
+
+    // The spin state is updated with the critical section held.
+    if (EnterCriticalSection(&this->image, spin_limit, &spin_count)) {
+        int32_t spin_count_delta =
+            static_cast<int32_t>(spin_count) - spin_state->spin_count;
+        spin_state->spin_count += spin_count_delta / 8;
+    }
+}
+
 bool CriticalSection::TryEnter() noexcept {
     auto self_thread_handle = hs::os::GetCurrentThreadHandle();
 
@@ -86,4 +165,12 @@ bool CriticalSection::IsLockedByCurrentThread() noexcept {
     return (this->image & ~HAS_LISTENERS) ==
            hs::os::GetCurrentThreadHandle().GetValue();
 }
+
+void SetCriticalSectionSpinCount(uint32_t spin_count) noexcept {
+    atomic_store_explicit(&g_SpinCount, spin_count, memory_order_relaxed);
+}
+
+uint32_t GetCriticalSectionSpinCount() noexcept {
+    return atomic_load_explicit(&g_SpinCount, memory_order_relaxed);
+}
 }  // namespace hs::os
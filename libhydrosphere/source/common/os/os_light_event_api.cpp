@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/os/os_address_arbiter_api.hpp>
+#include <hs/os/os_light_event_api.hpp>
+#include <os/detail/os_tick.hpp>
+
+enum LightEventState {
+    LightEventState_Uninitialized = 0,
+    LightEventState_Initialized = 1,
+};
+
+namespace hs::os {
+// Threads only sleep on a cleared event marked as having waiters, the
+// signalers only reach the kernel in this case. The values are chosen so that
+// SignalAndModifyByWaitingCountIfEqual sets the event when nobody waits and
+// clears the waiters mark when it wakes the last one.
+static const int32_t LIGHT_EVENT_CLEARED = -1;
+static const int32_t LIGHT_EVENT_CLEARED_WITH_WAITERS = 0;
+static const int32_t LIGHT_EVENT_SIGNALED = 1;
+
+// Consume the signal of an auto clear event or check the one of a manual clear
+// event.
+static bool TryWaitLightEvent(LightEvent *event) noexcept {
+    if (!event->is_auto_clear) {
+        return atomic_load(&event->signal_state) == LIGHT_EVENT_SIGNALED;
+    }
+
+    int32_t signal_state = LIGHT_EVENT_SIGNALED;
+
+    return atomic_compare_exchange_strong(&event->signal_state, &signal_state,
+                                          LIGHT_EVENT_CLEARED);
+}
+
+// Wait until the event is signaled or the deadline (in system ticks) expires.
+// A negative deadline waits forever.
+static bool WaitLightEventUntil(LightEvent *event, int64_t deadline) noexcept {
+    while (!TryWaitLightEvent(event)) {
+        int32_t signal_state = LIGHT_EVENT_CLEARED;
+
+        // Mark the waiters before sleeping, unless the event was signaled
+        // meanwhile.
+        if (!atomic_compare_exchange_strong(&event->signal_state,
+                                            &signal_state,
+                                            LIGHT_EVENT_CLEARED_WITH_WAITERS) &&
+            signal_state != LIGHT_EVENT_CLEARED_WITH_WAITERS) {
+            continue;
+        }
+
+        int64_t timeout = -1;
+
+        if (deadline >= 0) {
+            timeout = detail::GetRemainingTime(deadline);
+
+            if (timeout == 0) {
+                return false;
+            }
+        }
+
+        AddressWaitStatus status = WaitForAddressIfEqual(
+            &event->signal_state, LIGHT_EVENT_CLEARED_WITH_WAITERS, timeout);
+
+        // An auto clear event hands its signal to the thread it wakes.
+        if (status == AddressWaitStatus::Signaled && event->is_auto_clear) {
+            return true;
+        }
+
+        if (status == AddressWaitStatus::TimedOut) {
+            return TryWaitLightEvent(event);
+        }
+    }
+
+    return true;
+}
+
+void InitializeLightEvent(LightEvent *event, bool is_signaled,
+                          bool is_auto_clear) noexcept {
+    atomic_store(&event->signal_state,
+                 is_signaled ? LIGHT_EVENT_SIGNALED : LIGHT_EVENT_CLEARED);
+    event->is_auto_clear = is_auto_clear;
+    event->state = LightEventState_Initialized;
+}
+
+void WaitLightEvent(LightEvent *event) noexcept {
+    WaitLightEventUntil(event, -1);
+}
+
+bool TimedWaitLightEvent(LightEvent *event, int64_t timeout) noexcept {
+    if (TryWaitLightEvent(event)) {
+        return true;
+    }
+
+    if (timeout <= 0) {
+        return false;
+    }
+
+    return WaitLightEventUntil(event, detail::GetDeadline(timeout));
+}
+
+bool IsLightEventSignaled(LightEvent *event) noexcept {
+    return TryWaitLightEvent(event);
+}
+
+void SignalLightEvent(LightEvent *event) noexcept {
+    if (!event->is_auto_clear) {
+        if (atomic_exchange(&event->signal_state, LIGHT_EVENT_SIGNALED) ==
+            LIGHT_EVENT_CLEARED_WITH_WAITERS) {
+            SignalToAddress(&event->signal_state, -1);
+        }
+
+        return;
+    }
+
+    int32_t signal_state = atomic_load(&event->signal_state);
+
+    while (signal_state != LIGHT_EVENT_SIGNALED) {
+        if (signal_state == LIGHT_EVENT_CLEARED) {
+            if (atomic_compare_exchange_weak(&event->signal_state,
+                                             &signal_state,
+                                             LIGHT_EVENT_SIGNALED)) {
+                return;
+            }
+
+            continue;
+        }
+
+        // Wake a single waiter, the kernel sets the event if nobody waits
+        // anymore.
+        if (SignalToAddressAndModifyByWaitingCountIfEqual(
+                &event->signal_state, LIGHT_EVENT_CLEARED_WITH_WAITERS, 1)) {
+            return;
+        }
+
+        signal_state = atomic_load(&event->signal_state);
+    }
+}
+
+void ClearLightEvent(LightEvent *event) noexcept {
+    int32_t signal_state = LIGHT_EVENT_SIGNALED;
+
+    atomic_compare_exchange_strong(&event->signal_state, &signal_state,
+                                   LIGHT_EVENT_CLEARED);
+}
+
+void FinalizeLightEvent(LightEvent *event) noexcept {
+    event->state = LightEventState_Uninitialized;
+}
+}  // namespace hs::os
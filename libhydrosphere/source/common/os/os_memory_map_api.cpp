@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/os/os_memory_map_api.hpp>
+#include <os/detail/os_memory_map.hpp>
+
+namespace hs::os {
+bool QueryMemoryMap(MemoryRegion *out_region, uintptr_t address) noexcept {
+    return detail::g_MemoryMap->Query(out_region, address);
+}
+
+bool FindFreeMemoryGap(uintptr_t *out_address, uintptr_t search_address,
+                       size_t search_size, size_t size,
+                       size_t alignment) noexcept {
+    return detail::g_MemoryMap->FindFreeGap(out_address, search_address,
+                                            search_size, size, alignment);
+}
+
+void RefreshMemoryMap(uintptr_t address, size_t size) noexcept {
+    detail::g_MemoryMap->Refresh(address, size);
+}
+}  // namespace hs::os
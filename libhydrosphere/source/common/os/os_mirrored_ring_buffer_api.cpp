@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/diag.hpp>
+#include <hs/os/os_mirrored_ring_buffer_api.hpp>
+#include <hs/svc.hpp>
+#include <os/detail/os_memory_map.hpp>
+#include <os/detail/os_virtualmemory_allocator.hpp>
+
+namespace hs::os {
+static const hs::svc::MemoryPermission RING_BUFFER_PERMISSION =
+    hs::svc::MemoryPermission::Read | hs::svc::MemoryPermission::Write;
+
+// The indexes run over twice the capacity so a full buffer can be told apart
+// from an empty one.
+static inline size_t GetUsedSize(const MirroredRingBuffer *ring_buffer,
+                                 size_t write_index,
+                                 size_t read_index) noexcept {
+    if (write_index >= read_index) {
+        return write_index - read_index;
+    }
+
+    return 2 * ring_buffer->capacity - read_index + write_index;
+}
+
+static inline size_t AdvanceIndex(const MirroredRingBuffer *ring_buffer,
+                                  size_t index, size_t size) noexcept {
+    index += size;
+
+    if (index >= 2 * ring_buffer->capacity) {
+        index -= 2 * ring_buffer->capacity;
+    }
+
+    return index;
+}
+
+static inline uintptr_t GetIndexAddress(const MirroredRingBuffer *ring_buffer,
+                                        size_t index) noexcept {
+    if (index >= ring_buffer->capacity) {
+        index -= ring_buffer->capacity;
+    }
+
+    return ring_buffer->address + index;
+}
+
+hs::Result CreateMirroredRingBuffer(MirroredRingBuffer *ring_buffer,
+                                    size_t capacity) noexcept {
+    __HS_ASSERT((capacity != 0 && (capacity & 0xFFF) == 0));
+
+    if (capacity > SIZE_MAX / 2) {
+        // out of resources
+        return hs::Result(0x1203);
+    }
+
+    svc::Handle shared_memory_handle;
+    auto result = hs::svc::CreateSharedMemory(
+        &shared_memory_handle, capacity, RING_BUFFER_PERMISSION,
+        hs::svc::MemoryPermission::Read);
+    if (result.Err()) {
+        return result;
+    }
+
+    // Both mappings start on a large block boundary when the capacity is a
+    // multiple of it.
+    void *address;
+    if ((capacity & (hs::os::detail::LARGE_BLOCK_SIZE - 1)) == 0) {
+        address = hs::os::detail::g_AddressSpaceAllocator->ReserveLargeBlocks(
+            2 * capacity);
+    } else {
+        address = hs::os::detail::g_AddressSpaceAllocator->Reserve(
+            2 * capacity, 0x1000);
+    }
+
+    if (address == nullptr) {
+        hs::svc::CloseHandle(shared_memory_handle);
+
+        // out of resources
+        return hs::Result(0x1203);
+    }
+
+    uintptr_t first_mapping = reinterpret_cast<uintptr_t>(address);
+    uintptr_t second_mapping = first_mapping + capacity;
+
+    result = hs::os::detail::MapSharedMemory(
+        shared_memory_handle, first_mapping, capacity, RING_BUFFER_PERMISSION);
+    if (result.Ok()) {
+        result = hs::os::detail::MapSharedMemory(shared_memory_handle,
+                                                 second_mapping, capacity,
+                                                 RING_BUFFER_PERMISSION);
+        if (result.Err()) {
+            hs::os::detail::UnmapSharedMemory(shared_memory_handle,
+                                              first_mapping, capacity);
+        }
+    }
+
+    if (result.Err()) {
+        hs::os::detail::g_AddressSpaceAllocator->Free(address);
+        hs::svc::CloseHandle(shared_memory_handle);
+        return result;
+    }
+
+    ring_buffer->shared_memory_handle = shared_memory_handle;
+    ring_buffer->address = first_mapping;
+    ring_buffer->capacity = capacity;
+    atomic_store(&ring_buffer->write_index, 0);
+    atomic_store(&ring_buffer->read_index, 0);
+
+    return result;
+}
+
+void DestroyMirroredRingBuffer(MirroredRingBuffer *ring_buffer) noexcept {
+    for (size_t i = 0; i < 2; i++) {
+        auto result = hs::os::detail::UnmapSharedMemory(
+            ring_buffer->shared_memory_handle,
+            ring_buffer->address + i * ring_buffer->capacity,
+            ring_buffer->capacity);
+        __HS_ABORT_CONDITIONAL_RESULT(result.Ok(), result);
+    }
+
+    hs::os::detail::g_AddressSpaceAllocator->Free(
+        reinterpret_cast<void *>(ring_buffer->address));
+    hs::svc::CloseHandle(ring_buffer->shared_memory_handle);
+
+    ring_buffer->address = 0;
+    ring_buffer->capacity = 0;
+    atomic_store(&ring_buffer->write_index, 0);
+    atomic_store(&ring_buffer->read_index, 0);
+}
+
+void *BeginMirroredRingBufferWrite(MirroredRingBuffer *ring_buffer,
+                                   size_t *out_size) noexcept {
+    size_t write_index = atomic_load_explicit(&ring_buffer->write_index,
+                                              memory_order_relaxed);
+    // Pairs with the release in EndMirroredRingBufferRead, the consumer is
+    // done with the bytes it gave back.
+    size_t read_index =
+        atomic_load_explicit(&ring_buffer->read_index, memory_order_acquire);
+
+    *out_size = ring_buffer->capacity -
+                GetUsedSize(ring_buffer, write_index, read_index);
+
+    return reinterpret_cast<void *>(
+        GetIndexAddress(ring_buffer, write_index));
+}
+
+void EndMirroredRingBufferWrite(MirroredRingBuffer *ring_buffer,
+                                size_t size) noexcept {
+    size_t write_index = atomic_load_explicit(&ring_buffer->write_index,
+                                              memory_order_relaxed);
+
+    atomic_store_explicit(&ring_buffer->write_index,
+                          AdvanceIndex(ring_buffer, write_index, size),
+                          memory_order_release);
+}
+
+const void *BeginMirroredRingBufferRead(MirroredRingBuffer *ring_buffer,
+                                        size_t *out_size) noexcept {
+    size_t read_index =
+        atomic_load_explicit(&ring_buffer->read_index, memory_order_relaxed);
+    // Pairs with the release in EndMirroredRingBufferWrite, the published
+    // bytes are visible.
+    size_t write_index =
+        atomic_load_explicit(&ring_buffer->write_index, memory_order_acquire);
+
+    *out_size = GetUsedSize(ring_buffer, write_index, read_index);
+
+    return reinterpret_cast<const void *>(
+        GetIndexAddress(ring_buffer, read_index));
+}
+
+void EndMirroredRingBufferRead(MirroredRingBuffer *ring_buffer,
+                               size_t size) noexcept {
+    size_t read_index =
+        atomic_load_explicit(&ring_buffer->read_index, memory_order_relaxed);
+
+    atomic_store_explicit(&ring_buffer->read_index,
+                          AdvanceIndex(ring_buffer, read_index, size),
+                          memory_order_release);
+}
+}  // namespace hs::os
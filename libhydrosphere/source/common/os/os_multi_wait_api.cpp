@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/diag.hpp>
+#include <hs/os/os_api.hpp>
+#include <hs/os/os_multi_wait_api.hpp>
+#include <os/detail/os_multi_wait.hpp>
+#include <os/detail/os_tick.hpp>
+
+enum MultiWaitState {
+    MultiWaitState_Uninitialized = 0,
+    MultiWaitState_Initialized = 1,
+};
+
+enum MultiWaitHolderState {
+    MultiWaitHolderState_Uninitialized = 0,
+    MultiWaitHolderState_Initialized = 1,
+};
+
+enum MultiWaitHolderType {
+    MultiWaitHolderType_Handle = 0,
+    MultiWaitHolderType_UserEvent = 1,
+};
+
+namespace hs::os {
+namespace detail {
+void NotifyMultiWaitHolders(MultiWaitHolder *holders) noexcept {
+    for (MultiWaitHolder *holder = holders; holder != nullptr;
+         holder = holder->next_object_holder) {
+        MultiWait *multi_wait = holder->multi_wait;
+
+        multi_wait->critical_section.Enter();
+
+        multi_wait->notification_count++;
+
+        // A thread waiting on kernel objects can only be woken by cancelling
+        // its wait. If it didn't enter the kernel yet, its next wait returns
+        // right away.
+        if (!multi_wait->waiting_thread_handle.IsInvalid()) {
+            hs::svc::CancelSynchronization(multi_wait->waiting_thread_handle);
+        } else {
+            multi_wait->condition_variable.Broadcast();
+        }
+
+        multi_wait->critical_section.Leave();
+    }
+}
+}  // namespace detail
+
+static void SetMultiWaitHolderObject(MultiWaitHolder *holder, uint8_t type,
+                                     svc::Handle handle,
+                                     UserEvent *user_event) noexcept {
+    holder->type = type;
+    holder->handle = handle;
+    holder->user_event = user_event;
+    holder->multi_wait = nullptr;
+    holder->next = nullptr;
+    holder->next_object_holder = nullptr;
+    holder->user_data = 0;
+    holder->state = MultiWaitHolderState_Initialized;
+}
+
+static MultiWaitHolder *PollUserEvents(MultiWait *multi_wait) noexcept {
+    for (MultiWaitHolder *holder = multi_wait->holders; holder != nullptr;
+         holder = holder->next) {
+        if (holder->type != MultiWaitHolderType_UserEvent) {
+            continue;
+        }
+
+        UserEvent *event = holder->user_event;
+
+        event->critical_section.Enter();
+        bool is_signaled = event->is_signaled;
+        event->critical_section.Leave();
+
+        if (is_signaled) {
+            return holder;
+        }
+    }
+
+    return nullptr;
+}
+
+// Wait until an object is signaled or the deadline (in system ticks) expires.
+// A negative deadline waits forever.
+static MultiWaitHolder *WaitAnyUntil(MultiWait *multi_wait,
+                                     int64_t deadline) noexcept {
+    svc::Handle handles[MULTI_WAIT_HANDLE_COUNT_MAX];
+    MultiWaitHolder *handle_holders[MULTI_WAIT_HANDLE_COUNT_MAX];
+    int32_t handle_count = 0;
+
+    for (MultiWaitHolder *holder = multi_wait->holders; holder != nullptr;
+         holder = holder->next) {
+        if (holder->type == MultiWaitHolderType_Handle) {
+            handles[handle_count] = holder->handle;
+            handle_holders[handle_count] = holder;
+            handle_count++;
+        }
+    }
+
+    while (true) {
+        // The user objects are checked without the critical section, a
+        // notification sent meanwhile makes us check them again.
+        multi_wait->critical_section.Enter();
+        uint32_t notification_count = multi_wait->notification_count;
+        multi_wait->critical_section.Leave();
+
+        MultiWaitHolder *holder = PollUserEvents(multi_wait);
+        if (holder != nullptr) {
+            return holder;
+        }
+
+        int64_t timeout = -1;
+        if (deadline >= 0) {
+            timeout = detail::GetRemainingTime(deadline);
+        }
+
+        multi_wait->critical_section.Enter();
+
+        if (multi_wait->notification_count != notification_count) {
+            multi_wait->critical_section.Leave();
+            continue;
+        }
+
+        if (handle_count == 0) {
+            if (timeout == 0) {
+                multi_wait->critical_section.Leave();
+                return nullptr;
+            }
+
+            if (timeout < 0) {
+                multi_wait->condition_variable.Wait(
+                    &multi_wait->critical_section);
+            } else {
+                multi_wait->condition_variable.WaitTimeout(
+                    &multi_wait->critical_section, timeout);
+            }
+
+            multi_wait->critical_section.Leave();
+            continue;
+        }
+
+        multi_wait->waiting_thread_handle = GetCurrentThreadHandle();
+        multi_wait->critical_section.Leave();
+
+        int32_t index;
+        auto result = hs::svc::WaitSynchronization(&index, handles,
+                                                   handle_count, timeout);
+
+        multi_wait->critical_section.Enter();
+        multi_wait->waiting_thread_handle = svc::Handle();
+        bool is_notified = multi_wait->notification_count != notification_count;
+        multi_wait->critical_section.Leave();
+
+        // A notification sent after the wait returned left its cancellation
+        // pending on the thread, consume it here and not in the next wait of
+        // the thread. The kernel only checks for it once the wait would
+        // block: a zero timeout or a signaled object returns first, wait on
+        // no object for a nanosecond instead.
+        if (is_notified) {
+            int32_t pending_index;
+            hs::svc::WaitSynchronization(&pending_index, nullptr, 0, 1);
+        }
+
+        if (result.Ok()) {
+            return handle_holders[index];
+        }
+
+        // timed out, give the user objects a last chance
+        if ((result.GetValue() & 0x3FFFFF) == 0xEA01) {
+            return PollUserEvents(multi_wait);
+        }
+
+        // cancelled by a notification of a user object
+        if ((result.GetValue() & 0x3FFFFF) != 0xEC01) {
+            __HS_ABORT_CONDITIONAL_RESULT(result.Ok(), result);
+        }
+    }
+}
+
+void InitializeMultiWait(MultiWait *multi_wait) noexcept {
+    multi_wait->notification_count = 0;
+    multi_wait->waiting_thread_handle = svc::Handle();
+    multi_wait->holders = nullptr;
+    multi_wait->critical_section = CriticalSection();
+    multi_wait->condition_variable = ConditionVariableImpl();
+    multi_wait->state = MultiWaitState_Initialized;
+}
+
+void FinalizeMultiWait(MultiWait *multi_wait) noexcept {
+    __HS_ASSERT(multi_wait->holders == nullptr);
+
+    multi_wait->state = MultiWaitState_Uninitialized;
+}
+
+void InitializeMultiWaitHolder(MultiWaitHolder *holder,
+                               svc::Handle handle) noexcept {
+    SetMultiWaitHolderObject(holder, MultiWaitHolderType_Handle, handle,
+                             nullptr);
+}
+
+void InitializeMultiWaitHolder(MultiWaitHolder *holder,
+                               KernelEvent *event) noexcept {
+    SetMultiWaitHolderObject(holder, MultiWaitHolderType_Handle,
+                             *event->readable_handle, nullptr);
+}
+
+void InitializeMultiWaitHolder(MultiWaitHolder *holder,
+                               Thread *thread) noexcept {
+    SetMultiWaitHolderObject(holder, MultiWaitHolderType_Handle,
+                             thread->thread_handle, nullptr);
+}
+
+void InitializeMultiWaitHolder(MultiWaitHolder *holder,
+                               UserEvent *event) noexcept {
+    SetMultiWaitHolderObject(holder, MultiWaitHolderType_UserEvent,
+                             svc::Handle(), event);
+}
+
+void FinalizeMultiWaitHolder(MultiWaitHolder *holder) noexcept {
+    __HS_ASSERT(holder->multi_wait == nullptr);
+
+    holder->state = MultiWaitHolderState_Uninitialized;
+}
+
+void SetMultiWaitHolderUserData(MultiWaitHolder *holder,
+                                uintptr_t user_data) noexcept {
+    holder->user_data = user_data;
+}
+
+uintptr_t GetMultiWaitHolderUserData(MultiWaitHolder *holder) noexcept {
+    return holder->user_data;
+}
+
+void LinkMultiWaitHolder(MultiWait *multi_wait,
+                         MultiWaitHolder *holder) noexcept {
+    __HS_ASSERT(holder->multi_wait == nullptr);
+
+    if (holder->type == MultiWaitHolderType_Handle) {
+        int32_t handle_count = 0;
+
+        for (MultiWaitHolder *linked_holder = multi_wait->holders;
+             linked_holder != nullptr; linked_holder = linked_holder->next) {
+            if (linked_holder->type == MultiWaitHolderType_Handle) {
+                handle_count++;
+            }
+        }
+
+        __HS_ASSERT(handle_count < MULTI_WAIT_HANDLE_COUNT_MAX);
+    }
+
+    holder->multi_wait = multi_wait;
+    holder->next = multi_wait->holders;
+    multi_wait->holders = holder;
+
+    if (holder->type == MultiWaitHolderType_UserEvent) {
+        UserEvent *event = holder->user_event;
+
+        event->critical_section.Enter();
+        holder->next_object_holder = event->multi_wait_holders;
+        event->multi_wait_holders = holder;
+        event->critical_section.Leave();
+    }
+}
+
+void UnlinkMultiWaitHolder(MultiWaitHolder *holder) noexcept {
+    MultiWait *multi_wait = holder->multi_wait;
+
+    __HS_ASSERT(multi_wait != nullptr);
+
+    if (holder->type == MultiWaitHolderType_UserEvent) {
+        UserEvent *event = holder->user_event;
+
+        event->critical_section.Enter();
+
+        MultiWaitHolder **link = &event->multi_wait_holders;
+        while (*link != holder) {
+            link = &(*link)->next_object_holder;
+        }
+        *link = holder->next_object_holder;
+
+        event->critical_section.Leave();
+    }
+
+    MultiWaitHolder **link = &multi_wait->holders;
+    while (*link != holder) {
+        link = &(*link)->next;
+    }
+    *link = holder->next;
+
+    holder->multi_wait = nullptr;
+    holder->next = nullptr;
+    holder->next_object_holder = nullptr;
+}
+
+void UnlinkAllMultiWaitHolders(MultiWait *multi_wait) noexcept {
+    while (multi_wait->holders != nullptr) {
+        UnlinkMultiWaitHolder(multi_wait->holders);
+    }
+}
+
+MultiWaitHolder *WaitAny(MultiWait *multi_wait) noexcept {
+    return WaitAnyUntil(multi_wait, -1);
+}
+
+MultiWaitHolder *TryWaitAny(MultiWait *multi_wait) noexcept {
+    return WaitAnyUntil(multi_wait, 0);
+}
+
+MultiWaitHolder *TimedWaitAny(MultiWait *multi_wait,
+                              int64_t timeout) noexcept {
+    if (timeout <= 0) {
+        return TryWaitAny(multi_wait);
+    }
+
+    return WaitAnyUntil(multi_wait, detail::GetDeadline(timeout));
+}
+}  // namespace hs::os
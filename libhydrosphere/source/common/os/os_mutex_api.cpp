@@ -18,7 +18,11 @@ enum MutexState {
 
 namespace hs::os {
 void InitializeMutex(Mutex *mutex, bool is_recursive) noexcept {
+    uint32_t spin_limit = GetCriticalSectionSpinCount();
+
     mutex->critical_section = CriticalSection();
+    mutex->spin_state.spin_limit = spin_limit < 0xFF ? spin_limit : 0xFF;
+    mutex->spin_state.spin_count = 0;
     mutex->is_recursive = is_recursive;
     mutex->counter = 0;
     mutex->owner = hs::svc::Handle();
@@ -32,7 +36,7 @@ void LockMutex(Mutex *mutex) noexcept {
     // We don't own the mutex? enter the critical section and set the owner
     // after that.
     if (mutex->owner != current_thread_handle) {
-        mutex->critical_section.Enter();
+        mutex->critical_section.Enter(&mutex->spin_state);
         mutex->owner = current_thread_handle;
     }
 
@@ -82,6 +86,10 @@ void UnlockMutex(Mutex *mutex) noexcept {
     mutex->critical_section.Leave();
 }
 
+void SetMutexSpinLimit(Mutex *mutex, uint8_t spin_limit) noexcept {
+    mutex->spin_state.spin_limit = spin_limit;
+}
+
 void FinalizeMutex(Mutex *mutex) noexcept {
     mutex->state = MutexState_Uninitialized;
 }
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/diag.hpp>
+#include <hs/os/os_reader_writer_lock_api.hpp>
+
+enum ReaderWriterLockState {
+    ReaderWriterLockState_Uninitialized = 0,
+    ReaderWriterLockState_Initialized = 1,
+};
+
+namespace hs::os {
+// The lock state holds the count of readers holding the lock and three flags.
+// Waiters set their flag while holding the critical section, the releases
+// only take the critical section when a flag tells them someone waits.
+static const uint32_t READER_COUNT_MASK = 0x1FFFFFFF;
+static const uint32_t READER_WAITING_BIT = __HS_BIT(29);
+static const uint32_t WRITER_HOLDING_BIT = __HS_BIT(30);
+static const uint32_t WRITER_WAITING_BIT = __HS_BIT(31);
+
+// New readers wait for the writers holding or waiting for the lock.
+static inline bool IsBlockingReaders(uint32_t lock_state) noexcept {
+    return (lock_state & (WRITER_HOLDING_BIT | WRITER_WAITING_BIT)) != 0;
+}
+
+static inline bool IsBlockingWriters(uint32_t lock_state) noexcept {
+    return (lock_state & (READER_COUNT_MASK | WRITER_HOLDING_BIT)) != 0;
+}
+
+void InitializeReaderWriterLock(ReaderWriterLock *lock) noexcept {
+    atomic_store(&lock->lock_state, 0);
+    lock->waiting_reader_count = 0;
+    lock->waiting_writer_count = 0;
+    lock->critical_section = CriticalSection();
+    lock->reader_condition_variable = ConditionVariableImpl();
+    lock->writer_condition_variable = ConditionVariableImpl();
+    lock->state = ReaderWriterLockState_Initialized;
+}
+
+bool TryAcquireReaderLock(ReaderWriterLock *lock) noexcept {
+    uint32_t lock_state =
+        atomic_load_explicit(&lock->lock_state, memory_order_relaxed);
+
+    while (!IsBlockingReaders(lock_state)) {
+        if (atomic_compare_exchange_weak_explicit(
+                &lock->lock_state, &lock_state, lock_state + 1,
+                memory_order_acquire, memory_order_relaxed)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void AcquireReaderLock(ReaderWriterLock *lock) noexcept {
+    if (TryAcquireReaderLock(lock)) {
+        return;
+    }
+
+    lock->critical_section.Enter();
+
+    while (!TryAcquireReaderLock(lock)) {
+        lock->waiting_reader_count++;
+
+        // A writer releasing the lock without the critical section would miss
+        // us, only wait if the flag was set while a writer is still there.
+        uint32_t lock_state =
+            atomic_fetch_or(&lock->lock_state, READER_WAITING_BIT);
+
+        if (IsBlockingReaders(lock_state)) {
+            lock->reader_condition_variable.Wait(&lock->critical_section);
+        }
+
+        lock->waiting_reader_count--;
+    }
+
+    lock->critical_section.Leave();
+}
+
+void ReleaseReaderLock(ReaderWriterLock *lock) noexcept {
+    uint32_t lock_state =
+        atomic_fetch_sub_explicit(&lock->lock_state, 1, memory_order_release);
+
+    __HS_ASSERT((lock_state & READER_COUNT_MASK) != 0);
+
+    // The last reader hands the lock to a waiting writer.
+    if ((lock_state & READER_COUNT_MASK) == 1 &&
+        (lock_state & WRITER_WAITING_BIT) != 0) {
+        lock->critical_section.Enter();
+        lock->writer_condition_variable.Signal();
+        lock->critical_section.Leave();
+    }
+}
+
+bool TryAcquireWriterLock(ReaderWriterLock *lock) noexcept {
+    uint32_t lock_state =
+        atomic_load_explicit(&lock->lock_state, memory_order_relaxed);
+
+    while (!IsBlockingWriters(lock_state)) {
+        if (atomic_compare_exchange_weak_explicit(
+                &lock->lock_state, &lock_state,
+                lock_state | WRITER_HOLDING_BIT, memory_order_acquire,
+                memory_order_relaxed)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void AcquireWriterLock(ReaderWriterLock *lock) noexcept {
+    uint32_t lock_state = 0;
+
+    if (atomic_compare_exchange_strong_explicit(
+            &lock->lock_state, &lock_state, WRITER_HOLDING_BIT,
+            memory_order_acquire, memory_order_relaxed)) {
+        return;
+    }
+
+    lock->critical_section.Enter();
+
+    lock->waiting_writer_count++;
+    lock_state = atomic_fetch_or(&lock->lock_state, WRITER_WAITING_BIT) |
+                 WRITER_WAITING_BIT;
+
+    while (true) {
+        if (!IsBlockingWriters(lock_state)) {
+            // Keep the waiting flag for the other writers and the flag of the
+            // waiting readers.
+            uint32_t new_lock_state =
+                (lock_state & READER_WAITING_BIT) | WRITER_HOLDING_BIT;
+            if (lock->waiting_writer_count > 1) {
+                new_lock_state |= WRITER_WAITING_BIT;
+            }
+
+            if (atomic_compare_exchange_weak_explicit(
+                    &lock->lock_state, &lock_state, new_lock_state,
+                    memory_order_acquire, memory_order_relaxed)) {
+                break;
+            }
+
+            continue;
+        }
+
+        lock->writer_condition_variable.Wait(&lock->critical_section);
+        lock_state = atomic_load(&lock->lock_state);
+    }
+
+    lock->waiting_writer_count--;
+
+    lock->critical_section.Leave();
+}
+
+void ReleaseWriterLock(ReaderWriterLock *lock) noexcept {
+    uint32_t lock_state = WRITER_HOLDING_BIT;
+
+    // Nobody waits, no need to wake anyone.
+    if (atomic_compare_exchange_strong_explicit(
+            &lock->lock_state, &lock_state, 0, memory_order_release,
+            memory_order_relaxed)) {
+        return;
+    }
+
+    __HS_ASSERT((lock_state & WRITER_HOLDING_BIT) != 0);
+
+    lock->critical_section.Enter();
+
+    atomic_fetch_and(&lock->lock_state,
+                     ~(WRITER_HOLDING_BIT | READER_WAITING_BIT));
+
+    // Writers go first, the readers keep waiting for them.
+    if (lock->waiting_writer_count != 0) {
+        if (lock->waiting_reader_count != 0) {
+            atomic_fetch_or(&lock->lock_state, READER_WAITING_BIT);
+        }
+
+        lock->writer_condition_variable.Signal();
+    } else if (lock->waiting_reader_count != 0) {
+        lock->reader_condition_variable.Broadcast();
+    }
+
+    lock->critical_section.Leave();
+}
+
+void FinalizeReaderWriterLock(ReaderWriterLock *lock) noexcept {
+    __HS_ASSERT((atomic_load(&lock->lock_state) &
+                 (READER_COUNT_MASK | WRITER_HOLDING_BIT)) == 0);
+
+    lock->state = ReaderWriterLockState_Uninitialized;
+}
+}  // namespace hs::os
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/diag.hpp>
+#include <hs/os/os_semaphore_api.hpp>
+#include <hs/svc.hpp>
+#include <os/detail/os_tick.hpp>
+
+enum SemaphoreState {
+    SemaphoreState_Uninitialized = 0,
+    SemaphoreState_Initialized = 1,
+};
+
+namespace hs::os {
+// Waiters set the flag while holding the critical section, releases only take
+// the critical section when it is set.
+static const uint32_t SEMAPHORE_COUNT_MASK = 0x7FFFFFFF;
+static const uint32_t SEMAPHORE_WAITING_BIT = __HS_BIT(31);
+
+void InitializeSemaphore(Semaphore *semaphore, uint32_t initial_count,
+                         uint32_t max_count) noexcept {
+    __HS_ASSERT((initial_count <= max_count &&
+                 max_count <= SEMAPHORE_COUNT_MASK));
+
+    atomic_store(&semaphore->count, initial_count);
+    semaphore->max_count = max_count;
+    semaphore->waiting_count = 0;
+    semaphore->critical_section = CriticalSection();
+    semaphore->condition_variable = ConditionVariableImpl();
+    semaphore->state = SemaphoreState_Initialized;
+}
+
+bool TryAcquireSemaphore(Semaphore *semaphore) noexcept {
+    uint32_t count =
+        atomic_load_explicit(&semaphore->count, memory_order_relaxed);
+
+    while ((count & SEMAPHORE_COUNT_MASK) != 0) {
+        if (atomic_compare_exchange_weak_explicit(
+                &semaphore->count, &count, count - 1, memory_order_acquire,
+                memory_order_relaxed)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Wait for a unit under the critical section until the deadline (in system
+// ticks) expires. A negative deadline waits forever.
+static bool AcquireSemaphoreSlow(Semaphore *semaphore,
+                                 int64_t deadline) noexcept {
+    bool is_acquired = true;
+
+    semaphore->critical_section.Enter();
+    semaphore->waiting_count++;
+
+    while (!TryAcquireSemaphore(semaphore)) {
+        // A release racing with us either sees the flag or left a unit we
+        // see here.
+        uint32_t count =
+            atomic_fetch_or(&semaphore->count, SEMAPHORE_WAITING_BIT);
+
+        if ((count & SEMAPHORE_COUNT_MASK) != 0) {
+            continue;
+        }
+
+        if (deadline < 0) {
+            semaphore->condition_variable.Wait(&semaphore->critical_section);
+            continue;
+        }
+
+        int64_t remaining_time = detail::GetRemainingTime(deadline);
+
+        if (remaining_time == 0 ||
+            !semaphore->condition_variable.WaitTimeout(
+                &semaphore->critical_section, remaining_time)) {
+            is_acquired = TryAcquireSemaphore(semaphore);
+            break;
+        }
+    }
+
+    semaphore->waiting_count--;
+
+    if (semaphore->waiting_count == 0) {
+        atomic_fetch_and(&semaphore->count, SEMAPHORE_COUNT_MASK);
+    }
+
+    semaphore->critical_section.Leave();
+
+    return is_acquired;
+}
+
+void AcquireSemaphore(Semaphore *semaphore) noexcept {
+    if (TryAcquireSemaphore(semaphore)) {
+        return;
+    }
+
+    AcquireSemaphoreSlow(semaphore, -1);
+}
+
+bool TimedAcquireSemaphore(Semaphore *semaphore, int64_t timeout) noexcept {
+    if (TryAcquireSemaphore(semaphore)) {
+        return true;
+    }
+
+    if (timeout <= 0) {
+        return false;
+    }
+
+    return AcquireSemaphoreSlow(semaphore, detail::GetDeadline(timeout));
+}
+
+void ReleaseSemaphore(Semaphore *semaphore, uint32_t count) noexcept {
+    uint32_t previous_count = atomic_fetch_add_explicit(
+        &semaphore->count, count, memory_order_release);
+
+    __HS_ASSERT(((previous_count & SEMAPHORE_COUNT_MASK) + count <=
+                 semaphore->max_count));
+
+    if ((previous_count & SEMAPHORE_WAITING_BIT) == 0) {
+        return;
+    }
+
+    semaphore->critical_section.Enter();
+
+    if (count >= semaphore->waiting_count) {
+        semaphore->condition_variable.Broadcast();
+    } else {
+        for (uint32_t i = 0; i < count; i++) {
+            semaphore->condition_variable.Signal();
+        }
+    }
+
+    semaphore->critical_section.Leave();
+}
+
+uint32_t GetSemaphoreCount(Semaphore *semaphore) noexcept {
+    return atomic_load(&semaphore->count) & SEMAPHORE_COUNT_MASK;
+}
+
+void FinalizeSemaphore(Semaphore *semaphore) noexcept {
+    __HS_ASSERT(semaphore->waiting_count == 0);
+
+    semaphore->state = SemaphoreState_Uninitialized;
+}
+}  // namespace hs::os
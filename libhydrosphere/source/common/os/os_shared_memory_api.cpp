@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/diag.hpp>
+#include <hs/os/os_shared_memory_api.hpp>
+#include <hs/svc.hpp>
+#include <os/detail/os_memory_map.hpp>
+#include <os/detail/os_virtualmemory_allocator.hpp>
+
+enum SharedMemoryState {
+    SharedMemoryState_Uninitialized = 0,
+    SharedMemoryState_Initialized = 1,
+    SharedMemoryState_Mapped = 2,
+};
+
+namespace hs::os {
+hs::Result CreateSharedMemory(SharedMemory *shared_memory, size_t size,
+                              svc::MemoryPermission my_permission,
+                              svc::MemoryPermission other_permission) noexcept {
+    __HS_ASSERT((size != 0 && (size & 0xFFF) == 0));
+
+    svc::Handle handle;
+    auto result = hs::svc::CreateSharedMemory(&handle, size, my_permission,
+                                              other_permission);
+    if (result.Ok()) {
+        LoadSharedMemory(shared_memory, handle, size, my_permission, true);
+    }
+
+    return result;
+}
+
+void LoadSharedMemory(SharedMemory *shared_memory, svc::Handle handle,
+                      size_t size, svc::MemoryPermission permission,
+                      bool is_handle_managed) noexcept {
+    __HS_ASSERT((size != 0 && (size & 0xFFF) == 0));
+
+    shared_memory->state = SharedMemoryState_Initialized;
+    shared_memory->is_handle_managed = is_handle_managed;
+    shared_memory->handle = handle;
+    shared_memory->permission = permission;
+    shared_memory->size = size;
+    shared_memory->address = 0;
+}
+
+hs::Result MapSharedMemory(SharedMemory *shared_memory,
+                           void **out_address) noexcept {
+    __HS_ASSERT(shared_memory->state == SharedMemoryState_Initialized);
+
+    void *address = hs::os::detail::g_AddressSpaceAllocator->Reserve(
+        shared_memory->size, 0x1000);
+
+    if (address == nullptr) {
+        // out of resources
+        return hs::Result(0x1203);
+    }
+
+    auto result = hs::os::detail::MapSharedMemory(
+        shared_memory->handle, reinterpret_cast<uintptr_t>(address),
+        shared_memory->size, shared_memory->permission);
+
+    if (result.Err()) {
+        hs::os::detail::g_AddressSpaceAllocator->Free(address);
+        return result;
+    }
+
+    shared_memory->state = SharedMemoryState_Mapped;
+    shared_memory->address = reinterpret_cast<uintptr_t>(address);
+    *out_address = address;
+
+    return result;
+}
+
+void UnmapSharedMemory(SharedMemory *shared_memory) noexcept {
+    __HS_ASSERT(shared_memory->state == SharedMemoryState_Mapped);
+
+    auto result = hs::os::detail::UnmapSharedMemory(
+        shared_memory->handle, shared_memory->address, shared_memory->size);
+    __HS_ABORT_CONDITIONAL_RESULT(result.Ok(), result);
+
+    hs::os::detail::g_AddressSpaceAllocator->Free(
+        reinterpret_cast<void *>(shared_memory->address));
+
+    shared_memory->state = SharedMemoryState_Initialized;
+    shared_memory->address = 0;
+}
+
+void *GetSharedMemoryAddress(const SharedMemory *shared_memory) noexcept {
+    return reinterpret_cast<void *>(shared_memory->address);
+}
+
+svc::Handle GetSharedMemoryHandle(const SharedMemory *shared_memory) noexcept {
+    return shared_memory->handle;
+}
+
+void DestroySharedMemory(SharedMemory *shared_memory) noexcept {
+    if (shared_memory->state == SharedMemoryState_Mapped) {
+        UnmapSharedMemory(shared_memory);
+    }
+
+    if (shared_memory->is_handle_managed) {
+        hs::svc::CloseHandle(shared_memory->handle);
+    }
+
+    shared_memory->is_handle_managed = false;
+    shared_memory->size = 0;
+    shared_memory->state = SharedMemoryState_Uninitialized;
+}
+}  // namespace hs::os
@@ -9,11 +9,19 @@
  */
 
 #include <hs/hs_macro.hpp>
+#include <hs/mem/mem_accounting_api.hpp>
+#include <hs/mem/mem_heap_api.hpp>
 #include <hs/os/os_thread_api.hpp>
 #include <hs/os/os_tls.hpp>
 #include <hs/svc.hpp>
+#include <mem/detail/mem_arena.hpp>
+#include <mem/detail/mem_heap.hpp>
+#include <mem/detail/mem_trace.hpp>
+#include <os/detail/os_memory_map.hpp>
+#include <os/detail/os_stack_alias_cache.hpp>
 #include <os/detail/os_threadlist.hpp>
 #include <os/detail/os_virtualmemory_allocator.hpp>
+#include <util/detail/util_epoch_record.hpp>
 #include <util/util_string_api.hpp>
 
 #include <hs/diag.hpp>
@@ -23,12 +31,24 @@ namespace hs::os {
 
 typedef void (*ThreadEntrypoint)(Thread *);
 
+// Byte used to paint the stacks of the tracked threads.
+static const uint8_t STACK_PAINT_BYTE = 0xA5;
+static const uintptr_t STACK_PAINT_WORD =
+    static_cast<uintptr_t>(0xA5A5A5A5A5A5A5A5ULL);
+
+__HS_ATTRIBUTE_VISIBILITY_HIDDEN volatile _Atomic(bool)
+    g_IsThreadStackUsageTrackingEnabled = false;
+
 static void _thread_entry_wrapper(Thread *context) noexcept {
     auto tls_storage = os::ThreadLocalStorage::GetThreadLocalStorage();
     tls_storage->SetThreadContext(context);
 
     // Make sure the thread context is correctly sync before continuating.
+#ifdef HYDROSPHERE_TARGET_HOST
+    atomic_thread_fence(memory_order_seq_cst);
+#else
     __HS_ASM("dsb sy");
+#endif
 
     auto &critical_section = context->critical_section;
     auto &condition_variable = context->condition_variable;
@@ -52,6 +72,16 @@ static void _thread_entry_wrapper(Thread *context) noexcept {
 
     // TODO(Kaenbyō): TLS destruction
 
+    // Hand the objects retired by this thread to their epoch domains, they
+    // may be reclaimed with the heap.
+    hs::util::detail::FinalizeThreadEpochRecords(context);
+
+    // Give back the memory of this thread arena and heap cache, the trace is
+    // flushed while the heap cache can still serve the sink.
+    hs::mem::detail::FinalizeThreadArena(context);
+    hs::mem::detail::FinalizeThreadAllocationTrace(context);
+    hs::mem::detail::FinalizeThreadHeapCache(context);
+
     critical_section->Enter();
 
     context->state = ThreadState::Exited;
@@ -95,26 +125,105 @@ __HS_ATTRIBUTE_VISIBILITY_HIDDEN hs::Result CreateThreadUnsafe(
 
 __HS_ATTRIBUTE_VISIBILITY_HIDDEN static hs::Result CreateAliasStackUnsafe(
     Thread *thread) noexcept {
-    void *stack_mirror_address = hs::os::detail::g_StackAllocator->Reserve(
-        thread->thread_stack_size, 0x1000);
+    size_t retry_count = 0;
 
-    if (stack_mirror_address == nullptr) {
-        // out of resources
-        return hs::Result(0x1203);
-    }
+    // Reuse the mirror of a previous thread with the same stack if possible.
+    void *cached_stack_mirror_address =
+        hs::os::detail::g_StackAliasCache->Acquire(
+            thread->original_thread_stack, thread->thread_stack_size);
 
-    auto result = hs::svc::MapMemory(
-        reinterpret_cast<uintptr_t>(stack_mirror_address),
-        reinterpret_cast<uintptr_t>(thread->original_thread_stack),
-        thread->thread_stack_size);
-    if (result.Ok()) {
-        thread->mapped_thread_stack = stack_mirror_address;
+    if (cached_stack_mirror_address != nullptr) {
+        thread->mapped_thread_stack = cached_stack_mirror_address;
         thread->is_alias_thread_stack_mapped = true;
-    } else {
+        return hs::Result(hs::Result::Success);
+    }
+
+    while (true) {
+        void *stack_mirror_address = hs::os::detail::g_StackAllocator->Reserve(
+            thread->thread_stack_size, 0x1000);
+
+        if (stack_mirror_address == nullptr) {
+            // out of resources
+            return hs::Result(0x1203);
+        }
+
+        auto result = hs::os::detail::MapMemory(
+            reinterpret_cast<uintptr_t>(stack_mirror_address),
+            reinterpret_cast<uintptr_t>(thread->original_thread_stack),
+            thread->thread_stack_size);
+        if (result.Ok()) {
+            thread->mapped_thread_stack = stack_mirror_address;
+            thread->is_alias_thread_stack_mapped = true;
+            return result;
+        }
+
         hs::os::detail::g_StackAllocator->Free(stack_mirror_address);
+
+        // The memory map was refreshed, if the reservation was mapped behind
+        // our back, forget about it and try again.
+        if (retry_count++ >= 4 ||
+            !hs::os::detail::g_StackAllocator->ExcludeMapped(
+                reinterpret_cast<uintptr_t>(stack_mirror_address),
+                thread->thread_stack_size)) {
+            return result;
+        }
     }
+}
 
-    return result;
+static void PaintStackUnsafe(Thread *thread) noexcept {
+    memset(thread->mapped_thread_stack, STACK_PAINT_BYTE,
+           thread->thread_stack_size);
+    thread->is_thread_stack_painted = true;
+}
+
+static size_t GetStackUsageUnsafe(Thread *thread) noexcept {
+    // The stack grows downward, the untouched words are at its bottom.
+    auto words = reinterpret_cast<const volatile uintptr_t *>(
+        thread->mapped_thread_stack);
+    size_t word_count = thread->thread_stack_size / sizeof(uintptr_t);
+    size_t untouched_count = 0;
+
+    while (untouched_count < word_count &&
+           words[untouched_count] == STACK_PAINT_WORD) {
+        untouched_count++;
+    }
+
+    return (word_count - untouched_count) * sizeof(uintptr_t);
+}
+
+static void DestroyAliasStackUnsafe(Thread *thread) noexcept {
+    if (!thread->is_alias_thread_stack_mapped) {
+        return;
+    }
+
+    // The stack is only accessible through its mirror, record its usage
+    // while we still can.
+    if (thread->is_thread_stack_painted) {
+        thread->thread_stack_peak_usage = GetStackUsageUnsafe(thread);
+        thread->is_thread_stack_painted = false;
+    }
+
+    hs::mem::UnaccountMemory(hs::mem::MemoryTag::ThreadStack,
+                             thread->thread_stack_size);
+
+    // Owned stacks are going to be freed, they can't be kept locked by the
+    // stack cache.
+    if (thread->is_thread_stack_owned) {
+        auto result = hs::os::detail::UnmapMemory(
+            reinterpret_cast<uintptr_t>(thread->mapped_thread_stack),
+            reinterpret_cast<uintptr_t>(thread->original_thread_stack),
+            thread->thread_stack_size);
+        __HS_ABORT_CONDITIONAL_RESULT(result.Ok(), result);
+
+        hs::os::detail::g_StackAllocator->Free(thread->mapped_thread_stack);
+    } else {
+        hs::os::detail::g_StackAliasCache->Release(
+            thread->original_thread_stack, thread->thread_stack_size,
+            thread->mapped_thread_stack);
+    }
+
+    thread->is_alias_thread_stack_mapped = false;
+    thread->mapped_thread_stack = nullptr;
 }
 
 __HS_ATTRIBUTE_VISIBILITY_HIDDEN void WaitForExitThread(
@@ -134,10 +243,10 @@ __HS_ATTRIBUTE_VISIBILITY_HIDDEN void WaitForExitThread(
     }
 }
 
-hs::Result CreateThread(Thread *thread,
-                        ThreadEntrypointFunction thread_entrypoint,
-                        void *argument, void *stack, size_t stack_size,
-                        int priority, int cpuid) noexcept {
+static hs::Result CreateThreadWithStack(
+    Thread *thread, ThreadEntrypointFunction thread_entrypoint, void *argument,
+    void *stack, size_t stack_size, int priority, int cpuid,
+    bool is_stack_owned) noexcept {
     __HS_ABORT_UNLESS_NOT_NULL(thread);
     // TODO(Kaenbyō): preconditions assert
     new (thread) Thread();
@@ -146,7 +255,12 @@ hs::Result CreateThread(Thread *thread,
     thread->thread_entrypoint = thread_entrypoint;
     thread->thread_argument = argument;
     thread->original_thread_stack = stack;
+    // The stack mirror of an owned stack must not end in the stack cache,
+    // even when the creation fails.
+    thread->is_thread_stack_owned = is_stack_owned;
     thread->is_alias_thread_stack_mapped = false;
+    thread->is_thread_stack_painted = false;
+    thread->thread_stack_peak_usage = 0;
     thread->thread_stack_size = stack_size;
     thread->priority = priority;
     thread->state = ThreadState::Initialized;
@@ -154,16 +268,22 @@ hs::Result CreateThread(Thread *thread,
     // TODO(Kaenbyō): TLS slots
 
     auto result = CreateAliasStackUnsafe(thread);
-    __HS_ABORT_CONDITIONAL_RESULT(result.Ok(), result);
+    if (result.Err()) {
+        thread->state = ThreadState::Uninitialized;
+        return result;
+    }
+
+    hs::mem::AccountMemory(hs::mem::MemoryTag::ThreadStack, stack_size);
+
+    if (atomic_load(&g_IsThreadStackUsageTrackingEnabled)) {
+        PaintStackUnsafe(thread);
+    }
 
     result = CreateThreadUnsafe(thread, _thread_entry_wrapper, cpuid);
     if (result.Err()) {
-        hs::svc::UnmapMemory(
-            reinterpret_cast<uintptr_t>(thread->mapped_thread_stack),
-            reinterpret_cast<uintptr_t>(thread->original_thread_stack),
-            thread->thread_stack_size);
-        hs::os::detail::g_StackAllocator->Free(
-            thread->mapped_thread_stack);
+        DestroyAliasStackUnsafe(thread);
+        thread->state = ThreadState::Uninitialized;
+        return result;
     }
 
     // TODO(Kaenbyō): incremental thread name (with the number of the thread)
@@ -174,6 +294,37 @@ hs::Result CreateThread(Thread *thread,
     return result;
 }
 
+hs::Result CreateThread(Thread *thread,
+                        ThreadEntrypointFunction thread_entrypoint,
+                        void *argument, void *stack, size_t stack_size,
+                        int priority, int cpuid) noexcept {
+    return CreateThreadWithStack(thread, thread_entrypoint, argument, stack,
+                                 stack_size, priority, cpuid, false);
+}
+
+hs::Result CreateThread(Thread *thread,
+                        ThreadEntrypointFunction thread_entrypoint,
+                        void *argument, size_t stack_size, int priority,
+                        int cpuid) noexcept {
+    void *stack = hs::mem::AllocateAligned(stack_size, 0x1000);
+
+    if (stack == nullptr) {
+        // out of resources
+        return hs::Result(0x1203);
+    }
+
+    auto result = CreateThreadWithStack(thread, thread_entrypoint, argument,
+                                        stack, stack_size, priority, cpuid,
+                                        true);
+    if (result.Err()) {
+        thread->is_thread_stack_owned = false;
+        thread->original_thread_stack = nullptr;
+        hs::mem::Free(stack);
+    }
+
+    return result;
+}
+
 __HS_ATTRIBUTE_VISIBILITY_HIDDEN void StartThreadUnsafe(
     Thread *thread) noexcept {
     auto result = hs::svc::StartThread(thread->thread_handle);
@@ -200,21 +351,21 @@ void DestroyThread(Thread *thread) noexcept {
 
     WaitForExitThread(thread);
 
+    // Remove the thread from the list before taking its lock, the list lock
+    // is always taken first (see DumpThreadStackUsage).
+    hs::os::detail::ThreadList::Get().RemoveThread(*thread);
+
     critical_section->Enter();
-    if (thread->is_alias_thread_stack_mapped) {
-        hs::svc::UnmapMemory(
-            reinterpret_cast<uintptr_t>(thread->mapped_thread_stack),
-            reinterpret_cast<uintptr_t>(thread->original_thread_stack),
-            thread->thread_stack_size);
-        hs::os::detail::g_StackAllocator->Free(
-            thread->mapped_thread_stack);
-        thread->is_alias_thread_stack_mapped = false;
-        thread->mapped_thread_stack = nullptr;
+    DestroyAliasStackUnsafe(thread);
+
+    if (thread->is_thread_stack_owned) {
+        hs::mem::Free(thread->original_thread_stack);
+        thread->original_thread_stack = nullptr;
+        thread->is_thread_stack_owned = false;
     }
 
     DestroyThreadUnsafe(thread);
 
-    hs::os::detail::ThreadList::Get().RemoveThread(*thread);
     thread->state = ThreadState::Uninitialized;
     thread->thread_name[0] = '\0';
     critical_section->Leave();
@@ -236,16 +387,7 @@ void WaitThread(Thread *thread) noexcept {
     auto &critical_section = thread->critical_section;
 
     critical_section->Enter();
-    if (thread->is_alias_thread_stack_mapped) {
-        hs::svc::UnmapMemory(
-            reinterpret_cast<uintptr_t>(thread->mapped_thread_stack),
-            reinterpret_cast<uintptr_t>(thread->original_thread_stack),
-            thread->thread_stack_size);
-        hs::os::detail::g_StackAllocator->Free(
-            thread->mapped_thread_stack);
-        thread->is_alias_thread_stack_mapped = false;
-        thread->mapped_thread_stack = nullptr;
-    }
+    DestroyAliasStackUnsafe(thread);
     critical_section->Leave();
 }
 
@@ -294,4 +436,46 @@ int GetCurrentThreadPriority(Thread *thread) noexcept {
     return priority;
 }
 
+void SetThreadStackCacheCapacity(size_t capacity) noexcept {
+    hs::os::detail::g_StackAliasCache->SetCapacity(capacity);
+}
+
+void TrimThreadStackCache() noexcept {
+    hs::os::detail::g_StackAliasCache->Trim();
+}
+
+void SetThreadStackUsageTracking(bool is_enabled) noexcept {
+    atomic_store(&g_IsThreadStackUsageTrackingEnabled, is_enabled);
+}
+
+size_t GetThreadStackUsage(Thread *thread) noexcept {
+    auto &critical_section = thread->critical_section;
+
+    critical_section->Enter();
+
+    size_t usage = thread->thread_stack_peak_usage;
+    if (thread->is_thread_stack_painted) {
+        usage = GetStackUsageUnsafe(thread);
+    }
+
+    critical_section->Leave();
+
+    return usage;
+}
+
+void DumpThreadStackUsage() noexcept {
+    auto &thread_list = hs::os::detail::ThreadList::Get();
+
+    __HS_DEBUG_LOG("Thread stack usage:");
+
+    for (auto &thread : thread_list.Aquire()) {
+        size_t usage = GetThreadStackUsage(&thread);
+
+        __HS_DEBUG_LOG("  %s: 0x%zx/0x%zx bytes", thread.thread_name, usage,
+                       thread.thread_stack_size);
+    }
+
+    thread_list.Release();
+}
+
 }  // namespace hs::os
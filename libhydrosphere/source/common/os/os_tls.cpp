@@ -13,6 +13,8 @@
 #include <hs/os/os_tls.hpp>
 
 namespace hs::os {
+// Host builds get the thread local storage from the svc stand-in.
+#ifndef HYDROSPHERE_TARGET_HOST
 __HS_ATTRIBUTE_NAKED ThreadLocalStorage*
 ThreadLocalStorage::GetThreadLocalStorage() noexcept {
 #ifdef HYDROSPHERE_TARGET_AARCH64
@@ -25,6 +27,7 @@ ThreadLocalStorage::GetThreadLocalStorage() noexcept {
 #error "TLS not implemented for this architecture"
 #endif
 }
+#endif
 
 svc::Handle GetCurrentThreadHandle() noexcept {
     return ThreadLocalStorage::GetThreadLocalStorage()
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/diag.hpp>
+#include <hs/os/os_transfer_memory_api.hpp>
+#include <hs/svc.hpp>
+#include <os/detail/os_memory_map.hpp>
+#include <os/detail/os_virtualmemory_allocator.hpp>
+
+enum TransferMemoryState {
+    TransferMemoryState_Uninitialized = 0,
+    TransferMemoryState_Initialized = 1,
+    TransferMemoryState_Mapped = 2,
+};
+
+namespace hs::os {
+hs::Result CreateTransferMemory(TransferMemory *transfer_memory, void *address,
+                                size_t size,
+                                svc::MemoryPermission permission) noexcept {
+    uintptr_t source_address = reinterpret_cast<uintptr_t>(address);
+    __HS_ASSERT(((source_address & 0xFFF) == 0 && size != 0 &&
+                 (size & 0xFFF) == 0));
+
+    svc::Handle handle;
+    auto result = hs::svc::CreateTransferMemory(&handle, source_address, size,
+                                                permission);
+
+    // The kernel changed the permission of the buffer.
+    hs::os::detail::g_MemoryMap->Refresh(source_address, size);
+
+    if (result.Ok()) {
+        LoadTransferMemory(transfer_memory, handle, size, permission, true);
+        transfer_memory->source_address = source_address;
+    }
+
+    return result;
+}
+
+void LoadTransferMemory(TransferMemory *transfer_memory, svc::Handle handle,
+                        size_t size, svc::MemoryPermission permission,
+                        bool is_handle_managed) noexcept {
+    __HS_ASSERT((size != 0 && (size & 0xFFF) == 0));
+
+    transfer_memory->state = TransferMemoryState_Initialized;
+    transfer_memory->is_handle_managed = is_handle_managed;
+    transfer_memory->handle = handle;
+    transfer_memory->permission = permission;
+    transfer_memory->size = size;
+    transfer_memory->source_address = 0;
+    transfer_memory->address = 0;
+}
+
+hs::Result MapTransferMemory(TransferMemory *transfer_memory,
+                             void **out_address) noexcept {
+    __HS_ASSERT(transfer_memory->state == TransferMemoryState_Initialized);
+
+    void *address = hs::os::detail::g_AddressSpaceAllocator->Reserve(
+        transfer_memory->size, 0x1000);
+
+    if (address == nullptr) {
+        // out of resources
+        return hs::Result(0x1203);
+    }
+
+    auto result = hs::os::detail::MapTransferMemory(
+        transfer_memory->handle, reinterpret_cast<uintptr_t>(address),
+        transfer_memory->size, transfer_memory->permission);
+
+    if (result.Err()) {
+        hs::os::detail::g_AddressSpaceAllocator->Free(address);
+        return result;
+    }
+
+    transfer_memory->state = TransferMemoryState_Mapped;
+    transfer_memory->address = reinterpret_cast<uintptr_t>(address);
+    *out_address = address;
+
+    return result;
+}
+
+void UnmapTransferMemory(TransferMemory *transfer_memory) noexcept {
+    __HS_ASSERT(transfer_memory->state == TransferMemoryState_Mapped);
+
+    auto result = hs::os::detail::UnmapTransferMemory(
+        transfer_memory->handle, transfer_memory->address,
+        transfer_memory->size);
+    __HS_ABORT_CONDITIONAL_RESULT(result.Ok(), result);
+
+    hs::os::detail::g_AddressSpaceAllocator->Free(
+        reinterpret_cast<void *>(transfer_memory->address));
+
+    transfer_memory->state = TransferMemoryState_Initialized;
+    transfer_memory->address = 0;
+}
+
+void *GetTransferMemoryAddress(const TransferMemory *transfer_memory) noexcept {
+    return reinterpret_cast<void *>(transfer_memory->address);
+}
+
+svc::Handle GetTransferMemoryHandle(
+    const TransferMemory *transfer_memory) noexcept {
+    return transfer_memory->handle;
+}
+
+void DestroyTransferMemory(TransferMemory *transfer_memory) noexcept {
+    if (transfer_memory->state == TransferMemoryState_Mapped) {
+        UnmapTransferMemory(transfer_memory);
+    }
+
+    if (transfer_memory->is_handle_managed) {
+        hs::svc::CloseHandle(transfer_memory->handle);
+    }
+
+    // Closing the last handle gives the buffer back to this process.
+    if (transfer_memory->source_address != 0) {
+        hs::os::detail::g_MemoryMap->Refresh(transfer_memory->source_address,
+                                             transfer_memory->size);
+    }
+
+    transfer_memory->is_handle_managed = false;
+    transfer_memory->size = 0;
+    transfer_memory->source_address = 0;
+    transfer_memory->state = TransferMemoryState_Uninitialized;
+}
+}  // namespace hs::os
@@ -9,6 +9,7 @@
  */
 
 #include <hs/os/os_user_event_api.hpp>
+#include <os/detail/os_multi_wait.hpp>
 
 enum UserEventState {
     UserEventState_Uninitialized = 0,
@@ -20,6 +21,7 @@ void InitializeUserEvent(UserEvent *event, bool is_signaled_at_init,
                          bool is_auto_clear) noexcept {
     event->critical_section = CriticalSection();
     event->condition_variable = ConditionVariableImpl();
+    event->multi_wait_holders = nullptr;
     event->is_signaled_at_init = is_signaled_at_init;
     event->is_auto_clear = is_auto_clear;
     event->state = UserEventState_Initialized;
@@ -62,6 +64,7 @@ void SignalUserEvent(UserEvent *event) noexcept {
     if (!event->is_signaled) {
         event->is_signaled = true;
         event->condition_variable.Signal();
+        detail::NotifyMultiWaitHolders(event->multi_wait_holders);
     }
 
     event->critical_section.Leave();
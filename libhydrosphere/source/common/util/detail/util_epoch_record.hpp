@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/hs_macro.hpp>
+#include <hs/os/os_thread_api.hpp>
+#include <hs/util/util_epoch_domain.hpp>
+
+namespace hs::util::detail {
+// The state of a thread in an epoch domain. The records of a thread are
+// chained from its context and are only added or removed with the thread
+// list locked, so the other threads can read them while walking the list.
+struct EpochRecord {
+    EpochRecord *next;
+    EpochDomain *domain;
+
+    // The pinned epoch shifted by one, with the low bit set while pinned.
+    volatile _Atomic(uint64_t) local_epoch;
+
+    // The fields below are only touched by the owning thread.
+    size_t nesting_count;
+    EpochRetiredObject *retired_head;
+    EpochRetiredObject *retired_tail;
+    size_t retired_count;
+};
+
+// Remove the records of a thread, its retired objects are handed to their
+// domain. The thread must not be inside any domain.
+void FinalizeThreadEpochRecords(hs::os::Thread *thread) noexcept;
+}  // namespace hs::util::detail
@@ -0,0 +1,319 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/diag.hpp>
+#include <hs/mem/mem_heap_api.hpp>
+#include <hs/os/os_tls.hpp>
+#include <hs/util/util_epoch_domain.hpp>
+#include <hs/util/util_std_new.hpp>
+#include <os/detail/os_threadlist.hpp>
+#include <util/detail/util_epoch_record.hpp>
+
+namespace hs::util {
+using detail::EpochRecord;
+
+static const uint64_t EPOCH_ACTIVE_FLAG = 1;
+
+// Try to advance the epoch every time this many objects are retired.
+static const size_t EPOCH_RECLAIM_THRESHOLD = 0x40;
+
+static inline EpochRecord *GetFirstRecord(hs::os::Thread *thread) noexcept {
+    return reinterpret_cast<EpochRecord *>(thread->epoch_records);
+}
+
+static inline EpochRecord *FindRecord(hs::os::Thread *thread,
+                                      const EpochDomain *domain) noexcept {
+    for (auto record = GetFirstRecord(thread); record != nullptr;
+         record = record->next) {
+        if (record->domain == domain) {
+            return record;
+        }
+    }
+
+    return nullptr;
+}
+
+static inline hs::os::Thread *GetCurrentThreadContext() noexcept {
+    auto thread =
+        hs::os::ThreadLocalStorage::GetThreadLocalStorage()->GetThreadContext();
+    __HS_ABORT_UNLESS_NOT_NULL(thread);
+
+    return thread;
+}
+
+static EpochRecord *GetOrCreateCurrentRecord(EpochDomain *domain) noexcept {
+    auto thread = GetCurrentThreadContext();
+    auto record = FindRecord(thread, domain);
+
+    if (record != nullptr) {
+        return record;
+    }
+
+    void *storage = hs::mem::Allocate(sizeof(EpochRecord));
+    __HS_ABORT_UNLESS_NOT_NULL(storage);
+
+    record = new (storage) EpochRecord();
+    record->domain = domain;
+    atomic_store(&record->local_epoch, 0);
+    record->nesting_count = 0;
+    record->retired_head = nullptr;
+    record->retired_tail = nullptr;
+    record->retired_count = 0;
+
+    auto &thread_list = hs::os::detail::ThreadList::Get();
+    thread_list.Aquire();
+    record->next = GetFirstRecord(thread);
+    thread->epoch_records = record;
+    thread_list.Release();
+
+    return record;
+}
+
+// An object retired at a given epoch can't be reached anymore by the threads
+// pinned after it. Once the epoch advanced twice, every thread that was
+// pinned before it left.
+static inline bool IsReclaimable(const EpochRetiredObject *object,
+                                 uint64_t epoch) noexcept {
+    return object->epoch + 2 <= epoch;
+}
+
+static void ReclaimRecord(EpochRecord *record, uint64_t epoch) noexcept {
+    // The objects of a record are sorted by epoch.
+    while (record->retired_head != nullptr &&
+           IsReclaimable(record->retired_head, epoch)) {
+        EpochRetiredObject *object = record->retired_head;
+
+        record->retired_head = object->next;
+        if (record->retired_head == nullptr) {
+            record->retired_tail = nullptr;
+        }
+        record->retired_count--;
+
+        object->reclaim(object);
+    }
+}
+
+static void ReclaimAll(EpochRetiredObject *object) noexcept {
+    while (object != nullptr) {
+        EpochRetiredObject *next = object->next;
+        object->reclaim(object);
+        object = next;
+    }
+}
+
+void EpochDomain::AdoptOrphans(EpochRetiredObject *head) noexcept {
+    if (head == nullptr) {
+        return;
+    }
+
+    EpochRetiredObject *tail = head;
+    while (tail->next != nullptr) {
+        tail = tail->next;
+    }
+
+    this->critical_section.Enter();
+    tail->next = this->orphans;
+    this->orphans = head;
+    this->critical_section.Leave();
+}
+
+void EpochDomain::ReclaimOrphans() noexcept {
+    uint64_t epoch = atomic_load(&this->global_epoch);
+
+    this->critical_section.Enter();
+    EpochRetiredObject *object = this->orphans;
+    this->orphans = nullptr;
+    this->critical_section.Leave();
+
+    EpochRetiredObject *remaining = nullptr;
+
+    while (object != nullptr) {
+        EpochRetiredObject *next = object->next;
+
+        if (IsReclaimable(object, epoch)) {
+            object->reclaim(object);
+        } else {
+            object->next = remaining;
+            remaining = object;
+        }
+
+        object = next;
+    }
+
+    this->AdoptOrphans(remaining);
+}
+
+EpochDomain::~EpochDomain() noexcept {
+    EpochRecord *removed_records = nullptr;
+
+    auto &thread_list = hs::os::detail::ThreadList::Get();
+    for (auto &thread : thread_list.Aquire()) {
+        EpochRecord *previous = nullptr;
+        EpochRecord *record = GetFirstRecord(&thread);
+
+        while (record != nullptr) {
+            EpochRecord *next = record->next;
+
+            if (record->domain == this) {
+                if (previous == nullptr) {
+                    thread.epoch_records = next;
+                } else {
+                    previous->next = next;
+                }
+
+                record->next = removed_records;
+                removed_records = record;
+            } else {
+                previous = record;
+            }
+
+            record = next;
+        }
+    }
+    thread_list.Release();
+
+    while (removed_records != nullptr) {
+        EpochRecord *next = removed_records->next;
+
+        ReclaimAll(removed_records->retired_head);
+        hs::mem::Free(removed_records);
+
+        removed_records = next;
+    }
+
+    ReclaimAll(this->orphans);
+    this->orphans = nullptr;
+}
+
+void EpochDomain::Enter() noexcept {
+    auto record = GetOrCreateCurrentRecord(this);
+
+    if (record->nesting_count++ == 0) {
+        uint64_t epoch =
+            atomic_load_explicit(&this->global_epoch, memory_order_relaxed);
+
+        // A stale epoch is fine, it only holds back the next advance. The
+        // fence orders the announcement before any read of the shared data.
+        atomic_store_explicit(&record->local_epoch,
+                              (epoch << 1) | EPOCH_ACTIVE_FLAG,
+                              memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+    }
+}
+
+void EpochDomain::Leave() noexcept {
+    auto record = FindRecord(GetCurrentThreadContext(), this);
+    __HS_ASSERT((record != nullptr && record->nesting_count != 0));
+
+    if (--record->nesting_count == 0) {
+        atomic_store_explicit(&record->local_epoch, 0, memory_order_release);
+    }
+}
+
+void EpochDomain::Retire(EpochRetiredObject *object,
+                         EpochReclaimFunction reclaim) noexcept {
+    auto record = GetOrCreateCurrentRecord(this);
+
+    object->next = nullptr;
+    object->epoch = atomic_load(&this->global_epoch);
+    object->reclaim = reclaim;
+
+    if (record->retired_tail == nullptr) {
+        record->retired_head = object;
+    } else {
+        record->retired_tail->next = object;
+    }
+    record->retired_tail = object;
+
+    if (++record->retired_count % EPOCH_RECLAIM_THRESHOLD == 0) {
+        this->TryAdvance();
+    }
+}
+
+bool EpochDomain::TryAdvance() noexcept {
+    uint64_t epoch = atomic_load(&this->global_epoch);
+    bool can_advance = true;
+
+    // Every thread inside the domain must have seen the current epoch.
+    auto &thread_list = hs::os::detail::ThreadList::Get();
+    for (auto &thread : thread_list.Aquire()) {
+        auto record = FindRecord(&thread, this);
+
+        if (record != nullptr) {
+            uint64_t local_epoch = atomic_load(&record->local_epoch);
+
+            if ((local_epoch & EPOCH_ACTIVE_FLAG) != 0 &&
+                (local_epoch >> 1) != epoch) {
+                can_advance = false;
+                break;
+            }
+        }
+    }
+    thread_list.Release();
+
+    // Another thread may have advanced it in the meantime, this is as good.
+    if (can_advance) {
+        atomic_compare_exchange_strong(&this->global_epoch, &epoch, epoch + 1);
+    }
+
+    auto record = FindRecord(GetCurrentThreadContext(), this);
+    if (record != nullptr) {
+        ReclaimRecord(record, atomic_load(&this->global_epoch));
+    }
+
+    this->ReclaimOrphans();
+
+    return can_advance;
+}
+
+void EpochDomain::Synchronize() noexcept {
+    auto record = FindRecord(GetCurrentThreadContext(), this);
+
+    if (record == nullptr) {
+        return;
+    }
+
+    __HS_ASSERT(record->nesting_count == 0);
+
+    while (true) {
+        this->TryAdvance();
+
+        if (record->retired_head == nullptr) {
+            break;
+        }
+
+        hs::os::YieldThread();
+    }
+}
+
+namespace detail {
+void FinalizeThreadEpochRecords(hs::os::Thread *thread) noexcept {
+    if (thread->epoch_records == nullptr) {
+        return;
+    }
+
+    auto &thread_list = hs::os::detail::ThreadList::Get();
+    thread_list.Aquire();
+    auto record = GetFirstRecord(thread);
+    thread->epoch_records = nullptr;
+    thread_list.Release();
+
+    while (record != nullptr) {
+        EpochRecord *next = record->next;
+        __HS_ASSERT(record->nesting_count == 0);
+
+        record->domain->AdoptOrphans(record->retired_head);
+        hs::mem::Free(record);
+
+        record = next;
+    }
+}
+}  // namespace detail
+}  // namespace hs::util
@@ -17,3 +17,4 @@ size_t Strlen(const char *s) noexcept;
 }  // namespace hs::util
 
 extern "C" void *memcpy(void *dst, const void *src, size_t len);
+extern "C" void *memset(void *s, int c, size_t n);
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include "test.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <hs/diag.hpp>
+#include <hs/os/os_thread_api.hpp>
+
+#include "../host/host.hpp"
+
+namespace hs::test {
+namespace {
+TestCase *g_FirstTestCase;
+TestCase *g_LastTestCase;
+uint32_t g_CheckFailureCount;
+
+int g_ArgumentCount;
+char **g_Arguments;
+
+const size_t WORKER_COUNT_MAX = 16;
+const size_t WORKER_STACK_SIZE = 0x10000;
+
+struct WorkerArgument {
+    void (*worker)(size_t index, void *argument);
+    size_t index;
+    void *argument;
+};
+
+void RunWorker(void *argument) {
+    auto worker_argument = reinterpret_cast<WorkerArgument *>(argument);
+
+    worker_argument->worker(worker_argument->index,
+                            worker_argument->argument);
+}
+
+bool MatchesFilter(const TestCase *test_case, const char *filter) noexcept {
+    return filter == nullptr || strstr(test_case->name, filter) != nullptr;
+}
+}  // namespace
+
+TestRegistration::TestRegistration(TestCase *test_case) noexcept {
+    // Keep the registration order, which is the order of the sources.
+    if (g_LastTestCase == nullptr) {
+        g_FirstTestCase = test_case;
+    } else {
+        g_LastTestCase->next = test_case;
+    }
+
+    g_LastTestCase = test_case;
+}
+
+void ReportCheckFailure(const char *expression, const char *file,
+                        int line) noexcept {
+    __atomic_fetch_add(&g_CheckFailureCount, 1, __ATOMIC_RELAXED);
+    fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+}
+
+uint64_t GetTimeNs() noexcept {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+void LatencyHistogram::Record(uint64_t nanoseconds) noexcept {
+    size_t bucket = 0;
+
+    while (bucket + 1 < BUCKET_COUNT && (2ULL << bucket) <= nanoseconds) {
+        bucket++;
+    }
+
+    __atomic_fetch_add(&this->buckets[bucket], 1, __ATOMIC_RELAXED);
+
+    uint64_t maximum = __atomic_load_n(&this->maximum, __ATOMIC_RELAXED);
+    while (nanoseconds > maximum &&
+           !__atomic_compare_exchange_n(&this->maximum, &maximum, nanoseconds,
+                                        true, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED)) {
+    }
+}
+
+uint64_t LatencyHistogram::GetCount() const noexcept {
+    uint64_t count = 0;
+
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        count += this->buckets[i];
+    }
+
+    return count;
+}
+
+uint64_t LatencyHistogram::GetPercentile(uint32_t percentile) const noexcept {
+    uint64_t target = (this->GetCount() * percentile + 99) / 100;
+    uint64_t count = 0;
+
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        count += this->buckets[i];
+
+        if (count >= target && count != 0) {
+            return 2ULL << i;
+        }
+    }
+
+    return 0;
+}
+
+void LatencyHistogram::Print(const char *name) const noexcept {
+    printf("  %s: %llu samples, p50 < %llu ns, p90 < %llu ns, p99 < %llu ns, "
+           "max %llu ns\n",
+           name, static_cast<unsigned long long>(this->GetCount()),
+           static_cast<unsigned long long>(this->GetPercentile(50)),
+           static_cast<unsigned long long>(this->GetPercentile(90)),
+           static_cast<unsigned long long>(this->GetPercentile(99)),
+           static_cast<unsigned long long>(this->maximum));
+
+    for (size_t i = 0; i < BUCKET_COUNT; i++) {
+        if (this->buckets[i] != 0) {
+            printf("    < %12llu ns: %llu\n",
+                   static_cast<unsigned long long>(2ULL << i),
+                   static_cast<unsigned long long>(this->buckets[i]));
+        }
+    }
+}
+
+void ReportThroughput(const char *name, uint64_t operation_count,
+                      uint64_t nanoseconds) noexcept {
+    double seconds = static_cast<double>(nanoseconds) / 1e9;
+
+    printf("  %s: %llu ops in %.3f ms, %.0f ops/s, %.1f ns/op\n", name,
+           static_cast<unsigned long long>(operation_count), seconds * 1e3,
+           static_cast<double>(operation_count) / seconds,
+           static_cast<double>(nanoseconds) /
+               static_cast<double>(operation_count));
+}
+
+void ReportValue(const char *name, uint64_t value,
+                 const char *unit) noexcept {
+    printf("  %s: %llu %s\n", name, static_cast<unsigned long long>(value),
+           unit);
+}
+
+uint64_t RunWorkers(size_t worker_count,
+                    void (*worker)(size_t index, void *argument),
+                    void *argument) noexcept {
+    hs::os::Thread threads[WORKER_COUNT_MAX];
+    WorkerArgument arguments[WORKER_COUNT_MAX];
+
+    __HS_ASSERT(worker_count <= WORKER_COUNT_MAX);
+
+    for (size_t i = 0; i < worker_count; i++) {
+        arguments[i] = {worker, i, argument};
+
+        hs::Result result =
+            hs::os::CreateThread(&threads[i], RunWorker, &arguments[i],
+                                 WORKER_STACK_SIZE, 0x2C);
+        __HS_ABORT_CONDITIONAL_RESULT(result.Ok(), result);
+    }
+
+    uint64_t start_time = GetTimeNs();
+
+    for (size_t i = 0; i < worker_count; i++) {
+        hs::os::StartThread(&threads[i]);
+    }
+
+    for (size_t i = 0; i < worker_count; i++) {
+        hs::os::WaitThread(&threads[i]);
+    }
+
+    uint64_t end_time = GetTimeNs();
+
+    for (size_t i = 0; i < worker_count; i++) {
+        hs::os::DestroyThread(&threads[i]);
+    }
+
+    return end_time - start_time;
+}
+}  // namespace hs::test
+
+extern "C" void hsMain(void) {
+    bool is_benchmark = false;
+    const char *filter = nullptr;
+
+    for (int i = 1; i < hs::test::g_ArgumentCount; i++) {
+        if (strcmp(hs::test::g_Arguments[i], "--benchmark") == 0) {
+            is_benchmark = true;
+        } else {
+            filter = hs::test::g_Arguments[i];
+        }
+    }
+
+    uint32_t run_count = 0;
+    uint32_t failure_count = 0;
+
+    for (hs::test::TestCase *test_case = hs::test::g_FirstTestCase;
+         test_case != nullptr; test_case = test_case->next) {
+        if (test_case->is_benchmark != is_benchmark ||
+            !hs::test::MatchesFilter(test_case, filter)) {
+            continue;
+        }
+
+        printf("[ RUN  ] %s\n", test_case->name);
+        fflush(stdout);
+
+        uint32_t previous_failure_count = hs::test::g_CheckFailureCount;
+        uint64_t start_time = hs::test::GetTimeNs();
+
+        test_case->function();
+
+        uint64_t duration = hs::test::GetTimeNs() - start_time;
+        bool is_failed =
+            hs::test::g_CheckFailureCount != previous_failure_count;
+
+        printf("[ %s ] %s (%llu ms)\n", is_failed ? "FAIL" : " OK ",
+               test_case->name,
+               static_cast<unsigned long long>(duration / 1000000));
+        fflush(stdout);
+
+        run_count++;
+        if (is_failed) {
+            failure_count++;
+        }
+    }
+
+    printf("%u run, %u failed\n", run_count, failure_count);
+    fflush(stdout);
+
+    hs::test::SetHostExitCode(failure_count != 0 ? 1 : 0);
+}
+
+int main(int argc, char **argv) {
+    hs::test::g_ArgumentCount = argc;
+    hs::test::g_Arguments = argv;
+
+    hs::test::RunHostProcess();
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <hs/hs_result.hpp>
+#include <hs/os/os_thread_api.hpp>
+
+// A minimal test and benchmark harness for the host build.
+//
+// Tests and benchmarks register themselves with HS_TEST and HS_BENCHMARK and
+// run from hsMain, after the library is initialized, on top of the svc
+// stand-in. `hydrosphere-test` runs the tests, `hydrosphere-test --benchmark`
+// the benchmarks. Both accept a name filter as last argument.
+namespace hs::test {
+typedef void (*TestFunction)();
+
+struct TestCase {
+    const char *name;
+    TestFunction function;
+    bool is_benchmark;
+    TestCase *next;
+};
+
+class TestRegistration {
+ public:
+    explicit TestRegistration(TestCase *test_case) noexcept;
+};
+
+void ReportCheckFailure(const char *expression, const char *file,
+                        int line) noexcept;
+
+// The monotonic time in nanoseconds.
+uint64_t GetTimeNs() noexcept;
+
+// Log2 histogram of latencies in nanoseconds. Safe to record from several
+// threads.
+class LatencyHistogram {
+ public:
+    static const size_t BUCKET_COUNT = 40;
+
+    void Record(uint64_t nanoseconds) noexcept;
+    uint64_t GetCount() const noexcept;
+
+    // The upper bound of the bucket holding the given percentile.
+    uint64_t GetPercentile(uint32_t percentile) const noexcept;
+    void Print(const char *name) const noexcept;
+
+ private:
+    uint64_t buckets[BUCKET_COUNT];
+    uint64_t maximum;
+};
+
+// Print the operations per second of a benchmark.
+void ReportThroughput(const char *name, uint64_t operation_count,
+                      uint64_t nanoseconds) noexcept;
+void ReportValue(const char *name, uint64_t value,
+                 const char *unit) noexcept;
+
+// Run the given function on worker_count threads with a heap allocated
+// stack, the worker index is passed as argument. Returns the wall time in
+// nanoseconds once every worker exited.
+uint64_t RunWorkers(size_t worker_count, void (*worker)(size_t index,
+                                                        void *argument),
+                    void *argument) noexcept;
+
+// A simple xorshift generator, the std one isn't available here.
+class Random {
+ public:
+    explicit Random(uint64_t seed) noexcept : state(seed | 1) {}
+
+    uint64_t Next() noexcept {
+        this->state ^= this->state << 13;
+        this->state ^= this->state >> 7;
+        this->state ^= this->state << 17;
+        return this->state;
+    }
+
+    // A value in [0, bound).
+    uint64_t Next(uint64_t bound) noexcept { return this->Next() % bound; }
+
+ private:
+    uint64_t state;
+};
+}  // namespace hs::test
+
+#define __HS_TEST_REGISTER(name, is_benchmark)                         \
+    static void name();                                                \
+    static hs::test::TestCase name##_test_case = {#name, name,         \
+                                                  is_benchmark, nullptr}; \
+    static hs::test::TestRegistration name##_test_registration(        \
+        &name##_test_case);                                            \
+    static void name()
+
+#define HS_TEST(name) __HS_TEST_REGISTER(name, false)
+#define HS_BENCHMARK(name) __HS_TEST_REGISTER(name, true)
+
+// Checks don't stop the test, the failure is reported and the test fails.
+#define HS_CHECK(condition)                                               \
+    do {                                                                  \
+        if (!(condition)) {                                               \
+            hs::test::ReportCheckFailure(#condition, __FILE__, __LINE__); \
+        }                                                                 \
+    } while (0)
+
+#define HS_CHECK_RESULT(result, expected_value) \
+    HS_CHECK(((result).GetValue() & 0x3FFFFF) == (expected_value))
+
+#define HS_CHECK_SUCCESS(result) HS_CHECK((result).Ok())
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Controls of the Linux stand-in of the svc layer, see svc_host.cpp.
+namespace hs::test {
+// The count of supervisor calls of the AArch64 ABI.
+const uint32_t SVC_COUNT = 0x80;
+
+// Some of the supervisor call ids, as used by the kernel.
+const uint32_t SVC_ID_SET_HEAP_SIZE = 0x01;
+const uint32_t SVC_ID_MAP_MEMORY = 0x04;
+const uint32_t SVC_ID_UNMAP_MEMORY = 0x05;
+const uint32_t SVC_ID_QUERY_MEMORY = 0x06;
+const uint32_t SVC_ID_CREATE_THREAD = 0x08;
+const uint32_t SVC_ID_WAIT_SYNCHRONIZATION = 0x18;
+const uint32_t SVC_ID_ARBITRATE_LOCK = 0x1A;
+const uint32_t SVC_ID_ARBITRATE_UNLOCK = 0x1B;
+const uint32_t SVC_ID_WAIT_PROCESS_WIDE_KEY_ATOMIC = 0x1C;
+const uint32_t SVC_ID_SIGNAL_PROCESS_WIDE_KEY = 0x1D;
+const uint32_t SVC_ID_WAIT_FOR_ADDRESS = 0x34;
+const uint32_t SVC_ID_SIGNAL_TO_ADDRESS = 0x35;
+
+// Set up the stand-in kernel and run the library startup on the calling
+// thread, which becomes the main thread. The process exits when hsMain
+// returns.
+__attribute__((noreturn)) void RunHostProcess() noexcept;
+
+// The exit code of the process once hsMain returns.
+void SetHostExitCode(int exit_code) noexcept;
+
+// The thread local region of the current thread, the one TPIDRRO_EL0 points
+// to on the console.
+void *GetHostThreadLocalRegion() noexcept;
+
+// The count of calls of a supervisor call since the last reset, all threads
+// included.
+uint64_t GetSvcCallCount(uint32_t svc_id) noexcept;
+void ResetSvcCallCounts() noexcept;
+
+// The memory the process may use, heap and shared memory included.
+void SetHostMemoryLimit(size_t size) noexcept;
+size_t GetHostMemoryLimit() noexcept;
+
+// The count of threads CreateThread can create before failing with an out of
+// resource error, threads count until their handle is closed.
+void SetHostThreadLimit(uint32_t count) noexcept;
+}  // namespace hs::test
@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/os/os_tls.hpp>
+
+#include "host.hpp"
+
+namespace hs::os {
+ThreadLocalStorage *ThreadLocalStorage::GetThreadLocalStorage() noexcept {
+    return static_cast<ThreadLocalStorage *>(
+        hs::test::GetHostThreadLocalRegion());
+}
+}  // namespace hs::os
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+// The library uses the C11 atomics from C++, as clang allows it. GCC doesn't,
+// so host builds map them onto the __atomic builtins instead.
+
+#pragma once
+
+#if defined(__clang__)
+#include_next <stdatomic.h>
+#else
+#define _Atomic(type) type
+
+#define memory_order_relaxed __ATOMIC_RELAXED
+#define memory_order_consume __ATOMIC_CONSUME
+#define memory_order_acquire __ATOMIC_ACQUIRE
+#define memory_order_release __ATOMIC_RELEASE
+#define memory_order_acq_rel __ATOMIC_ACQ_REL
+#define memory_order_seq_cst __ATOMIC_SEQ_CST
+
+#define atomic_init(object, value) (*(object) = (value))
+#define atomic_thread_fence(order) __atomic_thread_fence(order)
+
+#define atomic_load(object) __atomic_load_n(object, __ATOMIC_SEQ_CST)
+#define atomic_load_explicit(object, order) __atomic_load_n(object, order)
+#define atomic_store(object, value) \
+    __atomic_store_n(object, value, __ATOMIC_SEQ_CST)
+#define atomic_store_explicit(object, value, order) \
+    __atomic_store_n(object, value, order)
+#define atomic_exchange(object, value) \
+    __atomic_exchange_n(object, value, __ATOMIC_SEQ_CST)
+#define atomic_exchange_explicit(object, value, order) \
+    __atomic_exchange_n(object, value, order)
+
+#define atomic_compare_exchange_strong(object, expected, desired)   \
+    __atomic_compare_exchange_n(object, expected, desired, false, \
+                                __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+#define atomic_compare_exchange_weak(object, expected, desired)    \
+    __atomic_compare_exchange_n(object, expected, desired, true, \
+                                __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)
+#define atomic_compare_exchange_strong_explicit(object, expected, desired, \
+                                                success, failure)         \
+    __atomic_compare_exchange_n(object, expected, desired, false, success, \
+                                failure)
+#define atomic_compare_exchange_weak_explicit(object, expected, desired, \
+                                              success, failure)         \
+    __atomic_compare_exchange_n(object, expected, desired, true, success, \
+                                failure)
+
+#define atomic_fetch_add(object, operand) \
+    __atomic_fetch_add(object, operand, __ATOMIC_SEQ_CST)
+#define atomic_fetch_add_explicit(object, operand, order) \
+    __atomic_fetch_add(object, operand, order)
+#define atomic_fetch_sub(object, operand) \
+    __atomic_fetch_sub(object, operand, __ATOMIC_SEQ_CST)
+#define atomic_fetch_sub_explicit(object, operand, order) \
+    __atomic_fetch_sub(object, operand, order)
+#define atomic_fetch_or(object, operand) \
+    __atomic_fetch_or(object, operand, __ATOMIC_SEQ_CST)
+#define atomic_fetch_or_explicit(object, operand, order) \
+    __atomic_fetch_or(object, operand, order)
+#define atomic_fetch_and(object, operand) \
+    __atomic_fetch_and(object, operand, __ATOMIC_SEQ_CST)
+#define atomic_fetch_and_explicit(object, operand, order) \
+    __atomic_fetch_and(object, operand, order)
+#endif
@@ -0,0 +1,1876 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+// Linux stand-in of the AArch64 svc layer.
+//
+// It models the part of the kernel the library relies on, with the same
+// results as the console:
+// - One big kernel lock serializes the calls. A thread that has to wait parks
+//   on a futex(2) word of its own, its waker sets the word and wakes it.
+// - The address space is a 32GiB PROT_NONE reservation split in the usual
+//   regions. The heap is backed by a memfd so that MapMemory can alias it,
+//   shared memories get a memfd each.
+// - Threads are pthreads switching to the stack given to CreateThread.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include <map>
+#include <vector>
+
+#include <hs/svc/svc_api.hpp>
+
+#include "host.hpp"
+
+namespace hs::init {
+void Start(uint64_t thread_handle, uintptr_t argument_address,
+           void (*notify_exception_handler_ready)(),
+           void (*call_initializator)());
+}  // namespace hs::init
+
+namespace {
+using hs::svc::ArbitrationType;
+using hs::svc::Handle;
+using hs::svc::InfoType;
+using hs::svc::MemoryAttribute;
+using hs::svc::MemoryInfo;
+using hs::svc::MemoryPermission;
+using hs::svc::MemoryType;
+using hs::svc::SignalType;
+
+const uint32_t RESULT_SUCCESS = 0;
+const uint32_t RESULT_INVALID_SIZE = 0xCA01;
+const uint32_t RESULT_INVALID_ADDRESS = 0xCC01;
+const uint32_t RESULT_OUT_OF_RESOURCE = 0xCE01;
+const uint32_t RESULT_OUT_OF_MEMORY = 0xD001;
+const uint32_t RESULT_OUT_OF_HANDLES = 0xD201;
+const uint32_t RESULT_INVALID_CURRENT_MEMORY = 0xD401;
+const uint32_t RESULT_INVALID_NEW_MEMORY_PERMISSION = 0xD801;
+const uint32_t RESULT_INVALID_MEMORY_REGION = 0xDC01;
+const uint32_t RESULT_INVALID_PRIORITY = 0xE001;
+const uint32_t RESULT_INVALID_HANDLE = 0xE401;
+const uint32_t RESULT_TIMED_OUT = 0xEA01;
+const uint32_t RESULT_CANCELLED = 0xEC01;
+const uint32_t RESULT_OUT_OF_RANGE = 0xEE01;
+const uint32_t RESULT_INVALID_ENUM_VALUE = 0xF001;
+const uint32_t RESULT_INVALID_STATE = 0xFA01;
+
+const uint32_t HAS_LISTENERS = 0x40000000;
+const uint32_t PSEUDO_HANDLE_CURRENT_THREAD = 0xFFFF8000;
+const uint32_t PSEUDO_HANDLE_CURRENT_PROCESS = 0xFFFF8001;
+const uint32_t HANDLE_INDEX_BASE = 0x8000;
+const int32_t WAIT_HANDLE_COUNT_MAX = 0x40;
+
+const uintptr_t PAGE_SIZE = 0x1000;
+const uint64_t HEAP_SIZE_ALIGNMENT = 0x200000;
+
+// The layout of the address space, as offsets in the reservation.
+const uint64_t ADDRESS_SPACE_SIZE = 0x800000000;
+const uint64_t CODE_REGION_OFFSET = 0;
+const uint64_t CODE_REGION_SIZE = 0x200000;
+const uint64_t HEAP_REGION_OFFSET = 0x40000000;
+const uint64_t HEAP_REGION_SIZE = 0x200000000;
+const uint64_t ALIAS_REGION_OFFSET = 0x240000000;
+const uint64_t ALIAS_REGION_SIZE = 0x200000000;
+const uint64_t STACK_REGION_OFFSET = 0x440000000;
+const uint64_t STACK_REGION_SIZE = 0x80000000;
+
+const uint64_t DEFAULT_MEMORY_LIMIT = 0x80000000;
+
+// The system counter of the console runs at 19.2MHz.
+const uint64_t TICKS_PER_625_NANOSECONDS = 12;
+
+enum class WaitKind {
+    None,
+    Synchronization,
+    Lock,
+    ConditionVariable,
+    AddressArbiter,
+};
+
+enum class ObjectKind {
+    Thread,
+    ReadableEvent,
+    WritableEvent,
+    SharedMemory,
+    TransferMemory,
+};
+
+struct KernelThread;
+
+struct KernelEvent {
+    bool is_signaled;
+};
+
+struct KernelSharedMemory {
+    int fd;
+    size_t size;
+    MemoryPermission owner_permission;
+    uint32_t reference_count;
+};
+
+struct KernelTransferMemory {
+    uintptr_t address;
+    size_t size;
+    MemoryPermission owner_permission;
+    uint32_t reference_count;
+};
+
+struct HandleEntry {
+    ObjectKind kind;
+    void *object;
+};
+
+struct KernelThread {
+    uint32_t handle_value;
+    uintptr_t entry_point;
+    uintptr_t argument;
+    uintptr_t stack_top;
+    int32_t priority;
+    bool is_started;
+    bool is_exited;
+
+    // Counted against the thread limit until its handle is closed.
+    bool is_counted;
+
+    // Parking, the futex word is set by the thread waking us.
+    uint32_t wake;
+    uint32_t wait_result;
+    WaitKind wait_kind;
+    uint64_t wait_sequence;
+
+    // WaitSynchronization
+    void *wait_objects[WAIT_HANDLE_COUNT_MAX];
+    int32_t wait_object_count;
+    int32_t wait_index;
+    bool is_cancel_pending;
+
+    // ArbitrateLock and WaitProcessWideKeyAtomic
+    KernelThread *lock_owner;
+    uintptr_t lock_address;
+    uintptr_t condition_variable_key;
+    uint32_t tag;
+
+    // WaitForAddress
+    uintptr_t arbiter_address;
+
+    ucontext_t host_context;
+    ucontext_t library_context;
+    pthread_t pthread;
+
+    alignas(16) char thread_local_region[0x200];
+};
+
+struct MemoryBlock {
+    MemoryType type;
+    uint32_t attribute;
+    MemoryPermission permission;
+
+    // The memfd backing the block, the offset is the one of the start of the
+    // block.
+    int fd;
+    uint64_t fd_offset;
+};
+
+pthread_mutex_t g_KernelLock = PTHREAD_MUTEX_INITIALIZER;
+
+std::vector<HandleEntry> g_Handles;
+std::vector<uint32_t> g_FreeHandleIndexes;
+
+std::vector<KernelThread *> g_SynchronizationWaiters;
+std::vector<KernelThread *> g_LockWaiters;
+std::vector<KernelThread *> g_ConditionVariableWaiters;
+std::vector<KernelThread *> g_AddressArbiterWaiters;
+uint64_t g_WaitSequence;
+
+// The blocks cover the whole 64-bit address space, a block ends where the
+// next one starts.
+std::map<uint64_t, MemoryBlock> g_MemoryBlocks;
+uintptr_t g_AddressSpaceBase;
+int g_HeapFd;
+uint64_t g_HeapSize;
+uint64_t g_SharedMemorySize;
+uint64_t g_MemoryLimit = DEFAULT_MEMORY_LIMIT;
+
+// The threads created by CreateThread whose handle is still open.
+uint32_t g_ThreadCount;
+uint32_t g_ThreadLimit = UINT32_MAX;
+
+uint64_t g_SvcCallCounts[hs::test::SVC_COUNT];
+int g_ExitCode;
+
+thread_local KernelThread *t_CurrentThread;
+
+class KernelLockGuard {
+ public:
+    KernelLockGuard() noexcept { pthread_mutex_lock(&g_KernelLock); }
+    ~KernelLockGuard() noexcept { pthread_mutex_unlock(&g_KernelLock); }
+};
+
+inline void CountSvc(uint32_t svc_id) noexcept {
+    __atomic_fetch_add(&g_SvcCallCounts[svc_id], 1, __ATOMIC_RELAXED);
+}
+
+__attribute__((noreturn)) void Panic(const char *message) noexcept {
+    fprintf(stderr, "svc stand-in: %s (errno %d)\n", message, errno);
+    abort();
+}
+
+uint64_t GetMonotonicTime() noexcept {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+// Threads
+
+KernelThread *CreateKernelThread() noexcept {
+    // Thread objects are never freed, a waker may still be looking at them.
+    KernelThread *thread = new KernelThread();
+
+    memset(thread->thread_local_region, 0,
+           sizeof(thread->thread_local_region));
+    thread->wait_kind = WaitKind::None;
+
+    return thread;
+}
+
+uint32_t AddHandle(ObjectKind kind, void *object) noexcept {
+    uint32_t index;
+
+    if (!g_FreeHandleIndexes.empty()) {
+        index = g_FreeHandleIndexes.back();
+        g_FreeHandleIndexes.pop_back();
+        g_Handles[index] = {kind, object};
+    } else {
+        index = static_cast<uint32_t>(g_Handles.size());
+        if (index >= HANDLE_INDEX_BASE) {
+            return 0;
+        }
+
+        g_Handles.push_back({kind, object});
+    }
+
+    return HANDLE_INDEX_BASE | index;
+}
+
+HandleEntry *GetHandleEntry(uint32_t handle_value) noexcept {
+    if (handle_value == PSEUDO_HANDLE_CURRENT_THREAD) {
+        handle_value = t_CurrentThread->handle_value;
+    }
+
+    if ((handle_value & HANDLE_INDEX_BASE) == 0) {
+        return nullptr;
+    }
+
+    uint32_t index = handle_value & ~HANDLE_INDEX_BASE;
+    if (index >= g_Handles.size() || g_Handles[index].object == nullptr) {
+        return nullptr;
+    }
+
+    return &g_Handles[index];
+}
+
+template <typename T>
+T *GetObject(uint32_t handle_value, ObjectKind kind) noexcept {
+    HandleEntry *entry = GetHandleEntry(handle_value);
+
+    if (entry == nullptr || entry->kind != kind) {
+        return nullptr;
+    }
+
+    return static_cast<T *>(entry->object);
+}
+
+// Called with the kernel lock held. Returns false if the timeout (in
+// nanoseconds, negative for none) expired before anybody woke us.
+bool Park(KernelThread *thread, int64_t timeout) noexcept {
+    uint64_t deadline = 0;
+
+    if (timeout >= 0) {
+        deadline = GetMonotonicTime() + static_cast<uint64_t>(timeout);
+    }
+
+    pthread_mutex_unlock(&g_KernelLock);
+
+    while (__atomic_load_n(&thread->wake, __ATOMIC_ACQUIRE) == 0) {
+        struct timespec remaining_time;
+        struct timespec *futex_timeout = nullptr;
+
+        if (timeout >= 0) {
+            uint64_t now = GetMonotonicTime();
+            if (now >= deadline) {
+                break;
+            }
+
+            uint64_t remaining = deadline - now;
+            remaining_time.tv_sec = remaining / 1000000000;
+            remaining_time.tv_nsec = remaining % 1000000000;
+            futex_timeout = &remaining_time;
+        }
+
+        syscall(SYS_futex, &thread->wake, FUTEX_WAIT_PRIVATE, 0,
+                futex_timeout, nullptr, 0);
+    }
+
+    pthread_mutex_lock(&g_KernelLock);
+
+    return __atomic_load_n(&thread->wake, __ATOMIC_ACQUIRE) != 0;
+}
+
+void PrepareWait(KernelThread *thread, WaitKind kind) noexcept {
+    thread->wait_kind = kind;
+    thread->wait_sequence = g_WaitSequence++;
+    __atomic_store_n(&thread->wake, 0, __ATOMIC_RELAXED);
+}
+
+// Called with the kernel lock held, once the thread left its wait list.
+void Wake(KernelThread *thread, uint32_t result) noexcept {
+    thread->wait_result = result;
+    thread->wait_kind = WaitKind::None;
+    __atomic_store_n(&thread->wake, 1, __ATOMIC_RELEASE);
+    syscall(SYS_futex, &thread->wake, FUTEX_WAKE_PRIVATE, 1, nullptr,
+            nullptr, 0);
+}
+
+void RemoveWaiter(std::vector<KernelThread *> *waiters,
+                  KernelThread *thread) noexcept {
+    for (auto it = waiters->begin(); it != waiters->end(); ++it) {
+        if (*it == thread) {
+            waiters->erase(it);
+            return;
+        }
+    }
+}
+
+// The kernel serves the waiters by priority, then in arrival order.
+template <typename Predicate>
+KernelThread *TakeWaiter(std::vector<KernelThread *> *waiters,
+                         Predicate predicate) noexcept {
+    auto best = waiters->end();
+
+    for (auto it = waiters->begin(); it != waiters->end(); ++it) {
+        if (!predicate(*it)) {
+            continue;
+        }
+
+        if (best == waiters->end() || (*it)->priority < (*best)->priority ||
+            ((*it)->priority == (*best)->priority &&
+             (*it)->wait_sequence < (*best)->wait_sequence)) {
+            best = it;
+        }
+    }
+
+    if (best == waiters->end()) {
+        return nullptr;
+    }
+
+    KernelThread *thread = *best;
+    waiters->erase(best);
+    return thread;
+}
+
+template <typename Predicate>
+size_t CountWaiters(const std::vector<KernelThread *> &waiters,
+                    Predicate predicate) noexcept {
+    size_t count = 0;
+
+    for (KernelThread *thread : waiters) {
+        if (predicate(thread)) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+// Synchronization objects
+
+bool IsSignaled(void *object) noexcept {
+    for (const HandleEntry &entry : g_Handles) {
+        if (entry.object != object) {
+            continue;
+        }
+
+        if (entry.kind == ObjectKind::Thread) {
+            return static_cast<KernelThread *>(object)->is_exited;
+        }
+
+        if (entry.kind == ObjectKind::ReadableEvent) {
+            return static_cast<KernelEvent *>(object)->is_signaled;
+        }
+    }
+
+    return false;
+}
+
+void NotifySynchronizationWaiters(void *object) noexcept {
+    for (size_t i = 0; i < g_SynchronizationWaiters.size();) {
+        KernelThread *thread = g_SynchronizationWaiters[i];
+        int32_t index = -1;
+
+        for (int32_t j = 0; j < thread->wait_object_count; j++) {
+            if (thread->wait_objects[j] == object) {
+                index = j;
+                break;
+            }
+        }
+
+        if (index < 0) {
+            i++;
+            continue;
+        }
+
+        g_SynchronizationWaiters.erase(g_SynchronizationWaiters.begin() + i);
+        thread->wait_index = index;
+        Wake(thread, RESULT_SUCCESS);
+    }
+}
+
+// Locks
+
+uint32_t LoadUserWord(uintptr_t address) noexcept {
+    return __atomic_load_n(reinterpret_cast<uint32_t *>(address),
+                           __ATOMIC_SEQ_CST);
+}
+
+void StoreUserWord(uintptr_t address, uint32_t value) noexcept {
+    __atomic_store_n(reinterpret_cast<uint32_t *>(address), value,
+                     __ATOMIC_SEQ_CST);
+}
+
+// Hand the lock at the given address to its next waiter, or release it.
+void ReleaseLock(KernelThread *owner, uintptr_t address) noexcept {
+    auto is_waiting_for_lock = [owner, address](KernelThread *thread) {
+        return thread->lock_owner == owner && thread->lock_address == address;
+    };
+
+    KernelThread *next_owner =
+        TakeWaiter(&g_LockWaiters, is_waiting_for_lock);
+
+    if (next_owner == nullptr) {
+        StoreUserWord(address, 0);
+        return;
+    }
+
+    bool has_more_waiters = false;
+    for (KernelThread *thread : g_LockWaiters) {
+        if (is_waiting_for_lock(thread)) {
+            thread->lock_owner = next_owner;
+            has_more_waiters = true;
+        }
+    }
+
+    StoreUserWord(address,
+                  next_owner->tag | (has_more_waiters ? HAS_LISTENERS : 0));
+    next_owner->lock_owner = nullptr;
+    Wake(next_owner, RESULT_SUCCESS);
+}
+
+// Give the lock to a thread woken from a condition variable, or make it wait
+// for it.
+void AcquireLockForWaiter(KernelThread *thread) noexcept {
+    uint32_t *lock = reinterpret_cast<uint32_t *>(thread->lock_address);
+
+    while (true) {
+        uint32_t value = 0;
+
+        if (__atomic_compare_exchange_n(lock, &value, thread->tag, false,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+            Wake(thread, RESULT_SUCCESS);
+            return;
+        }
+
+        if (!__atomic_compare_exchange_n(lock, &value, value | HAS_LISTENERS,
+                                         false, __ATOMIC_SEQ_CST,
+                                         __ATOMIC_SEQ_CST)) {
+            continue;
+        }
+
+        KernelThread *owner = GetObject<KernelThread>(
+            value & ~HAS_LISTENERS, ObjectKind::Thread);
+        if (owner == nullptr) {
+            Wake(thread, RESULT_INVALID_HANDLE);
+            return;
+        }
+
+        thread->lock_owner = owner;
+        thread->wait_kind = WaitKind::Lock;
+        g_LockWaiters.push_back(thread);
+        return;
+    }
+}
+
+// Memory
+
+inline uint64_t GetBlockEnd(std::map<uint64_t, MemoryBlock>::iterator it) {
+    auto next = std::next(it);
+
+    // The last block ends at the very end of the address space.
+    return next == g_MemoryBlocks.end() ? 0 : next->first;
+}
+
+void SplitBlock(uint64_t address) noexcept {
+    if (address == 0 || g_MemoryBlocks.count(address) != 0) {
+        return;
+    }
+
+    auto it = std::prev(g_MemoryBlocks.upper_bound(address));
+    MemoryBlock block = it->second;
+
+    if (block.fd >= 0) {
+        block.fd_offset += address - it->first;
+    }
+
+    g_MemoryBlocks[address] = block;
+}
+
+bool CanMerge(uint64_t address, const MemoryBlock &a, uint64_t next_address,
+              const MemoryBlock &b) noexcept {
+    if (a.type != b.type || a.attribute != b.attribute ||
+        a.permission != b.permission || a.fd != b.fd) {
+        return false;
+    }
+
+    return a.fd < 0 || a.fd_offset + (next_address - address) == b.fd_offset;
+}
+
+void MergeBlocks(uint64_t address) noexcept {
+    auto it = g_MemoryBlocks.find(address);
+
+    if (it != g_MemoryBlocks.begin()) {
+        auto previous = std::prev(it);
+
+        if (CanMerge(previous->first, previous->second, it->first,
+                     it->second)) {
+            g_MemoryBlocks.erase(it);
+            it = previous;
+        }
+    }
+
+    auto next = std::next(it);
+    if (next != g_MemoryBlocks.end() &&
+        CanMerge(it->first, it->second, next->first, next->second)) {
+        g_MemoryBlocks.erase(next);
+    }
+}
+
+void SetBlocks(uint64_t address, uint64_t size,
+               const MemoryBlock &block) noexcept {
+    uint64_t end = address + size;
+
+    SplitBlock(address);
+    SplitBlock(end);
+
+    auto it = g_MemoryBlocks.find(address);
+    while (it != g_MemoryBlocks.end() && it->first != end) {
+        it = g_MemoryBlocks.erase(it);
+    }
+
+    g_MemoryBlocks[address] = block;
+
+    if (end != 0) {
+        MergeBlocks(end);
+    }
+    MergeBlocks(address);
+}
+
+// Check that every block in the range satisfy a predicate.
+template <typename Predicate>
+bool CheckBlocks(uint64_t address, uint64_t size,
+                 Predicate predicate) noexcept {
+    uint64_t end = address + size;
+    auto it = std::prev(g_MemoryBlocks.upper_bound(address));
+
+    while (true) {
+        uint64_t block_address = it->first;
+        uint64_t block_end = GetBlockEnd(it);
+
+        if (!predicate(block_address, it->second)) {
+            return false;
+        }
+
+        if (block_end == 0 || block_end >= end) {
+            return true;
+        }
+
+        ++it;
+    }
+}
+
+inline bool IsInRange(uint64_t address, uint64_t size, uint64_t region_offset,
+                      uint64_t region_size) noexcept {
+    uint64_t region_address = g_AddressSpaceBase + region_offset;
+
+    return size != 0 && address >= region_address &&
+           address + size <= region_address + region_size &&
+           address + size > address;
+}
+
+// Shared and transfer memories are mapped outside of the heap, alias and
+// stack regions.
+bool IsInGeneralRegion(uint64_t address, uint64_t size) noexcept {
+    return IsInRange(address, size, 0, ADDRESS_SPACE_SIZE) &&
+           !IsInRange(address, 1, HEAP_REGION_OFFSET,
+                      STACK_REGION_OFFSET + STACK_REGION_SIZE -
+                          HEAP_REGION_OFFSET) &&
+           !IsInRange(address + size - 1, 1, HEAP_REGION_OFFSET,
+                      STACK_REGION_OFFSET + STACK_REGION_SIZE -
+                          HEAP_REGION_OFFSET) &&
+           !(address < g_AddressSpaceBase + HEAP_REGION_OFFSET &&
+             address + size >
+                 g_AddressSpaceBase + STACK_REGION_OFFSET + STACK_REGION_SIZE);
+}
+
+inline bool IsPageAligned(uint64_t value) noexcept {
+    return (value & (PAGE_SIZE - 1)) == 0;
+}
+
+int ToProtection(MemoryPermission permission) noexcept {
+    int protection = PROT_NONE;
+
+    if (static_cast<int>(permission) &
+        static_cast<int>(MemoryPermission::Read)) {
+        protection |= PROT_READ;
+    }
+
+    if (static_cast<int>(permission) &
+        static_cast<int>(MemoryPermission::Write)) {
+        protection |= PROT_WRITE;
+    }
+
+    return protection;
+}
+
+void MapBacking(uint64_t address, uint64_t size, int fd, uint64_t offset,
+                MemoryPermission permission) noexcept {
+    void *mapping = mmap(reinterpret_cast<void *>(address), size,
+                         ToProtection(permission), MAP_SHARED | MAP_FIXED,
+                         fd, static_cast<off_t>(offset));
+    if (mapping == MAP_FAILED) {
+        Panic("mmap failed");
+    }
+
+    // Give the big aligned ranges a chance to get large pages, as the kernel
+    // of the console does.
+    madvise(mapping, size, MADV_HUGEPAGE);
+}
+
+void UnmapBacking(uint64_t address, uint64_t size) noexcept {
+    void *mapping =
+        mmap(reinterpret_cast<void *>(address), size, PROT_NONE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0);
+    if (mapping == MAP_FAILED) {
+        Panic("mmap failed");
+    }
+}
+
+void ProtectBacking(uint64_t address, uint64_t size,
+                    MemoryPermission permission) noexcept {
+    if (mprotect(reinterpret_cast<void *>(address), size,
+                 ToProtection(permission)) != 0) {
+        Panic("mprotect failed");
+    }
+}
+
+const MemoryBlock FREE_BLOCK = {MemoryType::Free, 0, MemoryPermission::None,
+                                -1, 0};
+
+bool IsFree(uint64_t, const MemoryBlock &block) noexcept {
+    return block.type == MemoryType::Free;
+}
+
+bool IsUnlockedHeap(uint64_t, const MemoryBlock &block) noexcept {
+    return block.type == MemoryType::Normal && block.attribute == 0 &&
+           block.permission ==
+               (MemoryPermission::Read | MemoryPermission::Write);
+}
+
+// The owner of the buffer may keep accessing it while it is mapped.
+MemoryType GetTransferMemoryType(
+    const KernelTransferMemory *transfer_memory) noexcept {
+    return transfer_memory->owner_permission == MemoryPermission::None
+               ? MemoryType::Transfered
+               : MemoryType::SharedTransfered;
+}
+
+void ReleaseSharedMemory(KernelSharedMemory *shared_memory) noexcept {
+    if (--shared_memory->reference_count != 0) {
+        return;
+    }
+
+    close(shared_memory->fd);
+    g_SharedMemorySize -= shared_memory->size;
+    delete shared_memory;
+}
+
+// The source of the transfer memory goes back to its owner once the last
+// handle is closed and the last mapping is gone.
+void ReleaseTransferMemory(KernelTransferMemory *transfer_memory) noexcept {
+    if (--transfer_memory->reference_count != 0) {
+        return;
+    }
+
+    MemoryBlock block = {
+        MemoryType::Normal, 0,
+        MemoryPermission::Read | MemoryPermission::Write, g_HeapFd,
+        transfer_memory->address - g_AddressSpaceBase - HEAP_REGION_OFFSET};
+
+    ProtectBacking(transfer_memory->address, transfer_memory->size,
+                   block.permission);
+    SetBlocks(transfer_memory->address, transfer_memory->size, block);
+    delete transfer_memory;
+}
+
+uint32_t UnmapMemoryRange(uint64_t address, uint64_t size, MemoryType type,
+                          int fd) noexcept {
+    if (!IsPageAligned(address) || !IsPageAligned(size) || size == 0) {
+        return RESULT_INVALID_ADDRESS;
+    }
+
+    if (!CheckBlocks(address, size, [type, fd](uint64_t,
+                                               const MemoryBlock &block) {
+            return block.type == type && block.fd == fd;
+        })) {
+        return RESULT_INVALID_CURRENT_MEMORY;
+    }
+
+    UnmapBacking(address, size);
+    SetBlocks(address, size, FREE_BLOCK);
+
+    return RESULT_SUCCESS;
+}
+
+void InitializeAddressSpace() noexcept {
+    // Over-reserve to align the address space on a large block.
+    uint64_t reservation_size = ADDRESS_SPACE_SIZE + HEAP_SIZE_ALIGNMENT;
+    void *reservation =
+        mmap(nullptr, reservation_size, PROT_NONE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (reservation == MAP_FAILED) {
+        Panic("cannot reserve the address space");
+    }
+
+    g_AddressSpaceBase = (reinterpret_cast<uintptr_t>(reservation) +
+                          HEAP_SIZE_ALIGNMENT - 1) &
+                         ~(HEAP_SIZE_ALIGNMENT - 1);
+
+    g_HeapFd = memfd_create("hs-heap", MFD_CLOEXEC);
+    if (g_HeapFd < 0 ||
+        ftruncate(g_HeapFd, static_cast<off_t>(HEAP_REGION_SIZE)) != 0) {
+        Panic("cannot create the heap memory");
+    }
+
+    // Everything outside of the reservation belongs to somebody else.
+    g_MemoryBlocks[0] = {MemoryType::Inaccessible, 0, MemoryPermission::None,
+                         -1, 0};
+    SetBlocks(g_AddressSpaceBase, ADDRESS_SPACE_SIZE, FREE_BLOCK);
+    SetBlocks(g_AddressSpaceBase + CODE_REGION_OFFSET, CODE_REGION_SIZE,
+              {MemoryType::Code, 0,
+               MemoryPermission::Read | MemoryPermission::Execute, -1, 0});
+}
+
+// Thread startup
+
+void RunLibraryThread() noexcept {
+    KernelThread *thread = t_CurrentThread;
+
+    reinterpret_cast<void (*)(uintptr_t)>(thread->entry_point)(
+        thread->argument);
+
+    hs::svc::aarch64::ExitThread();
+}
+
+void *RunHostThread(void *argument) noexcept {
+    KernelThread *thread = static_cast<KernelThread *>(argument);
+
+    t_CurrentThread = thread;
+
+    // Switch to the stack given to CreateThread, ExitThread switches back.
+    getcontext(&thread->library_context);
+    thread->library_context.uc_stack.ss_sp =
+        reinterpret_cast<void *>(thread->stack_top - PAGE_SIZE);
+    thread->library_context.uc_stack.ss_size = PAGE_SIZE;
+    thread->library_context.uc_link = nullptr;
+    makecontext(&thread->library_context, RunLibraryThread, 0);
+    swapcontext(&thread->host_context, &thread->library_context);
+
+    // We are off the library stack, it can go away now.
+    KernelLockGuard guard;
+    thread->is_exited = true;
+    NotifySynchronizationWaiters(thread);
+
+    return nullptr;
+}
+}  // namespace
+
+namespace hs::svc::aarch64 {
+hs::Result SetHeapSize(uintptr_t *out_address, size_t heap_size) noexcept {
+    CountSvc(hs::test::SVC_ID_SET_HEAP_SIZE);
+    KernelLockGuard guard;
+
+    if ((heap_size & (HEAP_SIZE_ALIGNMENT - 1)) != 0 ||
+        heap_size > HEAP_REGION_SIZE) {
+        return hs::Result(RESULT_INVALID_SIZE);
+    }
+
+    uintptr_t heap_address = g_AddressSpaceBase + HEAP_REGION_OFFSET;
+
+    if (heap_size > g_HeapSize) {
+        uint64_t growth = heap_size - g_HeapSize;
+
+        if (g_HeapSize + g_SharedMemorySize + growth > g_MemoryLimit) {
+            return hs::Result(RESULT_OUT_OF_MEMORY);
+        }
+
+        MemoryBlock block = {
+            MemoryType::Normal, 0,
+            MemoryPermission::Read | MemoryPermission::Write, g_HeapFd,
+            g_HeapSize};
+        MapBacking(heap_address + g_HeapSize, growth, g_HeapFd, g_HeapSize,
+                   block.permission);
+        SetBlocks(heap_address + g_HeapSize, growth, block);
+    } else if (heap_size < g_HeapSize) {
+        uint64_t shrink = g_HeapSize - heap_size;
+
+        if (!CheckBlocks(heap_address + heap_size, shrink, IsUnlockedHeap)) {
+            return hs::Result(RESULT_INVALID_CURRENT_MEMORY);
+        }
+
+        UnmapBacking(heap_address + heap_size, shrink);
+        fallocate(g_HeapFd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                  static_cast<off_t>(heap_size), static_cast<off_t>(shrink));
+        SetBlocks(heap_address + heap_size, shrink, FREE_BLOCK);
+    }
+
+    g_HeapSize = heap_size;
+    *out_address = heap_address;
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result MapMemory(uintptr_t dst_address, uintptr_t src_address,
+                     uintptr_t size) noexcept {
+    CountSvc(hs::test::SVC_ID_MAP_MEMORY);
+    KernelLockGuard guard;
+
+    if (!IsPageAligned(dst_address) || !IsPageAligned(src_address) ||
+        !IsPageAligned(size) || size == 0) {
+        return hs::Result(RESULT_INVALID_ADDRESS);
+    }
+
+    if (!IsInRange(dst_address, size, STACK_REGION_OFFSET,
+                   STACK_REGION_SIZE)) {
+        return hs::Result(RESULT_INVALID_MEMORY_REGION);
+    }
+
+    if (!CheckBlocks(src_address, size, IsUnlockedHeap) ||
+        !CheckBlocks(dst_address, size, IsFree)) {
+        return hs::Result(RESULT_INVALID_CURRENT_MEMORY);
+    }
+
+    uint64_t offset = src_address - g_AddressSpaceBase - HEAP_REGION_OFFSET;
+    MemoryBlock source_block = {
+        MemoryType::Normal, static_cast<uint32_t>(MemoryAttribute::Locked),
+        MemoryPermission::None, g_HeapFd, offset};
+    MemoryBlock alias_block = {
+        MemoryType::Stack, 0,
+        MemoryPermission::Read | MemoryPermission::Write, g_HeapFd, offset};
+
+    MapBacking(dst_address, size, g_HeapFd, offset, alias_block.permission);
+    ProtectBacking(src_address, size, MemoryPermission::None);
+    SetBlocks(dst_address, size, alias_block);
+    SetBlocks(src_address, size, source_block);
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result UnmapMemory(uintptr_t dst_address, uintptr_t src_address,
+                       uintptr_t size) noexcept {
+    CountSvc(hs::test::SVC_ID_UNMAP_MEMORY);
+    KernelLockGuard guard;
+
+    if (!IsPageAligned(dst_address) || !IsPageAligned(src_address) ||
+        !IsPageAligned(size) || size == 0) {
+        return hs::Result(RESULT_INVALID_ADDRESS);
+    }
+
+    uint64_t offset = src_address - g_AddressSpaceBase - HEAP_REGION_OFFSET;
+
+    // The alias must map the given source.
+    bool is_alias_of_source = CheckBlocks(
+        dst_address, size,
+        [dst_address, offset](uint64_t address, const MemoryBlock &block) {
+            uint64_t block_offset = block.fd_offset;
+
+            if (address < dst_address) {
+                block_offset += dst_address - address;
+                address = dst_address;
+            }
+
+            return block.type == MemoryType::Stack && block.fd == g_HeapFd &&
+                   block_offset == offset + (address - dst_address);
+        });
+    bool is_source_locked =
+        CheckBlocks(src_address, size, [](uint64_t, const MemoryBlock &block) {
+            return block.type == MemoryType::Normal &&
+                   block.attribute ==
+                       static_cast<uint32_t>(MemoryAttribute::Locked);
+        });
+
+    if (!is_alias_of_source || !is_source_locked) {
+        return hs::Result(RESULT_INVALID_CURRENT_MEMORY);
+    }
+
+    MemoryBlock source_block = {
+        MemoryType::Normal, 0,
+        MemoryPermission::Read | MemoryPermission::Write, g_HeapFd, offset};
+
+    UnmapBacking(dst_address, size);
+    ProtectBacking(src_address, size, source_block.permission);
+    SetBlocks(dst_address, size, FREE_BLOCK);
+    SetBlocks(src_address, size, source_block);
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result QueryMemory(MemoryInfo *memory_info, uint32_t *page_info,
+                       uintptr_t address) noexcept {
+    CountSvc(hs::test::SVC_ID_QUERY_MEMORY);
+    KernelLockGuard guard;
+
+    auto it = std::prev(g_MemoryBlocks.upper_bound(address));
+    const MemoryBlock &block = it->second;
+    auto is_same_state = [&block](const MemoryBlock &other) {
+        return other.type == block.type &&
+               other.attribute == block.attribute &&
+               other.permission == block.permission;
+    };
+
+    // Blocks only differing by their backing are reported as one.
+    auto first = it;
+    while (first != g_MemoryBlocks.begin() &&
+           is_same_state(std::prev(first)->second)) {
+        --first;
+    }
+
+    auto last = it;
+    while (std::next(last) != g_MemoryBlocks.end() &&
+           is_same_state(std::next(last)->second)) {
+        ++last;
+    }
+
+    memset(memory_info, 0, sizeof(*memory_info));
+    memory_info->address = first->first;
+    memory_info->size = GetBlockEnd(last) - first->first;
+    memory_info->type = static_cast<uint32_t>(block.type);
+    memory_info->attribute = block.attribute;
+    memory_info->permission = static_cast<uint32_t>(block.permission);
+    *page_info = 0;
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+void ExitProcess(void) noexcept { exit(g_ExitCode); }
+
+hs::Result CreateThread(hs::svc::Handle *out_thread_handle,
+                        uintptr_t thread_entry_point, uintptr_t argument,
+                        uintptr_t stack_top, int32_t priority,
+                        int32_t cpu_id) noexcept {
+    CountSvc(hs::test::SVC_ID_CREATE_THREAD);
+    (void)cpu_id;
+    KernelLockGuard guard;
+
+    if (priority < 0 || priority > 0x3F) {
+        return hs::Result(RESULT_INVALID_PRIORITY);
+    }
+
+    if (g_ThreadCount >= g_ThreadLimit) {
+        return hs::Result(RESULT_OUT_OF_RESOURCE);
+    }
+
+    KernelThread *thread = CreateKernelThread();
+    thread->entry_point = thread_entry_point;
+    thread->argument = argument;
+    thread->stack_top = stack_top;
+    thread->priority = priority;
+
+    thread->handle_value = AddHandle(ObjectKind::Thread, thread);
+    if (thread->handle_value == 0) {
+        return hs::Result(RESULT_OUT_OF_HANDLES);
+    }
+
+    *out_thread_handle = Handle::FromRawValue(thread->handle_value);
+    thread->is_counted = true;
+    g_ThreadCount++;
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result StartThread(hs::svc::Handle thread_handle) noexcept {
+    KernelLockGuard guard;
+    KernelThread *thread =
+        GetObject<KernelThread>(thread_handle.GetValue(), ObjectKind::Thread);
+
+    if (thread == nullptr) {
+        return hs::Result(RESULT_INVALID_HANDLE);
+    }
+
+    if (thread->is_started) {
+        return hs::Result(RESULT_INVALID_STATE);
+    }
+
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    pthread_attr_setstacksize(&attributes, 0x10000);
+
+    int error =
+        pthread_create(&thread->pthread, &attributes, RunHostThread, thread);
+    pthread_attr_destroy(&attributes);
+
+    if (error != 0) {
+        return hs::Result(RESULT_OUT_OF_RESOURCE);
+    }
+
+    thread->is_started = true;
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+void ExitThread(void) noexcept {
+    setcontext(&t_CurrentThread->host_context);
+    Panic("cannot leave the thread");
+}
+
+void SleepThread(int64_t nanoseconds) noexcept {
+    if (nanoseconds <= 0) {
+        sched_yield();
+        return;
+    }
+
+    struct timespec duration;
+    duration.tv_sec = nanoseconds / 1000000000;
+    duration.tv_nsec = nanoseconds % 1000000000;
+
+    while (nanosleep(&duration, &duration) != 0 && errno == EINTR) {
+    }
+}
+
+hs::Result GetThreadPriority(int32_t *priority,
+                             hs::svc::Handle thread_handle) noexcept {
+    KernelLockGuard guard;
+    KernelThread *thread =
+        GetObject<KernelThread>(thread_handle.GetValue(), ObjectKind::Thread);
+
+    if (thread == nullptr) {
+        return hs::Result(RESULT_INVALID_HANDLE);
+    }
+
+    *priority = thread->priority;
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result SetThreadPriority(hs::svc::Handle thread_handle,
+                             int32_t priority) noexcept {
+    KernelLockGuard guard;
+    KernelThread *thread =
+        GetObject<KernelThread>(thread_handle.GetValue(), ObjectKind::Thread);
+
+    if (thread == nullptr) {
+        return hs::Result(RESULT_INVALID_HANDLE);
+    }
+
+    if (priority < 0 || priority > 0x3F) {
+        return hs::Result(RESULT_INVALID_PRIORITY);
+    }
+
+    thread->priority = priority;
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result SignalEvent(hs::svc::Handle handle) noexcept {
+    KernelLockGuard guard;
+    KernelEvent *event =
+        GetObject<KernelEvent>(handle.GetValue(), ObjectKind::WritableEvent);
+
+    if (event == nullptr) {
+        return hs::Result(RESULT_INVALID_HANDLE);
+    }
+
+    if (!event->is_signaled) {
+        event->is_signaled = true;
+        NotifySynchronizationWaiters(event);
+    }
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result ClearEvent(hs::svc::Handle handle) noexcept {
+    KernelLockGuard guard;
+    HandleEntry *entry = GetHandleEntry(handle.GetValue());
+
+    if (entry == nullptr || (entry->kind != ObjectKind::WritableEvent &&
+                             entry->kind != ObjectKind::ReadableEvent)) {
+        return hs::Result(RESULT_INVALID_HANDLE);
+    }
+
+    static_cast<KernelEvent *>(entry->object)->is_signaled = false;
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result ResetSignal(hs::svc::Handle handle) noexcept {
+    KernelLockGuard guard;
+    KernelEvent *event =
+        GetObject<KernelEvent>(handle.GetValue(), ObjectKind::ReadableEvent);
+
+    if (event == nullptr) {
+        return hs::Result(RESULT_INVALID_HANDLE);
+    }
+
+    if (!event->is_signaled) {
+        return hs::Result(RESULT_INVALID_STATE);
+    }
+
+    event->is_signaled = false;
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result CreateEvent(hs::svc::Handle *writable_event_handle,
+                       hs::svc::Handle *readable_event_handle) noexcept {
+    KernelLockGuard guard;
+    KernelEvent *event = new KernelEvent();
+
+    uint32_t writable_handle = AddHandle(ObjectKind::WritableEvent, event);
+    uint32_t readable_handle = AddHandle(ObjectKind::ReadableEvent, event);
+
+    if (writable_handle == 0 || readable_handle == 0) {
+        return hs::Result(RESULT_OUT_OF_HANDLES);
+    }
+
+    *writable_event_handle = Handle::FromRawValue(writable_handle);
+    *readable_event_handle = Handle::FromRawValue(readable_handle);
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result CreateSharedMemory(hs::svc::Handle *out_shared_memory_handle,
+                              size_t size, MemoryPermission my_permission,
+                              MemoryPermission other_permission) noexcept {
+    (void)other_permission;
+    KernelLockGuard guard;
+
+    if (size == 0 || !IsPageAligned(size)) {
+        return hs::Result(RESULT_INVALID_SIZE);
+    }
+
+    if (my_permission != MemoryPermission::Read &&
+        my_permission != (MemoryPermission::Read | MemoryPermission::Write)) {
+        return hs::Result(RESULT_INVALID_NEW_MEMORY_PERMISSION);
+    }
+
+    if (g_HeapSize + g_SharedMemorySize + size > g_MemoryLimit) {
+        return hs::Result(RESULT_OUT_OF_MEMORY);
+    }
+
+    KernelSharedMemory *shared_memory = new KernelSharedMemory();
+    shared_memory->fd = memfd_create("hs-shared-memory", MFD_CLOEXEC);
+    if (shared_memory->fd < 0 ||
+        ftruncate(shared_memory->fd, static_cast<off_t>(size)) != 0) {
+        Panic("cannot create a shared memory");
+    }
+
+    shared_memory->size = size;
+    shared_memory->owner_permission = my_permission;
+    shared_memory->reference_count = 1;
+    g_SharedMemorySize += size;
+
+    uint32_t handle = AddHandle(ObjectKind::SharedMemory, shared_memory);
+    if (handle == 0) {
+        ReleaseSharedMemory(shared_memory);
+        return hs::Result(RESULT_OUT_OF_HANDLES);
+    }
+
+    *out_shared_memory_handle = Handle::FromRawValue(handle);
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result MapSharedMemory(hs::svc::Handle shared_memory_handle,
+                           uintptr_t address, size_t size,
+                           MemoryPermission permission) noexcept {
+    KernelLockGuard guard;
+    KernelSharedMemory *shared_memory = GetObject<KernelSharedMemory>(
+        shared_memory_handle.GetValue(), ObjectKind::SharedMemory);
+
+    if (shared_memory == nullptr) {
+        return hs::Result(RESULT_INVALID_HANDLE);
+    }
+
+    if (!IsPageAligned(address)) {
+        return hs::Result(RESULT_INVALID_ADDRESS);
+    }
+
+    if (size != shared_memory->size) {
+        return hs::Result(RESULT_INVALID_SIZE);
+    }
+
+    if ((static_cast<int>(permission) &
+         ~static_cast<int>(shared_memory->owner_permission)) != 0 ||
+        permission == MemoryPermission::None) {
+        return hs::Result(RESULT_INVALID_NEW_MEMORY_PERMISSION);
+    }
+
+    if (!IsInGeneralRegion(address, size)) {
+        return hs::Result(RESULT_INVALID_MEMORY_REGION);
+    }
+
+    if (!CheckBlocks(address, size, IsFree)) {
+        return hs::Result(RESULT_INVALID_CURRENT_MEMORY);
+    }
+
+    MapBacking(address, size, shared_memory->fd, 0, permission);
+    SetBlocks(address, size,
+              {MemoryType::Shared, 0, permission, shared_memory->fd, 0});
+    shared_memory->reference_count++;
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result UnmapSharedMemory(hs::svc::Handle shared_memory_handle,
+                             uintptr_t address, size_t size) noexcept {
+    KernelLockGuard guard;
+    KernelSharedMemory *shared_memory = GetObject<KernelSharedMemory>(
+        shared_memory_handle.GetValue(), ObjectKind::SharedMemory);
+
+    if (shared_memory == nullptr) {
+        return hs::Result(RESULT_INVALID_HANDLE);
+    }
+
+    if (size != shared_memory->size) {
+        return hs::Result(RESULT_INVALID_SIZE);
+    }
+
+    uint32_t result = UnmapMemoryRange(address, size, MemoryType::Shared,
+                                       shared_memory->fd);
+    if (result == RESULT_SUCCESS) {
+        ReleaseSharedMemory(shared_memory);
+    }
+
+    return hs::Result(result);
+}
+
+hs::Result CreateTransferMemory(hs::svc::Handle *out_transfer_memory_handle,
+                                uintptr_t address, size_t size,
+                                MemoryPermission permission) noexcept {
+    KernelLockGuard guard;
+
+    if (!IsPageAligned(address) || !IsPageAligned(size) || size == 0) {
+        return hs::Result(RESULT_INVALID_ADDRESS);
+    }
+
+    if (permission != MemoryPermission::None &&
+        permission != MemoryPermission::Read &&
+        permission != (MemoryPermission::Read | MemoryPermission::Write)) {
+        return hs::Result(RESULT_INVALID_NEW_MEMORY_PERMISSION);
+    }
+
+    if (!CheckBlocks(address, size, IsUnlockedHeap)) {
+        return hs::Result(RESULT_INVALID_CURRENT_MEMORY);
+    }
+
+    KernelTransferMemory *transfer_memory = new KernelTransferMemory();
+    transfer_memory->address = address;
+    transfer_memory->size = size;
+    transfer_memory->owner_permission = permission;
+    transfer_memory->reference_count = 1;
+
+    uint32_t handle = AddHandle(ObjectKind::TransferMemory, transfer_memory);
+    if (handle == 0) {
+        delete transfer_memory;
+        return hs::Result(RESULT_OUT_OF_HANDLES);
+    }
+
+    // The owner keeps the given permission on the locked buffer.
+    ProtectBacking(address, size, permission);
+    SetBlocks(address, size,
+              {MemoryType::Normal,
+               static_cast<uint32_t>(MemoryAttribute::Locked), permission,
+               g_HeapFd, address - g_AddressSpaceBase - HEAP_REGION_OFFSET});
+
+    *out_transfer_memory_handle = Handle::FromRawValue(handle);
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result MapTransferMemory(hs::svc::Handle transfer_memory_handle,
+                             uintptr_t address, size_t size,
+                             MemoryPermission permission) noexcept {
+    KernelLockGuard guard;
+    KernelTransferMemory *transfer_memory = GetObject<KernelTransferMemory>(
+        transfer_memory_handle.GetValue(), ObjectKind::TransferMemory);
+
+    if (transfer_memory == nullptr) {
+        return hs::Result(RESULT_INVALID_HANDLE);
+    }
+
+    if (!IsPageAligned(address)) {
+        return hs::Result(RESULT_INVALID_ADDRESS);
+    }
+
+    if (size != transfer_memory->size) {
+        return hs::Result(RESULT_INVALID_SIZE);
+    }
+
+    // The permission given at creation is passed again, the mapping is
+    // always writable.
+    if (permission != transfer_memory->owner_permission) {
+        return hs::Result(RESULT_INVALID_STATE);
+    }
+
+    if (!IsInGeneralRegion(address, size)) {
+        return hs::Result(RESULT_INVALID_MEMORY_REGION);
+    }
+
+    if (!CheckBlocks(address, size, IsFree)) {
+        return hs::Result(RESULT_INVALID_CURRENT_MEMORY);
+    }
+
+    uint64_t offset =
+        transfer_memory->address - g_AddressSpaceBase - HEAP_REGION_OFFSET;
+
+    MemoryPermission map_permission =
+        MemoryPermission::Read | MemoryPermission::Write;
+
+    MapBacking(address, size, g_HeapFd, offset, map_permission);
+    SetBlocks(address, size,
+              {GetTransferMemoryType(transfer_memory), 0, map_permission,
+               g_HeapFd, offset});
+    transfer_memory->reference_count++;
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result UnmapTransferMemory(hs::svc::Handle transfer_memory_handle,
+                               uintptr_t address, size_t size) noexcept {
+    KernelLockGuard guard;
+    KernelTransferMemory *transfer_memory = GetObject<KernelTransferMemory>(
+        transfer_memory_handle.GetValue(), ObjectKind::TransferMemory);
+
+    if (transfer_memory == nullptr) {
+        return hs::Result(RESULT_INVALID_HANDLE);
+    }
+
+    if (size != transfer_memory->size) {
+        return hs::Result(RESULT_INVALID_SIZE);
+    }
+
+    uint32_t result = UnmapMemoryRange(
+        address, size, GetTransferMemoryType(transfer_memory), g_HeapFd);
+    if (result == RESULT_SUCCESS) {
+        ReleaseTransferMemory(transfer_memory);
+    }
+
+    return hs::Result(result);
+}
+
+hs::Result CloseHandle(hs::svc::Handle handle) noexcept {
+    KernelLockGuard guard;
+    HandleEntry *entry = GetHandleEntry(handle.GetValue());
+
+    if (entry == nullptr) {
+        return hs::Result(RESULT_INVALID_HANDLE);
+    }
+
+    // Threads and events are leaked, some waiter may still look at them.
+    if (entry->kind == ObjectKind::Thread) {
+        KernelThread *thread = static_cast<KernelThread *>(entry->object);
+
+        if (thread->is_counted) {
+            thread->is_counted = false;
+            g_ThreadCount--;
+        }
+    } else if (entry->kind == ObjectKind::SharedMemory) {
+        ReleaseSharedMemory(static_cast<KernelSharedMemory *>(entry->object));
+    } else if (entry->kind == ObjectKind::TransferMemory) {
+        ReleaseTransferMemory(
+            static_cast<KernelTransferMemory *>(entry->object));
+    }
+
+    entry->object = nullptr;
+    g_FreeHandleIndexes.push_back(handle.GetValue() & ~HANDLE_INDEX_BASE);
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result WaitSynchronization(int32_t *index, const hs::svc::Handle *handles,
+                               int32_t handle_count, uint64_t timeout) noexcept {
+    CountSvc(hs::test::SVC_ID_WAIT_SYNCHRONIZATION);
+    KernelLockGuard guard;
+    KernelThread *thread = t_CurrentThread;
+
+    if (handle_count < 0 || handle_count > WAIT_HANDLE_COUNT_MAX) {
+        return hs::Result(RESULT_OUT_OF_RANGE);
+    }
+
+    for (int32_t i = 0; i < handle_count; i++) {
+        Handle handle = handles[i];
+        HandleEntry *entry = GetHandleEntry(handle.GetValue());
+
+        if (entry == nullptr || (entry->kind != ObjectKind::Thread &&
+                                 entry->kind != ObjectKind::ReadableEvent)) {
+            return hs::Result(RESULT_INVALID_HANDLE);
+        }
+
+        thread->wait_objects[i] = entry->object;
+    }
+
+    thread->wait_object_count = handle_count;
+
+    // The checks come in the order of the kernel, threads aren't terminated
+    // here so that one is left out.
+    for (int32_t i = 0; i < handle_count; i++) {
+        if (IsSignaled(thread->wait_objects[i])) {
+            *index = i;
+            return hs::Result(RESULT_SUCCESS);
+        }
+    }
+
+    if (timeout == 0) {
+        return hs::Result(RESULT_TIMED_OUT);
+    }
+
+    // A cancellation sent while we weren't waiting hits the next wait that
+    // would block.
+    if (thread->is_cancel_pending) {
+        thread->is_cancel_pending = false;
+        return hs::Result(RESULT_CANCELLED);
+    }
+
+    PrepareWait(thread, WaitKind::Synchronization);
+    g_SynchronizationWaiters.push_back(thread);
+
+    if (!Park(thread, static_cast<int64_t>(timeout))) {
+        RemoveWaiter(&g_SynchronizationWaiters, thread);
+        thread->wait_kind = WaitKind::None;
+        return hs::Result(RESULT_TIMED_OUT);
+    }
+
+    if (thread->wait_result == RESULT_SUCCESS) {
+        *index = thread->wait_index;
+    }
+
+    return hs::Result(thread->wait_result);
+}
+
+hs::Result CancelSynchronization(hs::svc::Handle thread_handle) noexcept {
+    KernelLockGuard guard;
+    KernelThread *thread =
+        GetObject<KernelThread>(thread_handle.GetValue(), ObjectKind::Thread);
+
+    if (thread == nullptr) {
+        return hs::Result(RESULT_INVALID_HANDLE);
+    }
+
+    if (thread->wait_kind == WaitKind::Synchronization) {
+        RemoveWaiter(&g_SynchronizationWaiters, thread);
+        Wake(thread, RESULT_CANCELLED);
+    } else {
+        thread->is_cancel_pending = true;
+    }
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result ArbitrateLock(hs::svc::Handle owner_thread_handle,
+                         uintptr_t lock_address,
+                         hs::svc::Handle requester_handle) noexcept {
+    CountSvc(hs::test::SVC_ID_ARBITRATE_LOCK);
+    KernelLockGuard guard;
+    KernelThread *thread = t_CurrentThread;
+
+    if ((lock_address & 3) != 0) {
+        return hs::Result(RESULT_INVALID_ADDRESS);
+    }
+
+    // The owner may have released the lock meanwhile, try again then.
+    if (LoadUserWord(lock_address) !=
+        (owner_thread_handle.GetValue() | HAS_LISTENERS)) {
+        return hs::Result(RESULT_SUCCESS);
+    }
+
+    KernelThread *owner = GetObject<KernelThread>(
+        owner_thread_handle.GetValue(), ObjectKind::Thread);
+    if (owner == nullptr) {
+        return hs::Result(RESULT_INVALID_HANDLE);
+    }
+
+    PrepareWait(thread, WaitKind::Lock);
+    thread->lock_owner = owner;
+    thread->lock_address = lock_address;
+    thread->tag = requester_handle.GetValue();
+    g_LockWaiters.push_back(thread);
+
+    Park(thread, -1);
+
+    return hs::Result(thread->wait_result);
+}
+
+hs::Result ArbitrateUnlock(uintptr_t lock_address) noexcept {
+    CountSvc(hs::test::SVC_ID_ARBITRATE_UNLOCK);
+    KernelLockGuard guard;
+
+    if ((lock_address & 3) != 0) {
+        return hs::Result(RESULT_INVALID_ADDRESS);
+    }
+
+    ReleaseLock(t_CurrentThread, lock_address);
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result WaitProcessWideKeyAtomic(uintptr_t mutex_address,
+                                    uintptr_t condvar_address,
+                                    hs::svc::Handle thread_handle,
+                                    uint64_t timeout) noexcept {
+    CountSvc(hs::test::SVC_ID_WAIT_PROCESS_WIDE_KEY_ATOMIC);
+    KernelLockGuard guard;
+    KernelThread *thread = t_CurrentThread;
+
+    if ((mutex_address & 3) != 0 || (condvar_address & 3) != 0) {
+        return hs::Result(RESULT_INVALID_ADDRESS);
+    }
+
+    ReleaseLock(thread, mutex_address);
+
+    PrepareWait(thread, WaitKind::ConditionVariable);
+    thread->lock_owner = nullptr;
+    thread->lock_address = mutex_address;
+    thread->condition_variable_key = condvar_address;
+    thread->tag = thread_handle.GetValue();
+
+    // The key tells the signalers that somebody waits.
+    StoreUserWord(condvar_address, 1);
+
+    if (timeout == 0) {
+        thread->wait_kind = WaitKind::None;
+        return hs::Result(RESULT_TIMED_OUT);
+    }
+
+    g_ConditionVariableWaiters.push_back(thread);
+
+    if (!Park(thread, static_cast<int64_t>(timeout))) {
+        // We may have been moved to the waiters of the lock already.
+        if (thread->wait_kind == WaitKind::Lock) {
+            RemoveWaiter(&g_LockWaiters, thread);
+        } else {
+            RemoveWaiter(&g_ConditionVariableWaiters, thread);
+        }
+
+        thread->wait_kind = WaitKind::None;
+        return hs::Result(RESULT_TIMED_OUT);
+    }
+
+    return hs::Result(thread->wait_result);
+}
+
+hs::Result SignalProcessWideKey(uintptr_t address, int32_t count) noexcept {
+    CountSvc(hs::test::SVC_ID_SIGNAL_PROCESS_WIDE_KEY);
+    KernelLockGuard guard;
+    auto is_waiting_for_key = [address](KernelThread *thread) {
+        return thread->condition_variable_key == address;
+    };
+
+    for (int32_t i = 0; count <= 0 || i < count; i++) {
+        KernelThread *thread =
+            TakeWaiter(&g_ConditionVariableWaiters, is_waiting_for_key);
+
+        if (thread == nullptr) {
+            break;
+        }
+
+        thread->condition_variable_key = 0;
+        AcquireLockForWaiter(thread);
+    }
+
+    if (CountWaiters(g_ConditionVariableWaiters, is_waiting_for_key) == 0) {
+        StoreUserWord(address, 0);
+    }
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+uint64_t GetSystemTick(void) noexcept {
+    uint64_t nanoseconds = GetMonotonicTime();
+
+    return nanoseconds / 625 * TICKS_PER_625_NANOSECONDS +
+           nanoseconds % 625 * TICKS_PER_625_NANOSECONDS / 625;
+}
+
+hs::Result GetThreadId(uint64_t *out_thread_id,
+                       hs::svc::Handle thread_handle) noexcept {
+    KernelLockGuard guard;
+    HandleEntry *entry = GetHandleEntry(thread_handle.GetValue());
+
+    if (entry == nullptr || entry->kind != ObjectKind::Thread) {
+        return hs::Result(RESULT_INVALID_HANDLE);
+    }
+
+    *out_thread_id = static_cast<KernelThread *>(entry->object)->handle_value;
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result Break(uint32_t break_reason, size_t input_value1,
+                 size_t input_value2) noexcept {
+    fprintf(stderr, "svc stand-in: Break(0x%x, 0x%zx, 0x%zx)\n", break_reason,
+            input_value1, input_value2);
+    abort();
+}
+
+hs::Result OutputDebugString(const char *str, size_t str_size) noexcept {
+    size_t length = strnlen(str, str_size);
+
+    fprintf(stderr, "%.*s\n", static_cast<int>(length), str);
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result GetInfo(uint64_t *out_info_value, InfoType info_type,
+                   hs::svc::Handle handle, uint64_t info_subtype) noexcept {
+    (void)handle;
+    (void)info_subtype;
+    KernelLockGuard guard;
+
+    switch (info_type) {
+        case InfoType::AliasRegionBase:
+            *out_info_value = g_AddressSpaceBase + ALIAS_REGION_OFFSET;
+            break;
+        case InfoType::AliasRegionSize:
+            *out_info_value = ALIAS_REGION_SIZE;
+            break;
+        case InfoType::HeapRegionBase:
+            *out_info_value = g_AddressSpaceBase + HEAP_REGION_OFFSET;
+            break;
+        case InfoType::HeapRegionSize:
+            *out_info_value = HEAP_REGION_SIZE;
+            break;
+        case InfoType::TotalMemorySize:
+            *out_info_value = g_MemoryLimit;
+            break;
+        case InfoType::UsedMemorySize:
+            *out_info_value = g_HeapSize + g_SharedMemorySize;
+            break;
+        case InfoType::AddressSpaceBase:
+            *out_info_value = g_AddressSpaceBase;
+            break;
+        case InfoType::AddressSpaceSize:
+            *out_info_value = ADDRESS_SPACE_SIZE;
+            break;
+        case InfoType::StackRegionBase:
+            *out_info_value = g_AddressSpaceBase + STACK_REGION_OFFSET;
+            break;
+        case InfoType::StackRegionSize:
+            *out_info_value = STACK_REGION_SIZE;
+            break;
+        default:
+            return hs::Result(RESULT_INVALID_ENUM_VALUE);
+    }
+
+    return hs::Result(RESULT_SUCCESS);
+}
+
+hs::Result WaitForAddress(uintptr_t address,
+                          hs::svc::ArbitrationType arbitration_type,
+                          int32_t value, int64_t timeout) noexcept {
+    CountSvc(hs::test::SVC_ID_WAIT_FOR_ADDRESS);
+    KernelLockGuard guard;
+    KernelThread *thread = t_CurrentThread;
+
+    if ((address & 3) != 0) {
+        return hs::Result(RESULT_INVALID_ADDRESS);
+    }
+
+    int32_t *word = reinterpret_cast<int32_t *>(address);
+    int32_t current_value = __atomic_load_n(word, __ATOMIC_SEQ_CST);
+
+    switch (arbitration_type) {
+        case ArbitrationType::WaitIfLessThan:
+            if (current_value >= value) {
+                return hs::Result(RESULT_INVALID_STATE);
+            }
+            break;
+        case ArbitrationType::DecrementAndWaitIfLessThan:
+            if (current_value >= value) {
+                return hs::Result(RESULT_INVALID_STATE);
+            }
+
+            __atomic_store_n(word, current_value - 1, __ATOMIC_SEQ_CST);
+            break;
+        case ArbitrationType::WaitIfEqual:
+            if (current_value != value) {
+                return hs::Result(RESULT_INVALID_STATE);
+            }
+            break;
+        default:
+            return hs::Result(RESULT_INVALID_ENUM_VALUE);
+    }
+
+    if (timeout == 0) {
+        return hs::Result(RESULT_TIMED_OUT);
+    }
+
+    PrepareWait(thread, WaitKind::AddressArbiter);
+    thread->arbiter_address = address;
+    g_AddressArbiterWaiters.push_back(thread);
+
+    if (!Park(thread, timeout)) {
+        RemoveWaiter(&g_AddressArbiterWaiters, thread);
+        thread->wait_kind = WaitKind::None;
+        return hs::Result(RESULT_TIMED_OUT);
+    }
+
+    return hs::Result(thread->wait_result);
+}
+
+hs::Result SignalToAddress(uintptr_t address,
+                           hs::svc::SignalType signal_type, int32_t value,
+                           int32_t count) noexcept {
+    CountSvc(hs::test::SVC_ID_SIGNAL_TO_ADDRESS);
+    KernelLockGuard guard;
+    auto is_waiting_for_address = [address](KernelThread *thread) {
+        return thread->arbiter_address == address;
+    };
+
+    if ((address & 3) != 0) {
+        return hs::Result(RESULT_INVALID_ADDRESS);
+    }
+
+    int32_t *word = reinterpret_cast<int32_t *>(address);
+    int32_t current_value = __atomic_load_n(word, __ATOMIC_SEQ_CST);
+
+    switch (signal_type) {
+        case SignalType::Signal:
+            break;
+        case SignalType::SignalAndIncrementIfEqual:
+            if (current_value != value) {
+                return hs::Result(RESULT_INVALID_STATE);
+            }
+
+            __atomic_store_n(word, current_value + 1, __ATOMIC_SEQ_CST);
+            break;
+        case SignalType::SignalAndModifyByWaitingCountIfEqual: {
+            if (current_value != value) {
+                return hs::Result(RESULT_INVALID_STATE);
+            }
+
+            size_t waiter_count =
+                CountWaiters(g_AddressArbiterWaiters, is_waiting_for_address);
+
+            if (waiter_count == 0) {
+                __atomic_store_n(word, current_value + 1, __ATOMIC_SEQ_CST);
+            } else if (count <= 0 ||
+                       waiter_count <= static_cast<size_t>(count)) {
+                __atomic_store_n(word, current_value - 1, __ATOMIC_SEQ_CST);
+            }
+            break;
+        }
+        default:
+            return hs::Result(RESULT_INVALID_ENUM_VALUE);
+    }
+
+    for (int32_t i = 0; count <= 0 || i < count; i++) {
+        KernelThread *thread =
+            TakeWaiter(&g_AddressArbiterWaiters, is_waiting_for_address);
+
+        if (thread == nullptr) {
+            break;
+        }
+
+        thread->arbiter_address = 0;
+        Wake(thread, RESULT_SUCCESS);
+    }
+
+    return hs::Result(RESULT_SUCCESS);
+}
+}  // namespace hs::svc::aarch64
+
+namespace hs::test {
+static void Nop() {}
+
+void RunHostProcess() noexcept {
+    KernelThread *main_thread;
+
+    {
+        KernelLockGuard guard;
+
+        InitializeAddressSpace();
+
+        main_thread = CreateKernelThread();
+        main_thread->priority = 0x2C;
+        main_thread->is_started = true;
+        main_thread->handle_value =
+            AddHandle(ObjectKind::Thread, main_thread);
+        t_CurrentThread = main_thread;
+    }
+
+    hs::init::Start(main_thread->handle_value, 0, Nop, Nop);
+
+    // Start exits the process.
+    abort();
+}
+
+void SetHostExitCode(int exit_code) noexcept { g_ExitCode = exit_code; }
+
+void *GetHostThreadLocalRegion() noexcept {
+    return t_CurrentThread->thread_local_region;
+}
+
+uint64_t GetSvcCallCount(uint32_t svc_id) noexcept {
+    return __atomic_load_n(&g_SvcCallCounts[svc_id], __ATOMIC_RELAXED);
+}
+
+void ResetSvcCallCounts() noexcept {
+    for (uint32_t i = 0; i < SVC_COUNT; i++) {
+        __atomic_store_n(&g_SvcCallCounts[i], 0, __ATOMIC_RELAXED);
+    }
+}
+
+void SetHostMemoryLimit(size_t size) noexcept {
+    KernelLockGuard guard;
+    g_MemoryLimit = size;
+}
+
+size_t GetHostMemoryLimit() noexcept {
+    KernelLockGuard guard;
+    return g_MemoryLimit;
+}
+
+void SetHostThreadLimit(uint32_t count) noexcept {
+    KernelLockGuard guard;
+    g_ThreadLimit = count;
+}
+}  // namespace hs::test
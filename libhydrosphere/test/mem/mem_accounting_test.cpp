@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/mem.hpp>
+#include <hs/os/os_tls.hpp>
+
+#include "../harness/test.hpp"
+
+namespace {
+const size_t STRIPE_COUNT = 4;
+const size_t WORKER_COUNT = 8;
+const size_t WORKER_BLOCK_SIZE = 0x100;
+
+struct Accounted {
+    bool is_stripe_used[STRIPE_COUNT];
+};
+
+hs::mem::MemoryUsage GetUsage(hs::mem::MemoryTag tag) {
+    hs::mem::MemoryUsageSnapshot snapshot;
+
+    HS_CHECK_SUCCESS(hs::mem::GetMemoryUsageSnapshot(&snapshot));
+    return snapshot.usages[static_cast<size_t>(tag)];
+}
+
+// Every worker accounts a block on the stripe of its thread, picked from its
+// TLS address as the accounting API does.
+void AccountFromWorker(size_t index, void *argument) {
+    auto accounted = reinterpret_cast<Accounted *>(argument);
+    auto tls_address = reinterpret_cast<uintptr_t>(
+        hs::os::ThreadLocalStorage::GetThreadLocalStorage());
+
+    accounted->is_stripe_used[(tls_address >> 9) % STRIPE_COUNT] = true;
+    hs::mem::AccountMemory(hs::mem::MemoryTag::Application,
+                           WORKER_BLOCK_SIZE * (index + 1));
+}
+}  // namespace
+
+HS_TEST(HeapAccountingFollowsTheUsableSize) {
+    hs::mem::MemoryUsage before = GetUsage(hs::mem::MemoryTag::Heap);
+
+    void *block = hs::mem::Allocate(100);
+    HS_CHECK(block != nullptr);
+
+    hs::mem::MemoryUsage during = GetUsage(hs::mem::MemoryTag::Heap);
+    HS_CHECK(during.size - before.size == hs::mem::GetAllocationSize(block));
+    HS_CHECK(during.block_count - before.block_count == 1);
+
+    hs::mem::Free(block);
+
+    hs::mem::MemoryUsage after = GetUsage(hs::mem::MemoryTag::Heap);
+    HS_CHECK(after.size == before.size);
+    HS_CHECK(after.block_count == before.block_count);
+}
+
+HS_TEST(ArenaAccountingFollowsCommitAndTrim) {
+    hs::mem::Arena arena;
+
+    HS_CHECK(arena.Initialize(0x100000));
+
+    hs::mem::MemoryUsage before = GetUsage(hs::mem::MemoryTag::Arena);
+
+    HS_CHECK(arena.Allocate(hs::mem::ARENA_COMMIT_SIZE + 1, 1) != nullptr);
+
+    hs::mem::MemoryUsage during = GetUsage(hs::mem::MemoryTag::Arena);
+    HS_CHECK(during.size - before.size == 2 * hs::mem::ARENA_COMMIT_SIZE);
+    HS_CHECK(during.block_count - before.block_count == 2);
+
+    arena.Reset();
+    HS_CHECK(arena.Trim() == 2 * hs::mem::ARENA_COMMIT_SIZE);
+
+    hs::mem::MemoryUsage after = GetUsage(hs::mem::MemoryTag::Arena);
+    HS_CHECK(after.size == before.size);
+    HS_CHECK(after.block_count == before.block_count);
+
+    arena.Finalize();
+}
+
+HS_TEST(MemoryUsageSnapshotMergesTheStripes) {
+    static Accounted accounted;
+    hs::mem::MemoryUsage before = GetUsage(hs::mem::MemoryTag::Application);
+
+    hs::test::RunWorkers(WORKER_COUNT, AccountFromWorker, &accounted);
+
+    for (size_t i = 0; i < STRIPE_COUNT; i++) {
+        HS_CHECK(accounted.is_stripe_used[i]);
+    }
+
+    size_t total_size = 0;
+    for (size_t i = 0; i < WORKER_COUNT; i++) {
+        total_size += WORKER_BLOCK_SIZE * (i + 1);
+    }
+
+    hs::mem::MemoryUsage during = GetUsage(hs::mem::MemoryTag::Application);
+    HS_CHECK(during.size - before.size == total_size);
+    HS_CHECK(during.block_count - before.block_count == WORKER_COUNT);
+
+    // Blocks accounted on other stripes can be unaccounted from this one.
+    for (size_t i = 0; i < WORKER_COUNT; i++) {
+        hs::mem::UnaccountMemory(hs::mem::MemoryTag::Application,
+                                 WORKER_BLOCK_SIZE * (i + 1));
+    }
+
+    hs::mem::MemoryUsage after = GetUsage(hs::mem::MemoryTag::Application);
+    HS_CHECK(after.size == before.size);
+    HS_CHECK(after.block_count == before.block_count);
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <string.h>
+
+#include <hs/mem.hpp>
+#include <hs/util/util_object_pool.hpp>
+
+#include "../harness/test.hpp"
+
+namespace {
+const size_t ARENA_SIZE = 0x100000;
+const size_t COMMIT_SIZE = 0x10000;
+
+struct Object {
+    uint64_t value;
+};
+
+// Every thread starts with a fresh arena, finalized when it exits.
+void UseThreadArena(size_t index, void *argument) {
+    auto main_arena = reinterpret_cast<hs::mem::Arena *>(argument);
+    hs::mem::Arena *arena = hs::mem::GetThreadArena();
+
+    HS_CHECK(arena != nullptr);
+    if (arena == nullptr) {
+        return;
+    }
+
+    HS_CHECK(arena != main_arena);
+    HS_CHECK(hs::mem::GetThreadArena() == arena);
+    HS_CHECK(arena->GetUsedSize() == 0);
+
+    auto block = reinterpret_cast<uint8_t *>(arena->Allocate(0x3000));
+    HS_CHECK(block != nullptr);
+    memset(block, static_cast<int>(index), 0x3000);
+}
+}  // namespace
+
+HS_TEST(ArenaAllocatesAndRewinds) {
+    hs::mem::Arena arena;
+
+    HS_CHECK(arena.Initialize(ARENA_SIZE));
+    HS_CHECK(arena.GetUsedSize() == 0);
+    HS_CHECK(arena.GetCommittedSize() == 0);
+
+    auto first = reinterpret_cast<uint8_t *>(arena.Allocate(24));
+    HS_CHECK(first != nullptr);
+    HS_CHECK((reinterpret_cast<uintptr_t>(first) &
+              (hs::mem::HEAP_MINIMAL_ALIGNMENT - 1)) == 0);
+    HS_CHECK(arena.GetCommittedSize() == COMMIT_SIZE);
+    memset(first, 0x11, 24);
+
+    hs::mem::ArenaMarker marker = arena.Mark();
+
+    // Cross a few commit granules.
+    auto big = reinterpret_cast<uint8_t *>(arena.Allocate(COMMIT_SIZE * 3));
+    HS_CHECK(big != nullptr);
+    HS_CHECK(big >= first + 24);
+    HS_CHECK(arena.GetCommittedSize() == COMMIT_SIZE * 4);
+    memset(big, 0x22, COMMIT_SIZE * 3);
+
+    auto aligned = arena.Allocate(8, 0x1000);
+    HS_CHECK(aligned != nullptr);
+    HS_CHECK((reinterpret_cast<uintptr_t>(aligned) & 0xFFF) == 0);
+
+    // Rewinding reuses the same memory.
+    arena.Rewind(marker);
+    HS_CHECK(arena.GetUsedSize() == marker);
+    HS_CHECK(arena.Allocate(COMMIT_SIZE * 3) == big);
+    HS_CHECK(first[0] == 0x11 && first[23] == 0x11);
+
+    size_t used_size = arena.GetUsedSize();
+    {
+        hs::mem::ArenaScope scope(arena);
+        HS_CHECK(arena.Allocate(0x100) != nullptr);
+    }
+    HS_CHECK(arena.GetUsedSize() == used_size);
+
+    // The range is bounded.
+    HS_CHECK(arena.Allocate(ARENA_SIZE) == nullptr);
+
+    arena.Reset();
+    HS_CHECK(arena.GetUsedSize() == 0);
+    HS_CHECK(arena.Trim() == COMMIT_SIZE * 4);
+    HS_CHECK(arena.GetCommittedSize() == 0);
+
+    // Memory committed again after a trim is usable.
+    auto again = reinterpret_cast<uint8_t *>(arena.Allocate(COMMIT_SIZE));
+    HS_CHECK(again == first);
+    memset(again, 0x33, COMMIT_SIZE);
+
+    arena.Finalize();
+}
+
+HS_TEST(ArenaBacksObjectPools) {
+    hs::mem::Arena arena;
+
+    HS_CHECK(arena.Initialize(ARENA_SIZE));
+
+    {
+        hs::util::ObjectPool<Object, 0x1000, hs::mem::ArenaAllocator> pool(
+            (hs::mem::ArenaAllocator(&arena)));
+
+        for (size_t i = 0; i < 0x1000; i++) {
+            Object *object = pool.Acquire();
+            HS_CHECK(object != nullptr);
+            object->value = i;
+        }
+
+        HS_CHECK(pool.Acquire() == nullptr);
+        HS_CHECK(arena.GetUsedSize() >= 0x1000 * sizeof(Object));
+    }
+
+    arena.Finalize();
+}
+
+HS_TEST(ThreadArenaIsPerThread) {
+    hs::mem::Arena *arena = hs::mem::GetThreadArena();
+    HS_CHECK(arena != nullptr);
+
+    size_t used_size = arena->GetUsedSize();
+    HS_CHECK(arena->Allocate(0x100) != nullptr);
+
+    hs::test::RunWorkers(3, UseThreadArena, arena);
+    HS_CHECK(arena->GetUsedSize() >= used_size + 0x100);
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/mem.hpp>
+
+#include "../harness/test.hpp"
+
+namespace {
+const size_t STORM_WORKER_COUNT = 3;
+const size_t STORM_ROUND_COUNT = 2000;
+const size_t STORM_BATCH_SIZE = 256;
+
+struct StormArgument {
+    size_t maximum_size;
+};
+
+// Each round allocates a batch of blocks then frees them, which keeps the
+// thread caches and the central depot busy.
+void RunAllocationStorm(size_t index, void *argument) {
+    auto storm = reinterpret_cast<StormArgument *>(argument);
+    hs::test::Random random(0x5EED + index);
+    void *blocks[STORM_BATCH_SIZE];
+
+    for (size_t round = 0; round < STORM_ROUND_COUNT; round++) {
+        for (size_t i = 0; i < STORM_BATCH_SIZE; i++) {
+            blocks[i] = hs::mem::Allocate(random.Next(storm->maximum_size) + 1);
+        }
+
+        for (size_t i = 0; i < STORM_BATCH_SIZE; i++) {
+            hs::mem::Free(blocks[i]);
+        }
+    }
+}
+
+void RunStorm(const char *name, size_t worker_count, size_t maximum_size) {
+    StormArgument storm = {maximum_size};
+    uint64_t duration =
+        hs::test::RunWorkers(worker_count, RunAllocationStorm, &storm);
+
+    hs::test::ReportThroughput(
+        name, worker_count * STORM_ROUND_COUNT * STORM_BATCH_SIZE * 2,
+        duration);
+}
+}  // namespace
+
+HS_BENCHMARK(HeapAllocationStorm) {
+    RunStorm("1 worker, up to 128 bytes", 1, 0x80);
+    RunStorm("3 workers, up to 128 bytes", STORM_WORKER_COUNT, 0x80);
+    RunStorm("1 worker, up to 8KiB", 1, 0x2000);
+    RunStorm("3 workers, up to 8KiB", STORM_WORKER_COUNT, 0x2000);
+    RunStorm("3 workers, up to 64KiB", STORM_WORKER_COUNT, 0x10000);
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <string.h>
+
+#include <hs/mem.hpp>
+#include <hs/os.hpp>
+#include <mem/detail/mem_size_class.hpp>
+
+#include "../harness/test.hpp"
+
+namespace {
+const size_t STRESS_SLOT_COUNT = 256;
+const size_t STRESS_ITERATION_COUNT = 200000;
+const size_t STRESS_WORKER_COUNT = 3;
+
+struct Block {
+    uint8_t *address;
+    size_t size;
+    uint8_t pattern;
+};
+
+// Blocks are shared between the workers, so a block is often freed by another
+// thread than the one that allocated it.
+struct StressArgument {
+    hs::os::Mutex slot_mutexes[STRESS_SLOT_COUNT];
+    Block slots[STRESS_SLOT_COUNT];
+};
+
+void FillBlock(Block *block, uint8_t pattern) noexcept {
+    block->pattern = pattern;
+    memset(block->address, pattern, block->size);
+}
+
+bool CheckBlock(const Block *block, size_t size) noexcept {
+    for (size_t i = 0; i < size; i++) {
+        if (block->address[i] != block->pattern) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+size_t PickSize(hs::test::Random *random) noexcept {
+    uint64_t kind = random->Next(100);
+
+    // Mostly small objects, some at the edge of the size classes and a few
+    // large ones.
+    if (kind < 80) {
+        return random->Next(0x200) + 1;
+    } else if (kind < 95) {
+        return random->Next(hs::mem::detail::SIZE_CLASS_SMALL_MAX) + 1;
+    }
+
+    return random->Next(0x40000) + 1;
+}
+
+void RunHeapStress(size_t index, void *argument) {
+    auto stress = reinterpret_cast<StressArgument *>(argument);
+    hs::test::Random random(0x1234 + index);
+
+    for (size_t i = 0; i < STRESS_ITERATION_COUNT; i++) {
+        size_t slot_index = random.Next(STRESS_SLOT_COUNT);
+        Block *block = &stress->slots[slot_index];
+        uint8_t pattern = static_cast<uint8_t>(random.Next());
+
+        hs::os::LockMutex(&stress->slot_mutexes[slot_index]);
+
+        if (block->address == nullptr) {
+            block->size = PickSize(&random);
+
+            if (random.Next(4) == 0) {
+                size_t alignment = 1ULL << (4 + random.Next(12));
+                block->address = reinterpret_cast<uint8_t *>(
+                    hs::mem::AllocateAligned(block->size, alignment));
+                HS_CHECK((reinterpret_cast<uintptr_t>(block->address) &
+                          (alignment - 1)) == 0);
+            } else {
+                block->address = reinterpret_cast<uint8_t *>(
+                    hs::mem::Allocate(block->size));
+            }
+
+            HS_CHECK(block->address != nullptr);
+            HS_CHECK(hs::mem::GetAllocationSize(block->address) >=
+                     block->size);
+            FillBlock(block, pattern);
+        } else if (random.Next(3) == 0) {
+            size_t new_size = PickSize(&random);
+            size_t kept_size =
+                new_size < block->size ? new_size : block->size;
+
+            block->address = reinterpret_cast<uint8_t *>(
+                hs::mem::Reallocate(block->address, new_size));
+            HS_CHECK(block->address != nullptr);
+            HS_CHECK(CheckBlock(block, kept_size));
+
+            block->size = new_size;
+            FillBlock(block, pattern);
+        } else {
+            HS_CHECK(CheckBlock(block, block->size));
+            hs::mem::Free(block->address);
+            block->address = nullptr;
+        }
+
+        hs::os::UnlockMutex(&stress->slot_mutexes[slot_index]);
+    }
+}
+}  // namespace
+
+HS_TEST(HeapServesEverySizeClass) {
+    for (size_t size = 1; size <= hs::mem::detail::SIZE_CLASS_SMALL_MAX;
+         size += 7) {
+        auto block = reinterpret_cast<uint8_t *>(hs::mem::Allocate(size));
+
+        HS_CHECK(block != nullptr);
+        HS_CHECK((reinterpret_cast<uintptr_t>(block) &
+                  (hs::mem::HEAP_MINIMAL_ALIGNMENT - 1)) == 0);
+        HS_CHECK(hs::mem::GetAllocationSize(block) >= size);
+
+        memset(block, 0xA5, size);
+        hs::mem::Free(block);
+    }
+}
+
+HS_TEST(HeapAlignsBlocks) {
+    for (size_t alignment = 0x10; alignment <= hs::mem::HEAP_MAXIMUM_ALIGNMENT;
+         alignment <<= 1) {
+        size_t sizes[] = {1, alignment - 1, alignment + 1, 0x3000};
+
+        for (size_t size : sizes) {
+            void *block = hs::mem::AllocateAligned(size, alignment);
+
+            HS_CHECK(block != nullptr);
+            HS_CHECK((reinterpret_cast<uintptr_t>(block) & (alignment - 1)) ==
+                     0);
+            HS_CHECK(hs::mem::GetAllocationSize(block) >= size);
+
+            memset(block, 0x5A, size);
+            hs::mem::Free(block);
+        }
+    }
+
+    HS_CHECK(hs::mem::AllocateAligned(
+                 1, hs::mem::HEAP_MAXIMUM_ALIGNMENT * 2) == nullptr);
+}
+
+HS_TEST(HeapPlacesLargeBlocksOnLargeBoundaries) {
+    void *block = hs::mem::Allocate(hs::mem::HEAP_LARGE_BLOCK_SIZE * 2);
+
+    // The block starts right after the header of its first span.
+    HS_CHECK(block != nullptr);
+    HS_CHECK((reinterpret_cast<uintptr_t>(block) &
+              (hs::mem::HEAP_LARGE_BLOCK_SIZE - 1)) < 0x1000);
+
+    hs::mem::Free(block);
+}
+
+HS_TEST(HeapReallocatePreservesContent) {
+    auto block = reinterpret_cast<uint8_t *>(hs::mem::Reallocate(nullptr, 24));
+    HS_CHECK(block != nullptr);
+
+    for (size_t i = 0; i < 24; i++) {
+        block[i] = static_cast<uint8_t>(i);
+    }
+
+    // Grow through the size classes up to a large block, then shrink back.
+    size_t sizes[] = {100, 0x1000, 0x2000, 0x20000, 0x400000, 0x40, 24};
+    for (size_t size : sizes) {
+        block = reinterpret_cast<uint8_t *>(hs::mem::Reallocate(block, size));
+        HS_CHECK(block != nullptr);
+        HS_CHECK(hs::mem::GetAllocationSize(block) >= size);
+
+        for (size_t i = 0; i < 24; i++) {
+            HS_CHECK(block[i] == static_cast<uint8_t>(i));
+        }
+    }
+
+    hs::mem::Free(block);
+    hs::mem::Free(nullptr);
+}
+
+HS_TEST(HeapTrimGivesMemoryBack) {
+    void *block = hs::mem::Allocate(hs::mem::HEAP_LARGE_BLOCK_SIZE * 8);
+    HS_CHECK(block != nullptr);
+    hs::mem::Free(block);
+
+    HS_CHECK(hs::mem::TrimHeap() >= hs::mem::HEAP_LARGE_BLOCK_SIZE * 8);
+}
+
+HS_TEST(HeapSurvivesConcurrentStress) {
+    auto stress = reinterpret_cast<StressArgument *>(
+        hs::mem::Allocate(sizeof(StressArgument)));
+
+    for (size_t i = 0; i < STRESS_SLOT_COUNT; i++) {
+        hs::os::InitializeMutex(&stress->slot_mutexes[i], false);
+        stress->slots[i].address = nullptr;
+    }
+
+    hs::test::RunWorkers(STRESS_WORKER_COUNT, RunHeapStress, stress);
+
+    for (size_t i = 0; i < STRESS_SLOT_COUNT; i++) {
+        Block *block = &stress->slots[i];
+
+        if (block->address != nullptr) {
+            HS_CHECK(CheckBlock(block, block->size));
+            hs::mem::Free(block->address);
+        }
+
+        hs::os::FinalizeMutex(&stress->slot_mutexes[i]);
+    }
+
+    hs::mem::Free(stress);
+    hs::mem::TrimHeap();
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/mem.hpp>
+#include <mem/detail/mem_size_class.hpp>
+
+#include "../harness/test.hpp"
+
+namespace {
+size_t g_DestroyedCount;
+
+struct Small {
+    uint32_t value;
+    uint8_t padding[0x2C];
+
+    explicit Small(uint32_t value) : value(value) {}
+    ~Small() { g_DestroyedCount++; }
+};
+
+struct Large {
+    uint8_t data[hs::mem::HEAP_SMALL_BLOCK_SIZE_MAX + 1];
+
+    ~Large() { g_DestroyedCount++; }
+};
+
+struct alignas(0x100) Aligned {
+    uint8_t data[0x40];
+
+    ~Aligned() { g_DestroyedCount++; }
+};
+
+hs::mem::MemoryUsage GetHeapUsage() {
+    hs::mem::MemoryUsageSnapshot snapshot;
+
+    HS_CHECK_SUCCESS(hs::mem::GetMemoryUsageSnapshot(&snapshot));
+    return snapshot.usages[static_cast<size_t>(hs::mem::MemoryTag::Heap)];
+}
+
+void CheckHeapUsage(const hs::mem::MemoryUsage &expected) {
+    hs::mem::MemoryUsage usage = GetHeapUsage();
+
+    HS_CHECK(usage.size == expected.size);
+    HS_CHECK(usage.block_count == expected.block_count);
+}
+}  // namespace
+
+HS_TEST(NewUsesTheSizeClassOfTheType) {
+    hs::mem::MemoryUsage before = GetHeapUsage();
+
+    g_DestroyedCount = 0;
+
+    Small *small = hs::mem::New<Small>(42u);
+    HS_CHECK(small != nullptr);
+    HS_CHECK(small->value == 42);
+    HS_CHECK(hs::mem::GetAllocationSize(small) ==
+             hs::mem::detail::GetSizeClassSize(
+                 hs::mem::GetHeapSizeClass(sizeof(Small))));
+
+    Large *large = hs::mem::New<Large>();
+    HS_CHECK(large != nullptr);
+    HS_CHECK(hs::mem::GetAllocationSize(large) >= sizeof(Large));
+
+    hs::mem::Delete(large);
+    hs::mem::Delete(small);
+    hs::mem::Delete<Small>(nullptr);
+
+    HS_CHECK(g_DestroyedCount == 2);
+    CheckHeapUsage(before);
+}
+
+HS_TEST(SizedDeleteFreesTheBlock) {
+    hs::mem::MemoryUsage before = GetHeapUsage();
+
+    g_DestroyedCount = 0;
+
+    // The compiler passes the size of the objects to operator delete.
+    Small *small = new Small(7);
+    Large *large = new Large();
+    Small *smalls = static_cast<Small *>(::operator new[](4 * sizeof(Small)));
+
+    delete small;
+    delete large;
+    ::operator delete[](smalls, 4 * sizeof(Small));
+
+    HS_CHECK(g_DestroyedCount == 2);
+    CheckHeapUsage(before);
+}
+
+HS_TEST(AlignedNewHonorsTheAlignment) {
+    hs::mem::MemoryUsage before = GetHeapUsage();
+    Aligned *objects[4];
+
+    g_DestroyedCount = 0;
+
+    for (size_t i = 0; i < 4; i++) {
+        objects[i] = new Aligned();
+        HS_CHECK(reinterpret_cast<uintptr_t>(objects[i]) % alignof(Aligned) ==
+                 0);
+    }
+
+    Aligned *array = new Aligned[3];
+    HS_CHECK(reinterpret_cast<uintptr_t>(array) % alignof(Aligned) == 0);
+
+    Aligned *object = hs::mem::New<Aligned>();
+    HS_CHECK(reinterpret_cast<uintptr_t>(object) % alignof(Aligned) == 0);
+
+    for (size_t i = 0; i < 4; i++) {
+        delete objects[i];
+    }
+    delete[] array;
+    hs::mem::Delete(object);
+
+    HS_CHECK(g_DestroyedCount == 8);
+    CheckHeapUsage(before);
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/mem.hpp>
+#include <hs/os.hpp>
+#include <mem/detail/mem_pressure.hpp>
+
+#include "../harness/test.hpp"
+
+namespace {
+struct PressureState {
+    uint32_t call_count;
+    uint32_t is_in_callback;
+    bool is_reentered_dispatch_done;
+    bool has_late_dispatch_succeeded;
+};
+
+// Hold the dispatch long enough for the other worker to run into it.
+void ReleaseSlowly(void *argument) {
+    auto state = reinterpret_cast<PressureState *>(argument);
+    size_t released_size;
+
+    __atomic_fetch_add(&state->call_count, 1, __ATOMIC_RELAXED);
+
+    // Freeing memory from a callback may get back to the registry.
+    state->is_reentered_dispatch_done =
+        !hs::mem::detail::g_MemoryPressureRegistry->Dispatch(&released_size);
+
+    __atomic_store_n(&state->is_in_callback, 1, __ATOMIC_RELEASE);
+    hs::os::SleepThread(20000000);
+}
+
+void RunUnderPressure(size_t index, void *argument) {
+    auto state = reinterpret_cast<PressureState *>(argument);
+
+    if (index == 0) {
+        hs::mem::NotifyMemoryPressure();
+        return;
+    }
+
+    while (__atomic_load_n(&state->is_in_callback, __ATOMIC_ACQUIRE) == 0) {
+        hs::os::YieldThread();
+    }
+
+    // The dispatch in progress is waited for, so an allocation failing here
+    // can be tried again once the memory was released.
+    size_t released_size;
+    state->has_late_dispatch_succeeded =
+        hs::mem::detail::g_MemoryPressureRegistry->Dispatch(&released_size);
+}
+}  // namespace
+
+HS_TEST(MemoryPressureWaitsForTheDispatchInProgress) {
+    hs::mem::MemoryPressureCallback callback;
+    PressureState state = {};
+
+    hs::mem::RegisterMemoryPressureCallback(&callback, ReleaseSlowly, &state);
+
+    hs::test::RunWorkers(2, RunUnderPressure, &state);
+
+    HS_CHECK(state.call_count == 1);
+    HS_CHECK(state.is_reentered_dispatch_done);
+    HS_CHECK(state.has_late_dispatch_succeeded);
+
+    // Once nobody is dispatching, the callbacks are invoked again.
+    hs::mem::NotifyMemoryPressure();
+    HS_CHECK(state.call_count == 2);
+
+    hs::mem::UnregisterMemoryPressureCallback(&callback);
+}
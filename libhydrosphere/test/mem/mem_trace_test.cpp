@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/mem.hpp>
+#include <mem/detail/mem_trace.hpp>
+#include <util/util_string_api.hpp>
+
+#include "../harness/test.hpp"
+
+namespace {
+const size_t BLOCK_COUNT = 8;
+const size_t CALLER_SIZE_MAX = 0x400;
+
+struct Capture {
+    uint8_t data[sizeof(hs::mem::AllocationTraceHeader) +
+                 hs::mem::ALLOCATION_TRACE_BUFFER_RECORD_COUNT *
+                     sizeof(hs::mem::AllocationTraceRecord)];
+    size_t size;
+    size_t chunk_count;
+};
+
+void CaptureTrace(void *argument, const void *data, size_t size) {
+    auto capture = reinterpret_cast<Capture *>(argument);
+
+    capture->chunk_count++;
+    if (size <= sizeof(capture->data)) {
+        memcpy(capture->data, data, size);
+        capture->size = size;
+    }
+}
+
+// The blocks are allocated and freed from their own functions so the return
+// addresses of the records can be checked against them.
+__attribute__((noinline)) void AllocateBlocks(void **blocks) {
+    for (size_t i = 0; i < BLOCK_COUNT; i++) {
+        blocks[i] = hs::mem::Allocate(0x10 * (i + 1));
+    }
+}
+
+__attribute__((noinline)) void FreeBlocks(void **blocks) {
+    for (size_t i = 0; i < BLOCK_COUNT; i++) {
+        hs::mem::Free(blocks[i]);
+    }
+}
+
+bool IsCalledFrom(uint64_t return_address, void (*function)(void **)) {
+    auto start = reinterpret_cast<uintptr_t>(function);
+
+    return return_address > start && return_address < start + CALLER_SIZE_MAX;
+}
+
+// Trace with a capturing sink and give the flushed chunk back.
+template <typename Function>
+void TraceInto(Capture *capture, Function function) {
+    *capture = {};
+
+    hs::mem::SetAllocationTraceSink(CaptureTrace, capture);
+    hs::mem::SetAllocationTracing(true);
+    function();
+    hs::mem::SetAllocationTracing(false);
+    hs::mem::FlushAllocationTrace();
+    hs::mem::SetAllocationTraceSink(nullptr, nullptr);
+}
+}  // namespace
+
+HS_TEST(AllocationTraceIsFlushedToTheSink) {
+    static Capture capture;
+    void *blocks[BLOCK_COUNT];
+
+    TraceInto(&capture, [&blocks]() {
+        AllocateBlocks(blocks);
+        FreeBlocks(blocks);
+    });
+
+    HS_CHECK(capture.chunk_count == 1);
+    HS_CHECK(capture.size == sizeof(hs::mem::AllocationTraceHeader) +
+                                 2 * BLOCK_COUNT *
+                                     sizeof(hs::mem::AllocationTraceRecord));
+
+    auto header =
+        reinterpret_cast<hs::mem::AllocationTraceHeader *>(capture.data);
+    HS_CHECK(header->magic == hs::mem::ALLOCATION_TRACE_MAGIC);
+    HS_CHECK(header->version == hs::mem::ALLOCATION_TRACE_VERSION);
+    HS_CHECK(header->record_count == 2 * BLOCK_COUNT);
+
+    auto records = reinterpret_cast<hs::mem::AllocationTraceRecord *>(
+        capture.data + sizeof(hs::mem::AllocationTraceHeader));
+
+    for (size_t i = 0; i < BLOCK_COUNT; i++) {
+        auto &allocation = records[i];
+        auto &free = records[BLOCK_COUNT + i];
+        auto address = reinterpret_cast<uintptr_t>(blocks[i]);
+
+        HS_CHECK(allocation.event == hs::mem::AllocationTraceEvent::Allocate);
+        HS_CHECK(allocation.address == address);
+        HS_CHECK(allocation.size == hs::mem::GetAllocationSize(blocks[i]));
+        HS_CHECK(IsCalledFrom(allocation.return_address, AllocateBlocks));
+
+        HS_CHECK(free.event == hs::mem::AllocationTraceEvent::Free);
+        HS_CHECK(free.address == address);
+        HS_CHECK(free.size == allocation.size);
+        HS_CHECK(IsCalledFrom(free.return_address, FreeBlocks));
+        HS_CHECK(free.tick >= allocation.tick);
+    }
+}
+
+HS_TEST(AllocationTraceKeepsSizesAbove4GiB) {
+    static Capture capture;
+
+    if (sizeof(size_t) <= sizeof(uint32_t)) {
+        return;
+    }
+
+    // No host heap can hand such a block out, the event is recorded directly.
+    uint64_t size = 0x100000010;
+
+    TraceInto(&capture, [size]() {
+        hs::mem::detail::TraceAllocationSlow(
+            hs::mem::AllocationTraceEvent::Allocate, &capture,
+            static_cast<size_t>(size), nullptr);
+    });
+
+    auto header =
+        reinterpret_cast<hs::mem::AllocationTraceHeader *>(capture.data);
+    auto record = reinterpret_cast<hs::mem::AllocationTraceRecord *>(
+        capture.data + sizeof(hs::mem::AllocationTraceHeader));
+
+    HS_CHECK(header->record_count == 1);
+    HS_CHECK(record->size == size);
+}
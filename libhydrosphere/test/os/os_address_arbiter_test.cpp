@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/os.hpp>
+#include <hs/os/os_address_arbiter_api.hpp>
+#include <hs/svc.hpp>
+
+#include "../harness/test.hpp"
+#include "../host/host.hpp"
+
+namespace {
+const int64_t TIMEOUT = 1000000;
+const int64_t WAITER_TIMEOUT = 5000000000;
+const size_t WAITER_COUNT = 2;
+
+struct Waiter {
+    volatile _Atomic(int32_t) *address;
+    int32_t value;
+    hs::os::AddressWaitStatus status;
+};
+
+void WaitIfEqual(void *argument) {
+    auto waiter = reinterpret_cast<Waiter *>(argument);
+
+    waiter->status = hs::os::WaitForAddressIfEqual(
+        waiter->address, waiter->value, WAITER_TIMEOUT);
+}
+
+// Start threads waiting on an address while it holds a value, and give them
+// the time to go to sleep in the kernel.
+void StartWaiters(hs::os::Thread *threads, Waiter *waiters, size_t count,
+                  volatile _Atomic(int32_t) *address, int32_t value) {
+    hs::test::ResetSvcCallCounts();
+
+    for (size_t i = 0; i < count; i++) {
+        waiters[i] = {address, value, hs::os::AddressWaitStatus::TimedOut};
+
+        HS_CHECK_SUCCESS(hs::os::CreateThread(&threads[i], WaitIfEqual,
+                                              &waiters[i], 0x4000, 0x2C));
+        hs::os::StartThread(&threads[i]);
+    }
+
+    while (hs::test::GetSvcCallCount(hs::test::SVC_ID_WAIT_FOR_ADDRESS) <
+           count) {
+        hs::os::SleepThread(0);
+    }
+
+    hs::os::SleepThread(10000000);
+}
+
+// Return the count of waiters that were signaled.
+size_t JoinWaiters(hs::os::Thread *threads, Waiter *waiters, size_t count) {
+    size_t signaled_count = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        hs::os::WaitThread(&threads[i]);
+        hs::os::DestroyThread(&threads[i]);
+
+        if (waiters[i].status == hs::os::AddressWaitStatus::Signaled) {
+            signaled_count++;
+        }
+    }
+
+    return signaled_count;
+}
+}  // namespace
+
+// The kernel results of the arbitration types and how the API maps them.
+HS_TEST(AddressArbiterMapsKernelResults) {
+    static volatile _Atomic(int32_t) value = 5;
+    auto address = reinterpret_cast<uintptr_t>(&value);
+
+    HS_CHECK_RESULT(
+        hs::svc::WaitForAddress(
+            address, hs::svc::ArbitrationType::WaitIfEqual, 4, TIMEOUT),
+        0xFA01);
+    HS_CHECK_RESULT(
+        hs::svc::WaitForAddress(
+            address, hs::svc::ArbitrationType::WaitIfLessThan, 5, TIMEOUT),
+        0xFA01);
+    HS_CHECK_RESULT(
+        hs::svc::WaitForAddress(
+            address, hs::svc::ArbitrationType::DecrementAndWaitIfLessThan, 5,
+            TIMEOUT),
+        0xFA01);
+    HS_CHECK(value == 5);
+    HS_CHECK_RESULT(
+        hs::svc::WaitForAddress(address, hs::svc::ArbitrationType::WaitIfEqual,
+                                5, 0),
+        0xEA01);
+    HS_CHECK_RESULT(
+        hs::svc::SignalToAddress(
+            address, hs::svc::SignalType::SignalAndIncrementIfEqual, 4, 1),
+        0xFA01);
+    HS_CHECK_RESULT(
+        hs::svc::SignalToAddress(
+            address, hs::svc::SignalType::SignalAndModifyByWaitingCountIfEqual,
+            4, 1),
+        0xFA01);
+    HS_CHECK(value == 5);
+
+    HS_CHECK(hs::os::WaitForAddressIfEqual(&value, 4, TIMEOUT) ==
+             hs::os::AddressWaitStatus::ValueMismatch);
+    HS_CHECK(hs::os::WaitForAddressIfLessThan(&value, 5, TIMEOUT) ==
+             hs::os::AddressWaitStatus::ValueMismatch);
+    HS_CHECK(hs::os::DecrementAndWaitForAddressIfLessThan(&value, 5,
+                                                          TIMEOUT) ==
+             hs::os::AddressWaitStatus::ValueMismatch);
+    HS_CHECK(hs::os::WaitForAddressIfEqual(&value, 5, 0) ==
+             hs::os::AddressWaitStatus::TimedOut);
+    HS_CHECK(!hs::os::SignalToAddressAndIncrementIfEqual(&value, 4, 1));
+    HS_CHECK(
+        !hs::os::SignalToAddressAndModifyByWaitingCountIfEqual(&value, 4, 1));
+    HS_CHECK(value == 5);
+}
+
+HS_TEST(AddressArbiterWaitsTimeOut) {
+    static volatile _Atomic(int32_t) value = 0;
+
+    uint64_t start_time = hs::test::GetTimeNs();
+    HS_CHECK(hs::os::WaitForAddressIfEqual(&value, 0, TIMEOUT) ==
+             hs::os::AddressWaitStatus::TimedOut);
+    HS_CHECK(hs::test::GetTimeNs() - start_time >= TIMEOUT);
+
+    start_time = hs::test::GetTimeNs();
+    HS_CHECK(hs::os::WaitForAddressIfLessThan(&value, 1, TIMEOUT) ==
+             hs::os::AddressWaitStatus::TimedOut);
+    HS_CHECK(hs::test::GetTimeNs() - start_time >= TIMEOUT);
+
+    // The value is decremented even if the wait times out.
+    start_time = hs::test::GetTimeNs();
+    HS_CHECK(hs::os::DecrementAndWaitForAddressIfLessThan(&value, 1,
+                                                          TIMEOUT) ==
+             hs::os::AddressWaitStatus::TimedOut);
+    HS_CHECK(hs::test::GetTimeNs() - start_time >= TIMEOUT);
+    HS_CHECK(value == -1);
+}
+
+HS_TEST(AddressArbiterSignalTypes) {
+    static volatile _Atomic(int32_t) value = 0;
+    hs::os::Thread threads[WAITER_COUNT];
+    Waiter waiters[WAITER_COUNT];
+
+    // Signal wakes the requested count of waiters, all of them if 0.
+    StartWaiters(threads, waiters, WAITER_COUNT, &value, 0);
+    hs::os::SignalToAddress(&value, 1);
+    hs::os::SleepThread(10000000);
+    HS_CHECK(hs::test::GetSvcCallCount(hs::test::SVC_ID_WAIT_FOR_ADDRESS) ==
+             WAITER_COUNT);
+    HS_CHECK((waiters[0].status == hs::os::AddressWaitStatus::Signaled) !=
+             (waiters[1].status == hs::os::AddressWaitStatus::Signaled));
+    hs::os::SignalToAddress(&value, 0);
+    HS_CHECK(JoinWaiters(threads, waiters, WAITER_COUNT) == WAITER_COUNT);
+    HS_CHECK(value == 0);
+
+    // SignalAndIncrementIfEqual increments the value and wakes the waiters.
+    StartWaiters(threads, waiters, WAITER_COUNT, &value, 0);
+    HS_CHECK(hs::os::SignalToAddressAndIncrementIfEqual(&value, 0, 0));
+    HS_CHECK(JoinWaiters(threads, waiters, WAITER_COUNT) == WAITER_COUNT);
+    HS_CHECK(value == 1);
+
+    // SignalAndModifyByWaitingCountIfEqual increments the value when nobody
+    // waits.
+    HS_CHECK(hs::os::SignalToAddressAndModifyByWaitingCountIfEqual(&value, 1,
+                                                                   1));
+    HS_CHECK(value == 2);
+
+    // It leaves it untouched when some waiters are left.
+    StartWaiters(threads, waiters, WAITER_COUNT, &value, 2);
+    HS_CHECK(hs::os::SignalToAddressAndModifyByWaitingCountIfEqual(&value, 2,
+                                                                   1));
+    HS_CHECK(value == 2);
+
+    // It decrements it when every waiter is woken.
+    HS_CHECK(hs::os::SignalToAddressAndModifyByWaitingCountIfEqual(&value, 2,
+                                                                   1));
+    HS_CHECK(value == 1);
+    HS_CHECK(JoinWaiters(threads, waiters, WAITER_COUNT) == WAITER_COUNT);
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/os.hpp>
+
+#include "../harness/test.hpp"
+
+namespace {
+const size_t PHASE_COUNT = 5000;
+const uint32_t PARTICIPANT_COUNT_MAX = 8;
+const uint32_t SPIN_COUNT = 100;
+
+struct Frame {
+    hs::os::Barrier barrier;
+    hs::os::BarrierNode
+        nodes[hs::os::GetBarrierNodeCount(PARTICIPANT_COUNT_MAX)];
+    bool is_tree;
+    uint32_t participant_count;
+    volatile size_t phases[PARTICIPANT_COUNT_MAX];
+    bool is_in_phase[PARTICIPANT_COUNT_MAX];
+};
+
+// Every participant publishes its phase then arrives, once released every
+// other participant must have reached the same phase.
+void RunFrameWorker(size_t index, void *argument) {
+    auto frame = reinterpret_cast<Frame *>(argument);
+    bool is_in_phase = true;
+
+    for (size_t phase = 1; phase <= PHASE_COUNT; phase++) {
+        frame->phases[index] = phase;
+
+        if (frame->is_tree) {
+            hs::os::AwaitBarrier(&frame->barrier,
+                                 static_cast<uint32_t>(index));
+        } else {
+            hs::os::AwaitBarrier(&frame->barrier);
+        }
+
+        for (uint32_t i = 0; i < frame->participant_count; i++) {
+            is_in_phase &= frame->phases[i] >= phase;
+        }
+    }
+
+    frame->is_in_phase[index] = is_in_phase;
+}
+
+void RunFrames(const char *name, uint32_t participant_count, bool is_tree,
+               uint32_t spin_count) {
+    static Frame frame;
+
+    frame = {};
+    frame.is_tree = is_tree;
+    frame.participant_count = participant_count;
+
+    if (is_tree) {
+        hs::os::InitializeBarrier(&frame.barrier, participant_count,
+                                  frame.nodes);
+    } else {
+        hs::os::InitializeBarrier(&frame.barrier, participant_count);
+    }
+
+    hs::os::SetBarrierSpinCount(&frame.barrier, spin_count);
+
+    uint64_t duration =
+        hs::test::RunWorkers(participant_count, RunFrameWorker, &frame);
+
+    hs::test::ReportThroughput(name, PHASE_COUNT, duration);
+
+    for (uint32_t i = 0; i < participant_count; i++) {
+        HS_CHECK(frame.is_in_phase[i]);
+    }
+
+    hs::os::FinalizeBarrier(&frame.barrier);
+}
+}  // namespace
+
+// The same barrier hit over and over by a fork/join loop, with a single
+// counter or a combining tree, blocking right away or spinning first.
+HS_BENCHMARK(BarrierPhaseThroughput) {
+    for (uint32_t count = 2; count <= PARTICIPANT_COUNT_MAX; count *= 2) {
+        hs::test::ReportValue("participants", count, "threads");
+        RunFrames("single counter", count, false, 0);
+        RunFrames("single counter, spin", count, false, SPIN_COUNT);
+        RunFrames("combining tree", count, true, 0);
+        RunFrames("combining tree, spin", count, true, SPIN_COUNT);
+    }
+}
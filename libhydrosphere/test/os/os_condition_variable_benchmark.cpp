@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/os.hpp>
+
+#include "../harness/test.hpp"
+#include "../host/host.hpp"
+
+namespace {
+const size_t QUEUE_CAPACITY = 0x40;
+const size_t ITEM_COUNT = 100000;
+
+// A bounded queue signaling both of its condition variables on every push
+// and pop, like most of our producer/consumer code does.
+struct Queue {
+    hs::os::Mutex mutex;
+    hs::os::ConditionVariable not_empty;
+    hs::os::ConditionVariable not_full;
+    size_t items[QUEUE_CAPACITY];
+    size_t head;
+    size_t tail;
+    uint64_t checksum;
+};
+
+void Push(Queue *queue, size_t item) {
+    hs::os::LockMutex(&queue->mutex);
+
+    while (queue->tail - queue->head == QUEUE_CAPACITY) {
+        hs::os::WaitConditionVariable(&queue->not_full, &queue->mutex);
+    }
+
+    queue->items[queue->tail % QUEUE_CAPACITY] = item;
+    queue->tail++;
+
+    hs::os::SignalConditionVariable(&queue->not_empty);
+    hs::os::UnlockMutex(&queue->mutex);
+}
+
+size_t Pop(Queue *queue) {
+    hs::os::LockMutex(&queue->mutex);
+
+    while (queue->tail == queue->head) {
+        hs::os::WaitConditionVariable(&queue->not_empty, &queue->mutex);
+    }
+
+    size_t item = queue->items[queue->head % QUEUE_CAPACITY];
+    queue->head++;
+
+    hs::os::SignalConditionVariable(&queue->not_full);
+    hs::os::UnlockMutex(&queue->mutex);
+
+    return item;
+}
+
+void RunQueueWorker(size_t index, void *argument) {
+    auto queue = reinterpret_cast<Queue *>(argument);
+
+    if (index == 0) {
+        for (size_t i = 0; i < ITEM_COUNT; i++) {
+            Push(queue, i);
+        }
+    } else {
+        uint64_t checksum = 0;
+
+        for (size_t i = 0; i < ITEM_COUNT; i++) {
+            checksum += Pop(queue);
+        }
+
+        queue->checksum = checksum;
+    }
+}
+}  // namespace
+
+// Every push and pop signals, the signals only reach the kernel when the
+// other side is actually waiting.
+HS_BENCHMARK(ConditionVariableSignalWithoutWaiters) {
+    static Queue queue;
+
+    hs::os::InitializeMutex(&queue.mutex, false);
+    hs::os::InitializeConditionVariable(&queue.not_empty);
+    hs::os::InitializeConditionVariable(&queue.not_full);
+
+    hs::test::ResetSvcCallCounts();
+
+    uint64_t duration = hs::test::RunWorkers(2, RunQueueWorker, &queue);
+
+    uint64_t signal_count = ITEM_COUNT * 2;
+    uint64_t syscall_count = hs::test::GetSvcCallCount(
+        hs::test::SVC_ID_SIGNAL_PROCESS_WIDE_KEY);
+
+    hs::test::ReportThroughput("producer/consumer, 64 items queue",
+                               ITEM_COUNT, duration);
+    hs::test::ReportValue("  signals", signal_count, "calls");
+    hs::test::ReportValue("  SignalProcessWideKey", syscall_count, "calls");
+    hs::test::ReportValue("  syscalls removed", signal_count - syscall_count,
+                          "calls");
+    hs::test::ReportValue(
+        "  WaitProcessWideKeyAtomic",
+        hs::test::GetSvcCallCount(
+            hs::test::SVC_ID_WAIT_PROCESS_WIDE_KEY_ATOMIC),
+        "calls");
+
+    HS_CHECK(queue.checksum ==
+             static_cast<uint64_t>(ITEM_COUNT) * (ITEM_COUNT - 1) / 2);
+    HS_CHECK(syscall_count < signal_count);
+
+    hs::os::FinalizeConditionVariable(&queue.not_full);
+    hs::os::FinalizeConditionVariable(&queue.not_empty);
+    hs::os::FinalizeMutex(&queue.mutex);
+}
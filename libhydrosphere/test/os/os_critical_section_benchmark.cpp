@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/os.hpp>
+
+#include "../harness/test.hpp"
+#include "../host/host.hpp"
+
+namespace {
+const size_t ROUND_COUNT = 100000;
+const size_t HELD_WORK = 0x40;
+const size_t OUTSIDE_WORK = 0x40;
+
+struct Shared {
+    hs::os::CriticalSection critical_section;
+    hs::os::CriticalSectionSpinState spin_state;
+    bool is_spin_state;
+    volatile size_t owner;
+    volatile uint64_t leave_time;
+    hs::test::LatencyHistogram histogram;
+};
+
+void Work(size_t count) {
+    for (volatile size_t i = 0; i < count; i++) {
+    }
+}
+
+// Take the critical section for a short while over and over, recording the
+// time between a thread leaving it and another one entering it.
+void RunHandoffWorker(size_t index, void *argument) {
+    auto shared = reinterpret_cast<Shared *>(argument);
+
+    for (size_t i = 0; i < ROUND_COUNT; i++) {
+        if (shared->is_spin_state) {
+            shared->critical_section.Enter(&shared->spin_state);
+        } else {
+            shared->critical_section.Enter();
+        }
+
+        uint64_t enter_time = hs::test::GetTimeNs();
+
+        if (shared->owner != index && shared->leave_time != 0) {
+            shared->histogram.Record(enter_time - shared->leave_time);
+        }
+
+        shared->owner = index;
+        Work(HELD_WORK);
+        shared->leave_time = hs::test::GetTimeNs();
+
+        shared->critical_section.Leave();
+        Work(OUTSIDE_WORK);
+    }
+}
+
+void RunHandoff(const char *name, size_t thread_count, uint32_t spin_count,
+                bool is_spin_state) {
+    static Shared shared;
+
+    shared = {};
+    shared.is_spin_state = is_spin_state;
+    shared.spin_state.spin_limit = 200;
+    shared.owner = thread_count;
+
+    hs::os::SetCriticalSectionSpinCount(spin_count);
+    hs::test::ResetSvcCallCounts();
+
+    uint64_t duration =
+        hs::test::RunWorkers(thread_count, RunHandoffWorker, &shared);
+
+    hs::test::ReportThroughput(name, thread_count * ROUND_COUNT, duration);
+    shared.histogram.Print("  handoff");
+    hs::test::ReportValue(
+        "  ArbitrateLock",
+        hs::test::GetSvcCallCount(hs::test::SVC_ID_ARBITRATE_LOCK), "calls");
+
+    if (is_spin_state) {
+        hs::test::ReportValue("  tuned spin count",
+                              shared.spin_state.spin_count, "spins");
+    }
+}
+}  // namespace
+
+// Two and three threads contending on a critical section held for a short
+// while, blocking right away, spinning a fixed count and spinning with a
+// tuned count.
+HS_BENCHMARK(CriticalSectionHandoffLatency) {
+    uint32_t spin_count = hs::os::GetCriticalSectionSpinCount();
+
+    for (size_t thread_count = 2; thread_count <= 3; thread_count++) {
+        hs::test::ReportValue("contending", thread_count, "threads");
+        RunHandoff("no spin", thread_count, 0, false);
+        RunHandoff("fixed spin", thread_count, spin_count, false);
+        RunHandoff("tuned spin", thread_count, spin_count, true);
+    }
+
+    hs::os::SetCriticalSectionSpinCount(spin_count);
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/os.hpp>
+#include <hs/os/os_light_event_api.hpp>
+#include <hs/os/os_user_event_api.hpp>
+
+#include "../harness/test.hpp"
+#include "../host/host.hpp"
+
+namespace {
+const size_t ROUND_COUNT = 50000;
+
+void Initialize(hs::os::LightEvent *event) {
+    hs::os::InitializeLightEvent(event, false, true);
+}
+void Signal(hs::os::LightEvent *event) { hs::os::SignalLightEvent(event); }
+void Wait(hs::os::LightEvent *event) { hs::os::WaitLightEvent(event); }
+void Finalize(hs::os::LightEvent *event) {
+    hs::os::FinalizeLightEvent(event);
+}
+
+void Initialize(hs::os::UserEvent *event) {
+    hs::os::InitializeUserEvent(event, false, true);
+}
+void Signal(hs::os::UserEvent *event) { hs::os::SignalUserEvent(event); }
+void Wait(hs::os::UserEvent *event) { hs::os::WaitUserEvent(event); }
+void Finalize(hs::os::UserEvent *event) { hs::os::FinalizeUserEvent(event); }
+
+template <typename Event>
+struct PingPong {
+    Event ping;
+    Event pong;
+    hs::test::LatencyHistogram histogram;
+};
+
+// The first worker signals ping and waits pong, the second one answers
+// every ping with a pong.
+template <typename Event>
+void RunPingPongWorker(size_t index, void *argument) {
+    auto ping_pong = reinterpret_cast<PingPong<Event> *>(argument);
+
+    for (size_t i = 0; i < ROUND_COUNT; i++) {
+        if (index == 0) {
+            uint64_t start_time = hs::test::GetTimeNs();
+
+            Signal(&ping_pong->ping);
+            Wait(&ping_pong->pong);
+
+            ping_pong->histogram.Record(hs::test::GetTimeNs() - start_time);
+        } else {
+            Wait(&ping_pong->ping);
+            Signal(&ping_pong->pong);
+        }
+    }
+}
+
+template <typename Event>
+void RunPingPong(const char *name) {
+    static PingPong<Event> ping_pong;
+
+    ping_pong = {};
+    Initialize(&ping_pong.ping);
+    Initialize(&ping_pong.pong);
+
+    hs::test::ResetSvcCallCounts();
+
+    uint64_t duration = hs::test::RunWorkers(
+        2, RunPingPongWorker<Event>, &ping_pong);
+
+    hs::test::ReportThroughput(name, ROUND_COUNT, duration);
+    ping_pong.histogram.Print("  round trip");
+    hs::test::ReportValue(
+        "  ArbitrateLock",
+        hs::test::GetSvcCallCount(hs::test::SVC_ID_ARBITRATE_LOCK), "calls");
+    hs::test::ReportValue(
+        "  WaitProcessWideKeyAtomic",
+        hs::test::GetSvcCallCount(
+            hs::test::SVC_ID_WAIT_PROCESS_WIDE_KEY_ATOMIC),
+        "calls");
+    hs::test::ReportValue(
+        "  SignalProcessWideKey",
+        hs::test::GetSvcCallCount(hs::test::SVC_ID_SIGNAL_PROCESS_WIDE_KEY),
+        "calls");
+    hs::test::ReportValue(
+        "  WaitForAddress",
+        hs::test::GetSvcCallCount(hs::test::SVC_ID_WAIT_FOR_ADDRESS), "calls");
+    hs::test::ReportValue(
+        "  SignalToAddress",
+        hs::test::GetSvcCallCount(hs::test::SVC_ID_SIGNAL_TO_ADDRESS),
+        "calls");
+
+    HS_CHECK(ping_pong.histogram.GetCount() == ROUND_COUNT);
+
+    Finalize(&ping_pong.pong);
+    Finalize(&ping_pong.ping);
+}
+}  // namespace
+
+// Two threads bouncing a signal over a pair of auto clear events.
+HS_BENCHMARK(LightEventPingPong) {
+    RunPingPong<hs::os::LightEvent>("LightEvent ping-pong");
+    RunPingPong<hs::os::UserEvent>("UserEvent ping-pong");
+}
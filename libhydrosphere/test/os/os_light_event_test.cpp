@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/os.hpp>
+#include <hs/os/os_light_event_api.hpp>
+
+#include "../harness/test.hpp"
+#include "../host/host.hpp"
+
+namespace {
+const int64_t WAITER_TIMEOUT = 200000000;
+const size_t WAITER_COUNT = 4;
+
+struct Waiter {
+    hs::os::LightEvent *event;
+    bool is_signaled;
+};
+
+void WaitSignal(void *argument) {
+    auto waiter = reinterpret_cast<Waiter *>(argument);
+
+    waiter->is_signaled =
+        hs::os::TimedWaitLightEvent(waiter->event, WAITER_TIMEOUT);
+}
+}  // namespace
+
+// A single signal of an auto clear event releases a single one of the threads
+// sleeping on it, the others time out.
+HS_TEST(LightEventAutoClearReleasesOneWaiter) {
+    hs::os::LightEvent event;
+    hs::os::Thread threads[WAITER_COUNT];
+    Waiter waiters[WAITER_COUNT];
+
+    hs::os::InitializeLightEvent(&event, false, true);
+    hs::test::ResetSvcCallCounts();
+
+    for (size_t i = 0; i < WAITER_COUNT; i++) {
+        waiters[i] = {&event, false};
+
+        HS_CHECK_SUCCESS(hs::os::CreateThread(&threads[i], WaitSignal,
+                                              &waiters[i], 0x4000, 0x2C));
+        hs::os::StartThread(&threads[i]);
+    }
+
+    while (hs::test::GetSvcCallCount(hs::test::SVC_ID_WAIT_FOR_ADDRESS) <
+           WAITER_COUNT) {
+        hs::os::SleepThread(0);
+    }
+
+    hs::os::SleepThread(10000000);
+    hs::os::SignalLightEvent(&event);
+
+    size_t signaled_count = 0;
+
+    for (size_t i = 0; i < WAITER_COUNT; i++) {
+        hs::os::WaitThread(&threads[i]);
+        hs::os::DestroyThread(&threads[i]);
+
+        if (waiters[i].is_signaled) {
+            signaled_count++;
+        }
+    }
+
+    HS_CHECK(signaled_count == 1);
+    HS_CHECK(!hs::os::IsLightEventSignaled(&event));
+
+    hs::os::FinalizeLightEvent(&event);
+}
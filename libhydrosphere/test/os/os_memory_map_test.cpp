@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/mem.hpp>
+#include <hs/os/os_memory_map_api.hpp>
+#include <os/detail/os_memory_map.hpp>
+#include <os/detail/os_virtualmemory_allocator.hpp>
+
+#include "../harness/test.hpp"
+#include "../host/host.hpp"
+
+namespace {
+const size_t PAGE_SIZE = 0x1000;
+
+// Every alias splits the heap and the stack region twice, this is enough to
+// go past the capacity of the memory map.
+const size_t ALIAS_COUNT = hs::os::detail::MEMORY_MAP_CAPACITY / 2 + 0x10;
+const size_t RANGE_SIZE = ALIAS_COUNT * 2 * PAGE_SIZE;
+
+// The count of QueryMemory issued by a memory map lookup.
+uint64_t CountQueries(uintptr_t address) {
+    hs::os::MemoryRegion region;
+
+    hs::test::ResetSvcCallCounts();
+    bool found = hs::os::QueryMemoryMap(&region, address);
+    HS_CHECK(found);
+    HS_CHECK(region.address <= address &&
+             address - region.address < region.size);
+
+    return hs::test::GetSvcCallCount(hs::test::SVC_ID_QUERY_MEMORY);
+}
+}  // namespace
+
+HS_TEST(MemoryMapRecoversFromOverflow) {
+    auto source = reinterpret_cast<uintptr_t>(
+        hs::mem::AllocateAligned(RANGE_SIZE, PAGE_SIZE));
+    auto destination = reinterpret_cast<uintptr_t>(
+        hs::os::detail::g_StackAllocator->Reserve(RANGE_SIZE, PAGE_SIZE));
+    HS_CHECK(source != 0 && destination != 0);
+    if (source == 0 || destination == 0) {
+        return;
+    }
+
+    HS_CHECK(CountQueries(destination) == 0);
+
+    // Alias every other page.
+    for (size_t i = 0; i < ALIAS_COUNT; i++) {
+        size_t offset = i * 2 * PAGE_SIZE;
+
+        HS_CHECK_SUCCESS(hs::os::detail::MapMemory(
+            destination + offset, source + offset, PAGE_SIZE));
+    }
+
+    // Lookups go to the kernel once the snapshot is full.
+    HS_CHECK(CountQueries(destination) == 1);
+
+    hs::os::MemoryRegion region;
+    HS_CHECK(hs::os::QueryMemoryMap(&region, destination));
+    HS_CHECK(region.type == hs::svc::MemoryType::Stack);
+
+    for (size_t i = 0; i < ALIAS_COUNT; i++) {
+        size_t offset = i * 2 * PAGE_SIZE;
+
+        HS_CHECK_SUCCESS(hs::os::detail::UnmapMemory(
+            destination + offset, source + offset, PAGE_SIZE));
+    }
+
+    // The snapshot was rebuilt once the regions fit again.
+    HS_CHECK(CountQueries(destination) == 0);
+    HS_CHECK(hs::os::QueryMemoryMap(&region, destination));
+    HS_CHECK(region.type == hs::svc::MemoryType::Free);
+    HS_CHECK(region.address <= destination &&
+             region.address + region.size >= destination + RANGE_SIZE);
+
+    HS_CHECK(hs::os::QueryMemoryMap(&region, source));
+    HS_CHECK(region.type == hs::svc::MemoryType::Normal);
+    HS_CHECK(region.attribute == 0);
+
+    hs::os::detail::g_StackAllocator->Free(
+        reinterpret_cast<void *>(destination));
+    hs::mem::Free(reinterpret_cast<void *>(source));
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <string.h>
+
+#include <hs/mem.hpp>
+#include <hs/os/os_mirrored_ring_buffer_api.hpp>
+
+#include "../harness/test.hpp"
+
+namespace {
+const size_t CAPACITY = 0x10000;
+const size_t STREAM_SIZE = 0x8000000;
+const size_t RECORD_SIZE_MAX = 0x1000;
+
+// The classic ring buffer, copies are split in two at the end of the
+// buffer and the consumer copies the records out to get them contiguous.
+class SplitRingBuffer {
+ public:
+    explicit SplitRingBuffer(uint8_t *buffer) noexcept
+        : buffer(buffer), write_index(0), read_index(0) {}
+
+    size_t GetUsedSize() const noexcept {
+        return this->write_index - this->read_index;
+    }
+
+    void Write(const void *data, size_t size) noexcept {
+        size_t offset = this->write_index % CAPACITY;
+        size_t first_size = size < CAPACITY - offset ? size : CAPACITY - offset;
+
+        memcpy(this->buffer + offset, data, first_size);
+        memcpy(this->buffer,
+               reinterpret_cast<const uint8_t *>(data) + first_size,
+               size - first_size);
+        this->write_index += size;
+    }
+
+    void Read(void *data, size_t size) noexcept {
+        size_t offset = this->read_index % CAPACITY;
+        size_t first_size = size < CAPACITY - offset ? size : CAPACITY - offset;
+
+        memcpy(data, this->buffer + offset, first_size);
+        memcpy(reinterpret_cast<uint8_t *>(data) + first_size, this->buffer,
+               size - first_size);
+        this->read_index += size;
+    }
+
+ private:
+    uint8_t *buffer;
+    size_t write_index;
+    size_t read_index;
+};
+
+// The consumer looks at both ends of a record, the copy is what we measure.
+inline uint64_t ConsumeRecord(const uint8_t *record, size_t size) {
+    uint64_t head;
+    uint64_t tail;
+
+    memcpy(&head, record, sizeof(head));
+    memcpy(&tail, record + size - sizeof(tail), sizeof(tail));
+    return head ^ tail;
+}
+
+// Fill the buffer with records then drain it, until the whole stream went
+// through.
+uint64_t StreamMirrored(const uint8_t *source, size_t record_size) {
+    hs::os::MirroredRingBuffer ring_buffer;
+    uint64_t checksum = 0;
+
+    hs::Result result =
+        hs::os::CreateMirroredRingBuffer(&ring_buffer, CAPACITY);
+    HS_CHECK_SUCCESS(result);
+    if (result.Err()) {
+        return 0;
+    }
+
+    for (size_t streamed = 0; streamed < STREAM_SIZE;) {
+        size_t size;
+        auto data = reinterpret_cast<uint8_t *>(
+            hs::os::BeginMirroredRingBufferWrite(&ring_buffer, &size));
+
+        while (size >= record_size) {
+            memcpy(data, source, record_size);
+            data += record_size;
+            size -= record_size;
+            hs::os::EndMirroredRingBufferWrite(&ring_buffer, record_size);
+        }
+
+        auto record = reinterpret_cast<const uint8_t *>(
+            hs::os::BeginMirroredRingBufferRead(&ring_buffer, &size));
+
+        while (size >= record_size) {
+            checksum += ConsumeRecord(record, record_size);
+            record += record_size;
+            size -= record_size;
+            streamed += record_size;
+            hs::os::EndMirroredRingBufferRead(&ring_buffer, record_size);
+        }
+    }
+
+    hs::os::DestroyMirroredRingBuffer(&ring_buffer);
+    return checksum;
+}
+
+uint64_t StreamSplit(const uint8_t *source, size_t record_size) {
+    auto buffer = reinterpret_cast<uint8_t *>(hs::mem::Allocate(CAPACITY));
+    static uint8_t record[RECORD_SIZE_MAX];
+    SplitRingBuffer ring_buffer(buffer);
+    uint64_t checksum = 0;
+
+    for (size_t streamed = 0; streamed < STREAM_SIZE;) {
+        while (CAPACITY - ring_buffer.GetUsedSize() >= record_size) {
+            ring_buffer.Write(source, record_size);
+        }
+
+        while (ring_buffer.GetUsedSize() >= record_size) {
+            ring_buffer.Read(record, record_size);
+            checksum += ConsumeRecord(record, record_size);
+            streamed += record_size;
+        }
+    }
+
+    hs::mem::Free(buffer);
+    return checksum;
+}
+
+void CompareRingBuffers(const char *mirrored_name, const char *split_name,
+                        const uint8_t *source, size_t record_size) {
+    uint64_t start_time = hs::test::GetTimeNs();
+    uint64_t mirrored_checksum = StreamMirrored(source, record_size);
+    hs::test::ReportThroughput(mirrored_name, STREAM_SIZE / record_size,
+                               hs::test::GetTimeNs() - start_time);
+
+    start_time = hs::test::GetTimeNs();
+    uint64_t split_checksum = StreamSplit(source, record_size);
+    hs::test::ReportThroughput(split_name, STREAM_SIZE / record_size,
+                               hs::test::GetTimeNs() - start_time);
+
+    HS_CHECK(mirrored_checksum == split_checksum);
+}
+}  // namespace
+
+// The record sizes don't divide the capacity, so records keep landing on
+// the end of the buffer.
+HS_BENCHMARK(MirroredRingBufferStream) {
+    static uint8_t source[RECORD_SIZE_MAX];
+
+    for (size_t i = 0; i < RECORD_SIZE_MAX; i++) {
+        source[i] = static_cast<uint8_t>(i * 13);
+    }
+
+    CompareRingBuffers("mirrored, 72 byte records",
+                       "split copy, 72 byte records", source, 72);
+    CompareRingBuffers("mirrored, 1500 byte records",
+                       "split copy, 1500 byte records", source, 1500);
+    CompareRingBuffers("mirrored, 3000 byte records",
+                       "split copy, 3000 byte records", source, 3000);
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <string.h>
+
+#include <hs/os/os_mirrored_ring_buffer_api.hpp>
+
+#include "../harness/test.hpp"
+
+namespace {
+const size_t CAPACITY = 0x4000;
+}  // namespace
+
+HS_TEST(MirroredRingBufferIsContiguousAcrossTheEnd) {
+    hs::os::MirroredRingBuffer ring_buffer;
+
+    HS_CHECK_SUCCESS(hs::os::CreateMirroredRingBuffer(&ring_buffer, CAPACITY));
+
+    size_t size;
+    auto first = reinterpret_cast<uint8_t *>(
+        hs::os::BeginMirroredRingBufferWrite(&ring_buffer, &size));
+    HS_CHECK(size == CAPACITY);
+
+    // Move both cursors near the end of the buffer.
+    memset(first, 0, CAPACITY - 0x100);
+    hs::os::EndMirroredRingBufferWrite(&ring_buffer, CAPACITY - 0x100);
+    hs::os::BeginMirroredRingBufferRead(&ring_buffer, &size);
+    HS_CHECK(size == CAPACITY - 0x100);
+    hs::os::EndMirroredRingBufferRead(&ring_buffer, size);
+
+    // A write of the whole capacity goes past the end in one piece.
+    auto data = reinterpret_cast<uint8_t *>(
+        hs::os::BeginMirroredRingBufferWrite(&ring_buffer, &size));
+    HS_CHECK(size == CAPACITY);
+    HS_CHECK(data == first + CAPACITY - 0x100);
+
+    for (size_t i = 0; i < CAPACITY; i++) {
+        data[i] = static_cast<uint8_t>(i * 7);
+    }
+    hs::os::EndMirroredRingBufferWrite(&ring_buffer, CAPACITY);
+
+    // The bytes written past the end are the ones at the start.
+    HS_CHECK(first[0] == 0x100 * 7 % 0x100);
+    HS_CHECK(first[1] == (0x101 * 7) % 0x100);
+
+    hs::os::BeginMirroredRingBufferWrite(&ring_buffer, &size);
+    HS_CHECK(size == 0);
+
+    auto read = reinterpret_cast<const uint8_t *>(
+        hs::os::BeginMirroredRingBufferRead(&ring_buffer, &size));
+    HS_CHECK(size == CAPACITY);
+    HS_CHECK(read == data);
+
+    bool is_same = true;
+    for (size_t i = 0; i < CAPACITY; i++) {
+        is_same &= read[i] == static_cast<uint8_t>(i * 7);
+    }
+    HS_CHECK(is_same);
+
+    hs::os::EndMirroredRingBufferRead(&ring_buffer, CAPACITY);
+    hs::os::BeginMirroredRingBufferRead(&ring_buffer, &size);
+    HS_CHECK(size == 0);
+
+    hs::os::DestroyMirroredRingBuffer(&ring_buffer);
+}
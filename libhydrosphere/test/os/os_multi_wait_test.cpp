@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/os.hpp>
+#include <hs/os/os_kernel_event_api.hpp>
+#include <hs/os/os_multi_wait_api.hpp>
+#include <hs/os/os_user_event_api.hpp>
+#include <hs/svc.hpp>
+
+#include "../harness/test.hpp"
+
+namespace {
+const size_t ROUND_COUNT = 200000;
+const int64_t DELAY = 5000000;
+const int64_t TIMEOUT = 2000000;
+
+// A thread signaling an object once the waiter had time to block on it.
+struct Signaler {
+    hs::os::KernelEvent *kernel_event;
+    hs::os::UserEvent *user_event;
+};
+
+void RunSignaler(void *argument) {
+    auto signaler = reinterpret_cast<Signaler *>(argument);
+
+    hs::os::SleepThread(DELAY);
+
+    if (signaler->kernel_event != nullptr) {
+        HS_CHECK_SUCCESS(hs::os::SignalKernelEvent(signaler->kernel_event));
+    }
+
+    if (signaler->user_event != nullptr) {
+        hs::os::SignalUserEvent(signaler->user_event);
+    }
+}
+
+void RunSleeper(void *argument) {
+    (void)argument;
+
+    hs::os::SleepThread(DELAY);
+}
+
+void StartWorker(hs::os::Thread *thread,
+                 hs::os::ThreadEntrypointFunction function, void *argument) {
+    HS_CHECK_SUCCESS(
+        hs::os::CreateThread(thread, function, argument, 0x4000, 0x2C));
+    hs::os::StartThread(thread);
+}
+
+void JoinWorker(hs::os::Thread *thread) {
+    hs::os::WaitThread(thread);
+    hs::os::DestroyThread(thread);
+}
+
+void FinalizeHolders(hs::os::MultiWait *multi_wait,
+                     hs::os::MultiWaitHolder *holders, size_t count) {
+    hs::os::UnlinkAllMultiWaitHolders(multi_wait);
+
+    for (size_t i = 0; i < count; i++) {
+        hs::os::FinalizeMultiWaitHolder(&holders[i]);
+    }
+
+    hs::os::FinalizeMultiWait(multi_wait);
+}
+
+struct Shared {
+    hs::os::MultiWait multi_wait;
+    hs::os::MultiWaitHolder kernel_event_holder;
+    hs::os::MultiWaitHolder user_event_holder;
+    hs::os::KernelEvent signaled_event;
+    hs::os::KernelEvent idle_event;
+    hs::os::UserEvent user_event;
+    volatile bool is_done;
+    size_t cancelled_count;
+};
+
+// The waiter keeps returning from WaitAny through the signaled kernel event
+// while the notifier signals the user event, so notifications land right as
+// the kernel wait returns. Any cancellation left behind fails the next wait
+// of the waiter on an unrelated object.
+void RunNotifiedWaitWorker(size_t index, void *argument) {
+    auto shared = reinterpret_cast<Shared *>(argument);
+
+    if (index == 1) {
+        while (!shared->is_done) {
+            hs::os::SignalUserEvent(&shared->user_event);
+        }
+
+        return;
+    }
+
+    hs::svc::Handle idle_handle = *shared->idle_event.readable_handle;
+
+    for (size_t i = 0; i < ROUND_COUNT; i++) {
+        hs::os::MultiWaitHolder *holder = hs::os::WaitAny(&shared->multi_wait);
+        HS_CHECK(holder == &shared->kernel_event_holder ||
+                 holder == &shared->user_event_holder);
+
+        hs::os::ClearUserEvent(&shared->user_event);
+
+        // The kernel only looks for a pending cancellation once the wait
+        // would block, a zero timeout would miss it.
+        int32_t handle_index;
+        auto result =
+            hs::svc::WaitSynchronization(&handle_index, &idle_handle, 1, 1);
+        if ((result.GetValue() & 0x3FFFFF) == 0xEC01) {
+            shared->cancelled_count++;
+        } else {
+            HS_CHECK_RESULT(result, 0xEA01);
+        }
+    }
+
+    shared->is_done = true;
+}
+}  // namespace
+
+HS_TEST(MultiWaitDoesNotLeaveCancellationsPending) {
+    static Shared shared;
+
+    HS_CHECK_SUCCESS(hs::os::CreateKernelEvent(&shared.signaled_event, false));
+    HS_CHECK_SUCCESS(hs::os::CreateKernelEvent(&shared.idle_event, false));
+    HS_CHECK_SUCCESS(hs::os::SignalKernelEvent(&shared.signaled_event));
+    hs::os::InitializeUserEvent(&shared.user_event, false, false);
+
+    hs::os::InitializeMultiWait(&shared.multi_wait);
+    hs::os::InitializeMultiWaitHolder(&shared.kernel_event_holder,
+                                      &shared.signaled_event);
+    hs::os::InitializeMultiWaitHolder(&shared.user_event_holder,
+                                      &shared.user_event);
+    hs::os::LinkMultiWaitHolder(&shared.multi_wait,
+                                &shared.kernel_event_holder);
+    hs::os::LinkMultiWaitHolder(&shared.multi_wait, &shared.user_event_holder);
+
+    hs::test::RunWorkers(2, RunNotifiedWaitWorker, &shared);
+
+    HS_CHECK(shared.cancelled_count == 0);
+
+    hs::os::UnlinkAllMultiWaitHolders(&shared.multi_wait);
+    hs::os::FinalizeMultiWaitHolder(&shared.user_event_holder);
+    hs::os::FinalizeMultiWaitHolder(&shared.kernel_event_holder);
+    hs::os::FinalizeMultiWait(&shared.multi_wait);
+    hs::os::FinalizeUserEvent(&shared.user_event);
+    hs::os::DestroyKernelEvent(&shared.idle_event);
+    hs::os::DestroyKernelEvent(&shared.signaled_event);
+}
+
+HS_TEST(MultiWaitReturnsTheSignaledKernelEvent) {
+    hs::os::MultiWait multi_wait;
+    hs::os::MultiWaitHolder holders[2];
+    hs::os::KernelEvent events[2];
+    hs::os::Thread thread;
+    Signaler signaler = {&events[1], nullptr};
+
+    hs::os::InitializeMultiWait(&multi_wait);
+
+    for (size_t i = 0; i < 2; i++) {
+        HS_CHECK_SUCCESS(hs::os::CreateKernelEvent(&events[i], false));
+        hs::os::InitializeMultiWaitHolder(&holders[i], &events[i]);
+        hs::os::LinkMultiWaitHolder(&multi_wait, &holders[i]);
+    }
+
+    HS_CHECK(hs::os::TryWaitAny(&multi_wait) == nullptr);
+
+    StartWorker(&thread, RunSignaler, &signaler);
+    HS_CHECK(hs::os::WaitAny(&multi_wait) == &holders[1]);
+    JoinWorker(&thread);
+
+    HS_CHECK(hs::os::TryWaitAny(&multi_wait) == &holders[1]);
+
+    FinalizeHolders(&multi_wait, holders, 2);
+    hs::os::DestroyKernelEvent(&events[1]);
+    hs::os::DestroyKernelEvent(&events[0]);
+}
+
+HS_TEST(MultiWaitReturnsTheExitedThread) {
+    hs::os::MultiWait multi_wait;
+    hs::os::MultiWaitHolder holders[2];
+    hs::os::KernelEvent event;
+    hs::os::Thread thread;
+
+    HS_CHECK_SUCCESS(hs::os::CreateKernelEvent(&event, false));
+    HS_CHECK_SUCCESS(
+        hs::os::CreateThread(&thread, RunSleeper, nullptr, 0x4000, 0x2C));
+
+    hs::os::InitializeMultiWait(&multi_wait);
+    hs::os::InitializeMultiWaitHolder(&holders[0], &event);
+    hs::os::InitializeMultiWaitHolder(&holders[1], &thread);
+    hs::os::LinkMultiWaitHolder(&multi_wait, &holders[0]);
+    hs::os::LinkMultiWaitHolder(&multi_wait, &holders[1]);
+
+    hs::os::StartThread(&thread);
+    HS_CHECK(hs::os::WaitAny(&multi_wait) == &holders[1]);
+
+    FinalizeHolders(&multi_wait, holders, 2);
+    JoinWorker(&thread);
+    hs::os::DestroyKernelEvent(&event);
+}
+
+// The user event cancels the kernel wait of the waiter.
+HS_TEST(MultiWaitReturnsTheSignaledUserEvent) {
+    hs::os::MultiWait multi_wait;
+    hs::os::MultiWaitHolder holders[2];
+    hs::os::KernelEvent kernel_event;
+    hs::os::UserEvent user_event;
+    hs::os::Thread thread;
+    Signaler signaler = {nullptr, &user_event};
+
+    HS_CHECK_SUCCESS(hs::os::CreateKernelEvent(&kernel_event, false));
+    hs::os::InitializeUserEvent(&user_event, false, false);
+
+    hs::os::InitializeMultiWait(&multi_wait);
+    hs::os::InitializeMultiWaitHolder(&holders[0], &kernel_event);
+    hs::os::InitializeMultiWaitHolder(&holders[1], &user_event);
+    hs::os::LinkMultiWaitHolder(&multi_wait, &holders[0]);
+    hs::os::LinkMultiWaitHolder(&multi_wait, &holders[1]);
+
+    StartWorker(&thread, RunSignaler, &signaler);
+    HS_CHECK(hs::os::WaitAny(&multi_wait) == &holders[1]);
+    JoinWorker(&thread);
+
+    FinalizeHolders(&multi_wait, holders, 2);
+    hs::os::FinalizeUserEvent(&user_event);
+    hs::os::DestroyKernelEvent(&kernel_event);
+}
+
+// Without kernel objects the waiter blocks on the condition variable of the
+// MultiWait.
+HS_TEST(MultiWaitOnUserEventsOnly) {
+    hs::os::MultiWait multi_wait;
+    hs::os::MultiWaitHolder holders[2];
+    hs::os::UserEvent events[2];
+    hs::os::Thread thread;
+    Signaler signaler = {nullptr, &events[0]};
+
+    hs::os::InitializeMultiWait(&multi_wait);
+
+    for (size_t i = 0; i < 2; i++) {
+        hs::os::InitializeUserEvent(&events[i], false, false);
+        hs::os::InitializeMultiWaitHolder(&holders[i], &events[i]);
+        hs::os::LinkMultiWaitHolder(&multi_wait, &holders[i]);
+    }
+
+    HS_CHECK(hs::os::TryWaitAny(&multi_wait) == nullptr);
+    HS_CHECK(hs::os::TimedWaitAny(&multi_wait, TIMEOUT) == nullptr);
+
+    StartWorker(&thread, RunSignaler, &signaler);
+    HS_CHECK(hs::os::WaitAny(&multi_wait) == &holders[0]);
+    JoinWorker(&thread);
+
+    FinalizeHolders(&multi_wait, holders, 2);
+    hs::os::FinalizeUserEvent(&events[1]);
+    hs::os::FinalizeUserEvent(&events[0]);
+}
+
+HS_TEST(MultiWaitTimedWaitAnyExpires) {
+    hs::os::MultiWait multi_wait;
+    hs::os::MultiWaitHolder holders[2];
+    hs::os::KernelEvent kernel_event;
+    hs::os::UserEvent user_event;
+
+    HS_CHECK_SUCCESS(hs::os::CreateKernelEvent(&kernel_event, false));
+    hs::os::InitializeUserEvent(&user_event, false, false);
+
+    hs::os::InitializeMultiWait(&multi_wait);
+    hs::os::InitializeMultiWaitHolder(&holders[0], &kernel_event);
+    hs::os::InitializeMultiWaitHolder(&holders[1], &user_event);
+    hs::os::LinkMultiWaitHolder(&multi_wait, &holders[0]);
+    hs::os::LinkMultiWaitHolder(&multi_wait, &holders[1]);
+
+    uint64_t start_time = hs::test::GetTimeNs();
+    HS_CHECK(hs::os::TimedWaitAny(&multi_wait, TIMEOUT) == nullptr);
+    HS_CHECK(hs::test::GetTimeNs() - start_time >= TIMEOUT);
+
+    FinalizeHolders(&multi_wait, holders, 2);
+    hs::os::FinalizeUserEvent(&user_event);
+    hs::os::DestroyKernelEvent(&kernel_event);
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/os.hpp>
+
+#include "../harness/test.hpp"
+#include "../host/host.hpp"
+
+namespace {
+const size_t READER_COUNT = 3;
+const size_t READ_COUNT = 200000;
+const size_t WRITE_COUNT = 20000;
+const size_t TABLE_SIZE = 0x20;
+
+// A read-mostly table, a writer updates every entry at once.
+struct Table {
+    uint64_t entries[TABLE_SIZE];
+};
+
+struct Shared {
+    bool is_reader_writer_lock;
+    hs::os::ReaderWriterLock lock;
+    hs::os::Mutex mutex;
+    Table table;
+    bool is_consistent[READER_COUNT];
+};
+
+void LockShared(Shared *shared, bool is_writer) {
+    if (!shared->is_reader_writer_lock) {
+        hs::os::LockMutex(&shared->mutex);
+    } else if (is_writer) {
+        hs::os::AcquireWriterLock(&shared->lock);
+    } else {
+        hs::os::AcquireReaderLock(&shared->lock);
+    }
+}
+
+void UnlockShared(Shared *shared, bool is_writer) {
+    if (!shared->is_reader_writer_lock) {
+        hs::os::UnlockMutex(&shared->mutex);
+    } else if (is_writer) {
+        hs::os::ReleaseWriterLock(&shared->lock);
+    } else {
+        hs::os::ReleaseReaderLock(&shared->lock);
+    }
+}
+
+// The last worker writes, the others read and check they never see a
+// partial update.
+void RunTableWorker(size_t index, void *argument) {
+    auto shared = reinterpret_cast<Shared *>(argument);
+
+    if (index == READER_COUNT) {
+        for (size_t i = 0; i < WRITE_COUNT; i++) {
+            LockShared(shared, true);
+
+            for (size_t j = 0; j < TABLE_SIZE; j++) {
+                shared->table.entries[j] = i;
+            }
+
+            UnlockShared(shared, true);
+        }
+
+        return;
+    }
+
+    bool is_consistent = true;
+
+    for (size_t i = 0; i < READ_COUNT; i++) {
+        LockShared(shared, false);
+
+        uint64_t first = shared->table.entries[0];
+        for (size_t j = 1; j < TABLE_SIZE; j++) {
+            is_consistent &= shared->table.entries[j] == first;
+        }
+
+        UnlockShared(shared, false);
+    }
+
+    shared->is_consistent[index] = is_consistent;
+}
+
+void RunTable(const char *name, bool is_reader_writer_lock) {
+    static Shared shared;
+
+    shared.is_reader_writer_lock = is_reader_writer_lock;
+    hs::os::InitializeReaderWriterLock(&shared.lock);
+    hs::os::InitializeMutex(&shared.mutex, false);
+    shared.table = {};
+
+    hs::test::ResetSvcCallCounts();
+
+    uint64_t duration =
+        hs::test::RunWorkers(READER_COUNT + 1, RunTableWorker, &shared);
+
+    hs::test::ReportThroughput(name, READER_COUNT * READ_COUNT + WRITE_COUNT,
+                               duration);
+    hs::test::ReportValue(
+        "  ArbitrateLock",
+        hs::test::GetSvcCallCount(hs::test::SVC_ID_ARBITRATE_LOCK), "calls");
+    hs::test::ReportValue(
+        "  WaitProcessWideKeyAtomic",
+        hs::test::GetSvcCallCount(
+            hs::test::SVC_ID_WAIT_PROCESS_WIDE_KEY_ATOMIC),
+        "calls");
+
+    for (size_t i = 0; i < READER_COUNT; i++) {
+        HS_CHECK(shared.is_consistent[i]);
+    }
+
+    hs::os::FinalizeMutex(&shared.mutex);
+    hs::os::FinalizeReaderWriterLock(&shared.lock);
+}
+}  // namespace
+
+// Three readers and one writer over the same table, the readers share the
+// ReaderWriterLock while the Mutex serializes them.
+HS_BENCHMARK(ReaderWriterLockThroughput) {
+    RunTable("ReaderWriterLock, 3 readers 1 writer", true);
+    RunTable("Mutex, 3 readers 1 writer", false);
+}
@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/os.hpp>
+
+#include "../harness/test.hpp"
+
+namespace {
+const size_t STRESS_WRITER_COUNT = 2;
+const size_t STRESS_READER_COUNT = 4;
+const size_t STRESS_ROUND_COUNT = 20000;
+const size_t STRESS_VALUE_COUNT = 0x10;
+const size_t WAITER_POLL_COUNT = 10000;
+
+// A thread taking the lock once and recording its turn.
+struct Contender {
+    hs::os::ReaderWriterLock *lock;
+    volatile uint32_t *turn;
+    bool is_writer;
+    volatile uint32_t acquired_turn;
+};
+
+void RunContender(void *argument) {
+    auto contender = reinterpret_cast<Contender *>(argument);
+
+    if (contender->is_writer) {
+        hs::os::AcquireWriterLock(contender->lock);
+    } else {
+        hs::os::AcquireReaderLock(contender->lock);
+    }
+
+    contender->acquired_turn = ++*contender->turn;
+
+    if (contender->is_writer) {
+        hs::os::ReleaseWriterLock(contender->lock);
+    } else {
+        hs::os::ReleaseReaderLock(contender->lock);
+    }
+}
+
+void StartContender(hs::os::Thread *thread, Contender *contender) {
+    HS_CHECK_SUCCESS(
+        hs::os::CreateThread(thread, RunContender, contender, 0x4000, 0x2C));
+    hs::os::StartThread(thread);
+}
+
+void JoinContender(hs::os::Thread *thread) {
+    hs::os::WaitThread(thread);
+    hs::os::DestroyThread(thread);
+}
+
+// Wait for the given counts of threads to block on the lock, giving up after
+// a second.
+bool WaitForWaiters(hs::os::ReaderWriterLock *lock, uint32_t reader_count,
+                    uint32_t writer_count) {
+    for (size_t i = 0; i < WAITER_POLL_COUNT; i++) {
+        lock->critical_section.Enter();
+        bool is_waiting = lock->waiting_reader_count == reader_count &&
+                          lock->waiting_writer_count == writer_count;
+        lock->critical_section.Leave();
+
+        if (is_waiting) {
+            return true;
+        }
+
+        hs::os::SleepThread(100000);
+    }
+
+    return false;
+}
+
+struct Stress {
+    hs::os::ReaderWriterLock lock;
+    uint64_t values[STRESS_VALUE_COUNT];
+    volatile uint32_t writer_count;
+    volatile uint32_t reader_count;
+    bool is_consistent[STRESS_WRITER_COUNT + STRESS_READER_COUNT];
+};
+
+// Writers update every value while readers check they never see a partial
+// update nor a writer inside the lock with them.
+void RunStressWorker(size_t index, void *argument) {
+    auto stress = reinterpret_cast<Stress *>(argument);
+    bool is_writer = index < STRESS_WRITER_COUNT;
+    bool is_consistent = true;
+
+    for (size_t round = 0; round < STRESS_ROUND_COUNT; round++) {
+        if (is_writer) {
+            hs::os::AcquireWriterLock(&stress->lock);
+
+            uint32_t writer_count =
+                __atomic_add_fetch(&stress->writer_count, 1, __ATOMIC_RELAXED);
+            is_consistent &= writer_count == 1 &&
+                             __atomic_load_n(&stress->reader_count,
+                                             __ATOMIC_RELAXED) == 0;
+
+            for (size_t i = 0; i < STRESS_VALUE_COUNT; i++) {
+                stress->values[i]++;
+            }
+
+            __atomic_sub_fetch(&stress->writer_count, 1, __ATOMIC_RELAXED);
+            hs::os::ReleaseWriterLock(&stress->lock);
+        } else {
+            hs::os::AcquireReaderLock(&stress->lock);
+            __atomic_add_fetch(&stress->reader_count, 1, __ATOMIC_RELAXED);
+
+            is_consistent &=
+                __atomic_load_n(&stress->writer_count, __ATOMIC_RELAXED) == 0;
+
+            for (size_t i = 1; i < STRESS_VALUE_COUNT; i++) {
+                is_consistent &= stress->values[i] == stress->values[0];
+            }
+
+            __atomic_sub_fetch(&stress->reader_count, 1, __ATOMIC_RELAXED);
+            hs::os::ReleaseReaderLock(&stress->lock);
+        }
+    }
+
+    stress->is_consistent[index] = is_consistent;
+}
+}  // namespace
+
+HS_TEST(ReaderWriterLockBlocksReadersWhileAWriterWaits) {
+    hs::os::ReaderWriterLock lock;
+    volatile uint32_t turn = 0;
+    hs::os::Thread writer_thread;
+    hs::os::Thread reader_thread;
+    Contender writer = {&lock, &turn, true, 0};
+    Contender reader = {&lock, &turn, false, 0};
+
+    hs::os::InitializeReaderWriterLock(&lock);
+    hs::os::AcquireReaderLock(&lock);
+
+    StartContender(&writer_thread, &writer);
+    HS_CHECK(WaitForWaiters(&lock, 0, 1));
+
+    // Readers could still share the lock with us, they wait for the writer.
+    bool is_acquired = hs::os::TryAcquireReaderLock(&lock);
+    HS_CHECK(!is_acquired);
+    if (is_acquired) {
+        hs::os::ReleaseReaderLock(&lock);
+    }
+
+    StartContender(&reader_thread, &reader);
+    HS_CHECK(WaitForWaiters(&lock, 1, 1));
+    HS_CHECK(turn == 0);
+
+    hs::os::ReleaseReaderLock(&lock);
+    JoinContender(&writer_thread);
+    JoinContender(&reader_thread);
+
+    HS_CHECK(writer.acquired_turn == 1);
+    HS_CHECK(reader.acquired_turn == 2);
+
+    hs::os::FinalizeReaderWriterLock(&lock);
+}
+
+HS_TEST(ReaderWriterLockHandsOffToTheNextWriter) {
+    hs::os::ReaderWriterLock lock;
+    volatile uint32_t turn = 0;
+    hs::os::Thread threads[3];
+    Contender contenders[3] = {
+        {&lock, &turn, false, 0},
+        {&lock, &turn, true, 0},
+        {&lock, &turn, false, 0},
+    };
+
+    hs::os::InitializeReaderWriterLock(&lock);
+    hs::os::AcquireWriterLock(&lock);
+
+    // A reader waits before the writer, the released lock still goes to the
+    // writer first.
+    StartContender(&threads[0], &contenders[0]);
+    HS_CHECK(WaitForWaiters(&lock, 1, 0));
+    StartContender(&threads[1], &contenders[1]);
+    HS_CHECK(WaitForWaiters(&lock, 1, 1));
+    StartContender(&threads[2], &contenders[2]);
+    HS_CHECK(WaitForWaiters(&lock, 2, 1));
+
+    hs::os::ReleaseWriterLock(&lock);
+
+    for (size_t i = 0; i < 3; i++) {
+        JoinContender(&threads[i]);
+    }
+
+    HS_CHECK(contenders[1].acquired_turn == 1);
+    HS_CHECK(contenders[0].acquired_turn > 1);
+    HS_CHECK(contenders[2].acquired_turn > 1);
+
+    hs::os::FinalizeReaderWriterLock(&lock);
+}
+
+HS_TEST(ReaderWriterLockStress) {
+    static Stress stress;
+
+    stress = {};
+    hs::os::InitializeReaderWriterLock(&stress.lock);
+
+    hs::test::RunWorkers(STRESS_WRITER_COUNT + STRESS_READER_COUNT,
+                         RunStressWorker, &stress);
+
+    for (size_t i = 0; i < STRESS_WRITER_COUNT + STRESS_READER_COUNT; i++) {
+        HS_CHECK(stress.is_consistent[i]);
+    }
+
+    for (size_t i = 0; i < STRESS_VALUE_COUNT; i++) {
+        HS_CHECK(stress.values[i] == STRESS_WRITER_COUNT * STRESS_ROUND_COUNT);
+    }
+
+    hs::os::FinalizeReaderWriterLock(&stress.lock);
+}
@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/os.hpp>
+#include <hs/os/os_semaphore_api.hpp>
+
+#include "../harness/test.hpp"
+#include "../host/host.hpp"
+
+namespace {
+const uint32_t WAITER_COUNT = 4;
+const uint32_t RELEASED_COUNT = 2;
+const size_t WAITER_POLL_COUNT = 10000;
+const int64_t TIMEOUT = 2000000;
+const uint32_t SEMAPHORE_WAITING_BIT = 0x80000000;
+
+const size_t PRODUCER_COUNT = 2;
+const size_t CONSUMER_COUNT = 2;
+const size_t ITEM_COUNT = 20000;
+const uint32_t QUEUE_SIZE = 8;
+
+struct Waiters {
+    hs::os::Semaphore semaphore;
+    volatile uint32_t acquired_count;
+};
+
+void RunWaiter(void *argument) {
+    auto waiters = reinterpret_cast<Waiters *>(argument);
+
+    hs::os::AcquireSemaphore(&waiters->semaphore);
+    __atomic_add_fetch(&waiters->acquired_count, 1, __ATOMIC_RELAXED);
+}
+
+// Wait for the given count of threads to block on the semaphore, giving up
+// after a second.
+bool WaitForWaiters(hs::os::Semaphore *semaphore, uint32_t waiting_count) {
+    for (size_t i = 0; i < WAITER_POLL_COUNT; i++) {
+        semaphore->critical_section.Enter();
+        bool is_waiting = semaphore->waiting_count == waiting_count;
+        semaphore->critical_section.Leave();
+
+        if (is_waiting) {
+            return true;
+        }
+
+        hs::os::SleepThread(100000);
+    }
+
+    return false;
+}
+
+bool IsWaitingBitSet(hs::os::Semaphore *semaphore) {
+    return (atomic_load(&semaphore->count) & SEMAPHORE_WAITING_BIT) != 0;
+}
+
+// A bounded queue, the semaphores count its free and used slots.
+struct Queue {
+    hs::os::Semaphore free_slots;
+    hs::os::Semaphore used_slots;
+    hs::os::Mutex mutex;
+    uint64_t items[QUEUE_SIZE];
+    uint32_t read_index;
+    uint32_t write_index;
+    uint32_t used_count;
+    bool is_overflowed;
+    uint64_t consumed_sums[CONSUMER_COUNT];
+};
+
+void RunQueueWorker(size_t index, void *argument) {
+    auto queue = reinterpret_cast<Queue *>(argument);
+
+    if (index < PRODUCER_COUNT) {
+        for (size_t i = 0; i < ITEM_COUNT; i++) {
+            hs::os::AcquireSemaphore(&queue->free_slots);
+
+            hs::os::LockMutex(&queue->mutex);
+            queue->is_overflowed |= ++queue->used_count > QUEUE_SIZE;
+            queue->items[queue->write_index] = index * ITEM_COUNT + i + 1;
+            queue->write_index = (queue->write_index + 1) % QUEUE_SIZE;
+            hs::os::UnlockMutex(&queue->mutex);
+
+            hs::os::ReleaseSemaphore(&queue->used_slots);
+        }
+
+        return;
+    }
+
+    uint64_t sum = 0;
+
+    for (size_t i = 0; i < PRODUCER_COUNT * ITEM_COUNT / CONSUMER_COUNT;
+         i++) {
+        hs::os::AcquireSemaphore(&queue->used_slots);
+
+        hs::os::LockMutex(&queue->mutex);
+        queue->used_count--;
+        sum += queue->items[queue->read_index];
+        queue->read_index = (queue->read_index + 1) % QUEUE_SIZE;
+        hs::os::UnlockMutex(&queue->mutex);
+
+        hs::os::ReleaseSemaphore(&queue->free_slots);
+    }
+
+    queue->consumed_sums[index - PRODUCER_COUNT] = sum;
+}
+}  // namespace
+
+HS_TEST(SemaphoreDoesNotAcquireAtZero) {
+    hs::os::Semaphore semaphore;
+
+    hs::os::InitializeSemaphore(&semaphore, 0, 2);
+    HS_CHECK(!hs::os::TryAcquireSemaphore(&semaphore));
+
+    hs::os::ReleaseSemaphore(&semaphore);
+    HS_CHECK(hs::os::GetSemaphoreCount(&semaphore) == 1);
+    HS_CHECK(hs::os::TryAcquireSemaphore(&semaphore));
+    HS_CHECK(!hs::os::TryAcquireSemaphore(&semaphore));
+    HS_CHECK(hs::os::GetSemaphoreCount(&semaphore) == 0);
+
+    hs::os::FinalizeSemaphore(&semaphore);
+}
+
+HS_TEST(SemaphoreTimedAcquireTimesOut) {
+    hs::os::Semaphore semaphore;
+
+    hs::os::InitializeSemaphore(&semaphore, 0, 1);
+
+    uint64_t start_time = hs::test::GetTimeNs();
+    HS_CHECK(!hs::os::TimedAcquireSemaphore(&semaphore, TIMEOUT));
+    HS_CHECK(hs::test::GetTimeNs() - start_time >= TIMEOUT);
+    HS_CHECK(!hs::os::TimedAcquireSemaphore(&semaphore, 0));
+
+    // The waiting flag went away with the last waiter, an uncontended
+    // release doesn't wake anyone.
+    HS_CHECK(!IsWaitingBitSet(&semaphore));
+    hs::test::ResetSvcCallCounts();
+    hs::os::ReleaseSemaphore(&semaphore);
+    HS_CHECK(hs::test::GetSvcCallCount(
+                 hs::test::SVC_ID_SIGNAL_PROCESS_WIDE_KEY) == 0);
+
+    HS_CHECK(hs::os::TimedAcquireSemaphore(&semaphore, TIMEOUT));
+
+    hs::os::FinalizeSemaphore(&semaphore);
+}
+
+HS_TEST(SemaphoreReleaseWakesAsManyWaiters) {
+    static Waiters waiters;
+    hs::os::Thread threads[WAITER_COUNT];
+
+    waiters = {};
+    hs::os::InitializeSemaphore(&waiters.semaphore, 0, WAITER_COUNT);
+
+    for (uint32_t i = 0; i < WAITER_COUNT; i++) {
+        HS_CHECK_SUCCESS(hs::os::CreateThread(&threads[i], RunWaiter,
+                                              &waiters, 0x4000, 0x2C));
+        hs::os::StartThread(&threads[i]);
+    }
+
+    HS_CHECK(WaitForWaiters(&waiters.semaphore, WAITER_COUNT));
+    HS_CHECK(IsWaitingBitSet(&waiters.semaphore));
+
+    hs::os::ReleaseSemaphore(&waiters.semaphore, RELEASED_COUNT);
+    HS_CHECK(WaitForWaiters(&waiters.semaphore, WAITER_COUNT - RELEASED_COUNT));
+
+    // Leave the other waiters a chance to take a unit they weren't given.
+    hs::os::SleepThread(TIMEOUT);
+    HS_CHECK(waiters.acquired_count == RELEASED_COUNT);
+    HS_CHECK(hs::os::GetSemaphoreCount(&waiters.semaphore) == 0);
+
+    hs::os::ReleaseSemaphore(&waiters.semaphore,
+                             WAITER_COUNT - RELEASED_COUNT);
+
+    for (uint32_t i = 0; i < WAITER_COUNT; i++) {
+        hs::os::WaitThread(&threads[i]);
+        hs::os::DestroyThread(&threads[i]);
+    }
+
+    HS_CHECK(waiters.acquired_count == WAITER_COUNT);
+
+    // Once the last waiter left, releases don't take the slow path.
+    HS_CHECK(!IsWaitingBitSet(&waiters.semaphore));
+    hs::test::ResetSvcCallCounts();
+    hs::os::ReleaseSemaphore(&waiters.semaphore);
+    HS_CHECK(hs::test::GetSvcCallCount(
+                 hs::test::SVC_ID_SIGNAL_PROCESS_WIDE_KEY) == 0);
+    HS_CHECK(hs::os::TryAcquireSemaphore(&waiters.semaphore));
+
+    hs::os::FinalizeSemaphore(&waiters.semaphore);
+}
+
+HS_TEST(SemaphoreProducerConsumerStress) {
+    static Queue queue;
+
+    queue = {};
+    hs::os::InitializeSemaphore(&queue.free_slots, QUEUE_SIZE, QUEUE_SIZE);
+    hs::os::InitializeSemaphore(&queue.used_slots, 0, QUEUE_SIZE);
+    hs::os::InitializeMutex(&queue.mutex, false);
+
+    hs::test::RunWorkers(PRODUCER_COUNT + CONSUMER_COUNT, RunQueueWorker,
+                         &queue);
+
+    uint64_t sum = 0;
+    for (size_t i = 0; i < CONSUMER_COUNT; i++) {
+        sum += queue.consumed_sums[i];
+    }
+
+    uint64_t item_count = PRODUCER_COUNT * ITEM_COUNT;
+    HS_CHECK(!queue.is_overflowed);
+    HS_CHECK(sum == item_count * (item_count + 1) / 2);
+    HS_CHECK(hs::os::GetSemaphoreCount(&queue.free_slots) == QUEUE_SIZE);
+    HS_CHECK(hs::os::GetSemaphoreCount(&queue.used_slots) == 0);
+
+    hs::os::FinalizeMutex(&queue.mutex);
+    hs::os::FinalizeSemaphore(&queue.used_slots);
+    hs::os::FinalizeSemaphore(&queue.free_slots);
+}
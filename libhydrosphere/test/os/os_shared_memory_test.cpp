@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <string.h>
+
+#include <hs/os/os_memory_map_api.hpp>
+#include <hs/os/os_shared_memory_api.hpp>
+#include <hs/svc.hpp>
+
+#include "../harness/test.hpp"
+
+namespace {
+const size_t SHARED_MEMORY_SIZE = 0x3000;
+const hs::svc::MemoryPermission READ_WRITE =
+    hs::svc::MemoryPermission::Read | hs::svc::MemoryPermission::Write;
+
+// The memory map must agree with the kernel after every transition.
+void CheckRegion(const void *address, hs::svc::MemoryType type,
+                 hs::svc::MemoryPermission permission) {
+    hs::os::MemoryRegion region;
+    hs::svc::MemoryInfo memory_info;
+    uint32_t page_info;
+
+    HS_CHECK(hs::os::QueryMemoryMap(&region,
+                                    reinterpret_cast<uintptr_t>(address)));
+    HS_CHECK(region.type == type);
+    HS_CHECK(region.permission == permission);
+
+    HS_CHECK_SUCCESS(hs::svc::QueryMemory(
+        &memory_info, &page_info, reinterpret_cast<uintptr_t>(address)));
+    HS_CHECK(memory_info.type == static_cast<uint32_t>(type));
+    HS_CHECK(memory_info.permission == static_cast<uint32_t>(permission));
+}
+}  // namespace
+
+HS_TEST(SharedMemoryLifecycle) {
+    hs::os::SharedMemory shared_memory;
+
+    HS_CHECK_SUCCESS(hs::os::CreateSharedMemory(
+        &shared_memory, SHARED_MEMORY_SIZE, READ_WRITE,
+        hs::svc::MemoryPermission::Read));
+    HS_CHECK(hs::os::GetSharedMemoryAddress(&shared_memory) == nullptr);
+
+    void *address;
+    HS_CHECK_SUCCESS(hs::os::MapSharedMemory(&shared_memory, &address));
+    HS_CHECK(hs::os::GetSharedMemoryAddress(&shared_memory) == address);
+    CheckRegion(address, hs::svc::MemoryType::Shared, READ_WRITE);
+    memset(address, 0x5A, SHARED_MEMORY_SIZE);
+
+    // A second view of the same memory, as another process would load it.
+    hs::os::SharedMemory view;
+    hs::os::LoadSharedMemory(&view,
+                             hs::os::GetSharedMemoryHandle(&shared_memory),
+                             SHARED_MEMORY_SIZE,
+                             hs::svc::MemoryPermission::Read, false);
+
+    void *view_address;
+    HS_CHECK_SUCCESS(hs::os::MapSharedMemory(&view, &view_address));
+    HS_CHECK(view_address != address);
+    CheckRegion(view_address, hs::svc::MemoryType::Shared,
+                hs::svc::MemoryPermission::Read);
+
+    auto bytes = reinterpret_cast<const uint8_t *>(view_address);
+    HS_CHECK(bytes[0] == 0x5A && bytes[SHARED_MEMORY_SIZE - 1] == 0x5A);
+
+    // The view doesn't own the handle, destroying it leaves the memory
+    // usable.
+    hs::os::DestroySharedMemory(&view);
+    CheckRegion(view_address, hs::svc::MemoryType::Free,
+                hs::svc::MemoryPermission::None);
+
+    hs::os::UnmapSharedMemory(&shared_memory);
+    HS_CHECK(hs::os::GetSharedMemoryAddress(&shared_memory) == nullptr);
+    CheckRegion(address, hs::svc::MemoryType::Free,
+                hs::svc::MemoryPermission::None);
+
+    // Mapping again shows the same content.
+    HS_CHECK_SUCCESS(hs::os::MapSharedMemory(&shared_memory, &address));
+    CheckRegion(address, hs::svc::MemoryType::Shared, READ_WRITE);
+    HS_CHECK(reinterpret_cast<const uint8_t *>(address)[0x1000] == 0x5A);
+
+    // Destroying a mapped object unmaps it and closes its handle.
+    hs::svc::Handle handle = hs::os::GetSharedMemoryHandle(&shared_memory);
+    hs::os::DestroySharedMemory(&shared_memory);
+    CheckRegion(address, hs::svc::MemoryType::Free,
+                hs::svc::MemoryPermission::None);
+    HS_CHECK_RESULT(hs::svc::CloseHandle(handle), 0xE401);
+}
+
+HS_TEST(SharedMemoryMappingIsLimitedByTheOwnerPermission) {
+    hs::os::SharedMemory shared_memory;
+
+    HS_CHECK_SUCCESS(hs::os::CreateSharedMemory(
+        &shared_memory, SHARED_MEMORY_SIZE, hs::svc::MemoryPermission::Read,
+        hs::svc::MemoryPermission::Read));
+
+    // The failed mapping gives its reservation back.
+    void *address = nullptr;
+    shared_memory.permission = READ_WRITE;
+    HS_CHECK(hs::os::MapSharedMemory(&shared_memory, &address).Err());
+    HS_CHECK(address == nullptr);
+    HS_CHECK(hs::os::GetSharedMemoryAddress(&shared_memory) == nullptr);
+
+    shared_memory.permission = hs::svc::MemoryPermission::Read;
+    HS_CHECK_SUCCESS(hs::os::MapSharedMemory(&shared_memory, &address));
+    CheckRegion(address, hs::svc::MemoryType::Shared,
+                hs::svc::MemoryPermission::Read);
+
+    hs::os::DestroySharedMemory(&shared_memory);
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/mem.hpp>
+#include <hs/os.hpp>
+
+#include "../harness/test.hpp"
+#include "../host/host.hpp"
+
+namespace {
+const size_t CYCLE_COUNT = 2000;
+const size_t STACK_SIZE = 0x10000;
+const size_t STACK_COUNT = 4;
+
+void DoNothing(void *argument) {}
+
+// Create, run and destroy threads one after the other, rotating over a few
+// stacks like a pool of short lived workers would.
+void RunThreadChurn(const char *name, void **stacks) {
+    hs::test::ResetSvcCallCounts();
+
+    uint64_t start_time = hs::test::GetTimeNs();
+
+    for (size_t i = 0; i < CYCLE_COUNT; i++) {
+        hs::os::Thread thread;
+        hs::Result result =
+            stacks != nullptr
+                ? hs::os::CreateThread(&thread, DoNothing, nullptr,
+                                       stacks[i % STACK_COUNT], STACK_SIZE,
+                                       0x2C)
+                : hs::os::CreateThread(&thread, DoNothing, nullptr,
+                                       STACK_SIZE, 0x2C);
+        HS_CHECK_SUCCESS(result);
+
+        hs::os::StartThread(&thread);
+        hs::os::WaitThread(&thread);
+        hs::os::DestroyThread(&thread);
+    }
+
+    uint64_t duration = hs::test::GetTimeNs() - start_time;
+
+    hs::test::ReportThroughput(name, CYCLE_COUNT, duration);
+    hs::test::ReportValue(
+        "  MapMemory",
+        hs::test::GetSvcCallCount(hs::test::SVC_ID_MAP_MEMORY), "calls");
+    hs::test::ReportValue(
+        "  UnmapMemory",
+        hs::test::GetSvcCallCount(hs::test::SVC_ID_UNMAP_MEMORY), "calls");
+}
+}  // namespace
+
+HS_BENCHMARK(ThreadCreateDestroy) {
+    void *stacks[STACK_COUNT];
+
+    for (size_t i = 0; i < STACK_COUNT; i++) {
+        stacks[i] = hs::mem::AllocateAligned(STACK_SIZE, 0x1000);
+        HS_CHECK(stacks[i] != nullptr);
+    }
+
+    RunThreadChurn("heap owned stacks", nullptr);
+
+    hs::os::SetThreadStackCacheCapacity(0);
+    RunThreadChurn("caller stacks, no stack cache", stacks);
+
+    hs::os::SetThreadStackCacheCapacity(STACK_COUNT);
+    RunThreadChurn("caller stacks, stack cache", stacks);
+
+    // Give the stacks back before freeing them.
+    hs::os::SetThreadStackCacheCapacity(0);
+    hs::os::TrimThreadStackCache();
+
+    for (size_t i = 0; i < STACK_COUNT; i++) {
+        hs::mem::Free(stacks[i]);
+    }
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/os.hpp>
+#include <os/detail/os_threadlist.hpp>
+
+#include "../harness/test.hpp"
+#include "../host/host.hpp"
+
+namespace {
+struct CounterArgument {
+    hs::os::Mutex mutex;
+    uint32_t value;
+};
+
+void IncrementCounter(size_t index, void *argument) {
+    auto counter = reinterpret_cast<CounterArgument *>(argument);
+
+    // Yield with the mutex held so the other workers contend on it.
+    for (size_t i = 0; i < 2000; i++) {
+        hs::os::LockMutex(&counter->mutex);
+        uint32_t value = counter->value;
+        hs::os::YieldThread();
+        counter->value = value + 1;
+        hs::os::UnlockMutex(&counter->mutex);
+    }
+}
+
+const size_t TOUCHED_STACK_SIZE = 0x2000;
+
+// Write every byte of a frame of a known size.
+__attribute__((noinline)) void TouchStack(void *argument) {
+    volatile uint8_t frame[TOUCHED_STACK_SIZE];
+
+    for (size_t i = 0; i < TOUCHED_STACK_SIZE; i++) {
+        frame[i] = static_cast<uint8_t>(i);
+    }
+
+    HS_CHECK(frame[TOUCHED_STACK_SIZE - 1] ==
+             static_cast<uint8_t>(TOUCHED_STACK_SIZE - 1));
+}
+
+void StoreThreadValue(void *argument) {
+    *reinterpret_cast<uint32_t *>(argument) = 0xCAFE;
+}
+
+bool IsInThreadList(hs::os::Thread *thread) {
+    auto &thread_list = hs::os::detail::ThreadList::Get();
+    bool is_found = false;
+
+    for (auto &listed_thread : thread_list.Aquire()) {
+        if (&listed_thread == thread) {
+            is_found = true;
+        }
+    }
+
+    thread_list.Release();
+    return is_found;
+}
+}  // namespace
+
+HS_TEST(ThreadRunsOnItsOwnedStack) {
+    hs::os::Thread thread;
+    uint32_t value = 0;
+
+    hs::Result result =
+        hs::os::CreateThread(&thread, StoreThreadValue, &value, 0x4000, 0x2C);
+    HS_CHECK_SUCCESS(result);
+
+    hs::os::StartThread(&thread);
+    hs::os::WaitThread(&thread);
+    HS_CHECK(thread.state == hs::os::ThreadState::Exited);
+    HS_CHECK(value == 0xCAFE);
+
+    hs::os::DestroyThread(&thread);
+    HS_CHECK(thread.state == hs::os::ThreadState::Uninitialized);
+}
+
+HS_TEST(MutexSerializesWorkers) {
+    CounterArgument counter;
+
+    hs::os::InitializeMutex(&counter.mutex, false);
+    counter.value = 0;
+
+    hs::test::RunWorkers(4, IncrementCounter, &counter);
+    HS_CHECK(counter.value == 8000);
+
+    hs::os::FinalizeMutex(&counter.mutex);
+}
+
+HS_TEST(FailedThreadCreationCleansUp) {
+    hs::os::Thread thread;
+    uint32_t value = 0;
+
+    // The mirror of an owned stack must be unmapped and not cached, the
+    // stack is freed right away.
+    hs::os::SetThreadStackCacheCapacity(1);
+    hs::test::SetHostThreadLimit(0);
+    hs::test::ResetSvcCallCounts();
+
+    hs::Result result =
+        hs::os::CreateThread(&thread, StoreThreadValue, &value, 0x4000, 0x2C);
+    HS_CHECK_RESULT(result, 0x1203);
+    HS_CHECK(thread.state == hs::os::ThreadState::Uninitialized);
+    HS_CHECK(hs::test::GetSvcCallCount(hs::test::SVC_ID_MAP_MEMORY) == 1);
+    HS_CHECK(hs::test::GetSvcCallCount(hs::test::SVC_ID_UNMAP_MEMORY) == 1);
+    HS_CHECK(!IsInThreadList(&thread));
+
+    hs::test::SetHostThreadLimit(UINT32_MAX);
+
+    // Nothing was left behind, the thread can be created again.
+    result =
+        hs::os::CreateThread(&thread, StoreThreadValue, &value, 0x4000, 0x2C);
+    HS_CHECK_SUCCESS(result);
+    HS_CHECK(IsInThreadList(&thread));
+
+    hs::os::StartThread(&thread);
+    hs::os::WaitThread(&thread);
+    HS_CHECK(value == 0xCAFE);
+
+    hs::os::DestroyThread(&thread);
+    HS_CHECK(!IsInThreadList(&thread));
+
+    hs::os::SetThreadStackCacheCapacity(0);
+    hs::os::TrimThreadStackCache();
+}
+
+HS_TEST(ThreadStackUsageIsTracked) {
+    const size_t stack_size = 0x8000;
+    hs::os::Thread thread;
+
+    hs::os::SetThreadStackUsageTracking(true);
+
+    hs::Result result =
+        hs::os::CreateThread(&thread, TouchStack, nullptr, stack_size, 0x2C);
+    HS_CHECK_SUCCESS(result);
+
+    hs::os::SetThreadStackUsageTracking(false);
+
+    hs::os::StartThread(&thread);
+    hs::os::WaitThread(&thread);
+
+    size_t usage = hs::os::GetThreadStackUsage(&thread);
+    HS_CHECK(usage >= TOUCHED_STACK_SIZE && usage <= stack_size);
+
+    // The usage recorded when the stack is unmapped stays available.
+    hs::os::DestroyThread(&thread);
+    HS_CHECK(hs::os::GetThreadStackUsage(&thread) == usage);
+
+    // Threads created with the tracking disabled don't report any usage.
+    result =
+        hs::os::CreateThread(&thread, TouchStack, nullptr, stack_size, 0x2C);
+    HS_CHECK_SUCCESS(result);
+
+    hs::os::StartThread(&thread);
+    hs::os::WaitThread(&thread);
+    HS_CHECK(hs::os::GetThreadStackUsage(&thread) == 0);
+
+    hs::os::DestroyThread(&thread);
+}
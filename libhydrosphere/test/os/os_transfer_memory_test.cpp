@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <string.h>
+
+#include <hs/mem.hpp>
+#include <hs/os/os_memory_map_api.hpp>
+#include <hs/os/os_transfer_memory_api.hpp>
+#include <hs/svc.hpp>
+
+#include "../harness/test.hpp"
+
+namespace {
+const size_t BUFFER_SIZE = 0x4000;
+const hs::svc::MemoryPermission READ_WRITE =
+    hs::svc::MemoryPermission::Read | hs::svc::MemoryPermission::Write;
+
+// The memory map must agree with the kernel after every transition.
+void CheckRegion(const void *address, hs::svc::MemoryType type,
+                 uint32_t attribute, hs::svc::MemoryPermission permission) {
+    hs::os::MemoryRegion region;
+    hs::svc::MemoryInfo memory_info;
+    uint32_t page_info;
+
+    HS_CHECK(hs::os::QueryMemoryMap(&region,
+                                    reinterpret_cast<uintptr_t>(address)));
+    HS_CHECK(region.type == type);
+    HS_CHECK(region.attribute == attribute);
+    HS_CHECK(region.permission == permission);
+
+    HS_CHECK_SUCCESS(hs::svc::QueryMemory(
+        &memory_info, &page_info, reinterpret_cast<uintptr_t>(address)));
+    HS_CHECK(memory_info.type == static_cast<uint32_t>(type));
+    HS_CHECK(memory_info.attribute == attribute);
+    HS_CHECK(memory_info.permission == static_cast<uint32_t>(permission));
+}
+
+void TransferBuffer(hs::svc::MemoryPermission permission,
+                    hs::svc::MemoryType mapped_type) {
+    const uint32_t locked =
+        static_cast<uint32_t>(hs::svc::MemoryAttribute::Locked);
+    auto buffer = reinterpret_cast<uint8_t *>(
+        hs::mem::AllocateAligned(BUFFER_SIZE, 0x1000));
+    HS_CHECK(buffer != nullptr);
+    if (buffer == nullptr) {
+        return;
+    }
+
+    memset(buffer, 0x3C, BUFFER_SIZE);
+
+    hs::os::TransferMemory transfer_memory;
+    HS_CHECK_SUCCESS(hs::os::CreateTransferMemory(&transfer_memory, buffer,
+                                                  BUFFER_SIZE, permission));
+
+    // The buffer is locked with the permission left to this process.
+    CheckRegion(buffer, hs::svc::MemoryType::Normal, locked, permission);
+
+    void *address;
+    HS_CHECK_SUCCESS(hs::os::MapTransferMemory(&transfer_memory, &address));
+    HS_CHECK(hs::os::GetTransferMemoryAddress(&transfer_memory) == address);
+    CheckRegion(address, mapped_type, 0, READ_WRITE);
+
+    // The mapping is the buffer itself.
+    auto mapping = reinterpret_cast<uint8_t *>(address);
+    HS_CHECK(mapping[0] == 0x3C && mapping[BUFFER_SIZE - 1] == 0x3C);
+    mapping[0x2000] = 0xC3;
+
+    hs::os::UnmapTransferMemory(&transfer_memory);
+    HS_CHECK(hs::os::GetTransferMemoryAddress(&transfer_memory) == nullptr);
+    CheckRegion(address, hs::svc::MemoryType::Free, 0,
+                hs::svc::MemoryPermission::None);
+    CheckRegion(buffer, hs::svc::MemoryType::Normal, locked, permission);
+
+    // Destroying the last handle gives the buffer back.
+    hs::os::DestroyTransferMemory(&transfer_memory);
+    CheckRegion(buffer, hs::svc::MemoryType::Normal, 0, READ_WRITE);
+    HS_CHECK(buffer[0x2000] == 0xC3);
+
+    hs::mem::Free(buffer);
+}
+}  // namespace
+
+HS_TEST(TransferMemoryLifecycle) {
+    TransferBuffer(hs::svc::MemoryPermission::None,
+                   hs::svc::MemoryType::Transfered);
+    TransferBuffer(hs::svc::MemoryPermission::Read,
+                   hs::svc::MemoryType::SharedTransfered);
+}
+
+HS_TEST(TransferMemoryDestroyUnmaps) {
+    auto buffer = hs::mem::AllocateAligned(BUFFER_SIZE, 0x1000);
+    HS_CHECK(buffer != nullptr);
+
+    hs::os::TransferMemory transfer_memory;
+    HS_CHECK_SUCCESS(hs::os::CreateTransferMemory(
+        &transfer_memory, buffer, BUFFER_SIZE,
+        hs::svc::MemoryPermission::None));
+
+    void *address;
+    HS_CHECK_SUCCESS(hs::os::MapTransferMemory(&transfer_memory, &address));
+
+    hs::os::DestroyTransferMemory(&transfer_memory);
+    CheckRegion(address, hs::svc::MemoryType::Free, 0,
+                hs::svc::MemoryPermission::None);
+    CheckRegion(buffer, hs::svc::MemoryType::Normal, 0, READ_WRITE);
+
+    hs::mem::Free(buffer);
+}
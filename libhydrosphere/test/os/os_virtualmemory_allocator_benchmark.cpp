@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/mem.hpp>
+#include <os/detail/os_memory_map.hpp>
+#include <os/detail/os_virtualmemory_allocator.hpp>
+
+#include "../harness/test.hpp"
+
+namespace {
+const size_t BUFFER_SIZE = 0x10000000;
+const size_t LINE_SIZE = 0x40;
+const size_t LINE_COUNT = BUFFER_SIZE / LINE_SIZE;
+const size_t ACCESS_COUNT = 0x400000;
+
+// Link every cache line of the buffer in a single random cycle (Sattolo's
+// shuffle), so each load depends on the previous one and the accesses can't
+// be predicted.
+void BuildRandomCycle(uint8_t *buffer) {
+    hs::test::Random random(0x11);
+
+    for (size_t i = 0; i < LINE_COUNT; i++) {
+        *reinterpret_cast<uint32_t *>(buffer + i * LINE_SIZE) =
+            static_cast<uint32_t>(i);
+    }
+
+    for (size_t i = LINE_COUNT - 1; i > 0; i--) {
+        size_t j = random.Next(i);
+        auto a = reinterpret_cast<uint32_t *>(buffer + i * LINE_SIZE);
+        auto b = reinterpret_cast<uint32_t *>(buffer + j * LINE_SIZE);
+        uint32_t value = *a;
+
+        *a = *b;
+        *b = value;
+    }
+}
+
+void ChaseLines(const char *name, const uint8_t *buffer) {
+    uint32_t line = 0;
+    uint64_t start_time = hs::test::GetTimeNs();
+
+    for (size_t i = 0; i < ACCESS_COUNT; i++) {
+        line = *reinterpret_cast<const volatile uint32_t *>(
+            buffer + static_cast<size_t>(line) * LINE_SIZE);
+    }
+
+    hs::test::ReportThroughput(name, ACCESS_COUNT,
+                               hs::test::GetTimeNs() - start_time);
+    HS_CHECK(line < LINE_COUNT);
+}
+}  // namespace
+
+// Random loads over 256MiB of heap starting on a large block boundary, then
+// over an alias of the same memory placed one page past a large block
+// boundary, which the kernel can only map with pages.
+//
+// The host stand-in backs both with pages unless transparent huge pages are
+// enabled for shared memory, the difference only shows on the console.
+HS_BENCHMARK(LargeBlockRandomAccess) {
+    const size_t large_block_size = hs::os::detail::LARGE_BLOCK_SIZE;
+
+    // The heap block itself starts after its span header.
+    void *block = hs::mem::Allocate(BUFFER_SIZE + large_block_size);
+    HS_CHECK(block != nullptr);
+    if (block == nullptr) {
+        return;
+    }
+
+    uintptr_t buffer =
+        (reinterpret_cast<uintptr_t>(block) + large_block_size - 1) &
+        ~(large_block_size - 1);
+
+    BuildRandomCycle(reinterpret_cast<uint8_t *>(buffer));
+    ChaseLines("large block aligned", reinterpret_cast<uint8_t *>(buffer));
+
+    auto reservation = reinterpret_cast<uintptr_t>(
+        hs::os::detail::g_StackAllocator->Reserve(
+            BUFFER_SIZE + large_block_size, large_block_size));
+    HS_CHECK(reservation != 0);
+
+    if (reservation != 0) {
+        uintptr_t alias = reservation + 0x1000;
+
+        hs::Result result =
+            hs::os::detail::MapMemory(alias, buffer, BUFFER_SIZE);
+        HS_CHECK_SUCCESS(result);
+
+        if (result.Ok()) {
+            ChaseLines("page aligned", reinterpret_cast<uint8_t *>(alias));
+
+            result = hs::os::detail::UnmapMemory(alias, buffer, BUFFER_SIZE);
+            HS_CHECK_SUCCESS(result);
+        }
+
+        hs::os::detail::g_StackAllocator->Free(
+            reinterpret_cast<void *>(reservation));
+    }
+
+    hs::mem::Free(block);
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <os/detail/os_virtualmemory_allocator.hpp>
+
+#include "../harness/test.hpp"
+#include "../host/host.hpp"
+
+namespace {
+const size_t REGION_SIZE = 0x40000000;
+const size_t GUARD_SIZE = 0x1000;
+const size_t CYCLE_COUNT = 100000;
+const size_t SLOT_COUNT = 256;
+const size_t MAXIMUM_PAGE_COUNT = 64;
+
+const size_t ALIGNMENTS[] = {0x1000, 0x4000, 0x10000,
+                             hs::os::detail::LARGE_BLOCK_SIZE};
+
+struct Reservation {
+    uintptr_t address;
+    size_t size;
+};
+
+bool Overlaps(const Reservation &a, const Reservation &b) {
+    // The guard pages in front of a reservation are not handed out either.
+    return a.address - GUARD_SIZE < b.address + b.size &&
+           b.address - GUARD_SIZE < a.address + a.size;
+}
+}  // namespace
+
+// Run the allocator over a region of its own, carved out of the general
+// address space allocator, so the stress doesn't depend on what the library
+// reserved so far.
+HS_TEST(VirtualMemoryAllocatorStress) {
+    auto region = reinterpret_cast<uintptr_t>(
+        hs::os::detail::g_AddressSpaceAllocator->Reserve(
+            REGION_SIZE, hs::os::detail::LARGE_BLOCK_SIZE));
+    HS_CHECK(region != 0);
+    if (region == 0) {
+        return;
+    }
+
+    hs::os::detail::VirtualMemoryAllocator allocator(
+        region, region + REGION_SIZE, GUARD_SIZE);
+    allocator.Initialize();
+
+    static Reservation reservations[SLOT_COUNT];
+    static hs::test::LatencyHistogram histogram;
+    hs::test::Random random(0x400);
+    size_t live_count = 0;
+
+    hs::test::ResetSvcCallCounts();
+
+    // Each cycle reserves a range, which is freed when its slot is picked
+    // again.
+    for (size_t cycle = 0; cycle < CYCLE_COUNT;) {
+        Reservation &slot = reservations[random.Next(SLOT_COUNT)];
+
+        if (slot.address != 0) {
+            allocator.Free(reinterpret_cast<void *>(slot.address));
+            slot.address = 0;
+            live_count--;
+            continue;
+        }
+
+        cycle++;
+
+        size_t size = (random.Next(MAXIMUM_PAGE_COUNT) + 1) * 0x1000;
+        size_t alignment = ALIGNMENTS[random.Next(4)];
+
+        uint64_t start_time = hs::test::GetTimeNs();
+        auto address =
+            reinterpret_cast<uintptr_t>(allocator.Reserve(size, alignment));
+        histogram.Record(hs::test::GetTimeNs() - start_time);
+
+        HS_CHECK(address != 0);
+        if (address == 0) {
+            continue;
+        }
+
+        HS_CHECK((address & (alignment - 1)) == 0);
+        HS_CHECK(address - GUARD_SIZE >= region);
+        HS_CHECK(address + size <= region + REGION_SIZE);
+
+        slot = {address, size};
+        live_count++;
+
+        for (size_t i = 0; i < SLOT_COUNT; i++) {
+            if (&reservations[i] != &slot && reservations[i].address != 0) {
+                HS_CHECK(!Overlaps(reservations[i], slot));
+            }
+        }
+    }
+
+    // The free ranges are tracked by the allocator, no memory query needed.
+    HS_CHECK(hs::test::GetSvcCallCount(hs::test::SVC_ID_QUERY_MEMORY) == 0);
+
+    for (size_t i = 0; i < SLOT_COUNT; i++) {
+        if (reservations[i].address != 0) {
+            allocator.Free(reinterpret_cast<void *>(reservations[i].address));
+            reservations[i].address = 0;
+            live_count--;
+        }
+    }
+    HS_CHECK(live_count == 0);
+
+    // Everything was given back and coalesced, the whole region fits again.
+    void *whole = allocator.Reserve(REGION_SIZE - GUARD_SIZE, 0x1000);
+    HS_CHECK(reinterpret_cast<uintptr_t>(whole) == region + GUARD_SIZE);
+    allocator.Free(whole);
+
+    histogram.Print("reservation latency");
+
+    hs::os::detail::g_AddressSpaceAllocator->Free(
+        reinterpret_cast<void *>(region));
+}
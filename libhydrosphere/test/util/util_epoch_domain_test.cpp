@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/os.hpp>
+#include <hs/os/os_tls.hpp>
+#include <hs/util/util_epoch_domain.hpp>
+#include <hs/util/util_std_new.hpp>
+#include <util/detail/util_epoch_record.hpp>
+
+#include "../harness/test.hpp"
+
+namespace {
+const uint32_t NODE_ALIVE = 0xA11FE;
+const uint32_t NODE_RECLAIMED = 0xDEAD;
+const size_t WRITER_COUNT = 2;
+const size_t READER_COUNT = 2;
+const size_t REPLACE_COUNT = 20000;
+
+struct Node {
+    hs::util::EpochRetiredObject link;
+    volatile uint32_t state;
+};
+
+void ReclaimNode(hs::util::EpochRetiredObject *object) {
+    reinterpret_cast<Node *>(object)->state = NODE_RECLAIMED;
+}
+
+// A thread staying in a domain until told to leave, then idling until told
+// to exit.
+struct Pinner {
+    hs::util::EpochDomain *domain;
+    Node *retired_node;
+    volatile uint32_t step;
+    volatile uint32_t reached_step;
+};
+
+void WaitStep(volatile uint32_t *step, uint32_t value) {
+    while (*step < value) {
+        hs::os::SleepThread(100000);
+    }
+}
+
+void RunPinner(void *argument) {
+    auto pinner = reinterpret_cast<Pinner *>(argument);
+
+    pinner->domain->Enter();
+    pinner->reached_step = 1;
+    WaitStep(&pinner->step, 1);
+
+    pinner->domain->Leave();
+
+    if (pinner->retired_node != nullptr) {
+        pinner->domain->Retire(&pinner->retired_node->link, ReclaimNode);
+    }
+
+    pinner->reached_step = 2;
+    WaitStep(&pinner->step, 2);
+}
+
+void StartPinner(hs::os::Thread *thread, Pinner *pinner) {
+    HS_CHECK_SUCCESS(
+        hs::os::CreateThread(thread, RunPinner, pinner, 0x4000, 0x2C));
+    hs::os::StartThread(thread);
+    WaitStep(&pinner->reached_step, 1);
+}
+
+bool HasRecord(hs::os::Thread *thread, hs::util::EpochDomain *domain) {
+    auto record = reinterpret_cast<hs::util::detail::EpochRecord *>(
+        thread->epoch_records);
+
+    for (; record != nullptr; record = record->next) {
+        if (record->domain == domain) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+hs::os::Thread *GetCurrentThread() {
+    return hs::os::ThreadLocalStorage::GetThreadLocalStorage()
+        ->GetThreadContext();
+}
+
+struct Stress {
+    hs::util::EpochDomain domain;
+    Node nodes[WRITER_COUNT * REPLACE_COUNT + 1];
+    volatile _Atomic(size_t) node_count;
+    Node *volatile current;
+    volatile _Atomic(size_t) done_writer_count;
+    volatile _Atomic(size_t) reclaimed_count;
+    volatile bool has_seen_reclaimed;
+};
+
+Stress *g_Stress;
+
+void ReclaimStressNode(hs::util::EpochRetiredObject *object) {
+    reinterpret_cast<Node *>(object)->state = NODE_RECLAIMED;
+    atomic_fetch_add(&g_Stress->reclaimed_count, 1);
+}
+
+// Writers replace the current node and retire the old one, readers check the
+// node they reach is never reclaimed while they are inside the domain.
+void RunStressWorker(size_t index, void *argument) {
+    auto stress = reinterpret_cast<Stress *>(argument);
+
+    if (index < WRITER_COUNT) {
+        for (size_t i = 0; i < REPLACE_COUNT; i++) {
+            Node *node = &stress->nodes[atomic_fetch_add(&stress->node_count,
+                                                         1)];
+            node->state = NODE_ALIVE;
+
+            Node *previous =
+                __atomic_exchange_n(&stress->current, node, __ATOMIC_SEQ_CST);
+            stress->domain.Retire(&previous->link, ReclaimStressNode);
+        }
+
+        stress->domain.Synchronize();
+        atomic_fetch_add(&stress->done_writer_count, 1);
+        return;
+    }
+
+    while (atomic_load(&stress->done_writer_count) < WRITER_COUNT) {
+        hs::util::EpochGuard guard(stress->domain);
+        Node *node = __atomic_load_n(&stress->current, __ATOMIC_SEQ_CST);
+
+        for (size_t i = 0; i < 0x10; i++) {
+            if (node->state != NODE_ALIVE) {
+                stress->has_seen_reclaimed = true;
+            }
+        }
+    }
+}
+}  // namespace
+
+HS_TEST(EpochDomainWaitsForPinnedThreads) {
+    hs::util::EpochDomain domain;
+    hs::os::Thread thread;
+    Pinner pinner = {&domain, nullptr, 0, 0};
+    Node node = {{}, NODE_ALIVE};
+
+    StartPinner(&thread, &pinner);
+
+    // The pinned thread saw the epoch of the object, the epoch can move once.
+    domain.Retire(&node.link, ReclaimNode);
+    HS_CHECK(domain.TryAdvance());
+
+    for (size_t i = 0; i < 10; i++) {
+        HS_CHECK(!domain.TryAdvance());
+    }
+    HS_CHECK(node.state == NODE_ALIVE);
+
+    // Once it left, the second advance reclaims the object.
+    pinner.step = 1;
+    WaitStep(&pinner.reached_step, 2);
+
+    HS_CHECK(domain.TryAdvance());
+    HS_CHECK(node.state == NODE_RECLAIMED);
+
+    pinner.step = 2;
+    hs::os::WaitThread(&thread);
+    hs::os::DestroyThread(&thread);
+}
+
+HS_TEST(EpochDomainAdoptsObjectsOfExitedThreads) {
+    hs::util::EpochDomain domain;
+    hs::os::Thread thread;
+    Node node = {{}, NODE_ALIVE};
+    Pinner pinner = {&domain, &node, 1, 0};
+
+    StartPinner(&thread, &pinner);
+    pinner.step = 2;
+    hs::os::WaitThread(&thread);
+    hs::os::DestroyThread(&thread);
+
+    // The exited thread can't reclaim its object, the domain does it once
+    // two advances happened.
+    HS_CHECK(node.state == NODE_ALIVE);
+    HS_CHECK(domain.TryAdvance());
+    HS_CHECK(node.state == NODE_ALIVE);
+    HS_CHECK(domain.TryAdvance());
+    HS_CHECK(node.state == NODE_RECLAIMED);
+}
+
+HS_TEST(EpochDomainDestructionUnlinksTheRecords) {
+    static uint8_t storage[sizeof(hs::util::EpochDomain)];
+    auto domain = new (storage) hs::util::EpochDomain();
+    hs::os::Thread thread;
+    Node node = {{}, NODE_ALIVE};
+    Pinner pinner = {domain, &node, 1, 0};
+
+    domain->Enter();
+    domain->Leave();
+
+    StartPinner(&thread, &pinner);
+    WaitStep(&pinner.reached_step, 2);
+
+    HS_CHECK(HasRecord(&thread, domain));
+    HS_CHECK(HasRecord(GetCurrentThread(), domain));
+
+    // The live thread keeps running without a record, its retired object
+    // is reclaimed by the destruction.
+    domain->~EpochDomain();
+    HS_CHECK(!HasRecord(&thread, domain));
+    HS_CHECK(!HasRecord(GetCurrentThread(), domain));
+    HS_CHECK(node.state == NODE_RECLAIMED);
+
+    pinner.step = 2;
+    hs::os::WaitThread(&thread);
+    hs::os::DestroyThread(&thread);
+}
+
+HS_TEST(EpochDomainStress) {
+    static Stress stress;
+
+    g_Stress = &stress;
+    stress.nodes[0].state = NODE_ALIVE;
+    stress.node_count = 1;
+    stress.current = &stress.nodes[0];
+
+    hs::test::RunWorkers(WRITER_COUNT + READER_COUNT, RunStressWorker,
+                         &stress);
+
+    HS_CHECK(!stress.has_seen_reclaimed);
+    HS_CHECK(stress.reclaimed_count == WRITER_COUNT * REPLACE_COUNT);
+    HS_CHECK(stress.current->state == NODE_ALIVE);
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/os/os_critical_section.hpp>
+#include <hs/util/util_object_pool.hpp>
+
+#include "../harness/test.hpp"
+
+namespace {
+const size_t POOL_CAPACITY = 4096;
+const size_t OPERATION_COUNT = 1000000;
+
+// About the size of the objects we pool (threads, events).
+struct Object {
+    uint8_t data[0x100];
+};
+
+// What callers did before: a fixed array with a used flag per entry, scanned
+// under a lock for a free one.
+class ArrayScanPool {
+ private:
+    hs::os::CriticalSection critical_section;
+    bool is_used[POOL_CAPACITY];
+    Object objects[POOL_CAPACITY];
+
+ public:
+    ArrayScanPool() noexcept : critical_section(), is_used() {}
+
+    Object *Acquire() noexcept {
+        Object *object = nullptr;
+
+        this->critical_section.Enter();
+
+        for (size_t i = 0; i < POOL_CAPACITY; i++) {
+            if (!this->is_used[i]) {
+                this->is_used[i] = true;
+                object = &this->objects[i];
+                break;
+            }
+        }
+
+        this->critical_section.Leave();
+
+        return object;
+    }
+
+    void Release(Object *object) noexcept {
+        this->critical_section.Enter();
+        this->is_used[object - this->objects] = false;
+        this->critical_section.Leave();
+    }
+};
+
+ArrayScanPool g_ArrayScanPool;
+hs::util::StaticObjectPool<Object, POOL_CAPACITY> g_StaticPool;
+
+// Keep the pool at the given occupancy while replacing random objects.
+template <typename PoolType>
+void RunChurn(const char *name, PoolType *pool, size_t held_count) {
+    static Object *held[POOL_CAPACITY];
+    hs::test::Random random(42);
+
+    for (size_t i = 0; i < held_count; i++) {
+        held[i] = pool->Acquire();
+    }
+
+    uint64_t start_time = hs::test::GetTimeNs();
+
+    for (size_t i = 0; i < OPERATION_COUNT; i++) {
+        size_t index = random.Next(held_count);
+
+        pool->Release(held[index]);
+        held[index] = pool->Acquire();
+    }
+
+    uint64_t duration = hs::test::GetTimeNs() - start_time;
+
+    for (size_t i = 0; i < held_count; i++) {
+        pool->Release(held[i]);
+    }
+
+    hs::test::ReportThroughput(name, OPERATION_COUNT * 2, duration);
+}
+}  // namespace
+
+HS_BENCHMARK(ObjectPoolVersusArrayScan) {
+    hs::util::ObjectPool<Object, POOL_CAPACITY> pool;
+    size_t occupancies[] = {16, POOL_CAPACITY / 2, POOL_CAPACITY - 16};
+
+    for (size_t held_count : occupancies) {
+        hs::test::ReportValue("held", held_count, "objects");
+        RunChurn("ObjectPool", &pool, held_count);
+        RunChurn("StaticObjectPool", &g_StaticPool, held_count);
+        RunChurn("array scan", &g_ArrayScanPool, held_count);
+    }
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/util/util_object_pool.hpp>
+
+#include "../harness/test.hpp"
+
+namespace {
+const size_t POOL_CAPACITY = 1000;
+const size_t WORKER_COUNT = 3;
+const size_t WORKER_HELD_COUNT = 64;
+const size_t WORKER_ROUND_COUNT = 20000;
+
+struct Object {
+    size_t owner;
+    size_t round;
+    uint8_t padding[0x70];
+};
+
+typedef hs::util::ObjectPool<Object, POOL_CAPACITY> Pool;
+
+hs::util::StaticObjectPool<Object, POOL_CAPACITY> g_StaticPool;
+
+template <typename PoolType>
+void CheckExhaustion(PoolType *pool) {
+    Object *objects[POOL_CAPACITY];
+
+    for (size_t i = 0; i < POOL_CAPACITY; i++) {
+        objects[i] = pool->Acquire();
+        HS_CHECK(objects[i] != nullptr);
+        HS_CHECK((reinterpret_cast<uintptr_t>(objects[i]) &
+                  (alignof(Object) - 1)) == 0);
+        objects[i]->owner = i;
+    }
+
+    HS_CHECK(pool->Acquire() == nullptr);
+
+    for (size_t i = 0; i < POOL_CAPACITY; i++) {
+        HS_CHECK(objects[i]->owner == i);
+    }
+
+    // Released slots are handed out again, most recent first.
+    pool->Release(objects[10]);
+    pool->Release(objects[20]);
+    HS_CHECK(pool->Acquire() == objects[20]);
+    HS_CHECK(pool->Acquire() == objects[10]);
+    HS_CHECK(pool->Acquire() == nullptr);
+
+    for (size_t i = 0; i < POOL_CAPACITY; i++) {
+        pool->Release(objects[i]);
+    }
+}
+
+// Every worker keeps a window of objects, stamps them and checks nobody else
+// got the same slot meanwhile.
+void RunPoolStress(size_t index, void *argument) {
+    auto pool = reinterpret_cast<Pool *>(argument);
+    Object *held[WORKER_HELD_COUNT] = {};
+    hs::test::Random random(index + 1);
+
+    for (size_t round = 0; round < WORKER_ROUND_COUNT; round++) {
+        size_t slot = random.Next(WORKER_HELD_COUNT);
+
+        if (held[slot] != nullptr) {
+            HS_CHECK(held[slot]->owner == index);
+            pool->Release(held[slot]);
+            held[slot] = nullptr;
+        } else {
+            held[slot] = pool->Acquire();
+            HS_CHECK(held[slot] != nullptr);
+            held[slot]->owner = index;
+            held[slot]->round = round;
+        }
+    }
+
+    for (size_t i = 0; i < WORKER_HELD_COUNT; i++) {
+        if (held[i] != nullptr) {
+            HS_CHECK(held[i]->owner == index);
+            pool->Release(held[i]);
+        }
+    }
+}
+}  // namespace
+
+HS_TEST(ObjectPoolHandsOutEverySlotOnce) {
+    Pool pool;
+
+    CheckExhaustion(&pool);
+}
+
+HS_TEST(StaticObjectPoolHandsOutEverySlotOnce) {
+    CheckExhaustion(&g_StaticPool);
+}
+
+HS_TEST(ObjectPoolSurvivesConcurrentUse) {
+    Pool pool;
+
+    hs::test::RunWorkers(WORKER_COUNT, RunPoolStress, &pool);
+
+    // Nothing leaked, the whole capacity is still available.
+    Object *objects[POOL_CAPACITY];
+    for (size_t i = 0; i < POOL_CAPACITY; i++) {
+        objects[i] = pool.Acquire();
+        HS_CHECK(objects[i] != nullptr);
+    }
+
+    HS_CHECK(pool.Acquire() == nullptr);
+
+    for (size_t i = 0; i < POOL_CAPACITY; i++) {
+        pool.Release(objects[i]);
+    }
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2019 Hydrosphère Developers
+ *
+ * Licensed under the Apache License, Version 2.0 <LICENSE-APACHE or
+ * http://www.apache.org/licenses/LICENSE-2.0> or the MIT license
+ * <LICENSE-MIT or http://opensource.org/licenses/MIT>, at your
+ * option. This file may not be copied, modified, or distributed
+ * except according to those terms.
+ */
+
+#include <hs/util/util_virtual_array.hpp>
+
+#include "../harness/test.hpp"
+#include "../host/host.hpp"
+
+namespace {
+const size_t GRANULE_SIZE = hs::mem::ARENA_COMMIT_SIZE;
+const size_t ELEMENT_PER_GRANULE = GRANULE_SIZE / sizeof(uint64_t);
+const size_t CAPACITY = ELEMENT_PER_GRANULE * 64;
+const size_t ROUND_COUNT = 1000;
+
+size_t g_LiveCount;
+
+struct Counted {
+    size_t value;
+
+    Counted() noexcept : value(0) { g_LiveCount++; }
+    explicit Counted(size_t value) noexcept : value(value) { g_LiveCount++; }
+    Counted(const Counted &other) noexcept : value(other.value) {
+        g_LiveCount++;
+    }
+    ~Counted() noexcept { g_LiveCount--; }
+};
+}  // namespace
+
+HS_TEST(VirtualArrayElementsNeverMove) {
+    hs::util::VirtualArray<Counted> array;
+
+    HS_CHECK(array.Initialize(CAPACITY));
+    HS_CHECK(array.IsEmpty());
+
+    Counted *first = array.EmplaceBack(0);
+    HS_CHECK(first != nullptr);
+
+    for (size_t i = 1; i < CAPACITY; i++) {
+        HS_CHECK(array.PushBack(Counted(i)));
+    }
+
+    HS_CHECK(array.GetSize() == CAPACITY);
+    HS_CHECK(g_LiveCount == CAPACITY);
+    HS_CHECK(!array.PushBack(Counted(CAPACITY)));
+    HS_CHECK(array.GetData() == first);
+
+    bool is_same = true;
+    for (size_t i = 0; i < CAPACITY; i++) {
+        is_same &= array[i].value == i;
+    }
+    HS_CHECK(is_same);
+
+    array.PopBack();
+    HS_CHECK(array.GetSize() == CAPACITY - 1);
+    HS_CHECK(g_LiveCount == CAPACITY - 1);
+
+    HS_CHECK(array.Resize(10));
+    HS_CHECK(array.Resize(20));
+    HS_CHECK(array[9].value == 9 && array[10].value == 0);
+    HS_CHECK(g_LiveCount == 20);
+
+    array.Finalize();
+    HS_CHECK(g_LiveCount == 0);
+}
+
+// Shrinking by less than the hysteresis keeps the memory, going back and
+// forth around a granule boundary doesn't reach the kernel.
+HS_TEST(VirtualArrayShrinkKeepsSomeSlack) {
+    hs::util::VirtualArray<uint64_t> array;
+
+    HS_CHECK(array.Initialize(CAPACITY));
+    HS_CHECK(array.Resize(ELEMENT_PER_GRANULE * 8 + 1));
+    HS_CHECK(array.GetCommittedSize() == GRANULE_SIZE * 9);
+
+    hs::test::ResetSvcCallCounts();
+
+    for (size_t i = 0; i < ROUND_COUNT; i++) {
+        HS_CHECK(array.Resize(ELEMENT_PER_GRANULE * 8 - 1));
+        HS_CHECK(array.Resize(ELEMENT_PER_GRANULE * 8 + 1));
+    }
+
+    HS_CHECK(hs::test::GetSvcCallCount(hs::test::SVC_ID_MAP_MEMORY) == 0);
+    HS_CHECK(hs::test::GetSvcCallCount(hs::test::SVC_ID_UNMAP_MEMORY) == 0);
+    HS_CHECK(array.GetCommittedSize() == GRANULE_SIZE * 9);
+
+    // Two granules of slack are kept.
+    HS_CHECK(array.Resize(ELEMENT_PER_GRANULE * 7));
+    HS_CHECK(array.GetCommittedSize() == GRANULE_SIZE * 9);
+
+    // Past that the memory is given back.
+    HS_CHECK(array.Resize(ELEMENT_PER_GRANULE * 6));
+    HS_CHECK(array.GetCommittedSize() == GRANULE_SIZE * 6);
+
+    // On a small array, half of the committed memory is enough.
+    HS_CHECK(array.Resize(ELEMENT_PER_GRANULE * 3));
+    HS_CHECK(array.GetCommittedSize() == GRANULE_SIZE * 3);
+    HS_CHECK(array.Resize(ELEMENT_PER_GRANULE * 2));
+    HS_CHECK(array.GetCommittedSize() == GRANULE_SIZE * 3);
+    HS_CHECK(array.Resize(ELEMENT_PER_GRANULE));
+    HS_CHECK(array.GetCommittedSize() == GRANULE_SIZE);
+
+    array.Finalize();
+}
+
+HS_TEST(VirtualArrayShrinkToFit) {
+    hs::util::VirtualArray<uint64_t> array;
+
+    HS_CHECK(array.Initialize(CAPACITY));
+    HS_CHECK(array.Resize(ELEMENT_PER_GRANULE * 8));
+    HS_CHECK(array.Resize(ELEMENT_PER_GRANULE * 7 - 1));
+    HS_CHECK(array.GetCommittedSize() == GRANULE_SIZE * 8);
+
+    HS_CHECK(array.ShrinkToFit() == GRANULE_SIZE);
+    HS_CHECK(array.GetCommittedSize() == GRANULE_SIZE * 7);
+    HS_CHECK(array.ShrinkToFit() == 0);
+
+    array.Clear();
+    HS_CHECK(array.GetCommittedSize() == 0);
+
+    array.Finalize();
+}